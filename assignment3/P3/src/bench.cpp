@@ -0,0 +1,2255 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <iomanip>
+#include <fstream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "btree.h"
+#include "hashindex.h"
+#include "statictree.h"
+#include "page.h"
+#include "filescan.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+
+using namespace badgerdb;
+
+// -----------------------------------------------------------------------------
+// Globals
+// -----------------------------------------------------------------------------
+const std::string relationName = "benchRel";
+// keys inserted by every benchmark run
+const int benchSize = 1000000;
+
+// tuples of the relations the heap fetch benchmark reads, as in the tests
+typedef struct tuple {
+	int i;
+	double d;
+	char s[64];
+} RECORD;
+
+BufMgr * bufMgr = new BufMgr(8192);
+
+// -----------------------------------------------------------------------------
+// Forward declarations
+// -----------------------------------------------------------------------------
+
+void createEmptyRelation();
+void createRelationRandom(int size);
+void removeFiles(const std::string &indexName);
+double secondsSince(std::chrono::steady_clock::time_point start);
+std::vector<int> shuffledKeys(int size);
+RecordId fakeRid(int key);
+int countScan(BTreeIndex *index, int lowVal, int highVal);
+int countBatches(BTreeIndex *index, int lowVal, int highVal, std::vector<RecordId> &batch);
+void fillIndex(BTreeIndex &index, const std::vector<int> &keys);
+std::vector<int> threadCounts(int maxThreads);
+void benchConcurrent(int maxThreads);
+void benchProbe(int maxThreads);
+void benchBatch();
+void benchLookup();
+void benchPostings();
+void benchPacked();
+void benchAppend();
+void benchInsertBatch();
+void benchPinned();
+void benchSwizzle();
+void benchBlocked();
+void benchLookupBatch();
+void benchDescending();
+void benchCounted();
+void benchHeapFetch();
+long directFetch(BTreeIndex *index, PageFile *file, int lowVal, int highVal, std::vector<RecordId> &batch);
+long heapFetch(HeapFetch &fetch, int lowVal, int highVal);
+void benchCovering();
+void createRelationOrders(int size, int perCustomer);
+void benchComposite();
+void createRelationPaths(int size);
+void pathString(int key, char *s);
+void benchStrings();
+void benchTable();
+void benchHash();
+void benchBuffered();
+void benchStatic();
+void benchLearned();
+void benchBloom();
+std::vector<int> distributedKeys(int size, int distribution);
+std::uint64_t cycleCount();
+long fileSize(const std::string &fileName);
+
+
+int main(int argc, char **argv)
+{
+	// usage: badgerdb_bench [benchmark|all] [max threads]
+	std::string which = argc > 1 ? argv[1] : "all";
+	int maxThreads = argc > 2 ? atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+	if(which == "all" || which == "concurrent"){
+		benchConcurrent(maxThreads);
+	}
+	if(which == "all" || which == "probe"){
+		benchProbe(maxThreads);
+	}
+	if(which == "all" || which == "batch"){
+		benchBatch();
+	}
+	if(which == "all" || which == "lookup"){
+		benchLookup();
+	}
+	if(which == "all" || which == "postings"){
+		benchPostings();
+	}
+	if(which == "all" || which == "packed"){
+		benchPacked();
+	}
+	if(which == "all" || which == "append"){
+		benchAppend();
+	}
+	if(which == "all" || which == "insertbatch"){
+		benchInsertBatch();
+	}
+	if(which == "all" || which == "pinned"){
+		benchPinned();
+	}
+	if(which == "all" || which == "swizzle"){
+		benchSwizzle();
+	}
+	if(which == "all" || which == "blocked"){
+		benchBlocked();
+	}
+	if(which == "all" || which == "lookupbatch"){
+		benchLookupBatch();
+	}
+	if(which == "all" || which == "descending"){
+		benchDescending();
+	}
+	if(which == "all" || which == "counted"){
+		benchCounted();
+	}
+	if(which == "all" || which == "heapfetch"){
+		benchHeapFetch();
+	}
+	if(which == "all" || which == "covering"){
+		benchCovering();
+	}
+	if(which == "all" || which == "composite"){
+		benchComposite();
+	}
+	if(which == "all" || which == "strings"){
+		benchStrings();
+	}
+	if(which == "all" || which == "table"){
+		benchTable();
+	}
+	if(which == "all" || which == "hash"){
+		benchHash();
+	}
+	if(which == "all" || which == "buffered"){
+		benchBuffered();
+	}
+	if(which == "all" || which == "static"){
+		benchStatic();
+	}
+	if(which == "all" || which == "learned"){
+		benchLearned();
+	}
+	if(which == "all" || which == "bloom"){
+		benchBloom();
+	}
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// createEmptyRelation
+// -----------------------------------------------------------------------------
+void createEmptyRelation()
+{
+	// the benchmarks insert their own entries, the index is built over an empty relation
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	PageFile file = PageFile::create(relationName);
+}
+
+// -----------------------------------------------------------------------------
+// createRelationRandom
+// -----------------------------------------------------------------------------
+void createRelationRandom(int size)
+{
+	// tuples valued 0 to size in random order, written a page at a time past the buffer pool
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	PageFile file = PageFile::create(relationName);
+	std::vector<int> keys = shuffledKeys(size);
+	RECORD record;
+	memset(record.s, ' ', sizeof(record.s));
+	PageId pageNumber;
+	Page page = file.allocatePage(pageNumber);
+	for(int i = 0; i < size; i++){
+		sprintf(record.s, "%05d string record", keys[i]);
+		record.i = keys[i];
+		record.d = keys[i];
+		std::string data(reinterpret_cast<char*>(&record), sizeof(RECORD));
+		if(!page.hasSpaceForRecord(data)){
+			file.writePage(pageNumber, page);
+			page = file.allocatePage(pageNumber);
+		}
+		page.insertRecord(data);
+	}
+	file.writePage(pageNumber, page);
+}
+
+// -----------------------------------------------------------------------------
+// createRelationOrders
+// -----------------------------------------------------------------------------
+void createRelationOrders(int size, int perCustomer)
+{
+	// orders in random order, the integer field the customer and the double field the date of each of
+	// their perCustomer orders
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	PageFile file = PageFile::create(relationName);
+	std::vector<int> keys = shuffledKeys(size);
+	RECORD record;
+	memset(record.s, ' ', sizeof(record.s));
+	PageId pageNumber;
+	Page page = file.allocatePage(pageNumber);
+	for(int i = 0; i < size; i++){
+		sprintf(record.s, "%05d string record", keys[i]);
+		record.i = keys[i] / perCustomer;
+		record.d = keys[i] % perCustomer;
+		std::string data(reinterpret_cast<char*>(&record), sizeof(RECORD));
+		if(!page.hasSpaceForRecord(data)){
+			file.writePage(pageNumber, page);
+			page = file.allocatePage(pageNumber);
+		}
+		page.insertRecord(data);
+	}
+	file.writePage(pageNumber, page);
+}
+
+// -----------------------------------------------------------------------------
+// createRelationPaths
+// -----------------------------------------------------------------------------
+void createRelationPaths(int size)
+{
+	// records in random order whose string field is the path of an order of a web shop, see pathString
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	PageFile file = PageFile::create(relationName);
+	std::vector<int> keys = shuffledKeys(size);
+	RECORD record;
+	PageId pageNumber;
+	Page page = file.allocatePage(pageNumber);
+	for(int i = 0; i < size; i++){
+		pathString(keys[i], record.s);
+		record.i = keys[i];
+		record.d = keys[i];
+		std::string data(reinterpret_cast<char*>(&record), sizeof(RECORD));
+		if(!page.hasSpaceForRecord(data)){
+			file.writePage(pageNumber, page);
+			page = file.allocatePage(pageNumber);
+		}
+		page.insertRecord(data);
+	}
+	file.writePage(pageNumber, page);
+}
+
+// -----------------------------------------------------------------------------
+// pathString
+// -----------------------------------------------------------------------------
+void pathString(int key, char *s)
+{
+	// eight orders a customer, the paths sharing the host and differing in the numbers at their end
+	memset(s, 0, 64);
+	sprintf(s, "https://shop.example.com/customers/%08d/orders/%010u", key / 8, (unsigned)key * 2654435761u);
+}
+
+// -----------------------------------------------------------------------------
+// removeFiles
+// -----------------------------------------------------------------------------
+void removeFiles(const std::string &indexName)
+{
+	try
+	{
+		File::remove(indexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+// -----------------------------------------------------------------------------
+// secondsSince
+// -----------------------------------------------------------------------------
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// -----------------------------------------------------------------------------
+// shuffledKeys
+// -----------------------------------------------------------------------------
+std::vector<int> shuffledKeys(int size)
+{
+	std::vector<int> keys(size);
+	for(int i = 0; i < size; i++){
+		keys[i] = i;
+	}
+	std::mt19937 gen(564);
+	std::shuffle(keys.begin(), keys.end(), gen);
+	return keys;
+}
+
+// -----------------------------------------------------------------------------
+// fakeRid
+// -----------------------------------------------------------------------------
+RecordId fakeRid(int key)
+{
+	// the index never looks at the relation, any non zero page number will do
+	RecordId rid;
+	rid.page_number = key / 100 + 1;
+	rid.slot_number = key % 100;
+	return rid;
+}
+
+// -----------------------------------------------------------------------------
+// countScan
+// -----------------------------------------------------------------------------
+int countScan(BTreeIndex *index, int lowVal, int highVal)
+{
+	RecordId rid;
+	int numResults = 0;
+	BTreeCursor scan;
+	try
+	{
+		scan = index->startScan(&lowVal, GTE, &highVal, LT);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+	try
+	{
+		while(1)
+		{
+			scan.scanNext(rid);
+			numResults++;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	scan.endScan();
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// countBatches
+// -----------------------------------------------------------------------------
+int countBatches(BTreeIndex *index, int lowVal, int highVal, std::vector<RecordId> &batch)
+{
+	int numResults = 0;
+	BTreeCursor scan = index->openScan(&lowVal, GTE, &highVal, LT);
+	size_t n;
+	while((n = scan.nextBatch(&batch[0], batch.size())) > 0){
+		numResults += n;
+	}
+	scan.endScan();
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// fillIndex
+// -----------------------------------------------------------------------------
+void fillIndex(BTreeIndex &index, const std::vector<int> &keys)
+{
+	for(size_t i = 0; i < keys.size(); i++){
+		index.insertEntry(&keys[i], fakeRid(keys[i]));
+	}
+}
+
+// -----------------------------------------------------------------------------
+// fileSize
+// -----------------------------------------------------------------------------
+long fileSize(const std::string &fileName)
+{
+	std::ifstream file(fileName.c_str(), std::ios::binary | std::ios::ate);
+	return file.tellg();
+}
+
+// -----------------------------------------------------------------------------
+// threadCounts
+// -----------------------------------------------------------------------------
+std::vector<int> threadCounts(int maxThreads)
+{
+	// powers of two up to maxThreads, and maxThreads itself
+	std::vector<int> counts;
+	for(int t = 1; t < maxThreads; t *= 2){
+		counts.push_back(t);
+	}
+	counts.push_back(maxThreads);
+	return counts;
+}
+
+// -----------------------------------------------------------------------------
+// benchConcurrent
+// -----------------------------------------------------------------------------
+void benchConcurrent(int maxThreads)
+{
+	// insert, then delete, benchSize random keys from 1 to N threads, each thread
+	// working on its own slice of the keys; a separate thread keeps scanning meanwhile
+	std::cout << "---------------------" << std::endl;
+	std::cout << "concurrent insert/delete, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(8) << "threads" << std::setw(16) << "insert Mops/s"
+		<< std::setw(16) << "delete Mops/s" << std::setw(16) << "scans/s" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	std::vector<int> counts = threadCounts(maxThreads);
+	for(size_t c = 0; c < counts.size(); c++){
+		int threads = counts[c];
+		createEmptyRelation();
+		std::string indexName;
+		{
+			BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+			std::atomic<bool> stop(false);
+			std::atomic<int> scans(0);
+			std::thread scanner([&index, &stop, &scans](){
+				while(!stop){
+					countScan(&index, benchSize/2, benchSize/2 + 1000);
+					scans++;
+				}
+			});
+
+			double phase[2];
+			for(int deleting = 0; deleting < 2; deleting++){
+				std::vector<std::thread> workers;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int t = 0; t < threads; t++){
+					workers.push_back(std::thread([&index, &keys, t, threads, deleting](){
+						for(int i = t; i < benchSize; i += threads){
+							if(deleting){
+								index.deleteEntry(&keys[i], fakeRid(keys[i]));
+							}
+							else{
+								index.insertEntry(&keys[i], fakeRid(keys[i]));
+							}
+						}
+					}));
+				}
+				for(int t = 0; t < threads; t++){
+					workers[t].join();
+				}
+				phase[deleting] = secondsSince(start);
+			}
+			stop = true;
+			scanner.join();
+
+			std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+				<< std::setw(16) << benchSize / phase[0] / 1e6
+				<< std::setw(16) << benchSize / phase[1] / 1e6
+				<< std::setw(16) << std::setprecision(0) << scans / (phase[0] + phase[1]) << std::endl;
+		}
+		removeFiles(indexName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchProbe
+// -----------------------------------------------------------------------------
+void benchProbe(int maxThreads)
+{
+	// point probes that each open their own cursor, as the inner side of a nested
+	// loop join would, from 1 to N threads sharing one index
+	std::cout << "---------------------" << std::endl;
+	std::cout << "cursor per probe, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(8) << "threads" << std::setw(16) << "Mprobes/s" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	createEmptyRelation();
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+		fillIndex(index, keys);
+
+		std::vector<int> counts = threadCounts(maxThreads);
+		for(size_t c = 0; c < counts.size(); c++){
+			int threads = counts[c];
+			std::atomic<int> misses(0);
+			std::vector<std::thread> workers;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for(int t = 0; t < threads; t++){
+				workers.push_back(std::thread([&index, &keys, &misses, t, threads](){
+					for(int i = t; i < benchSize; i += threads){
+						if(countScan(&index, keys[i], keys[i] + 1) != 1){
+							misses++;
+						}
+					}
+				}));
+			}
+			for(int t = 0; t < threads; t++){
+				workers[t].join();
+			}
+			double seconds = secondsSince(start);
+			std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+				<< std::setw(16) << benchSize / seconds / 1e6;
+			if(misses > 0){
+				std::cout << "  (" << misses << " probes missed)";
+			}
+			std::cout << std::endl;
+		}
+	}
+	removeFiles(indexName);
+}
+
+// -----------------------------------------------------------------------------
+// benchBatch
+// -----------------------------------------------------------------------------
+void benchBatch()
+{
+	// rows per second of the scanNext loop intScan uses against nextBatch, over the
+	// whole index and over many short ranges
+	std::cout << "---------------------" << std::endl;
+	std::cout << "scanNext against nextBatch, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(12) << "range" << std::setw(10) << "batch"
+		<< std::setw(18) << "scanNext Mrows/s" << std::setw(20) << "nextBatch Mrows/s" << std::endl;
+
+	createEmptyRelation();
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+		fillIndex(index, shuffledKeys(benchSize));
+
+		const int ranges[] = {benchSize, 10000, 100};
+		const int batchSizes[] = {64, 1024};
+		for(int r = 0; r < 3; r++){
+			int range = ranges[r];
+			int scans = benchSize / range;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			long rows = 0;
+			for(int i = 0; i < scans; i++){
+				rows += countScan(&index, i * range, (i + 1) * range);
+			}
+			double single = rows / secondsSince(start) / 1e6;
+
+			for(int b = 0; b < 2; b++){
+				std::vector<RecordId> batch(batchSizes[b]);
+				start = std::chrono::steady_clock::now();
+				long batchRows = 0;
+				for(int i = 0; i < scans; i++){
+					batchRows += countBatches(&index, i * range, (i + 1) * range, batch);
+				}
+				double batched = batchRows / secondsSince(start) / 1e6;
+				std::cout << std::setw(12) << range << std::setw(10) << batchSizes[b]
+					<< std::fixed << std::setprecision(2) << std::setw(18) << single
+					<< std::setw(20) << batched;
+				if(batchRows != rows){
+					std::cout << "  (" << rows << " rows against " << batchRows << ")";
+				}
+				std::cout << std::endl;
+			}
+		}
+	}
+	removeFiles(indexName);
+}
+
+// -----------------------------------------------------------------------------
+// benchLookup
+// -----------------------------------------------------------------------------
+void benchLookup()
+{
+	// latency of point probes through a [k,k] scan against lookup()
+	std::cout << "---------------------" << std::endl;
+	std::cout << "point probes, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(12) << "path" << std::setw(12) << "mean us"
+		<< std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	createEmptyRelation();
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+		fillIndex(index, keys);
+
+		const int probes = 200000;
+		std::vector<double> latency(probes);
+		std::vector<RecordId> rids;
+		for(int path = 0; path < 2; path++){
+			int misses = 0;
+			for(int i = 0; i < probes; i++){
+				int key = keys[(i * 7919) % benchSize];
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				int found;
+				if(path == 0){
+					found = countScan(&index, key, key + 1);
+				}
+				else{
+					rids.clear();
+					found = index.lookup(&key, rids);
+				}
+				latency[i] = secondsSince(start) * 1e6;
+				misses += found != 1;
+			}
+			double total = 0;
+			for(int i = 0; i < probes; i++){
+				total += latency[i];
+			}
+			std::sort(latency.begin(), latency.end());
+			std::cout << std::setw(12) << (path == 0 ? "scan [k,k]" : "lookup")
+				<< std::fixed << std::setprecision(3)
+				<< std::setw(12) << total / probes
+				<< std::setw(12) << latency[probes / 2]
+				<< std::setw(12) << latency[probes * 99 / 100]
+				<< std::setw(12) << latency[probes - 1];
+			if(misses > 0){
+				std::cout << "  (" << misses << " probes missed)";
+			}
+			std::cout << std::endl;
+		}
+	}
+	removeFiles(indexName);
+}
+
+// -----------------------------------------------------------------------------
+// benchPostings
+// -----------------------------------------------------------------------------
+void benchPostings()
+{
+	// benchSize entries over 10 and over 1000 keys drawn from a zipf distribution, inserted
+	// in record order like the index constructor does, against as many distinct keys.
+	// The hottest key of a skewed index is scanned, and a range of 100000 distinct keys.
+	std::cout << "---------------------" << std::endl;
+	std::cout << "skewed keys in posting lists, " << benchSize << " entries" << std::endl;
+	std::cout << std::setw(10) << "keys" << std::setw(12) << "index MB" << std::setw(12) << "build s"
+		<< std::setw(12) << "scan rows" << std::setw(18) << "scanNext Mrows/s" << std::setw(20) << "nextBatch Mrows/s" << std::endl;
+
+	const int distincts[] = {10, 1000, benchSize};
+	for(int d = 0; d < 3; d++){
+		int distinct = distincts[d];
+		std::vector<int> keys;
+		if(distinct == benchSize){
+			keys = shuffledKeys(benchSize);
+		}
+		else{
+			std::vector<double> weights(distinct);
+			for(int r = 0; r < distinct; r++){
+				weights[r] = 1.0 / (r + 1);
+			}
+			std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+			std::mt19937 gen(564);
+			for(int i = 0; i < benchSize; i++){
+				keys.push_back(zipf(gen));
+			}
+		}
+
+		createEmptyRelation();
+		std::string indexName;
+		{
+			BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for(int i = 0; i < benchSize; i++){
+				index.insertEntry(&keys[i], fakeRid(i));
+			}
+			double build = secondsSince(start);
+			double megabytes = fileSize(indexName) / 1048576.0;
+
+			int high = distinct == benchSize ? 100000 : 1;
+			start = std::chrono::steady_clock::now();
+			int rows = countScan(&index, 0, high);
+			double single = rows / secondsSince(start) / 1e6;
+			std::vector<RecordId> batch(1024);
+			start = std::chrono::steady_clock::now();
+			int batchRows = countBatches(&index, 0, high, batch);
+			double batched = batchRows / secondsSince(start) / 1e6;
+
+			std::cout << std::setw(10) << distinct << std::fixed << std::setprecision(2)
+				<< std::setw(12) << megabytes << std::setw(12) << build << std::setw(12) << rows
+				<< std::setw(18) << single << std::setw(20) << batched;
+			if(batchRows != rows){
+				std::cout << "  (" << rows << " rows against " << batchRows << ")";
+			}
+			std::cout << std::endl;
+		}
+		removeFiles(indexName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchPacked
+// -----------------------------------------------------------------------------
+void benchPacked()
+{
+	// benchSize dense keys of records stored in key order, inserted in that order and
+	// shuffled, in plain and in packed leaves. The whole index is scanned and probed.
+	std::cout << "---------------------" << std::endl;
+	std::cout << "plain against packed leaves, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(10) << "leaves" << std::setw(10) << "order" << std::setw(12) << "index MB"
+		<< std::setw(8) << "height" << std::setw(12) << "build s" << std::setw(18) << "scanNext Mrows/s"
+		<< std::setw(20) << "nextBatch Mrows/s" << std::setw(12) << "lookup us" << std::endl;
+
+	std::vector<int> shuffled = shuffledKeys(benchSize);
+	for(int order = 0; order < 2; order++){
+		for(int format = 0; format < 2; format++){
+			createEmptyRelation();
+			std::string indexName;
+			{
+				BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER, format == 0 ? PLAIN_LEAVES : PACKED_LEAVES);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int i = 0; i < benchSize; i++){
+					int key = order == 0 ? i : shuffled[i];
+					index.insertEntry(&key, fakeRid(key));
+				}
+				double build = secondsSince(start);
+				double megabytes = fileSize(indexName) / 1048576.0;
+
+				start = std::chrono::steady_clock::now();
+				int rows = countScan(&index, 0, benchSize);
+				double single = rows / secondsSince(start) / 1e6;
+				std::vector<RecordId> batch(1024);
+				start = std::chrono::steady_clock::now();
+				int batchRows = countBatches(&index, 0, benchSize, batch);
+				double batched = batchRows / secondsSince(start) / 1e6;
+
+				const int probes = 100000;
+				std::vector<RecordId> rids;
+				start = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i++){
+					rids.clear();
+					index.lookup(&shuffled[i], rids);
+				}
+				double probe = secondsSince(start) / probes * 1e6;
+
+				std::cout << std::setw(10) << (format == 0 ? "plain" : "packed") << std::setw(10) << (order == 0 ? "key" : "random")
+					<< std::fixed << std::setprecision(2) << std::setw(12) << megabytes << std::setw(8) << index.height()
+					<< std::setw(12) << build << std::setw(18) << single << std::setw(20) << batched
+					<< std::setw(12) << probe;
+				if(rows != benchSize || batchRows != benchSize){
+					std::cout << "  (" << rows << " and " << batchRows << " rows)";
+				}
+				std::cout << std::endl;
+			}
+			removeFiles(indexName);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchAppend
+// -----------------------------------------------------------------------------
+void benchAppend()
+{
+	// benchSize dense keys inserted in increasing order, which appends to the rightmost leaf,
+	// in decreasing order, which fills the leftmost leaf and splits it at the median, and shuffled
+	std::cout << "---------------------" << std::endl;
+	std::cout << "appends against median splits, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(10) << "leaves" << std::setw(12) << "order" << std::setw(12) << "index MB"
+		<< std::setw(8) << "height" << std::setw(18) << "insert Mkeys/s" << std::setw(12) << "lookup us" << std::endl;
+
+	const char *orders[] = {"increasing", "decreasing", "random"};
+	std::vector<int> shuffled = shuffledKeys(benchSize);
+	for(int format = 0; format < 2; format++){
+		for(int order = 0; order < 3; order++){
+			createEmptyRelation();
+			std::string indexName;
+			{
+				BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER, format == 0 ? PLAIN_LEAVES : PACKED_LEAVES);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int i = 0; i < benchSize; i++){
+					int key = order == 0 ? i : order == 1 ? benchSize - 1 - i : shuffled[i];
+					index.insertEntry(&key, fakeRid(key));
+				}
+				double inserts = benchSize / secondsSince(start) / 1e6;
+				double megabytes = fileSize(indexName) / 1048576.0;
+
+				const int probes = 100000;
+				std::vector<RecordId> rids;
+				start = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i++){
+					rids.clear();
+					index.lookup(&shuffled[i], rids);
+				}
+				double probe = secondsSince(start) / probes * 1e6;
+
+				std::cout << std::setw(10) << (format == 0 ? "plain" : "packed") << std::setw(12) << orders[order]
+					<< std::fixed << std::setprecision(2) << std::setw(12) << megabytes << std::setw(8) << index.height()
+					<< std::setw(18) << inserts << std::setw(12) << probe << std::endl;
+			}
+			removeFiles(indexName);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchInsertBatch
+// -----------------------------------------------------------------------------
+void benchInsertBatch()
+{
+	// benchSize shuffled keys delivered in chunks, inserted one at a time with insertEntry
+	// (batch 1) and a chunk at a time with insertBatch
+	std::cout << "---------------------" << std::endl;
+	std::cout << "insertEntry against insertBatch, " << benchSize << " shuffled keys" << std::endl;
+	std::cout << std::setw(10) << "leaves" << std::setw(8) << "batch" << std::setw(18) << "insert Mkeys/s"
+		<< std::setw(12) << "index MB" << std::endl;
+
+	std::vector<int> shuffled = shuffledKeys(benchSize);
+	const int batchSizes[] = {1, 16, 256, 4096, 65536};
+	for(int format = 0; format < 2; format++){
+		for(int b = 0; b < 5; b++){
+			int size = batchSizes[b];
+			createEmptyRelation();
+			std::string indexName;
+			{
+				BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER, format == 0 ? PLAIN_LEAVES : PACKED_LEAVES);
+				std::vector<RIDKeyPair<int> > batch;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int i = 0; i < benchSize; i += size){
+					int end = std::min(benchSize, i + size);
+					if(size == 1){
+						index.insertEntry(&shuffled[i], fakeRid(shuffled[i]));
+						continue;
+					}
+					batch.resize(end - i);
+					for(int j = i; j < end; j++){
+						batch[j - i].set(fakeRid(shuffled[j]), shuffled[j]);
+					}
+					index.insertBatch(&batch[0], batch.size());
+				}
+				double inserts = benchSize / secondsSince(start) / 1e6;
+				int rows = countScan(&index, 0, benchSize);
+
+				std::cout << std::setw(10) << (format == 0 ? "plain" : "packed") << std::setw(8) << size
+					<< std::fixed << std::setprecision(2) << std::setw(18) << inserts
+					<< std::setw(12) << fileSize(indexName) / 1048576.0;
+				if(rows != benchSize){
+					std::cout << "  (" << rows << " rows)";
+				}
+				std::cout << std::endl;
+			}
+			removeFiles(indexName);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchPinned
+// -----------------------------------------------------------------------------
+void benchPinned()
+{
+	// latency of lookup() with the top levels of the tree kept pinned, from none of them to all
+	// non leaf levels of a three level tree. Probes of all keys mostly wait for the leaf to come
+	// into the cache, probes of a few hot keys mostly for the buffer manager
+	std::cout << "---------------------" << std::endl;
+	std::cout << "lookup with pinned upper levels, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(8) << "probes" << std::setw(8) << "levels" << std::setw(8) << "nodes" << std::setw(12) << "mean us"
+		<< std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(14) << "Mprobes/s" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	createEmptyRelation();
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+		fillIndex(index, keys);
+
+		const int probes = 500000;
+		const int hotKeys = 10000;
+		std::vector<double> latency(probes);
+		std::vector<RecordId> rids;
+		for(int hot = 0; hot < 2; hot++){
+			for(int levels = 0; levels < 4; levels++){
+				int nodes = index.pinUpperLevels(levels);
+				int misses = 0;
+				std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i++){
+					int key = hot ? (int)((i * 7919L) % hotKeys) : keys[(i * 7919L) % benchSize];
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					rids.clear();
+					misses += index.lookup(&key, rids) != 1;
+					latency[i] = secondsSince(start) * 1e6;
+				}
+				double rate = probes / secondsSince(begin) / 1e6;
+				double total = 0;
+				for(int i = 0; i < probes; i++){
+					total += latency[i];
+				}
+				std::sort(latency.begin(), latency.end());
+				std::cout << std::setw(8) << (hot ? "hot" : "all") << std::setw(8) << levels << std::setw(8) << nodes
+					<< std::fixed << std::setprecision(3)
+					<< std::setw(12) << total / probes
+					<< std::setw(12) << latency[probes / 2]
+					<< std::setw(12) << latency[probes * 99 / 100]
+					<< std::setw(14) << rate;
+				if(misses > 0){
+					std::cout << "  (" << misses << " probes missed)";
+				}
+				std::cout << std::endl;
+			}
+		}
+		index.pinUpperLevels(0);
+	}
+	removeFiles(indexName);
+}
+
+// -----------------------------------------------------------------------------
+// benchSwizzle
+// -----------------------------------------------------------------------------
+void benchSwizzle()
+{
+	// lookup() and point scans on an index that fits in the buffer pool, with child references
+	// translated through the buffer manager and with them swizzled by a first round of probes
+	std::cout << "---------------------" << std::endl;
+	std::cout << "swizzled child references, " << benchSize << " keys in memory" << std::endl;
+	std::cout << std::setw(10) << "children" << std::setw(12) << "path" << std::setw(12) << "mean us"
+		<< std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(14) << "Mprobes/s" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	createEmptyRelation();
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+		index.swizzleChildren(false);
+		fillIndex(index, keys);
+
+		const int probes = 500000;
+		std::vector<double> latency(probes);
+		std::vector<RecordId> rids;
+		for(int swizzled = 0; swizzled < 2; swizzled++){
+			index.swizzleChildren(swizzled == 1);
+			for(int path = 0; path < 2; path++){
+				int misses = 0;
+				std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i++){
+					int key = keys[(i * 7919L) % benchSize];
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					int found;
+					if(path == 0){
+						rids.clear();
+						found = index.lookup(&key, rids);
+					}
+					else{
+						found = countScan(&index, key, key + 1);
+					}
+					latency[i] = secondsSince(start) * 1e6;
+					misses += found != 1;
+				}
+				double rate = probes / secondsSince(begin) / 1e6;
+				double total = 0;
+				for(int i = 0; i < probes; i++){
+					total += latency[i];
+				}
+				std::sort(latency.begin(), latency.end());
+				std::cout << std::setw(10) << (swizzled ? "swizzled" : "page no") << std::setw(12) << (path == 0 ? "lookup" : "scan [k,k]")
+					<< std::fixed << std::setprecision(3)
+					<< std::setw(12) << total / probes
+					<< std::setw(12) << latency[probes / 2]
+					<< std::setw(12) << latency[probes * 99 / 100]
+					<< std::setw(14) << rate;
+				if(misses > 0){
+					std::cout << "  (" << misses << " probes missed)";
+				}
+				std::cout << std::endl;
+			}
+		}
+	}
+	removeFiles(indexName);
+}
+
+// -----------------------------------------------------------------------------
+// cycleCount
+// -----------------------------------------------------------------------------
+std::uint64_t cycleCount()
+{
+	// time stamp counter where there is one, nanoseconds elsewhere
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// benchBlocked
+// -----------------------------------------------------------------------------
+void benchBlocked()
+{
+	// lookup() on indexes with plain and with blocked non-leaves. Cold probes first push the index
+	// out of the processor caches by reading a buffer larger than them, so every line of a node that
+	// the search touches is a miss; warm probes go to a few hot keys whose paths stay cached
+	std::cout << "---------------------" << std::endl;
+	std::cout << "plain against blocked non-leaves, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(10) << "nonleaves" << std::setw(10) << "caches" << std::setw(8) << "height" << std::setw(12) << "mean us" << std::setw(12) << "p50 us" << std::setw(14) << "mean cycles" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	std::vector<char> flush(64 << 20);
+	createEmptyRelation();
+	for(int format = 0; format < 2; format++){
+		std::string indexName;
+		{
+			BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER, PLAIN_LEAVES,
+				format == 0 ? PLAIN_NONLEAVES : BLOCKED_NONLEAVES);
+			fillIndex(index, keys);
+
+			std::vector<RecordId> rids;
+			for(int cold = 1; cold >= 0; cold--){
+				const int probes = cold ? 2000 : 500000;
+				const int hotKeys = 100;
+				std::vector<double> latency(probes);
+				std::uint64_t cycles = 0;
+				int misses = 0;
+				long sum = 0;
+				for(int i = 0; i < probes; i++){
+					int key = cold ? keys[(i * 7919L) % benchSize] : keys[(i * 7919L) % hotKeys];
+					if(cold){
+						for(size_t j = 0; j < flush.size(); j += 64){
+							sum += ++flush[j];
+						}
+					}
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					std::uint64_t first = cycleCount();
+					rids.clear();
+					misses += index.lookup(&key, rids) != 1;
+					cycles += cycleCount() - first;
+					latency[i] = secondsSince(start) * 1e6;
+				}
+				double total = 0;
+				for(int i = 0; i < probes; i++){
+					total += latency[i];
+				}
+				std::sort(latency.begin(), latency.end());
+				std::cout << std::setw(10) << (format == 0 ? "plain" : "blocked") << std::setw(10) << (cold ? "cold" : "warm")
+					<< std::fixed << std::setprecision(3)
+					<< std::setw(8) << index.height()
+					<< std::setw(12) << total / probes
+					<< std::setw(12) << latency[probes / 2]
+					<< std::setw(14) << (double)cycles / probes;
+				if(misses > 0 || sum == 1){
+					std::cout << "  (" << misses << " probes missed)";
+				}
+				std::cout << std::endl;
+			}
+		}
+		removeFiles(indexName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchLookupBatch
+// -----------------------------------------------------------------------------
+void benchLookupBatch()
+{
+	// random probes of an index several times the size of the last level cache, one lookup() at a
+	// time and lookupBatch() with batches of 1 to LOOKUPGROUP keys. The index gets a buffer pool of
+	// its own that holds all of it, so probes wait on memory and not on the disk
+	const int size = 10 * benchSize;
+	const int probes = 1000000;
+	std::cout << "---------------------" << std::endl;
+	std::cout << "lookup against lookupBatch, " << probes << " random probes of " << size << " keys" << std::endl;
+	std::cout << std::setw(10) << "nonleaves" << std::setw(12) << "batch" << std::setw(12) << "index MB"
+		<< std::setw(14) << "Mprobes/s" << std::setw(12) << "ns/probe" << std::endl;
+
+	std::vector<int> keys(probes);
+	std::mt19937 gen(564);
+	std::uniform_int_distribution<int> pick(0, size - 1);
+	for(int i = 0; i < probes; i++){
+		keys[i] = pick(gen);
+	}
+	BufMgr *pool = new BufMgr(20480);
+	for(int format = 0; format < 2; format++){
+		createEmptyRelation();
+		std::string indexName;
+		{
+			BTreeIndex index(relationName, indexName, pool, 0, INTEGER, PLAIN_LEAVES,
+				format == 0 ? PLAIN_NONLEAVES : BLOCKED_NONLEAVES);
+			std::vector<RIDKeyPair<int> > batch(65536);
+			for(int i = 0; i < size; i += batch.size()){
+				for(size_t j = 0; j < batch.size(); j++){
+					batch[j].set(fakeRid(i + j), i + j);
+				}
+				index.insertBatch(&batch[0], std::min(batch.size(), (size_t)(size - i)));
+			}
+			double megabytes = fileSize(indexName) / 1048576.0;
+
+			std::vector<RecordId> rids;
+			std::vector<size_t> ends(LOOKUPGROUP);
+			for(size_t group = 0; group <= LOOKUPGROUP; group = group == 0 ? 1 : group * 2){
+				rids.clear();
+				size_t found = 0;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i += group == 0 ? 1 : group){
+					if(group == 0){
+						found += index.lookup(&keys[i], rids);
+					}
+					else{
+						found += index.lookupBatch(&keys[i], std::min(group, (size_t)(probes - i)), rids, &ends[0]);
+					}
+					rids.clear();
+				}
+				double seconds = secondsSince(start);
+				std::cout << std::setw(10) << (format == 0 ? "plain" : "blocked");
+				if(group == 0){
+					std::cout << std::setw(12) << "lookup";
+				}
+				else{
+					std::cout << std::setw(12) << group;
+				}
+				std::cout << std::fixed << std::setprecision(2) << std::setw(12) << megabytes
+					<< std::setw(14) << probes / seconds / 1e6 << std::setw(12) << seconds / probes * 1e9;
+				if(found != (size_t)probes){
+					std::cout << "  (" << found << " found)";
+				}
+				std::cout << std::endl;
+			}
+		}
+		removeFiles(indexName);
+	}
+	delete pool;
+}
+
+// -----------------------------------------------------------------------------
+// benchDescending
+// -----------------------------------------------------------------------------
+void benchDescending()
+{
+	// the 20 largest entries of ranges of several widths, kept from the tail of an ascending scan
+	// against read off a descending one, and whole ranges in either order
+	std::cout << "---------------------" << std::endl;
+	std::cout << "largest entries of a range, " << benchSize << " keys" << std::endl;
+	std::cout << std::setw(12) << "range" << std::setw(16) << "ascending us" << std::setw(16) << "descending us"
+		<< std::setw(16) << "asc Mrows/s" << std::setw(16) << "desc Mrows/s" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	createEmptyRelation();
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+		fillIndex(index, keys);
+
+		const int limit = 20;
+		const int ranges[] = {benchSize, 100000, 1000};
+		std::vector<RecordId> batch(1024);
+		for(int r = 0; r < 3; r++){
+			int queries = std::max(10, 2000000 / ranges[r]);
+			double seconds[2];
+			int wrong = 0;
+			for(int order = 0; order < 2; order++){
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int q = 0; q < queries; q++){
+					int low = (int)(((long)q * 7919) % (benchSize - ranges[r] + 1));
+					int high = low + ranges[r];
+					std::vector<RecordId> top;
+					if(order == 0){
+						BTreeCursor scan = index.openScan(&low, GTE, &high, LT);
+						size_t n;
+						while((n = scan.nextBatch(&batch[0], batch.size())) > 0){
+							top.insert(top.end(), batch.begin(), batch.begin() + n);
+							if(top.size() > (size_t)(2 * limit)){
+								top.erase(top.begin(), top.end() - limit);
+							}
+						}
+						top.erase(top.begin(), top.end() - std::min(top.size(), (size_t)limit));
+						std::reverse(top.begin(), top.end());
+					}
+					else{
+						BTreeCursor scan = index.openScan(&low, GTE, &high, LT, DESCENDING);
+						top.resize(limit);
+						top.resize(scan.nextBatch(&top[0], limit));
+					}
+					wrong += top.size() != (size_t)limit || top[0] != fakeRid(high - 1);
+				}
+				seconds[order] = secondsSince(start) / queries;
+			}
+
+			double rows[2];
+			for(int order = 0; order < 2; order++){
+				int low = 0;
+				int high = ranges[r];
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				long found = 0;
+				for(int q = 0; q < std::max(1, queries / 10); q++){
+					BTreeCursor scan = index.openScan(&low, GTE, &high, LT, order == 0 ? ASCENDING : DESCENDING);
+					size_t n;
+					while((n = scan.nextBatch(&batch[0], batch.size())) > 0){
+						found += n;
+					}
+				}
+				rows[order] = found / secondsSince(start) / 1e6;
+			}
+			std::cout << std::setw(12) << ranges[r] << std::fixed << std::setprecision(2)
+				<< std::setw(16) << seconds[0] * 1e6 << std::setw(16) << seconds[1] * 1e6
+				<< std::setw(16) << rows[0] << std::setw(16) << rows[1];
+			if(wrong > 0){
+				std::cout << "  (" << wrong << " wrong)";
+			}
+			std::cout << std::endl;
+		}
+	}
+	removeFiles(indexName);
+}
+
+// -----------------------------------------------------------------------------
+// benchCounted
+// -----------------------------------------------------------------------------
+void benchCounted()
+{
+	// counts of ranges of several widths from a scanNext loop and a nextBatch loop over an index with
+	// plain non-leaves, against countRange over one with counted non-leaves, and what the counts cost
+	// the inserts that keep them and the position of an entry found with select or a scan
+	std::cout << "---------------------" << std::endl;
+	std::cout << "range counts, " << benchSize << " keys" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(benchSize);
+	createEmptyRelation();
+	const int ranges[] = {benchSize, 100000, 1000, 10};
+	double seconds[4][3];
+	double build[2];
+	double selectSeconds[2];
+	int height[2];
+	int wrong = 0;
+	std::vector<RecordId> batch(1024);
+	for(int format = 0; format < 2; format++){
+		std::string indexName;
+		{
+			BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER, PLAIN_LEAVES,
+				format == 0 ? PLAIN_NONLEAVES : COUNTED_NONLEAVES);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			fillIndex(index, keys);
+			build[format] = secondsSince(start);
+			height[format] = index.height();
+
+			for(int r = 0; r < 4; r++){
+				int queries = std::max(10, 2000000 / ranges[r]);
+				for(int method = 0; method < 2; method++){
+					// countRange only on the counted index, the scan loops on the other
+					if(format == 1 && method == 1){
+						continue;
+					}
+					start = std::chrono::steady_clock::now();
+					for(int q = 0; q < queries; q++){
+						int low = (int)(((long)q * 7919) % (benchSize - ranges[r] + 1));
+						int high = low + ranges[r];
+						int found;
+						if(format == 1){
+							found = index.countRange(&low, GTE, &high, LT);
+						}
+						else if(method == 0){
+							found = countScan(&index, low, high);
+						}
+						else{
+							found = countBatches(&index, low, high, batch);
+						}
+						wrong += found != ranges[r];
+					}
+					seconds[r][format == 1 ? 2 : method] = secondsSince(start) / queries;
+				}
+			}
+
+			const int probes = format == 0 ? 20 : 100000;
+			start = std::chrono::steady_clock::now();
+			for(int q = 0; q < probes; q++){
+				size_t position = ((long)q * 7919) % benchSize;
+				int key;
+				RecordId rid;
+				wrong += !index.select(position, &key, rid) || key != (int)position;
+			}
+			selectSeconds[format] = secondsSince(start) / probes;
+		}
+		removeFiles(indexName);
+	}
+
+	std::cout << std::setw(12) << "range" << std::setw(14) << "scanNext us" << std::setw(14) << "nextBatch us"
+		<< std::setw(16) << "countRange us" << std::endl;
+	for(int r = 0; r < 4; r++){
+		std::cout << std::setw(12) << ranges[r] << std::fixed << std::setprecision(2)
+			<< std::setw(14) << seconds[r][0] * 1e6 << std::setw(14) << seconds[r][1] * 1e6
+			<< std::setw(16) << seconds[r][2] * 1e6 << std::endl;
+	}
+	std::cout << std::setw(12) << "nonleaves" << std::setw(8) << "height" << std::setw(12) << "build s"
+		<< std::setw(14) << "select us" << std::endl;
+	for(int format = 0; format < 2; format++){
+		std::cout << std::setw(12) << (format == 0 ? "plain" : "counted") << std::setw(8) << height[format]
+			<< std::fixed << std::setprecision(2) << std::setw(12) << build[format]
+			<< std::setw(14) << selectSeconds[format] * 1e6 << std::endl;
+	}
+	if(wrong > 0){
+		std::cout << "(" << wrong << " wrong)" << std::endl;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchHeapFetch
+// -----------------------------------------------------------------------------
+void benchHeapFetch()
+{
+	// records of ranges of several widths of an index over a relation in random key order, read a
+	// record id at a time in key order against HeapFetch, which reads them a page at a time. The
+	// relation has more pages than the buffer pool has frames
+	std::cout << "---------------------" << std::endl;
+	std::cout << "heap fetch, " << benchSize << " records in random order" << std::endl;
+
+	createRelationRandom(benchSize);
+	const int ranges[] = {10, 1000, 100000, benchSize};
+	double seconds[4][2];
+	double reads[4][2];
+	long wrong = 0;
+	std::vector<RecordId> batch(1024);
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER);
+		for(int r = 0; r < 4; r++){
+			int queries = std::max(2, 200000 / ranges[r]);
+			for(int method = 0; method < 2; method++){
+				// each method reads through its own file, whose pages leave the pool once it is done
+				PageFile file(relationName, false);
+				HeapFetch fetch(relationName, bufMgr, &index);
+				bufMgr->clearBufStats();
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int q = 0; q < queries; q++){
+					int low = (int)(((long)q * 7919) % (benchSize - ranges[r] + 1));
+					int high = low + ranges[r];
+					long sum = method == 0 ? directFetch(&index, &file, low, high, batch) : heapFetch(fetch, low, high);
+					wrong += sum != ((long)low + high - 1) * ranges[r] / 2;
+				}
+				seconds[r][method] = secondsSince(start) / queries;
+				reads[r][method] = (double)bufMgr->getBufStats().diskreads / queries;
+				bufMgr->flushFile(&file);
+			}
+		}
+	}
+	removeFiles(indexName);
+
+	std::cout << std::setw(12) << "range" << std::setw(14) << "direct us" << std::setw(14) << "direct reads"
+		<< std::setw(16) << "HeapFetch us" << std::setw(16) << "HeapFetch reads" << std::endl;
+	for(int r = 0; r < 4; r++){
+		std::cout << std::setw(12) << ranges[r] << std::fixed << std::setprecision(2)
+			<< std::setw(14) << seconds[r][0] * 1e6 << std::setw(14) << reads[r][0]
+			<< std::setw(16) << seconds[r][1] * 1e6 << std::setw(16) << reads[r][1] << std::endl;
+	}
+	if(wrong > 0){
+		std::cout << "(" << wrong << " wrong)" << std::endl;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// directFetch
+// -----------------------------------------------------------------------------
+long directFetch(BTreeIndex *index, PageFile *file, int lowVal, int highVal, std::vector<RecordId> &batch)
+{
+	// read the record of each entry of a range in key order. Returns the sum of the keys of the records
+	long sum = 0;
+	BTreeCursor scan = index->openScan(&lowVal, GTE, &highVal, LT);
+	size_t n;
+	while((n = scan.nextBatch(&batch[0], batch.size())) > 0){
+		for(size_t i = 0; i < n; i++){
+			Page *page;
+			bufMgr->readPage(file, batch[i].page_number, page);
+			sum += reinterpret_cast<const RECORD*>(page->getRecord(batch[i]).data())->i;
+			bufMgr->unPinPage(file, batch[i].page_number, false);
+		}
+	}
+	scan.endScan();
+	return sum;
+}
+
+// -----------------------------------------------------------------------------
+// heapFetch
+// -----------------------------------------------------------------------------
+long heapFetch(HeapFetch &fetch, int lowVal, int highVal)
+{
+	// read the records of a range with HeapFetch. Returns the sum of their keys
+	long sum = 0;
+	RecordId rid;
+	fetch.startScan(&lowVal, GTE, &highVal, LT);
+	try
+	{
+		while(1)
+		{
+			fetch.scanNext(rid);
+			sum += reinterpret_cast<const RECORD*>(fetch.getRecord().data())->i;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	fetch.endScan();
+	return sum;
+}
+
+// -----------------------------------------------------------------------------
+// benchCovering
+// -----------------------------------------------------------------------------
+void benchCovering()
+{
+	// what including attributes in the leaves costs in leaf entries, index size and build time, and
+	// what it saves scans of ranges of several widths of a relation in random key order that need the
+	// double field: read from the leaves of a covering index, against each record read by its id
+	std::cout << "---------------------" << std::endl;
+	std::cout << "covering index, " << benchSize << " records in random order" << std::endl;
+
+	createRelationRandom(benchSize);
+	const int configs = 3;
+	const int payloads[configs] = {0, 8, 28};
+	const int ranges[] = {100, 10000, benchSize};
+	double build[configs];
+	double megabytes[configs];
+	int capacity[configs];
+	int height[configs];
+	double seconds[3][2];
+	double reads[3][2];
+	long wrong = 0;
+	std::vector<RecordId> batch(1024);
+	std::vector<char> payload(batch.size() * MAXPAYLOADSIZE);
+	for(int c = 0; c < configs; c++){
+		std::vector<IncludedAttr> included;
+		if(payloads[c] > 0){
+			IncludedAttr d = {(int)offsetof(tuple,d), (int)sizeof(double)};
+			included.push_back(d);
+		}
+		if(payloads[c] > 8){
+			IncludedAttr str = {(int)offsetof(tuple,s), payloads[c] - 8};
+			included.push_back(str);
+		}
+		std::string indexName;
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			BTreeIndex index(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES,
+				PLAIN_NONLEAVES, included);
+			build[c] = secondsSince(start);
+			capacity[c] = index.leafCapacity();
+			height[c] = index.height();
+
+			// the plain index reads the records, the widest covering one reads the leaves only
+			for(int r = 0; r < 3 && c != 1; r++){
+				int method = c == 0 ? 0 : 1;
+				int queries = std::max(2, 200000 / ranges[r]);
+				PageFile file(relationName, false);
+				bufMgr->clearBufStats();
+				start = std::chrono::steady_clock::now();
+				for(int q = 0; q < queries; q++){
+					int low = (int)(((long)q * 7919) % (benchSize - ranges[r] + 1));
+					int high = low + ranges[r];
+					double sum = 0;
+					BTreeCursor scan = index.openScan(&low, GTE, &high, LT);
+					size_t n;
+					while((n = scan.nextBatch(&batch[0], batch.size(), method == 1 ? &payload[0] : nullptr)) > 0){
+						for(size_t i = 0; i < n; i++){
+							double value;
+							if(method == 1){
+								memcpy(&value, &payload[i * index.payloadSize()], sizeof(double));
+							}
+							else{
+								Page *page;
+								bufMgr->readPage(&file, batch[i].page_number, page);
+								value = reinterpret_cast<const RECORD*>(page->getRecord(batch[i]).data())->d;
+								bufMgr->unPinPage(&file, batch[i].page_number, false);
+							}
+							sum += value;
+						}
+					}
+					scan.endScan();
+					wrong += sum != ((double)low + high - 1) * ranges[r] / 2;
+				}
+				seconds[r][method] = secondsSince(start) / queries;
+				reads[r][method] = (double)bufMgr->getBufStats().diskreads / queries;
+				bufMgr->flushFile(&file);
+			}
+		}
+		megabytes[c] = fileSize(indexName) / 1048576.0;
+		removeFiles(indexName);
+	}
+
+	std::cout << std::setw(16) << "included bytes" << std::setw(16) << "leaf entries" << std::setw(12) << "index MB"
+		<< std::setw(8) << "height" << std::setw(12) << "build s" << std::endl;
+	for(int c = 0; c < configs; c++){
+		std::cout << std::setw(16) << payloads[c] << std::setw(16) << capacity[c] << std::fixed << std::setprecision(2)
+			<< std::setw(12) << megabytes[c] << std::setw(8) << height[c] << std::setw(12) << build[c] << std::endl;
+	}
+	std::cout << std::setw(12) << "range" << std::setw(16) << "index+heap us" << std::setw(14) << "reads"
+		<< std::setw(16) << "index only us" << std::setw(14) << "reads" << std::endl;
+	for(int r = 0; r < 3; r++){
+		std::cout << std::setw(12) << ranges[r] << std::fixed << std::setprecision(2)
+			<< std::setw(16) << seconds[r][0] * 1e6 << std::setw(14) << reads[r][0]
+			<< std::setw(16) << seconds[r][1] * 1e6 << std::setw(14) << reads[r][1] << std::endl;
+	}
+	if(wrong > 0){
+		std::cout << "(" << wrong << " wrong)" << std::endl;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchComposite
+// -----------------------------------------------------------------------------
+void benchComposite()
+{
+	// probes for the orders of a customer in a range of dates: a composite index on (customer, date)
+	// finds them in its leaves, an index on the customer alone reads every order of the customer and
+	// filters the dates. The relation has more pages than the buffer pool has frames. Customers with
+	// thousands of orders spread them over many leaves, which the composite index seeks past
+	const int perCustomers[] = {50, 5000};
+	for(int config = 0; config < 2; config++){
+		const int perCustomer = perCustomers[config];
+		const int customers = benchSize / perCustomer;
+		std::cout << "---------------------" << std::endl;
+		std::cout << "composite keys, " << customers << " customers with " << perCustomer << " orders each" << std::endl;
+
+		createRelationOrders(benchSize, perCustomer);
+		// the customer index reads every order of a customer, so fewer probes for the larger ones
+		const int queries = 1000000 / perCustomer;
+		const double dateFrom = perCustomer / 2;
+		const double dateTo = dateFrom + 10;
+		double build[2];
+		double megabytes[2];
+		double seconds[2];
+		double reads[2];
+		long wrong = 0;
+		std::vector<RecordId> batch(1024);
+		for(int method = 0; method < 2; method++){
+			std::string indexName;
+			{
+				std::vector<KeyAttr> keys(2);
+				keys[0].offset = offsetof(tuple,i);
+				keys[0].type = INTEGER;
+				keys[1].offset = offsetof(tuple,d);
+				keys[1].type = DOUBLE;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				BTreeIndex *index = method == 0 ? new BTreeIndex(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER)
+					: new BTreeIndex(relationName, indexName, bufMgr, keys);
+				build[method] = secondsSince(start);
+
+				PageFile file(relationName, false);
+				bufMgr->clearBufStats();
+				start = std::chrono::steady_clock::now();
+				for(int q = 0; q < queries; q++){
+					int customer = (int)(((long)q * 7919) % customers);
+					long found = 0;
+					if(method == 0){
+						BTreeCursor scan = index->openScan(&customer, GTE, &customer, LTE);
+						size_t n;
+						while((n = scan.nextBatch(&batch[0], batch.size())) > 0){
+							for(size_t i = 0; i < n; i++){
+								Page *page;
+								bufMgr->readPage(&file, batch[i].page_number, page);
+								double date = reinterpret_cast<const RECORD*>(page->getRecord(batch[i]).data())->d;
+								bufMgr->unPinPage(&file, batch[i].page_number, false);
+								found += date >= dateFrom && date < dateTo;
+							}
+						}
+						scan.endScan();
+					}
+					else{
+						const void *low[] = {&customer, &dateFrom};
+						const void *high[] = {&customer, &dateTo};
+						char lowKey[MAXPAYLOADSIZE];
+						char highKey[MAXPAYLOADSIZE];
+						int lowLength = index->encodePrefix(low, 2, lowKey);
+						int highLength = index->encodePrefix(high, 2, highKey);
+						std::vector<RecordId> rids;
+						found = index->lookupKeys(lowKey, lowLength, GTE, highKey, highLength, LT, rids);
+					}
+					wrong += found != dateTo - dateFrom;
+				}
+				seconds[method] = secondsSince(start) / queries;
+				reads[method] = (double)bufMgr->getBufStats().diskreads / queries;
+				bufMgr->flushFile(&file);
+				delete index;
+			}
+			megabytes[method] = fileSize(indexName) / 1048576.0;
+			removeFiles(indexName);
+		}
+
+		std::cout << std::setw(22) << "index" << std::setw(12) << "index MB" << std::setw(12) << "build s"
+			<< std::setw(12) << "probe us" << std::setw(14) << "probe reads" << std::endl;
+		const char *names[] = {"customer + heap", "(customer, date)"};
+		for(int method = 0; method < 2; method++){
+			std::cout << std::setw(22) << names[method] << std::fixed << std::setprecision(2) << std::setw(12) << megabytes[method]
+				<< std::setw(12) << build[method] << std::setw(12) << seconds[method] * 1e6
+				<< std::setw(14) << reads[method] << std::endl;
+		}
+		if(wrong > 0){
+			std::cout << "(" << wrong << " wrong)" << std::endl;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchStrings
+// -----------------------------------------------------------------------------
+void benchStrings()
+{
+	// point lookups of string keys sharing a long prefix, an index on the whole string with plain
+	// non-leaves, which keep whole keys, against compressed ones, which keep the prefix of a node once
+	// and separators cut short. The index has more pages than the buffer pool has frames
+	std::cout << "---------------------" << std::endl;
+	std::cout << "string keys, " << benchSize << " paths sharing their first 35 bytes" << std::endl;
+	createRelationPaths(benchSize);
+	const int queries = 200000;
+	int heights[2];
+	double build[2];
+	double megabytes[2];
+	double seconds[2];
+	double reads[2];
+	long wrong = 0;
+	for(int method = 0; method < 2; method++){
+		std::string indexName;
+		{
+			std::vector<KeyAttr> keys(1);
+			keys[0].offset = offsetof(tuple,s);
+			keys[0].type = STRING;
+			keys[0].length = 64;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			BTreeIndex index(relationName, indexName, bufMgr, keys, method == 0 ? PLAIN_NONLEAVES : COMPRESSED_NONLEAVES);
+			build[method] = secondsSince(start);
+			heights[method] = index.height();
+
+			bufMgr->clearBufStats();
+			start = std::chrono::steady_clock::now();
+			char s[64];
+			char key[MAXPAYLOADSIZE];
+			const void *values[] = {s};
+			std::vector<RecordId> rids;
+			for(int q = 0; q < queries; q++){
+				pathString((int)(((long)q * 7919) % benchSize), s);
+				index.encodePrefix(values, 1, key);
+				rids.clear();
+				wrong += index.lookupKeys(key, 64, EQ, key, 64, EQ, rids) != 1;
+			}
+			seconds[method] = secondsSince(start) / queries;
+			reads[method] = (double)bufMgr->getBufStats().diskreads / queries;
+		}
+		megabytes[method] = fileSize(indexName) / 1048576.0;
+		removeFiles(indexName);
+	}
+
+	std::cout << std::setw(22) << "non-leaves" << std::setw(10) << "height" << std::setw(12) << "index MB" << std::setw(12) << "build s"
+		<< std::setw(12) << "probe us" << std::setw(14) << "probe reads" << std::endl;
+	const char *names[] = {"plain", "compressed"};
+	for(int method = 0; method < 2; method++){
+		std::cout << std::setw(22) << names[method] << std::setw(10) << heights[method] << std::fixed << std::setprecision(2)
+			<< std::setw(12) << megabytes[method] << std::setw(12) << build[method] << std::setw(12) << seconds[method] * 1e6
+			<< std::setw(14) << reads[method] << std::endl;
+	}
+	if(wrong > 0){
+		std::cout << "(" << wrong << " wrong)" << std::endl;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchTable
+// -----------------------------------------------------------------------------
+void benchTable()
+{
+	// point lookups and range scans that read whole records: a relation in random key order with an
+	// index on the key, each record read by its id, against an index-organized table holding the
+	// records in its leaves. Both have more pages than the buffer pool has frames
+	std::cout << "---------------------" << std::endl;
+	std::cout << "index-organized table, " << benchSize << " records" << std::endl;
+
+	createRelationRandom(benchSize);
+	std::vector<int> keys = shuffledKeys(benchSize);
+	const int ranges[] = {1, 100, 10000};
+	double build[2];
+	double megabytes[2];
+	double seconds[3][2];
+	double reads[3][2];
+	long wrong = 0;
+	std::vector<RecordId> batch(1024);
+	for(int method = 0; method < 2; method++){
+		std::string indexName;
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			BTreeIndex *index;
+			if(method == 0){
+				index = new BTreeIndex(relationName, indexName, bufMgr, offsetof(tuple,i), INTEGER);
+			}
+			else{
+				index = new BTreeIndex(relationName, indexName, bufMgr, offsetof(tuple,i), sizeof(RECORD));
+				RECORD record;
+				memset(record.s, ' ', sizeof(record.s));
+				for(int i = 0; i < benchSize; i++){
+					sprintf(record.s, "%05d string record", keys[i]);
+					record.i = keys[i];
+					record.d = keys[i];
+					index->insertRecord(std::string(reinterpret_cast<char*>(&record), sizeof(RECORD)));
+				}
+			}
+			build[method] = secondsSince(start);
+
+			PageFile file(relationName, false);
+			TableScan scan(index);
+			for(int r = 0; r < 3; r++){
+				int queries = std::max(2, 200000 / ranges[r]);
+				bufMgr->clearBufStats();
+				start = std::chrono::steady_clock::now();
+				for(int q = 0; q < queries; q++){
+					int low = (int)(((long)q * 7919) % (benchSize - ranges[r] + 1));
+					int high = low + ranges[r];
+					double sum = 0;
+					if(method == 0){
+						BTreeCursor cursor = index->openScan(&low, GTE, &high, LT);
+						size_t n;
+						while((n = cursor.nextBatch(&batch[0], batch.size())) > 0){
+							for(size_t i = 0; i < n; i++){
+								Page *page;
+								bufMgr->readPage(&file, batch[i].page_number, page);
+								sum += reinterpret_cast<const RECORD*>(page->getRecord(batch[i]).data())->d;
+								bufMgr->unPinPage(&file, batch[i].page_number, false);
+							}
+						}
+						cursor.endScan();
+					}
+					else{
+						RecordId rowId;
+						scan.startScan(&low, GTE, &high, LT);
+						try
+						{
+							while(1)
+							{
+								scan.scanNext(rowId);
+								sum += reinterpret_cast<const RECORD*>(scan.getRecord().data())->d;
+							}
+						}
+						catch(IndexScanCompletedException e)
+						{
+						}
+						scan.endScan();
+					}
+					wrong += sum != ((double)low + high - 1) * ranges[r] / 2;
+				}
+				seconds[r][method] = secondsSince(start) / queries;
+				reads[r][method] = (double)bufMgr->getBufStats().diskreads / queries;
+			}
+			bufMgr->flushFile(&file);
+			delete index;
+		}
+		megabytes[method] = fileSize(indexName) / 1048576.0;
+		removeFiles(indexName);
+	}
+
+	std::cout << std::setw(22) << "storage" << std::setw(12) << "index MB" << std::setw(12) << "build s" << std::endl;
+	const char *names[] = {"relation + index", "index-organized"};
+	for(int method = 0; method < 2; method++){
+		std::cout << std::setw(22) << names[method] << std::fixed << std::setprecision(2) << std::setw(12) << megabytes[method]
+			<< std::setw(12) << build[method] << std::endl;
+	}
+	std::cout << std::setw(12) << "range" << std::setw(16) << "heap+index us" << std::setw(14) << "reads"
+		<< std::setw(16) << "organized us" << std::setw(14) << "reads" << std::endl;
+	for(int r = 0; r < 3; r++){
+		std::cout << std::setw(12) << ranges[r] << std::fixed << std::setprecision(2)
+			<< std::setw(16) << seconds[r][0] * 1e6 << std::setw(14) << reads[r][0]
+			<< std::setw(16) << seconds[r][1] * 1e6 << std::setw(14) << reads[r][1] << std::endl;
+	}
+	if(wrong > 0){
+		std::cout << "(" << wrong << " wrong)" << std::endl;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchHash
+// -----------------------------------------------------------------------------
+void benchHash()
+{
+	// point lookups of random keys in a B+ tree against a hash index holding the same keys, inserted in
+	// random order, at sizes that fit the buffer pool and that do not
+	std::cout << "---------------------" << std::endl;
+	std::cout << "hash index against B+ tree, point lookups" << std::endl;
+	std::cout << std::setw(12) << "keys" << std::setw(12) << "index" << std::setw(12) << "MB" << std::setw(12) << "build s"
+		<< std::setw(12) << "lookup us" << std::setw(14) << "lookup reads" << std::endl;
+
+	const int sizes[] = {benchSize, 10 * benchSize};
+	const int probes = 200000;
+	for(int s = 0; s < 2; s++){
+		std::vector<int> keys = shuffledKeys(sizes[s]);
+		for(int method = 0; method < 2; method++){
+			createEmptyRelation();
+			std::string indexName;
+			double build;
+			double seconds;
+			double reads;
+			int misses = 0;
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				BTreeIndex *tree = nullptr;
+				HashIndex *hash = nullptr;
+				if(method == 0){
+					tree = new BTreeIndex(relationName, indexName, bufMgr, 0, INTEGER);
+					fillIndex(*tree, keys);
+				}
+				else{
+					hash = new HashIndex(relationName, indexName, bufMgr, 0, INTEGER);
+					for(int i = 0; i < sizes[s]; i++){
+						hash->insertEntry(&keys[i], fakeRid(keys[i]));
+					}
+				}
+				build = secondsSince(start);
+
+				std::vector<RecordId> rids;
+				bufMgr->clearBufStats();
+				start = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i++){
+					int key = keys[((long)i * 7919) % sizes[s]];
+					rids.clear();
+					size_t found = method == 0 ? tree->lookup(&key, rids) : hash->lookup(&key, rids);
+					misses += found != 1;
+				}
+				seconds = secondsSince(start) / probes;
+				reads = (double)bufMgr->getBufStats().diskreads / probes;
+				delete tree;
+				delete hash;
+			}
+			double megabytes = fileSize(indexName) / 1048576.0;
+			removeFiles(indexName);
+			std::cout << std::setw(12) << sizes[s] << std::setw(12) << (method == 0 ? "B+ tree" : "hash")
+				<< std::fixed << std::setprecision(2) << std::setw(12) << megabytes << std::setw(12) << build
+				<< std::setw(12) << seconds * 1e6 << std::setw(14) << reads;
+			if(misses > 0){
+				std::cout << "  (" << misses << " probes missed)";
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	// inserts of one key over and over, which all go to one bucket and its ever longer chain
+	std::cout << std::setw(12) << "duplicates" << std::setw(12) << "insert us" << std::endl;
+	const int duplicates[] = {10000, 100000};
+	for(int d = 0; d < 2; d++){
+		createEmptyRelation();
+		std::string indexName;
+		{
+			HashIndex hash(relationName, indexName, bufMgr, 0, INTEGER);
+			int key = 42;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for(int i = 0; i < duplicates[d]; i++){
+				hash.insertEntry(&key, fakeRid(i));
+			}
+			std::cout << std::setw(12) << duplicates[d] << std::fixed << std::setprecision(2)
+				<< std::setw(12) << secondsSince(start) / duplicates[d] * 1e6 << std::endl;
+		}
+		removeFiles(indexName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// benchBuffered
+// -----------------------------------------------------------------------------
+void benchBuffered()
+{
+	// random inserts into an index about 10 times the size of its buffer pool, straight into the
+	// tree and through insert buffers of two sizes, then the cost of range scans and a full scan
+	// of the index that results
+	const int size = 2 * benchSize;
+	const int frames = 420;
+	const int ranges = 1000;
+	const int rangeSize = 1000;
+	std::cout << "---------------------" << std::endl;
+	std::cout << "buffered inserts, " << size << " random keys, " << frames << " page buffer pool" << std::endl;
+	std::cout << std::setw(10) << "buffer" << std::setw(12) << "MB" << std::setw(12) << "Kinserts/s"
+		<< std::setw(14) << "reads/insert" << std::setw(14) << "writes/insert" << std::setw(12) << "range us"
+		<< std::setw(12) << "range reads" << std::setw(12) << "full scan s" << std::endl;
+
+	std::vector<int> keys = shuffledKeys(size);
+	const size_t buffers[] = {0, 65536, 524288};
+	BufMgr *pool = new BufMgr(frames);
+	for(int b = 0; b < 3; b++){
+		createEmptyRelation();
+		std::string indexName;
+		double seconds;
+		double reads;
+		double writes;
+		double rangeSeconds;
+		double rangeReads;
+		double fullSeconds;
+		int misses = 0;
+		{
+			BTreeIndex index(relationName, indexName, pool, 0, INTEGER);
+			index.bufferInserts(buffers[b]);
+			pool->clearBufStats();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			fillIndex(index, keys);
+			index.flushInserts();
+			seconds = secondsSince(start);
+			reads = (double)pool->getBufStats().diskreads / size;
+			writes = (double)pool->getBufStats().diskwrites / size;
+
+			std::vector<RecordId> batch(1024);
+			pool->clearBufStats();
+			start = std::chrono::steady_clock::now();
+			for(int i = 0; i < ranges; i++){
+				int low = keys[i] % (size - rangeSize);
+				misses += countBatches(&index, low, low + rangeSize, batch) != rangeSize;
+			}
+			rangeSeconds = secondsSince(start) / ranges;
+			rangeReads = (double)pool->getBufStats().diskreads / ranges;
+
+			start = std::chrono::steady_clock::now();
+			misses += countBatches(&index, 0, size, batch) != size;
+			fullSeconds = secondsSince(start);
+		}
+		double megabytes = fileSize(indexName) / 1048576.0;
+		removeFiles(indexName);
+		std::cout << std::setw(10) << buffers[b] << std::fixed << std::setprecision(2) << std::setw(12) << megabytes
+			<< std::setw(12) << size / seconds / 1e3 << std::setw(14) << reads << std::setw(14) << writes
+			<< std::setw(12) << rangeSeconds * 1e6 << std::setw(12) << rangeReads << std::setw(12) << fullSeconds;
+		if(misses > 0){
+			std::cout << "  (" << misses << " scans short)";
+		}
+		std::cout << std::endl;
+	}
+	delete pool;
+}
+
+// -----------------------------------------------------------------------------
+// benchStatic
+// -----------------------------------------------------------------------------
+void benchStatic()
+{
+	// random point lookups, range scans of 1000 keys and a full scan of an index built by random inserts,
+	// against the static tree it freezes into, at a size that fits the buffer pool and one that does not
+	std::cout << "---------------------" << std::endl;
+	std::cout << "static tree against B+ tree" << std::endl;
+	std::cout << std::setw(12) << "keys" << std::setw(12) << "index" << std::setw(12) << "MB" << std::setw(12) << "height"
+		<< std::setw(12) << "lookup us" << std::setw(12) << "range us" << std::setw(14) << "full scan s" << std::endl;
+
+	const int sizes[] = {benchSize, 10 * benchSize};
+	const int probes = 200000;
+	const int ranges = 10000;
+	const int rangeSize = 1000;
+	const std::string staticName = std::string(relationName) + ".static";
+	for(int s = 0; s < 2; s++){
+		std::vector<int> keys = shuffledKeys(sizes[s]);
+		createEmptyRelation();
+		std::string indexName;
+		double lookupSeconds[2];
+		double rangeSeconds[2];
+		double fullSeconds[2];
+		double megabytes[2];
+		int height[2];
+		double freezeSeconds;
+		long misses = 0;
+		{
+			BTreeIndex index(relationName, indexName, bufMgr, 0, INTEGER);
+			fillIndex(index, keys);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			index.freeze(staticName);
+			freezeSeconds = secondsSince(start);
+			height[0] = index.height();
+
+			std::vector<RecordId> rids;
+			start = std::chrono::steady_clock::now();
+			for(int i = 0; i < probes; i++){
+				int key = keys[((long)i * 7919) % sizes[s]];
+				rids.clear();
+				misses += index.lookup(&key, rids) != 1;
+			}
+			lookupSeconds[0] = secondsSince(start) / probes;
+
+			std::vector<RecordId> batch(1024);
+			start = std::chrono::steady_clock::now();
+			for(int i = 0; i < ranges; i++){
+				int low = keys[i] % (sizes[s] - rangeSize);
+				misses += countBatches(&index, low, low + rangeSize, batch) != rangeSize;
+			}
+			rangeSeconds[0] = secondsSince(start) / ranges;
+
+			start = std::chrono::steady_clock::now();
+			misses += countBatches(&index, 0, sizes[s], batch) != sizes[s];
+			fullSeconds[0] = secondsSince(start);
+		}
+		megabytes[0] = fileSize(indexName) / 1048576.0;
+		removeFiles(indexName);
+
+		{
+			StaticTree tree(staticName);
+			height[1] = tree.height() + 1;
+			std::vector<RecordId> rids;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for(int i = 0; i < probes; i++){
+				int key = keys[((long)i * 7919) % sizes[s]];
+				rids.clear();
+				misses += tree.lookup(&key, rids) != 1;
+			}
+			lookupSeconds[1] = secondsSince(start) / probes;
+
+			// the record ids of a range are read where they lie in the mapping
+			long pages = 0;
+			start = std::chrono::steady_clock::now();
+			for(int i = 0; i < ranges; i++){
+				int low = keys[i] % (sizes[s] - rangeSize);
+				int high = low + rangeSize;
+				size_t begin;
+				size_t n = tree.range(&low, GTE, &high, LT, begin);
+				misses += n != (size_t)rangeSize;
+				for(size_t j = begin; j < begin + n; j++){
+					pages += tree.rids()[j].page_number;
+				}
+			}
+			rangeSeconds[1] = secondsSince(start) / ranges;
+
+			int low = 0;
+			int high = sizes[s];
+			size_t begin;
+			start = std::chrono::steady_clock::now();
+			size_t n = tree.range(&low, GTE, &high, LT, begin);
+			for(size_t j = begin; j < begin + n; j++){
+				pages += tree.rids()[j].page_number;
+			}
+			fullSeconds[1] = secondsSince(start);
+			misses += n != (size_t)sizes[s] || pages == 0;
+		}
+		megabytes[1] = fileSize(staticName) / 1048576.0;
+		removeFiles(staticName);
+
+		for(int method = 0; method < 2; method++){
+			std::cout << std::setw(12) << sizes[s] << std::setw(12) << (method == 0 ? "B+ tree" : "static")
+				<< std::fixed << std::setprecision(2) << std::setw(12) << megabytes[method] << std::setw(12) << height[method]
+				<< std::setw(12) << lookupSeconds[method] * 1e6 << std::setw(12) << rangeSeconds[method] * 1e6
+				<< std::setw(14) << fullSeconds[method];
+			if(method == 1){
+				std::cout << "  (frozen in " << freezeSeconds << " s)";
+			}
+			std::cout << std::endl;
+		}
+		if(misses > 0){
+			std::cout << "  (" << misses << " lookups or scans wrong)" << std::endl;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// distributedKeys
+// -----------------------------------------------------------------------------
+std::vector<int> distributedKeys(int size, int distribution)
+{
+	// sorted distinct keys, uniform over the positive ints, in clusters of consecutive keys at random
+	// places, or lognormal so that most of them crowd at the low end
+	std::mt19937 gen(564);
+	std::vector<int> keys;
+	while((int)keys.size() < size){
+		int want = size - keys.size();
+		if(distribution == 0){
+			std::uniform_int_distribution<int> pick(0, std::numeric_limits<int>::max() - 1);
+			for(int i = 0; i < want; i++){
+				keys.push_back(pick(gen));
+			}
+		}
+		else if(distribution == 1){
+			std::uniform_int_distribution<int> pick(0, std::numeric_limits<int>::max() - 10000);
+			for(int i = 0; i < want; i += 1000){
+				int start = pick(gen);
+				for(int j = 0; j < 1000 && i + j < want; j++){
+					keys.push_back(start + j);
+				}
+			}
+		}
+		else{
+			std::lognormal_distribution<double> pick(0, 2);
+			for(int i = 0; i < want; i++){
+				keys.push_back((int)std::min(pick(gen) * 1e6, (double)std::numeric_limits<int>::max() - 1));
+			}
+		}
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	}
+	return keys;
+}
+
+// -----------------------------------------------------------------------------
+// benchLearned
+// -----------------------------------------------------------------------------
+void benchLearned()
+{
+	// random lookups of a bulk loaded index descending the tree against going through a learned model of
+	// its leaves, for three key distributions. The index gets a buffer pool of its own that holds all of it,
+	// and the memory the non-leaf nodes take is what pinning them all takes
+	const int size = 10 * benchSize;
+	const int probes = 1000000;
+	const char *names[] = {"uniform", "clustered", "lognormal"};
+	std::cout << "---------------------" << std::endl;
+	std::cout << "learned leaves against tree descent, " << size << " keys, " << probes << " random lookups" << std::endl;
+	std::cout << std::setw(10) << "keys" << std::setw(8) << "error" << std::setw(10) << "segments" << std::setw(14) << "nonleaf KB"
+		<< std::setw(12) << "model KB" << std::setw(12) << "tree us" << std::setw(12) << "learned us" << std::endl;
+
+	BufMgr *pool = new BufMgr(20480);
+	for(int distribution = 0; distribution < 3; distribution++){
+		std::vector<int> keys = distributedKeys(size, distribution);
+		std::vector<int> probeKeys(probes);
+		std::mt19937 gen(564);
+		std::uniform_int_distribution<int> pick(0, size - 1);
+		for(int i = 0; i < probes; i++){
+			probeKeys[i] = keys[pick(gen)];
+		}
+		createEmptyRelation();
+		std::string indexName;
+		{
+			BTreeIndex index(relationName, indexName, pool, 0, INTEGER);
+			std::vector<RIDKeyPair<int> > batch(65536);
+			for(int i = 0; i < size; i += batch.size()){
+				size_t n = std::min(batch.size(), (size_t)(size - i));
+				for(size_t j = 0; j < n; j++){
+					batch[j].set(fakeRid(i + j), keys[i + j]);
+				}
+				index.insertBatch(&batch[0], n);
+			}
+			double nonleafKB = index.pinUpperLevels(index.height() - 1) * (double)Page::SIZE / 1024;
+			index.pinUpperLevels(0);
+
+			const int errors[] = {0, 2, 8, 32};
+			for(int e = 0; e < 4; e++){
+				double seconds[2];
+				size_t segments = 0;
+				size_t found = 0;
+				std::vector<RecordId> rids;
+				for(int method = 0; method < 2; method++){
+					if(method == 1){
+						segments = index.learnLeaves(errors[e]);
+					}
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					for(int i = 0; i < probes; i++){
+						rids.clear();
+						found += index.lookup(&probeKeys[i], rids);
+					}
+					seconds[method] = secondsSince(start) / probes;
+				}
+				std::cout << std::setw(10) << names[distribution] << std::setw(8) << errors[e] << std::setw(10) << segments
+					<< std::fixed << std::setprecision(2) << std::setw(14) << nonleafKB << std::setw(12) << index.learnedSize() / 1024.0
+					<< std::setw(12) << seconds[0] * 1e6 << std::setw(12) << seconds[1] * 1e6;
+				if(found != 2 * (size_t)probes){
+					std::cout << "  (" << found << " found)";
+				}
+				std::cout << std::endl;
+				// an insert and delete leave the model stale for the next descent measurement
+				RecordId rid = fakeRid(0);
+				index.insertEntry(&keys[0], rid);
+				index.deleteEntry(&keys[0], rid);
+			}
+		}
+		removeFiles(indexName);
+	}
+	delete pool;
+}
+
+// -----------------------------------------------------------------------------
+// benchBloom
+// -----------------------------------------------------------------------------
+void benchBloom()
+{
+	// point lookups of an index of the even keys with and without a Bloom filter of them, with odd keys
+	// making up the given share of the probes, and the probe rate of the filter on its own. The index gets
+	// a buffer pool of its own that holds all of it. The filter probes one word at a time and with AVX2
+	const int size = 10 * benchSize;
+	const int probes = 2000000;
+	std::cout << "---------------------" << std::endl;
+	std::cout << "bloom filter, " << size << " keys, " << probes << " random lookups" << std::endl;
+	std::cout << std::setw(8) << "miss %" << std::setw(12) << "tree us" << std::setw(12) << "bloom us"
+		<< std::setw(16) << "word probes/s" << std::setw(16) << "AVX2 probes/s" << std::setw(10) << "pass %" << std::endl;
+
+	BufMgr *pool = new BufMgr(20480);
+	createEmptyRelation();
+	std::string indexName;
+	{
+		BTreeIndex index(relationName, indexName, pool, 0, INTEGER);
+		std::vector<RIDKeyPair<int> > batch(65536);
+		for(int i = 0; i < size; i += batch.size()){
+			size_t n = std::min(batch.size(), (size_t)(size - i));
+			for(size_t j = 0; j < n; j++){
+				batch[j].set(fakeRid(i + j), 2 * (i + j));
+			}
+			index.insertBatch(&batch[0], n);
+		}
+
+		const int missRates[] = {0, 50, 99};
+		for(int m = 0; m < 3; m++){
+			std::vector<int> probeKeys(probes);
+			std::mt19937 gen(564);
+			std::uniform_int_distribution<int> pick(0, size - 1);
+			std::uniform_int_distribution<int> percent(0, 99);
+			for(int i = 0; i < probes; i++){
+				probeKeys[i] = 2 * pick(gen) + (percent(gen) < missRates[m]);
+			}
+			double seconds[2];
+			size_t found[2] = {0, 0};
+			std::vector<RecordId> rids;
+			for(int method = 0; method < 2; method++){
+				index.bloomFilter(method == 0 ? 0 : BLOOMBITSPERKEY, size);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i++){
+					rids.clear();
+					found[method] += index.lookup(&probeKeys[i], rids);
+				}
+				seconds[method] = secondsSince(start) / probes;
+			}
+
+			BloomFilter filter(BLOOMBITSPERKEY, size);
+			for(int i = 0; i < size; i++){
+				filter.insert(2 * i);
+			}
+			size_t passed = 0;
+			double filterSeconds[2] = {0, 0};
+			for(int wide = 0; wide < 2; wide++){
+				if(filter.vectorProbes(wide == 1) != (wide == 1)){
+					break;
+				}
+				passed = 0;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for(int i = 0; i < probes; i++){
+					passed += filter.mayContain(probeKeys[i]);
+				}
+				filterSeconds[wide] = secondsSince(start);
+			}
+			std::cout << std::setw(8) << missRates[m] << std::fixed << std::setprecision(2)
+				<< std::setw(12) << seconds[0] * 1e6 << std::setw(12) << seconds[1] * 1e6;
+			for(int wide = 0; wide < 2; wide++){
+				if(filterSeconds[wide] > 0){
+					std::cout << std::setw(14) << probes / filterSeconds[wide] / 1e6 << " M";
+				}
+				else{
+					std::cout << std::setw(16) << "-";
+				}
+			}
+			std::cout << std::setw(10) << passed * 100.0 / probes;
+			if(found[0] != found[1]){
+				std::cout << "  (" << found[0] << " against " << found[1] << " found)";
+			}
+			std::cout << std::endl;
+		}
+		index.bloomFilter(0);
+	}
+	removeFiles(indexName);
+	delete pool;
+}
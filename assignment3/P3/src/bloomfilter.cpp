@@ -0,0 +1,213 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#ifdef __SSE2__
+#include <immintrin.h>
+#endif
+#include "bloomfilter.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/file_open_exception.h"
+
+namespace badgerdb
+{
+
+// odd constants the hash is multiplied with for the bit of each word, as in the split block
+// Bloom filters of Impala and Parquet
+static const std::uint32_t bloomSalts[ BLOOMHASHES ] = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+	0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+#ifdef __SSE2__
+// the bit of every word of the half block at once, the key may be there if none of them is clear. Built
+// for AVX2 whatever the build flags are and only called once the processor is known to have it
+__attribute__((target("avx2")))
+static bool probeWide(const std::uint32_t *half, std::uint32_t hash)
+{
+	const __m256i salts = _mm256_loadu_si256((const __m256i *)bloomSalts);
+	__m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(hash), salts), 27);
+	__m256i bits = _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+	return _mm256_testc_si256(_mm256_load_si256((const __m256i *)half), bits);
+}
+#endif
+
+// the bits one word at a time
+static bool probeNarrow(const std::uint32_t *half, std::uint32_t hash)
+{
+	std::uint32_t missing = 0;
+	for(int i = 0; i < BLOOMHASHES; i++){
+		missing |= ~half[i] & (1u << ((hash * bloomSalts[i]) >> 27));
+	}
+	return missing == 0;
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::BloomFilter -- Constructor
+// -----------------------------------------------------------------------------
+
+BloomFilter::BloomFilter(int bitsPerKey, std::uint64_t keys)
+{
+	this->bitsPerKey = std::max(bitsPerKey, 1);
+	const std::uint64_t blockBits = BLOOMBLOCKWORDS * 32;
+	allocate(std::max<std::uint64_t>((std::max<std::uint64_t>(keys, 1) * this->bitsPerKey + blockBits - 1) / blockBits, 1));
+	vectorProbes(true);
+}
+
+BloomFilter::BloomFilter(const std::string &fileName, std::uint64_t stamp)
+{
+	std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+	if(!in){
+		throw FileNotFoundException(fileName);
+	}
+	BloomMetaInfo meta;
+	in.read((char *)&meta, sizeof(meta));
+	if(!in || strncmp(meta.magic, "BDBBLOOM", sizeof(meta.magic)) != 0 || meta.stamp != stamp
+		|| meta.bitsPerKey <= 0 || meta.blockCount <= 0){
+		throw BadIndexInfoException(fileName);
+	}
+	bitsPerKey = meta.bitsPerKey;
+	allocate(meta.blockCount);
+	vectorProbes(true);
+	in.read((char *)words, blockCount * BLOOMBLOCKWORDS * sizeof(std::uint32_t));
+	if(!in){
+		throw BadIndexInfoException(fileName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::write
+// -----------------------------------------------------------------------------
+
+const void BloomFilter::write(const std::string &fileName, std::uint64_t stamp)
+{
+	BloomMetaInfo meta;
+	memset(&meta, 0, sizeof(meta));
+	memcpy(meta.magic, "BDBBLOOM", sizeof(meta.magic));
+	meta.stamp = stamp;
+	meta.bitsPerKey = bitsPerKey;
+	meta.blockCount = blockCount;
+	std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write((const char *)&meta, sizeof(meta));
+	out.write((const char *)words, blockCount * BLOOMBLOCKWORDS * sizeof(std::uint32_t));
+	if(!out){
+		throw FileOpenException(fileName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::insert
+// -----------------------------------------------------------------------------
+
+const void BloomFilter::insert(int key)
+{
+	std::uint32_t hash;
+	std::uint32_t *half = (std::uint32_t *)locate(key, hash);
+	for(int i = 0; i < BLOOMHASHES; i++){
+		__atomic_fetch_or(half + i, 1u << ((hash * bloomSalts[i]) >> 27), __ATOMIC_RELAXED);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::mayContain
+// -----------------------------------------------------------------------------
+
+const bool BloomFilter::mayContain(int key)
+{
+	std::uint32_t hash;
+	const std::uint32_t *half = locate(key, hash);
+#ifdef __SSE2__
+	if(wideProbes){
+		return probeWide(half, hash);
+	}
+#endif
+	return probeNarrow(half, hash);
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::vectorProbes
+// -----------------------------------------------------------------------------
+
+const bool BloomFilter::vectorProbes(bool enable)
+{
+#ifdef __SSE2__
+	wideProbes = enable && __builtin_cpu_supports("avx2");
+#else
+	wideProbes = false;
+#endif
+	return wideProbes;
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::fill
+// -----------------------------------------------------------------------------
+
+const double BloomFilter::fill()
+{
+	std::uint64_t set = 0;
+	for(std::uint64_t i = 0; i < blockCount * BLOOMBLOCKWORDS; i++){
+		set += __builtin_popcount(words[i]);
+	}
+	return (double)set / (blockCount * BLOOMBLOCKWORDS * 32);
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::designFill
+// -----------------------------------------------------------------------------
+
+const double BloomFilter::designFill()
+{
+	return 1 - std::exp(-(double)BLOOMHASHES / bitsPerKey);
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::bits
+// -----------------------------------------------------------------------------
+
+const int BloomFilter::bits()
+{
+	return bitsPerKey;
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::size
+// -----------------------------------------------------------------------------
+
+const size_t BloomFilter::size()
+{
+	return blockCount * BLOOMBLOCKWORDS * sizeof(std::uint32_t);
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::allocate
+// -----------------------------------------------------------------------------
+const void BloomFilter::allocate(std::uint64_t blocks){
+	blockCount = blocks;
+	storage.assign(blocks * BLOOMBLOCKWORDS + BLOOMBLOCKWORDS, 0);
+	std::uintptr_t start = (std::uintptr_t)&storage[0];
+	words = &storage[0] + ((64 - start % 64) % 64) / sizeof(std::uint32_t);
+}
+
+// -----------------------------------------------------------------------------
+// BloomFilter::locate
+// -----------------------------------------------------------------------------
+const std::uint32_t* BloomFilter::locate(int key, std::uint32_t &hash){
+	// mix the key into 64 bits: the top 31 pick the block, the next one the half and the low 32 the bits
+	std::uint64_t h = (std::uint32_t)key;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	std::uint64_t block = ((h >> 33) * blockCount) >> 31;
+	hash = (std::uint32_t)h;
+	return words + block * BLOOMBLOCKWORDS + ((h >> 32) & 1) * (BLOOMBLOCKWORDS / 2);
+}
+
+}
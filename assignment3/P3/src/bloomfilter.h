@@ -0,0 +1,174 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace badgerdb
+{
+
+/**
+ * @brief Number of 32 bit words in a block of a BloomFilter, one cache line of them.
+ */
+const int BLOOMBLOCKWORDS = 16;
+
+/**
+ * @brief Number of bits a key sets in a BloomFilter, one in each word of half a block.
+ */
+const int BLOOMHASHES = 8;
+
+/**
+ * @brief Default number of bits of a BloomFilter per key it is sized for, for about 1% false positives.
+ */
+const int BLOOMBITSPERKEY = 10;
+
+/**
+ * @brief The header at the start of a Bloom filter file, followed by the blocks.
+*/
+struct BloomMetaInfo{
+  /**
+   * "BDBBLOOM", checked when the file is read.
+   */
+	char magic[8];
+
+  /**
+   * Stamp the file was written with, which the index it belongs to keeps too.
+   */
+	std::uint64_t stamp;
+
+  /**
+   * Bits per key the filter was sized with.
+   */
+	int bitsPerKey;
+
+  /**
+   * Number of blocks.
+   */
+	std::int64_t blockCount;
+};
+
+/**
+ * @brief Blocked Bloom filter of INTEGER keys. A key hashes to one block of BLOOMBLOCKWORDS words and sets
+ * one bit in each word of one half of it, picked by multiplying the hash with a different odd constant for
+ * every word. A probe therefore reads a single cache line and tests all of its bits at once, with AVX2 when
+ * the processor has it, whatever the build flags are. Inserts set their bits with atomic ors, so any number
+ * of threads may insert and probe at once. Keys cannot be removed, so deleted keys only add false positives.
+*/
+class BloomFilter {
+
+ private:
+
+  /**
+   * Storage of the blocks, with room to start them at a cache line boundary.
+   */
+	std::vector<std::uint32_t>	storage;
+
+  /**
+   * First word of the first block, inside storage.
+   */
+	std::uint32_t	*words;
+
+  /**
+   * Number of blocks.
+   */
+	std::uint64_t	blockCount;
+
+  /**
+   * Bits per key the filter was sized with.
+   */
+	int			bitsPerKey;
+
+  /**
+   * True if probes test the bits of a key with AVX2 rather than one word at a time.
+   */
+	bool		wideProbes;
+
+	BloomFilter(const BloomFilter &other);
+	BloomFilter & operator=(const BloomFilter &other);
+
+ public:
+
+  /**
+   * BloomFilter Constructor.
+	 * Make an empty filter for the given number of keys.
+   *
+   * @param bitsPerKey	Bits per key, more give fewer false positives
+   * @param keys				Number of keys the filter is sized for
+   */
+	BloomFilter(int bitsPerKey, std::uint64_t keys);
+
+  /**
+   * BloomFilter Constructor.
+	 * Read a filter written by write().
+   *
+   * @param fileName	Name of the file
+   * @param stamp			Stamp the file has to have been written with
+   * @throws  FileNotFoundException     If the file does not exist.
+   * @throws  BadIndexInfoException     If the file is not a Bloom filter or has another stamp.
+   */
+	BloomFilter(const std::string &fileName, std::uint64_t stamp);
+
+  /**
+	 * Write the filter to a file, replacing it if it exists.
+   * @param fileName	Name of the file
+   * @param stamp			Stamp to write with, for the reader to check
+   * @throws  FileOpenException If the file cannot be written.
+	**/
+	const void write(const std::string &fileName, std::uint64_t stamp);
+
+  /**
+	 * Add a key to the filter.
+   * @param key			Key to add
+	**/
+	const void insert(int key);
+
+  /**
+	 * Probe the filter for a key.
+   * @param key			Key to probe for
+   * @return  False if the key was never added, true if it may have been
+	**/
+	const bool mayContain(int key);
+
+  /**
+	 * Choose how probes test the bits of a key. Filters start out probing with AVX2 when the processor
+	 * has it, both ways give the same answers.
+   * @param enable	True to probe with AVX2 if the processor has it, false to test one word at a time
+   * @return  True if probes use AVX2 from now on
+	**/
+	const bool vectorProbes(bool enable);
+
+  /**
+	 * Share of the bits of the filter that are set.
+	**/
+	const double fill();
+
+  /**
+	 * Share of bits a filter of this size holding the keys it was sized for would have set.
+	**/
+	const double designFill();
+
+  /**
+	 * Bits per key the filter was sized with.
+	**/
+	const int bits();
+
+  /**
+	 * Bytes of memory the blocks take.
+	**/
+	const size_t size();
+
+ private:
+	// make room for the given number of zeroed blocks
+	const void allocate(std::uint64_t blocks);
+	// first word of the half block the hash of a key falls in, and the hash its bits are taken from
+	const std::uint32_t* locate(int key, std::uint32_t &hash);
+};
+
+}
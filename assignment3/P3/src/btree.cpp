@@ -5,8 +5,17 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "btree.h"
 #include "filescan.h"
+#include "statictree.h"
 #include "exceptions/bad_index_info_exception.h"
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/bad_scanrange_exception.h"
@@ -30,17 +39,148 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 		std::string & outIndexName,
 		BufMgr *bufMgrIn,
 		const int attrByteOffset,
-		const Datatype attrType)
+		const Datatype attrType,
+		const LeafFormat leafFormat,
+		const NonLeafFormat nonLeafFormat,
+		const std::vector<IncludedAttr> &included)
+	: BTreeIndex(relationName, outIndexName, bufMgrIn, attrByteOffset, attrType, leafFormat, nonLeafFormat,
+		included, std::vector<KeyAttr>())
 {
+}
+
+BTreeIndex::BTreeIndex(const std::string & relationName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const std::vector<KeyAttr> &keys,
+		const NonLeafFormat nonLeafFormat)
+	: BTreeIndex(relationName, outIndexName, bufMgrIn, keys.empty() ? -1 : keys[0].offset, INTEGER, PLAIN_LEAVES,
+		nonLeafFormat, std::vector<IncludedAttr>(), keys)
+{
+}
+
+BTreeIndex::BTreeIndex(const std::string & tableName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const int attrByteOffset,
+		const int recordLength,
+		const NonLeafFormat nonLeafFormat)
+	: BTreeIndex(tableName, outIndexName, bufMgrIn, attrByteOffset, INTEGER, RECORD_LEAVES, nonLeafFormat,
+		std::vector<IncludedAttr>(1, IncludedAttr{0, recordLength}), std::vector<KeyAttr>())
+{
+}
+
+BTreeIndex::BTreeIndex(const std::string & relationName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const int attrByteOffset,
+		const Datatype attrType,
+		const LeafFormat leafFormat,
+		const NonLeafFormat nonLeafFormat,
+		const std::vector<IncludedAttr> &included,
+		const std::vector<KeyAttr> &keys)
+{
+	blockedNonleaves = nonLeafFormat == BLOCKED_NONLEAVES;
+	countedNonleaves = nonLeafFormat == COUNTED_NONLEAVES;
+	compressedNonleaves = nonLeafFormat == COMPRESSED_NONLEAVES;
 	leafOccupancy = INTARRAYLEAFSIZE;
-	nodeOccupancy = INTARRAYNONLEAFSIZE;
-	scanExecuting = false;
+	nodeOccupancy = blockedNonleaves ? INTARRAYBLOCKEDSIZE : INTARRAYNONLEAFSIZE;
+	if(countedNonleaves){
+		nodeOccupancy = INTARRAYCOUNTEDSIZE;
+	}
+	if(compressedNonleaves){
+		nodeOccupancy = INTARRAYCOMPRESSEDSIZE;
+	}
+	crowdedNode = 0;
+	packedLeaves = leafFormat == PACKED_LEAVES;
 	bufMgr = bufMgrIn;
+	rightmostLeaf = 0;
+	rightmostLowKey = 0;
+	pinnedLevels = 0;
+	pinnedCount = 0;
+	swizzling = true;
+	learnedError = LEARNEDERROR;
+	learnedFresh = false;
+	bloom = nullptr;
+	includedAttrs = included;
+	payloadBytes = 0;
+	relationFile = nullptr;
+	keyAttrs = keys;
+	recordLeaves = leafFormat == RECORD_LEAVES;
+	nextRowId = 1;
+	insertBufferLimit = 0;
+	bufferedCount = 0;
+	this->attrByteOffset = attrByteOffset;
+	attributeType = attrType;
 
 	std::ostringstream index_string;
 	index_string << relationName << "." << attrByteOffset;
+	if(!keys.empty()){
+		index_string.str("");
+		index_string << relationName << ".key";
+		for(size_t i = 0; i < keys.size(); i++){
+			index_string << "." << keys[i].offset;
+		}
+	}
+	if(recordLeaves){
+		index_string.str("");
+		index_string << relationName << ".iot";
+	}
 	outIndexName = index_string.str();
 
+	// a negative offset is no attribute at all, which is also what an empty composite key comes as.
+	// it would otherwise open whatever index is on offset 0
+	if(attrByteOffset < 0){
+		throw BadIndexInfoException(outIndexName);
+	}
+
+	// only integer keys have node layouts, the first bytes of a string or double attribute would
+	// silently be indexed as an int. they are indexed as composite keys of one attribute instead
+	if(attrType != INTEGER){
+		throw BadIndexInfoException(outIndexName);
+	}
+
+	// included attributes take the slots of the rid array past the entries of a plain leaf
+	if(included.size() > (size_t)MAXINCLUDED || (packedLeaves && !included.empty())){
+		throw BadIndexInfoException(outIndexName);
+	}
+	for(size_t i = 0; i < included.size(); i++){
+		if(included[i].offset < 0 || included[i].length <= 0){
+			throw BadIndexInfoException(outIndexName);
+		}
+		payloadBytes += included[i].length;
+	}
+	// a composite key is kept whole where included attributes would be, and where the directory of a
+	// blocked non leaf would be for its separators
+	if(keys.size() > (size_t)MAXKEYATTRS || (!keys.empty() && (packedLeaves || !included.empty() || blockedNonleaves))){
+		throw BadIndexInfoException(outIndexName);
+	}
+	// compressed non leaves only hold the separators of normalized keys
+	if(compressedNonleaves && keys.empty()){
+		throw BadIndexInfoException(outIndexName);
+	}
+	for(size_t i = 0; i < keys.size(); i++){
+		if(keys[i].offset < 0 || (keys[i].type == STRING && keys[i].length <= 0)){
+			throw BadIndexInfoException(outIndexName);
+		}
+		payloadBytes += keys[i].type == INTEGER ? sizeof(int) : keys[i].type == DOUBLE ? sizeof(double) : keys[i].length;
+	}
+	// the record of an index-organized table is included whole and has to hold its key
+	if(recordLeaves && (included.size() != 1 || included[0].offset != 0
+		|| attrByteOffset + (int)sizeof(int) > included[0].length || !keys.empty())){
+		throw BadIndexInfoException(outIndexName);
+	}
+	if(payloadBytes > (recordLeaves ? MAXRECORDSIZE : MAXPAYLOADSIZE)){
+		throw BadIndexInfoException(outIndexName);
+	}
+	leafOccupancy = INTARRAYLEAFSIZE * sizeof(RecordId) / (sizeof(RecordId) + payloadBytes);
+	if(!keys.empty() && !compressedNonleaves){
+		// the whole keys of the separators take the slots of pageNoArray past the children
+		nodeOccupancy = std::min(nodeOccupancy, INTARRAYNONLEAFSIZE * (int)sizeof(PageId) / ((int)sizeof(PageId) + payloadBytes));
+	}
+	if(!included.empty() && !recordLeaves){
+		relationFile = new PageFile(relationName, false);
+	}
+
 	try{
 		file = new BlobFile(outIndexName, false);
 		headerPageNum = file->getFirstPageNo();
@@ -48,11 +188,37 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 		bufMgr->readPage(file, headerPageNum, header_Page);
 		IndexMetaInfo *m = (IndexMetaInfo *)header_Page;
 		rootPageNum = m->rootPageNo;
-		if (relationName != m->relationName || attrType != m->attrType 
-			|| attrByteOffset != m->attrByteOffset){
+		initialroot = m->leafRootPageNo;
+		nextRowId = m->nextRowId;
+		// nothing else of a file in another layout is looked at
+		bool sameLayout = m->magic == INDEXMAGIC && m->version == INDEXVERSION;
+		bool sameIncluded = sameLayout && m->includedCount == (int)included.size();
+		for(int i = 0; sameIncluded && i < m->includedCount; i++){
+			sameIncluded = m->included[i].offset == included[i].offset && m->included[i].length == included[i].length;
+		}
+		bool sameKeys = sameLayout && m->keyCount == (int)keys.size();
+		for(int i = 0; sameKeys && i < m->keyCount; i++){
+			sameKeys = m->keys[i].offset == keys[i].offset && m->keys[i].type == keys[i].type
+				&& (keys[i].type != STRING || m->keys[i].length == keys[i].length);
+		}
+		if (!sameLayout || relationName != m->relationName || attrType != m->attrType 
+			|| attrByteOffset != m->attrByteOffset || leafFormat != m->leafFormat
+			|| nonLeafFormat != m->nonLeafFormat || !sameIncluded || !sameKeys){
+			// close the files again, the index object is never constructed
+			bufMgr->unPinPage(file, headerPageNum, false);
+			bufMgr->flushFile(file);
+			delete file;
+			if(relationFile != nullptr){
+				delete relationFile;
+			}
 			throw BadIndexInfoException(outIndexName);
 		}
+		int bloomBits = m->bloomBits;
+		std::uint64_t bloomStamp = m->bloomStamp;
 		bufMgr->unPinPage(file, headerPageNum, false);
+		if(bloomBits > 0){
+			openBloom(bloomBits, bloomStamp);
+		}
 	}
 	catch(FileNotFoundException e){
 		file = new BlobFile(outIndexName, true);
@@ -62,26 +228,62 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 		bufMgr->allocPage(file, rootPageNum, rootPage);
 
 		IndexMetaInfo *m = (IndexMetaInfo *)header_Page;
+		m->magic = INDEXMAGIC;
+		m->version = INDEXVERSION;
 		m->attrByteOffset = attrByteOffset;
 		m->attrType = attrType;
 		m->rootPageNo = rootPageNum;
+		m->leafRootPageNo = rootPageNum;
+		m->leafFormat = leafFormat;
+		m->nonLeafFormat = nonLeafFormat;
+		m->includedCount = included.size();
+		for(size_t i = 0; i < included.size(); i++){
+			m->included[i] = included[i];
+		}
+		m->keyCount = keys.size();
+		for(size_t i = 0; i < keys.size(); i++){
+			m->keys[i] = keys[i];
+		}
+		m->nextRowId = nextRowId;
+		m->bloomBits = 0;
+		m->bloomStamp = 0;
 		strncpy((char *)(&(m->relationName)), relationName.c_str(), 20);
 		m->relationName[19] = 0;
 		initialroot = rootPageNum;
 
-		LeafNodeInt *root = (LeafNodeInt *)rootPage;
-		root->rightSibPageNo = 0;
+		if(packedLeaves){
+			PackedLeafInt *root = (PackedLeafInt *)rootPage;
+			packedEncode(root, nullptr, nullptr, 0);
+			root->rightSibPageNo = 0;
+			root->leftSibPageNo = 0;
+		}
+		else{
+			LeafNodeInt *root = (LeafNodeInt *)rootPage;
+			root->rightSibPageNo = 0;
+			root->leftSibPageNo = 0;
+		}
 
 		bufMgr->unPinPage(file, headerPageNum, true);
 		bufMgr->unPinPage(file, rootPageNum, true);
 
+		// an index-organized table starts empty, there is no relation to read
+		if(recordLeaves){
+			bufMgr->flushFile(file);
+			return;
+		}
 		FileScan fileScan(relationName, bufMgr);
 		RecordId rid;
 		try{
 			while(1){
 				fileScan.scanNext(rid);
 				std::string record = fileScan.getRecord();
-				insertEntry(record.c_str() + attrByteOffset, rid);
+				if(!keyAttrs.empty()){
+					char key[MAXPAYLOADSIZE];
+					encodeKey(record.c_str(), key);
+					insertEntry(key, rid);
+					continue;
+				}
+				insertEntry(record.c_str() + attrByteOffset, rid, record.c_str());
 			}
 		}
 		catch(EndOfFileException e){
@@ -97,10 +299,33 @@ BTreeIndex::BTreeIndex(const std::string & relationName,
 
 BTreeIndex::~BTreeIndex()
 {
-	scanExecuting = false;
+	flushInserts();
+	unpinNodes();
+	if(recordLeaves){
+		Page *header_Page;
+		bufMgr->readPage(file, headerPageNum, header_Page);
+		((IndexMetaInfo *)header_Page)->nextRowId = nextRowId;
+		bufMgr->unPinPage(file, headerPageNum, true);
+	}
+	if(bloom != nullptr){
+		// a new stamp, so that the file of an earlier close is never taken for this one
+		std::uint64_t stamp = std::chrono::system_clock::now().time_since_epoch().count() | 1;
+		bloom->write(file->filename() + ".bloom", stamp);
+		Page *header_Page;
+		bufMgr->readPage(file, headerPageNum, header_Page);
+		((IndexMetaInfo *)header_Page)->bloomStamp = stamp;
+		bufMgr->unPinPage(file, headerPageNum, true);
+		delete bloom;
+		bloom = nullptr;
+	}
 	bufMgr->flushFile(BTreeIndex::file);
 	delete file;
 	file = nullptr;
+	if(relationFile != nullptr){
+		bufMgr->flushFile(relationFile);
+		delete relationFile;
+		relationFile = nullptr;
+	}
 }
 
 // -----------------------------------------------------------------------------
@@ -109,353 +334,4852 @@ BTreeIndex::~BTreeIndex()
 
 const void BTreeIndex::insertEntry(const void *key, const RecordId rid) 
 {
-	RIDKeyPair<int> data;
-	data.set(rid, *((int *)key));
-	Page* root;
-	bufMgr->readPage(file, rootPageNum, root);
-	PageKeyPair<int> *newChild = nullptr;
-	insert(root, rootPageNum, initialroot == rootPageNum ? true : false, data, newChild);
+	if(insertBufferLimit > 0){
+		std::unique_lock<std::mutex> guard(bufferMutex);
+		// checked again, bufferInserts(0) may have stopped buffering meanwhile
+		if(insertBufferLimit > 0){
+			RIDKeyPair<int> entry;
+			entry.set(rid, *((int *)key));
+			insertBuffer.push_back(entry);
+			bufferedCount++;
+			bool full = insertBuffer.size() >= insertBufferLimit;
+			guard.unlock();
+			if(full){
+				flushInserts();
+			}
+			return;
+		}
+	}
+	insertEntry(key, rid, nullptr);
 }
 
-// -----------------------------------------------------------------------------
-// BTreeIndex::startScan
-// -----------------------------------------------------------------------------
-
-const void BTreeIndex::startScan(const void* lowValParm,
-				   const Operator lowOpParm,
-				   const void* highValParm,
-				   const Operator highOpParm)
+const void BTreeIndex::insertEntry(const void *key, const RecordId rid, const char *record)
 {
-	lowValInt = *((int *)lowValParm);
-	highValInt = *((int *)highValParm);
-	if(lowValInt > highValInt){
-		throw BadScanrangeException();
+	if(learnedFresh.load(std::memory_order_relaxed)){
+		learnedFresh = false;
 	}
-	if(!((lowOpParm == GT or lowOpParm == GTE) and (highOpParm == LT or highOpParm == LTE))){
-		throw BadOpcodesException();
+	RIDKeyPair<int> data;
+	char payload[MAXRECORDSIZE];
+	if(!keyAttrs.empty()){
+		// the leaf entry keeps the whole normalized key, the tree goes by its first bytes
+		memcpy(payload, key, payloadBytes);
+		data.set(rid, keyPrefix(payload, payloadBytes, 0));
 	}
-
-	lowOp = lowOpParm;
-	highOp = highOpParm;
-
-	if(scanExecuting){
-		endScan();
+	else{
+		data.set(rid, *((int *)key));
 	}
-	currentPageNum = rootPageNum;
-	bufMgr->readPage(file, currentPageNum, currentPageData);
-
-	if(initialroot != rootPageNum){
-		NonLeafNodeInt* currentNode = (NonLeafNodeInt *) currentPageData;
-		bool foundLeaf = false;
-		while(!foundLeaf) {
-			currentNode = (NonLeafNodeInt *) currentPageData;
-			if(currentNode->level == 1){
-				foundLeaf = true;
-			}
-
-			PageId nextPageNum;
-			nextNonleaf(currentNode, nextPageNum, lowValInt);
-			bufMgr->unPinPage(file, currentPageNum, false);
-			currentPageNum = nextPageNum;
-			bufMgr->readPage(file, currentPageNum, currentPageData);
-		}
+	// the key is in the filter before a lookup can find it in the tree
+	if(bloom != nullptr){
+		bloom->insert(data.key);
 	}
-	bool found = false;
-	while(!found){
-		LeafNodeInt* currentNode = (LeafNodeInt *) currentPageData;
-		if(currentNode->ridArray[0].page_number == 0){
-			bufMgr->unPinPage(file, currentPageNum, false);
-			throw NoSuchKeyFoundException();
+	if(!includedAttrs.empty()){
+		if(record == nullptr && recordLeaves){
+			throw BadIndexInfoException(file->filename());
 		}
-		bool nullVal = false;
-		for(int i = 0; i < leafOccupancy and !nullVal; i++){
-			int key = currentNode->keyArray[i];
-			if(i < leafOccupancy - 1 and currentNode->ridArray[i + 1].page_number == 0){
-				nullVal = true;
-			}
-			if(checkKey(lowValInt, lowOp, highValInt, highOp, key)){
-				nextEntry = i;
-				found = true;
-				scanExecuting = true;
-				break;
-			}
-			else if((highOp == LT and key >= highValInt) or (highOp == LTE and key > highValInt)){
-				bufMgr->unPinPage(file, currentPageNum, false);
-				throw NoSuchKeyFoundException();
-			}
-			if(i == leafOccupancy - 1 or nullVal){
-				bufMgr->unPinPage(file, currentPageNum, false);
-				if(currentNode->rightSibPageNo == 0){
-					throw NoSuchKeyFoundException();
-				}
-				currentPageNum = currentNode->rightSibPageNo;
-			bufMgr->readPage(file, currentPageNum, currentPageData);
-			}
+		if(record == nullptr){
+			Page *page;
+			bufMgr->readPage(relationFile, rid.page_number, page);
+			std::string read = page->getRecord(rid);
+			bufMgr->unPinPage(relationFile, rid.page_number, false);
+			gatherPayload(read.c_str(), payload);
 		}
+		else{
+			gatherPayload(record, payload);
+		}
+	}
+	if(countedNonleaves){
+		// the counts above the leaf are fixed before the next insert or delete changes the path
+		std::lock_guard<std::mutex> guard(structureMutex);
+		while(!insert(data, payload)){
+			std::this_thread::yield();
+		}
+		recountPath(data.key, payload);
+		return;
+	}
+	while(!insert(data, payload)){
+		std::this_thread::yield();
 	}
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::scanNext
+// BTreeIndex::insertRecord
 // -----------------------------------------------------------------------------
 
-const void BTreeIndex::scanNext(RecordId& outRid) 
+const RecordId BTreeIndex::insertRecord(const std::string &record)
 {
-	if(!scanExecuting){
-		throw ScanNotInitializedException();
-	}
-	LeafNodeInt* currentNode = (LeafNodeInt *) currentPageData;
-	if(currentNode->ridArray[nextEntry].page_number == 0 or nextEntry == leafOccupancy){
-		bufMgr->unPinPage(file, currentPageNum, false);
-		if(currentNode->rightSibPageNo == 0){
-			throw IndexScanCompletedException();
-		}
-		currentPageNum = currentNode->rightSibPageNo;
-		bufMgr->readPage(file, currentPageNum, currentPageData);
-		currentNode = (LeafNodeInt *) currentPageData;
-		nextEntry = 0;
-	}
-
-	int key = currentNode->keyArray[nextEntry];
-	if(checkKey(lowValInt, lowOp, highValInt, highOp, key)){
-		outRid = currentNode->ridArray[nextEntry];
-		nextEntry++;
-	}
-	else{
-		throw IndexScanCompletedException();
+	if(!recordLeaves || (int)record.size() != payloadBytes){
+		throw BadIndexInfoException(file->filename());
 	}
+	RecordId rowId;
+	rowId.page_number = nextRowId++;
+	rowId.slot_number = 0;
+	insertEntry(record.c_str() + attrByteOffset, rowId, record.c_str());
+	return rowId;
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::endScan
+// BTreeIndex::bufferInserts
 // -----------------------------------------------------------------------------
-//
-const void BTreeIndex::endScan() 
+
+const void BTreeIndex::bufferInserts(size_t entries)
 {
-	if(!scanExecuting){
-		throw ScanNotInitializedException();
+	if(!keyAttrs.empty() || recordLeaves){
+		throw BadIndexInfoException(file->filename());
 	}
-	scanExecuting = false;
-	bufMgr->unPinPage(file, currentPageNum, false);
-	currentPageNum = static_cast<PageId>(-1);
-	currentPageData = nullptr;
-	nextEntry = -1;
-}
-// -----------------------------------------------------------------------------
-// BTreeIndex::~BTreeIndex -- nextNonleaf
-// -----------------------------------------------------------------------------
-const void BTreeIndex::nextNonleaf(NonLeafNodeInt *currentNode, PageId &nextNode, int check){
-	int i = nodeOccupancy;
-	while(i >= 0 && (currentNode->pageNoArray[i] == 0)){
-		i--;
+	{
+		std::lock_guard<std::mutex> guard(bufferMutex);
+		insertBufferLimit = entries;
 	}
-	while(i > 0 && (currentNode->keyArray[i-1] >= check)){
-		i--;
+	if(entries == 0){
+		flushInserts();
 	}
-	nextNode = currentNode->pageNoArray[i];
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::update
+// BTreeIndex::flushInserts
 // -----------------------------------------------------------------------------
-const void BTreeIndex::update(PageId firstPageInRoot, PageKeyPair<int> *newChild){
-	PageId newroot_Num;
-	Page *newRoot;
-	bufMgr->allocPage(file, newroot_Num, newRoot);
-	NonLeafNodeInt *newRootPage = (NonLeafNodeInt *)newRoot;
-
-	newRootPage->pageNoArray[0] = firstPageInRoot;
-	newRootPage->pageNoArray[1] = newChild->pageNo;
-	newRootPage->level = initialroot == rootPageNum ? 1 : 0;
-	newRootPage->keyArray[0] = newChild->key;
-
-	Page *m;
-	bufMgr->readPage(file, headerPageNum, m);
-	IndexMetaInfo *metaPage = (IndexMetaInfo *)m;
-	metaPage->rootPageNo = newroot_Num;
-	rootPageNum = newroot_Num;
 
-	bufMgr->unPinPage(file, headerPageNum, true);
-	bufMgr->unPinPage(file, newroot_Num, true);
+const void BTreeIndex::flushInserts()
+{
+	if(bufferedCount == 0){
+		return;
+	}
+	// the buffer is taken while holding flushMutex, so a read that finds it empty has waited
+	// for the entries taken before to reach the tree
+	std::lock_guard<std::mutex> flushGuard(flushMutex);
+	std::vector<RIDKeyPair<int> > entries;
+	{
+		std::lock_guard<std::mutex> guard(bufferMutex);
+		entries.swap(insertBuffer);
+	}
+	if(!entries.empty()){
+		insertBatch(&entries[0], entries.size());
+	}
+	bufferedCount -= entries.size();
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::~BTreeIndex -- insert
+// BTreeIndex::insertBatch
 // -----------------------------------------------------------------------------
-const void BTreeIndex::insert(Page *currentPage, PageId currentPage_Num, bool node_leaf, const RIDKeyPair<int> data, PageKeyPair<int> *&newChild){
-	if (!node_leaf){
-		NonLeafNodeInt *currentNode = (NonLeafNodeInt *)currentPage;
-		Page *nextPage;
-		PageId nextNode;
-		nextNonleaf(currentNode, nextNode, data.key);
-		bufMgr->readPage(file, nextNode, nextPage);
-		node_leaf = currentNode->level == 1;
-		insert(nextPage, nextNode, node_leaf, data, newChild);
 
-		if (newChild == nullptr){
-			bufMgr->unPinPage(file, currentPage_Num, false);
-		}
-		else{
-			if (currentNode->pageNoArray[nodeOccupancy] == 0){
-				nonleafInsertion(currentNode, newChild);
-			newChild = nullptr;
-			bufMgr->unPinPage(file, currentPage_Num, true);
-			}
-			else{
-				nonleafSplit(currentNode, currentPage_Num, newChild);
-			}	
+const void BTreeIndex::insertBatch(RIDKeyPair<int> *entries, size_t count)
+{
+	// integer keys cannot stand for normalized ones, nor bring the records of an index-organized table
+	if(!keyAttrs.empty() || recordLeaves){
+		throw BadIndexInfoException(file->filename());
+	}
+	if(learnedFresh.load(std::memory_order_relaxed)){
+		learnedFresh = false;
+	}
+	std::sort(entries, entries + count);
+	if(countedNonleaves || payloadBytes > 0){
+		// a run merged into a leaf would leave the counts above it behind, and has no included attributes
+		for(size_t i = 0; i < count; i++){
+			insertEntry(&entries[i].key, entries[i].rid, nullptr);
 		}
+		return;
 	}
-	else{
-		LeafNodeInt *leaf = (LeafNodeInt *)currentPage;
-		if (leaf->ridArray[leafOccupancy - 1].page_number == 0){
-			leafInsertion(leaf, data);
-			bufMgr->unPinPage(file, currentPage_Num, true);
-			newChild = nullptr;
+	for(size_t i = 0; bloom != nullptr && i < count; i++){
+		bloom->insert(entries[i].key);
+	}
+	size_t i = 0;
+	while(i < count){
+		size_t placed = insertRun(entries + i, count - i);
+		if(placed > 0){
+			i += placed;
+			continue;
 		}
-		else {
-		leafSplit(leaf, currentPage_Num, newChild, data);
+		// the leaf is full or the key has to go to a posting list, which splits or builds it
+		while(!insert(entries[i], nullptr)){
+			std::this_thread::yield();
 		}
+		i++;
 	}
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::leafSplit
+// BTreeIndex::deleteEntry
 // -----------------------------------------------------------------------------
-const void BTreeIndex::leafSplit(LeafNodeInt *leaf, PageId leafPageNum, PageKeyPair<int> *&newChild, const RIDKeyPair<int> data){
-	PageId newPageNum;
-	Page *newPage;
-	bufMgr->allocPage(file, newPageNum, newPage);
-	LeafNodeInt *new_leafNode = (LeafNodeInt *)newPage;
-	int median = leafOccupancy/2;
 
-	if (leafOccupancy %2 == 1 && data.key > leaf->keyArray[median]){
-		median = median + 1;
+const void BTreeIndex::deleteEntry(const void *key, const RecordId rid)
+{
+	flushInserts();
+	if(learnedFresh.load(std::memory_order_relaxed)){
+		learnedFresh = false;
 	}
+	RIDKeyPair<int> data;
+	data.set(rid, keyAttrs.empty() ? *((int *)key) : keyPrefix((const char *)key, payloadBytes, 0));
 
-	for(int i = median; i < leafOccupancy; i++) {
-		new_leafNode->keyArray[i-median] = leaf->keyArray[i];
-		new_leafNode->ridArray[i-median] = leaf->ridArray[i];
-		leaf->keyArray[i] = 0;
-		leaf->ridArray[i].page_number = 0;
+	// common case: the entry is in the leaf the key leads to and the leaf does not underflow.
+	// counted non-leaves above the leaf would miss the entry going
+	while(!countedNonleaves){
+		PageId leafPageNum;
+		Page *leafPage;
+		std::uint64_t version;
+		bool root_leaf;
+		if(keyAttrs.empty()){
+			findLeaf(data.key, leafPageNum, leafPage, version, root_leaf);
+		}
+		else{
+			findKeyLeaf((const char *)key, payloadBytes, false, leafPageNum, leafPage, version, root_leaf);
+		}
+		OptLatch &latch = bufMgr->latch(leafPage);
+		if(!latch.upgrade(version)){
+			bufMgr->unPinPage(file, leafPageNum, false);
+			continue;
+		}
+		bool found;
+		if(packedLeaves){
+			PackedLeafInt *leaf = (PackedLeafInt *)leafPage;
+			found = (root_leaf || leaf->count * 2 > leaf->capacity) && packedRemoval(leaf, data);
+		}
+		else{
+			LeafNodeInt *leaf = (LeafNodeInt *)leafPage;
+			found = (root_leaf || leafSize(leaf) > leafOccupancy/2) && leafRemoval(leaf, data);
+		}
+		latch.unlock();
+		bufMgr->unPinPage(file, leafPageNum, found);
+		if(found){
+			return;
+		}
+		break;
 	}
 
-	if (data.key > leaf->keyArray[median-1]) {
-		leafInsertion(new_leafNode, data);
-	}
-	else{
-		leafInsertion(leaf, data);
+	// otherwise latch the whole path, one structure changing delete at a time
+	std::lock_guard<std::mutex> guard(structureMutex);
+	while(true){
+		std::uint64_t rootVersion;
+		if(!rootLatch.readLock(rootVersion)){
+			std::this_thread::yield();
+			continue;
+		}
+		PageId rootNum = rootPageNum;
+		bool root_leaf = initialroot == rootNum;
+		Page *rootPage;
+		bufMgr->readPage(file, rootNum, rootPage);
+		bufMgr->latch(rootPage).lock();
+		if(!rootLatch.validate(rootVersion)){
+			unlatchPage(rootNum, rootPage, false);
+			continue;
+		}
+		int remaining;
+		if(!remove(rootPage, rootNum, root_leaf, data, (const char *)key, remaining)){
+			throw NoSuchKeyFoundException();
+		}
+		if(!root_leaf && remaining == 0){
+			collapseRoot();
+		}
+		return;
 	}
+}
 
-	new_leafNode->rightSibPageNo = leaf->rightSibPageNo;
-	leaf->rightSibPageNo = newPageNum;
-
-	newChild = new PageKeyPair<int>();
-	PageKeyPair<int> newPair;
-	newPair.set(newPageNum, new_leafNode->keyArray[0]);
-	newChild = &newPair;
-	bufMgr->unPinPage(file, leafPageNum, true);
-	bufMgr->unPinPage(file, newPageNum, true);
+// -----------------------------------------------------------------------------
+// BTreeIndex::startScan
+// -----------------------------------------------------------------------------
 
-	if (leafPageNum == rootPageNum){
-		update(leafPageNum, newChild);
+BTreeCursor BTreeIndex::startScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const ScanOrder order)
+{
+	if(bloom != nullptr && ((lowOpParm == EQ && highOpParm == EQ) || (lowOpParm == GTE && highOpParm == LTE))
+		&& *((int *)lowValParm) == *((int *)highValParm)){
+		// a key the filter never saw has no entries, there is no need to descend
+		flushInserts();
+		if(!bloom->mayContain(*((int *)lowValParm))){
+			throw NoSuchKeyFoundException();
+		}
+	}
+	BTreeCursor cursor = openScan(lowValParm, lowOpParm, highValParm, highOpParm, order);
+	if(!cursor.fetch(cursor.pendingRid, cursor.pendingPayload)){
+		cursor.endScan();
+		throw NoSuchKeyFoundException();
 	}
+	cursor.hasPending = true;
+	return cursor;
 }
+
 // -----------------------------------------------------------------------------
-// BTreeIndex::leafInsertion
+// BTreeIndex::openScan
 // -----------------------------------------------------------------------------
-const void BTreeIndex::leafInsertion(LeafNodeInt *leaf, RIDKeyPair<int> entry)
+
+BTreeCursor BTreeIndex::openScan(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   const ScanOrder order)
 {
-	if (leaf->ridArray[0].page_number == 0){
-		leaf->ridArray[0] = entry.rid;
-		leaf->keyArray[0] = entry.key;
-	}
-	else {
-		int i = leafOccupancy - 1;
-		while(i >= 0 && (leaf->ridArray[i].page_number == 0)) {
-			i--;
-		}
-		while(i >= 0 && (leaf->keyArray[i] > entry.key)) {
-			leaf->ridArray[i+1] = leaf->ridArray[i];
-			leaf->keyArray[i+1] = leaf->keyArray[i];
-			i--;
-		}
-		leaf->ridArray[i+1] = entry.rid;
-		leaf->keyArray[i+1] = entry.key;
-	}
+	flushInserts();
+	BTreeCursor cursor;
+	cursor.setRange(lowValParm, lowOpParm, highValParm, highOpParm);
+	cursor.descending = order == DESCENDING;
+	cursor.index = this;
+	cursor.seek();
+	cursor.scanExecuting = true;
+	return cursor;
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::nonleafSplit
+// BTreeIndex::lookup
 // -----------------------------------------------------------------------------
-const void BTreeIndex::nonleafSplit(NonLeafNodeInt *p_node, PageId p_pageNum, PageKeyPair<int> *&newChild){
-	PageId newPageNum;
-	Page *newPage;
-	bufMgr->allocPage(file, newPageNum, newPage);
-	NonLeafNodeInt *newNode = (NonLeafNodeInt *)newPage;
 
-	int median = nodeOccupancy/2;
-	int p_index = median;
-	PageKeyPair<int> p_entry;
-	if (nodeOccupancy % 2 == 0){
-		p_index = newChild->key < p_node->keyArray[median] ? median -1 : median;
+const size_t BTreeIndex::lookup(const void *key, std::vector<RecordId> &outRids)
+{
+	flushInserts();
+	int check = *((int *)key);
+	size_t initialSize = outRids.size();
+	if(bloom != nullptr && !bloom->mayContain(check)){
+		return 0;
 	}
-	p_entry.set(newPageNum, p_node->keyArray[p_index]);
-
-	median = p_index + 1;
-	for(int i = median; i < nodeOccupancy; i++){
-		newNode->keyArray[i-median] = p_node->keyArray[i];
-		newNode->pageNoArray[i-median] = p_node->pageNoArray[i+1];
-		p_node->pageNoArray[i+1] = (PageId) 0;
-		p_node->keyArray[i+1] = 0;
+	if(learnedFresh && learnedLookup(check, outRids)){
+		return outRids.size() - initialSize;
 	}
-
-	newNode->level = p_node->level;
-	p_node->keyArray[p_index] = 0;
-	p_node->pageNoArray[p_index] = (PageId) 0;
-	nonleafInsertion(newChild->key < newNode->keyArray[0] ? p_node : newNode, newChild);
-	newChild = &p_entry;
-	bufMgr->unPinPage(file, p_pageNum, true);
-	bufMgr->unPinPage(file, newPageNum, true);
-
-	if (p_pageNum == rootPageNum)  {
-		update(p_pageNum, newChild);
+	while(true){
+		PageId leafPageNum;
+		Page *leafPage;
+		std::uint64_t version;
+		bool root_leaf;
+		findLeaf(check, leafPageNum, leafPage, version, root_leaf);
+		if(leafLookup(check, leafPageNum, leafPage, version, -1, outRids)){
+			return outRids.size() - initialSize;
+		}
 	}
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::nonleafInsertion
+// BTreeIndex::lookupBatch
 // -----------------------------------------------------------------------------
-const void BTreeIndex::nonleafInsertion(NonLeafNodeInt *nonleaf, PageKeyPair<int> *entry){
-	int i = nodeOccupancy;
-	while(i >= 0 && (nonleaf->pageNoArray[i] == 0)){
-		i--;
-	}
-	while( i > 0 && (nonleaf->keyArray[i-1] > entry->key)) {
-		nonleaf->keyArray[i] = nonleaf->keyArray[i-1];
-		nonleaf->pageNoArray[i+1] = nonleaf->pageNoArray[i];
-		i--;
-	}
+
+const size_t BTreeIndex::lookupBatch(const void *keys, size_t count, std::vector<RecordId> &outRids, size_t *ends)
+{
+	flushInserts();
+	const int *check = (const int *)keys;
+	size_t initialSize = outRids.size();
+	Descent descents[LOOKUPGROUP];
+	bool started[LOOKUPGROUP];
+	int positions[LOOKUPGROUP];
+	for(size_t first = 0; first < count; first += LOOKUPGROUP){
+		size_t group = std::min(count - first, LOOKUPGROUP);
+		if(group == 1){
+			// nothing for the misses to overlap with
+			lookup(&check[first], outRids);
+			ends[first] = outRids.size();
+			continue;
+		}
+		for(size_t i = 0; i < group; i++){
+			started[i] = descendRoot(descents[i]);
+		}
+		// take every descent one level down before any goes further, so that the child each one goes
+		// to is prefetched while the others find theirs
+		bool deeper = true;
+		while(deeper){
+			deeper = false;
+			for(size_t i = 0; i < group; i++){
+				if(started[i] && !descents[i].leaf){
+					prefetchChild(check[first + i], descents[i]);
+				}
+			}
+			for(size_t i = 0; i < group; i++){
+				if(started[i] && !descents[i].leaf){
+					started[i] = descendChild(check[first + i], descents[i]);
+					if(started[i]){
+						prefetchNode(descents[i].page, descents[i].leaf);
+						deeper = deeper || !descents[i].leaf;
+					}
+				}
+			}
+		}
+		if(!packedLeaves){
+			leafLowerBounds(check + first, descents, started, group, positions);
+		}
+		// descents that had to start again, and leaves that changed, are looked up on their own
+		for(size_t i = 0; i < group; i++){
+			int start = packedLeaves ? -1 : positions[i];
+			if(!started[i] || !leafLookup(check[first + i], descents[i].pageNo, descents[i].page, descents[i].version, start, outRids)){
+				lookup(&check[first + i], outRids);
+			}
+			ends[first + i] = outRids.size();
+		}
+	}
+	return outRids.size() - initialSize;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafLowerBounds
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::leafLowerBounds(const int *keys, const Descent *descents, const bool *started, size_t count, int *positions)
+{
+	// the same two searches as leafLowerBound, for the end of the used slots and then for the key.
+	// leaves may be changing, whatever is found is validated by leafLookup
+	int lo[LOOKUPGROUP];
+	int hi[LOOKUPGROUP];
+	for(int pass = 0; pass < 2; pass++){
+		for(size_t i = 0; i < count; i++){
+			hi[i] = pass == 0 ? leafOccupancy : lo[i];
+			lo[i] = 0;
+		}
+		bool searching = true;
+		while(searching){
+			searching = false;
+			for(size_t i = 0; i < count; i++){
+				if(!started[i] || lo[i] >= hi[i]){
+					continue;
+				}
+				LeafNodeInt *leaf = (LeafNodeInt *)descents[i].page;
+				int mid = (lo[i] + hi[i])/2;
+				bool below = pass == 0 ? leaf->ridArray[mid].page_number != 0 : leaf->keyArray[mid] < keys[i];
+				if(below){
+					lo[i] = mid + 1;
+				}
+				else{
+					hi[i] = mid;
+				}
+				if(lo[i] < hi[i]){
+					mid = (lo[i] + hi[i])/2;
+					__builtin_prefetch(pass == 0 ? (const void *)&leaf->ridArray[mid] : (const void *)&leaf->keyArray[mid]);
+					searching = true;
+				}
+			}
+		}
+	}
+	// leafLookup goes on with the record id of the first match and the sibling link
+	for(size_t i = 0; i < count; i++){
+		positions[i] = lo[i];
+		if(started[i]){
+			LeafNodeInt *leaf = (LeafNodeInt *)descents[i].page;
+			__builtin_prefetch(&leaf->ridArray[std::min(lo[i], leafOccupancy - 1)]);
+			__builtin_prefetch(&leaf->rightSibPageNo);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafLookup
+// -----------------------------------------------------------------------------
+
+const bool BTreeIndex::leafLookup(int check, PageId leafPageNum, Page *leafPage, std::uint64_t version, int start, std::vector<RecordId> &outRids)
+{
+	size_t initialSize = outRids.size();
+	std::vector<PageId> lists;
+	bool first = true;
+	while(true){
+		// copy the matching run optimistically, the leaf version tells if it was consistent
+		int i = !first ? 0 : start >= 0 ? start : leafLowerBound(leafPage, check);
+		int key;
+		RecordId rid;
+		bool more;
+		lists.clear();
+		while((more = leafEntry(leafPage, i, key, rid)) && key == check){
+			if(rid.slot_number == POSTINGSLOT){
+				lists.push_back(rid.page_number);
+			}
+			else{
+				outRids.push_back(rid);
+			}
+			i++;
+		}
+		PageId rightSib = leafSibling(leafPage);
+		bool valid = bufMgr->latch(leafPage).validate(version);
+		// posting lists are read while the leaf still points to them
+		for(size_t j = 0; valid && j < lists.size(); j++){
+			valid = postingRead(lists[j], leafPage, version, outRids);
+		}
+		if(valid){
+			if(more || rightSib == 0){
+				// the run ended inside this leaf
+				bufMgr->unPinPage(file, leafPageNum, false);
+				return true;
+			}
+			// duplicates of the key may continue in the right sibling
+			Page *nextPage;
+			bufMgr->readPage(file, rightSib, nextPage);
+			OptLatch &nextLatch = bufMgr->latch(nextPage);
+			std::uint64_t nextVersion;
+			while(!nextLatch.readLock(nextVersion) && !OptLatch::isObsolete(nextVersion)){
+				std::this_thread::yield();
+			}
+			if(!OptLatch::isObsolete(nextVersion) && bufMgr->latch(leafPage).validate(version)){
+				bufMgr->unPinPage(file, leafPageNum, false);
+				leafPageNum = rightSib;
+				leafPage = nextPage;
+				version = nextVersion;
+				first = false;
+				continue;
+			}
+			bufMgr->unPinPage(file, rightSib, false);
+		}
+		// the leaf changed while it was read, start over
+		bufMgr->unPinPage(file, leafPageNum, false);
+		outRids.resize(initialSize);
+		return false;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::buildBloom
+// -----------------------------------------------------------------------------
+const void BTreeIndex::buildBloom(int bitsPerKey, size_t keys){
+	flushInserts();
+	std::vector<int> leafKeys;
+	PageId leafPageNum;
+	Page *leafPage;
+	std::uint64_t version;
+	bool root_leaf;
+	findLeaf(std::numeric_limits<int>::min(), leafPageNum, leafPage, version, root_leaf);
+	while(true){
+		int count = leafCount(leafPage);
+		for(int i = 0; i < count; i++){
+			leafKeys.push_back(leafKey(leafPage, i));
+		}
+		PageId rightSib = leafSibling(leafPage);
+		bufMgr->unPinPage(file, leafPageNum, false);
+		if(rightSib == 0){
+			break;
+		}
+		leafPageNum = rightSib;
+		bufMgr->readPage(file, leafPageNum, leafPage);
+	}
+	BloomFilter *filter = new BloomFilter(bitsPerKey, std::max(keys, leafKeys.size()));
+	for(size_t i = 0; i < leafKeys.size(); i++){
+		filter->insert(leafKeys[i]);
+	}
+	delete bloom;
+	bloom = filter;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::openBloom
+// -----------------------------------------------------------------------------
+const void BTreeIndex::openBloom(int bitsPerKey, std::uint64_t stamp){
+	BloomFilter *filter = nullptr;
+	try{
+		filter = new BloomFilter(file->filename() + ".bloom", stamp);
+	}
+	catch(FileNotFoundException e){
+	}
+	catch(BadIndexInfoException e){
+	}
+	// twice the keys it was sized for would leave the share of clear bits squared
+	if(filter != nullptr && (stamp == 0 || filter->bits() != bitsPerKey
+		|| 1 - filter->fill() < (1 - filter->designFill()) * (1 - filter->designFill()))){
+		delete filter;
+		filter = nullptr;
+	}
+	if(filter == nullptr){
+		buildBloom(bitsPerKey, 0);
+	}
+	else{
+		bloom = filter;
+	}
+
+	// until the next close the file on disk falls behind the inserts
+	Page *header_Page;
+	bufMgr->readPage(file, headerPageNum, header_Page);
+	((IndexMetaInfo *)header_Page)->bloomStamp = 0;
+	bufMgr->unPinPage(file, headerPageNum, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::learnSegments
+// -----------------------------------------------------------------------------
+const void BTreeIndex::learnSegments(const std::vector<int> &lowKeys){
+	// shrinking cone: a segment keeps the slopes through its first point that pass within learnedError
+	// of every later point, and ends at the first point that leaves none. Leaves starting with the same
+	// key as the one before them are not points, a lookup of the key starts at the first of them
+	const int n = lowKeys.size();
+	int start = 0;
+	while(start < n){
+		double low = 0;
+		double high = std::numeric_limits<double>::infinity();
+		int end = start + 1;
+		for(; end < n; end++){
+			if(lowKeys[end] == lowKeys[end - 1]){
+				continue;
+			}
+			double dx = (double)lowKeys[end] - lowKeys[start];
+			double below = (end - start - learnedError) / dx;
+			double above = (end - start + learnedError) / dx;
+			if(below > high || above < low){
+				break;
+			}
+			low = std::max(low, below);
+			high = std::min(high, above);
+		}
+		LearnedSegment segment;
+		segment.firstKey = lowKeys[start];
+		segment.firstLeaf = start;
+		segment.lastLeaf = end - 1;
+		segment.slope = high == std::numeric_limits<double>::infinity() ? low : (low + high) / 2;
+		learnedSegments.push_back(segment);
+		start = end;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::learnedLookup
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::learnedLookup(int key, std::vector<RecordId> &outRids){
+	// the last segment starting at or below the key, or the first one for keys below every leaf
+	int lo = 0;
+	int hi = learnedSegments.size();
+	while(hi - lo > 1){
+		int mid = (lo + hi) / 2;
+		if(learnedSegments[mid].firstKey <= key){
+			lo = mid;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	const LearnedSegment &segment = learnedSegments[lo];
+	double predicted = segment.firstLeaf + segment.slope * std::max((double)key - segment.firstKey, 0.0);
+	int leaf = (int)std::min(predicted + 0.5, (double)segment.lastLeaf);
+
+	// walk to the leftmost leaf that may hold the key: its first key below it, unless it is the first
+	// leaf, and its last key not below it, unless the walk came from the left
+	int moved = 0;
+	for(int steps = 0; steps <= learnedError + 1; steps++){
+		PageId leafPageNum = learnedLeaves[leaf];
+		Page *leafPage;
+		bufMgr->readPage(file, leafPageNum, leafPage);
+		OptLatch &latch = bufMgr->latch(leafPage);
+		std::uint64_t version;
+		while(!latch.readLock(version) && !OptLatch::isObsolete(version)){
+			std::this_thread::yield();
+		}
+		int count = OptLatch::isObsolete(version) ? 0 : leafCount(leafPage);
+		int first = count > 0 ? leafKey(leafPage, 0) : 0;
+		int last = count > 0 ? leafKey(leafPage, count - 1) : 0;
+		if(count == 0 || !latch.validate(version)){
+			bufMgr->unPinPage(file, leafPageNum, false);
+			return false;
+		}
+		if(leaf > 0 && first >= key && moved <= 0){
+			bufMgr->unPinPage(file, leafPageNum, false);
+			leaf--;
+			moved = -1;
+			continue;
+		}
+		if(leaf + 1 < (int)learnedLeaves.size() && last < key && moved >= 0){
+			bufMgr->unPinPage(file, leafPageNum, false);
+			leaf++;
+			moved = 1;
+			continue;
+		}
+		size_t initialSize = outRids.size();
+		if(!leafLookup(key, leafPageNum, leafPage, version, -1, outRids)){
+			return false;
+		}
+		// a writer clears learnedFresh before it changes a leaf, so the leaves read were as learned
+		if(!learnedFresh){
+			outRids.resize(initialSize);
+			return false;
+		}
+		return true;
+	}
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::countRange
+// -----------------------------------------------------------------------------
+
+const size_t BTreeIndex::countRange(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm)
+{
+	flushInserts();
+	if(!countedNonleaves){
+		BTreeCursor scan = openScan(lowValParm, lowOpParm, highValParm, highOpParm);
+		std::vector<RecordId> batch(1024);
+		size_t count = 0;
+		size_t n;
+		while((n = scan.nextBatch(&batch[0], batch.size())) > 0){
+			count += n;
+		}
+		return count;
+	}
+	BTreeCursor range;
+	range.setRange(lowValParm, lowOpParm, highValParm, highOpParm);
+	size_t below = countBelow(range.lowValInt, range.lowOp == GT);
+	size_t upTo = countBelow(range.highValInt, range.highOp == LTE);
+	// inserts between the two descents may make an empty range look negative
+	return upTo > below ? upTo - below : 0;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::rank
+// -----------------------------------------------------------------------------
+
+const size_t BTreeIndex::rank(const void *key)
+{
+	flushInserts();
+	int check = *((int *)key);
+	if(countedNonleaves){
+		return countBelow(check, false);
+	}
+	int low = std::numeric_limits<int>::min();
+	if(check == low){
+		return 0;
+	}
+	return countRange(&low, GTE, &check, LT);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::select
+// -----------------------------------------------------------------------------
+
+const bool BTreeIndex::select(size_t position, void *outKey, RecordId &outRid)
+{
+	flushInserts();
+	if(!countedNonleaves){
+		// skip the entries before it, the cursor remembers the key of the last one it returned
+		int low = std::numeric_limits<int>::min();
+		int high = std::numeric_limits<int>::max();
+		BTreeCursor scan = openScan(&low, GTE, &high, LTE);
+		std::vector<RecordId> batch(std::min(position, (size_t)1024));
+		size_t left = position;
+		while(left > 0){
+			size_t n = scan.nextBatch(&batch[0], std::min(left, batch.size()));
+			if(n == 0){
+				return false;
+			}
+			left -= n;
+		}
+		if(scan.nextBatch(&outRid, 1) == 0){
+			return false;
+		}
+		*((int *)outKey) = scan.lastKeyInt;
+		return true;
+	}
+
+	while(true){
+		Descent descent;
+		bool restart = !descendRoot(descent);
+		// follow the child whose entries cover the position, skipping the entries of those before it
+		size_t left = position;
+		while(!restart && !descent.leaf){
+			NonLeafNodeInt *currentNode = (NonLeafNodeInt *)descent.page;
+			const int *counts = childCounts(currentNode);
+			int size = nonleafSize(currentNode);
+			int childPos = 0;
+			while(childPos < size && left >= (size_t)counts[childPos]){
+				left -= counts[childPos];
+				childPos++;
+			}
+			restart = !descendTo(childPos, descent);
+		}
+		if(restart){
+			std::this_thread::yield();
+			continue;
+		}
+		int key;
+		RecordId rid;
+		bool found = leafEntry(descent.page, (int)std::min(left, (size_t)PACKEDLEAFSIZE), key, rid);
+		bool valid = bufMgr->latch(descent.page).validate(descent.version);
+		bufMgr->unPinPage(file, descent.pageNo, false);
+		if(!valid){
+			std::this_thread::yield();
+			continue;
+		}
+		// a position past the last entry runs off the end of the last leaf
+		if(found){
+			*((int *)outKey) = key;
+			outRid = rid;
+		}
+		return found;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::freeze
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::freeze(const std::string &fileName)
+{
+	if(!keyAttrs.empty() || recordLeaves){
+		throw BadIndexInfoException(file->filename());
+	}
+	std::vector<int> keys;
+	std::vector<RecordId> rids;
+	int low = std::numeric_limits<int>::min();
+	int high = std::numeric_limits<int>::max();
+	BTreeCursor scan = openScan(&low, GTE, &high, LTE);
+	RecordId rid;
+	while(scan.fetch(rid)){
+		keys.push_back(scan.lastKeyInt);
+		rids.push_back(rid);
+	}
+	scan.endScan();
+	StaticTree::write(fileName, keys.empty() ? nullptr : &keys[0], rids.empty() ? nullptr : &rids[0], keys.size());
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::lookupKeys
+// -----------------------------------------------------------------------------
+
+const size_t BTreeIndex::lookupKeys(const void* lowKey, int lowLength, const Operator lowOpParm,
+				const void* highKey, int highLength, const Operator highOpParm, std::vector<RecordId> &outRids)
+{
+	if(keyAttrs.empty()){
+		throw BadIndexInfoException(file->filename());
+	}
+	const char *low = (const char *)lowKey;
+	const char *high = (const char *)highKey;
+	Operator lowOp = lowOpParm;
+	Operator highOp = highOpParm;
+	if((lowOp == EQ) != (highOp == EQ)){
+		throw BadOpcodesException();
+	}
+	if(lowLength < 0 || lowLength > payloadBytes || highLength < 0 || highLength > payloadBytes){
+		throw BadScanrangeException();
+	}
+	int common = std::min(lowLength, highLength);
+	if(lowOp == EQ){
+		if(lowLength != highLength || memcmp(low, high, common) != 0){
+			throw BadScanrangeException();
+		}
+		// an equality lookup is every key starting with the bound
+		lowOp = GTE;
+		highOp = LTE;
+	}
+	else if(!((lowOp == GT or lowOp == GTE) and (highOp == LT or highOp == LTE))){
+		throw BadOpcodesException();
+	}
+	if(memcmp(low, high, common) > 0){
+		throw BadScanrangeException();
+	}
+
+	// entries are in the order of their whole keys, so the scan starts at the first one past the low bound
+	// and stops at the first one past the high bound. A leaf that changes while it is read is read again
+	// from the last key taken, skipping the entries of that key taken before
+	char last[MAXPAYLOADSIZE];
+	std::vector<RecordId> lastRids;
+	RecordId rids[INTARRAYLEAFSIZE];
+	char keys[Page::SIZE];
+	size_t found = 0;
+	while(true){
+		PageId leafPageNum;
+		Page *leafPage;
+		std::uint64_t version;
+		bool root_leaf;
+		bool resumed = !lastRids.empty();
+		if(resumed){
+			findKeyLeaf(last, payloadBytes, false, leafPageNum, leafPage, version, root_leaf);
+		}
+		else{
+			findKeyLeaf(low, lowLength, lowOp == GT, leafPageNum, leafPage, version, root_leaf);
+		}
+		LeafNodeInt *leaf = (LeafNodeInt *)leafPage;
+		int lo = 0;
+		int hi = leafSize(leaf);
+		while(lo < hi){
+			int mid = (lo + hi)/2;
+			int cmp = resumed ? memcmp(leafPayload(leaf, mid), last, payloadBytes) : memcmp(leafPayload(leaf, mid), low, lowLength);
+			if(cmp < 0 || (cmp == 0 && !resumed && lowOp == GT)){
+				lo = mid + 1;
+			}
+			else{
+				hi = mid;
+			}
+		}
+		while(true){
+			// copy the entries up to the high bound optimistically, the leaf version tells if they were consistent
+			int size = leafSize(leaf);
+			int count = 0;
+			bool done = false;
+			for(int i = lo; i < size; i++){
+				const char *key = leafPayload(leaf, i);
+				int highCmp = memcmp(key, high, highLength);
+				if(highOp == LT ? highCmp >= 0 : highCmp > 0){
+					done = true;
+					break;
+				}
+				rids[count] = leaf->ridArray[i];
+				memcpy(keys + count * payloadBytes, key, payloadBytes);
+				count++;
+			}
+			PageId rightSib = leaf->rightSibPageNo;
+			if(!bufMgr->latch(leafPage).validate(version)){
+				break;
+			}
+			for(int i = 0; i < count; i++){
+				const char *key = keys + i * payloadBytes;
+				if(lastRids.empty() || memcmp(key, last, payloadBytes) != 0){
+					memcpy(last, key, payloadBytes);
+					lastRids.clear();
+					resumed = false;
+				}
+				else if(resumed && std::find(lastRids.begin(), lastRids.end(), rids[i]) != lastRids.end()){
+					continue;
+				}
+				lastRids.push_back(rids[i]);
+				outRids.push_back(rids[i]);
+				found++;
+			}
+			if(done || rightSib == 0){
+				bufMgr->unPinPage(file, leafPageNum, false);
+				return found;
+			}
+			Page *nextPage;
+			bufMgr->readPage(file, rightSib, nextPage);
+			OptLatch &nextLatch = bufMgr->latch(nextPage);
+			std::uint64_t nextVersion;
+			while(!nextLatch.readLock(nextVersion) && !OptLatch::isObsolete(nextVersion)){
+				std::this_thread::yield();
+			}
+			if(OptLatch::isObsolete(nextVersion) || !bufMgr->latch(leafPage).validate(version)){
+				bufMgr->unPinPage(file, rightSib, false);
+				break;
+			}
+			bufMgr->unPinPage(file, leafPageNum, false);
+			leafPageNum = rightSib;
+			leafPage = nextPage;
+			leaf = (LeafNodeInt *)nextPage;
+			version = nextVersion;
+			lo = 0;
+		}
+		// the leaf changed while it was read, descend again
+		bufMgr->unPinPage(file, leafPageNum, false);
+		std::this_thread::yield();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::encodeKey
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::encodeKey(const char* record, char* outKey)
+{
+	const void *values[MAXKEYATTRS];
+	for(size_t i = 0; i < keyAttrs.size(); i++){
+		values[i] = record + keyAttrs[i].offset;
+	}
+	encodePrefix(values, keyAttrs.size(), outKey);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::encodePrefix
+// -----------------------------------------------------------------------------
+
+const int BTreeIndex::encodePrefix(const void* const* values, int count, char* outKey)
+{
+	unsigned char *out = (unsigned char *)outKey;
+	for(int i = 0; i < count && i < (int)keyAttrs.size(); i++){
+		if(keyAttrs[i].type == INTEGER){
+			// flipping the sign bit orders negative numbers before positive ones
+			std::uint32_t bits;
+			memcpy(&bits, values[i], sizeof(bits));
+			bits ^= 0x80000000u;
+			for(int b = 3; b >= 0; b--){
+				*out++ = bits >> (8 * b);
+			}
+		}
+		else if(keyAttrs[i].type == DOUBLE){
+			// positive doubles order like their bits once the sign is set, negative ones like their bits inverted
+			double value;
+			memcpy(&value, values[i], sizeof(value));
+			if(value == 0){
+				value = 0;
+			}
+			std::uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			bits = (bits >> 63) ? ~bits : bits | (1ull << 63);
+			for(int b = 7; b >= 0; b--){
+				*out++ = bits >> (8 * b);
+			}
+		}
+		else{
+			// shorter strings end in zero bytes, which come before any character
+			const char *value = (const char *)values[i];
+			int length = strnlen(value, keyAttrs[i].length);
+			memcpy(out, value, length);
+			memset(out + length, 0, keyAttrs[i].length - length);
+			out += keyAttrs[i].length;
+		}
+	}
+	return out - (unsigned char *)outKey;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::keySize
+// -----------------------------------------------------------------------------
+
+const int BTreeIndex::keySize()
+{
+	return keyAttrs.empty() ? 0 : payloadBytes;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::height
+// -----------------------------------------------------------------------------
+
+const int BTreeIndex::height()
+{
+	while(true){
+		std::uint64_t rootVersion;
+		if(!rootLatch.readLock(rootVersion)){
+			std::this_thread::yield();
+			continue;
+		}
+		PageId pageNum = rootPageNum;
+		bool node_leaf = initialroot == pageNum;
+		if(!rootLatch.validate(rootVersion)){
+			continue;
+		}
+		// every leaf is at the same depth, follow the leftmost children down
+		int levels = 1;
+		bool restart = false;
+		while(!node_leaf){
+			Page *page;
+			bufMgr->readPage(file, pageNum, page);
+			std::uint64_t version;
+			restart = !bufMgr->latch(page).readLock(version);
+			NonLeafNodeInt *node = (NonLeafNodeInt *)page;
+			PageId childNum = childPageNo(node, 0);
+			node_leaf = node->level == 1;
+			restart = restart || !bufMgr->latch(page).validate(version);
+			bufMgr->unPinPage(file, pageNum, false);
+			if(restart){
+				break;
+			}
+			pageNum = childNum;
+			levels++;
+		}
+		if(!restart){
+			return levels;
+		}
+		std::this_thread::yield();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::payloadSize
+// -----------------------------------------------------------------------------
+
+const int BTreeIndex::payloadSize()
+{
+	return payloadBytes;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafCapacity
+// -----------------------------------------------------------------------------
+
+const int BTreeIndex::leafCapacity()
+{
+	return leafOccupancy;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::pinUpperLevels
+// -----------------------------------------------------------------------------
+
+const int BTreeIndex::pinUpperLevels(int levels)
+{
+	unpinNodes();
+	pinnedLevels = levels > 0 ? levels : 0;
+	if(pinnedLevels == 0){
+		return 0;
+	}
+	if(pinnedNodes.empty()){
+		pinnedNodes.assign(PINNEDSLOTS, PinnedNode{Page::INVALID_NUMBER, nullptr});
+	}
+
+	// pin the tree breadth first, nobody else uses the index meanwhile
+	std::vector<PageId> level;
+	if(initialroot != rootPageNum){
+		level.push_back(rootPageNum);
+	}
+	for(int depth = 0; depth < pinnedLevels && !level.empty(); depth++){
+		std::vector<PageId> next;
+		for(size_t i = 0; i < level.size(); i++){
+			Page *page;
+			if(!pinNode(level[i], page)){
+				return pinnedCount;
+			}
+			NonLeafNodeInt *node = (NonLeafNodeInt *)page;
+			if(node->level == 1){
+				continue;
+			}
+			for(int j = 0; j <= nodeOccupancy && node->pageNoArray[j] != 0; j++){
+				next.push_back(childPageNo(node, j));
+			}
+		}
+		level.swap(next);
+	}
+	return pinnedCount;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::swizzleChildren
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::swizzleChildren(bool enable)
+{
+	swizzling = enable;
+	if(!swizzling){
+		bufMgr->unswizzleFile(file);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::learnLeaves
+// -----------------------------------------------------------------------------
+
+const size_t BTreeIndex::learnLeaves(int maxError)
+{
+	if(!keyAttrs.empty()){
+		throw BadIndexInfoException(file->filename());
+	}
+	flushInserts();
+	learnedFresh = false;
+	learnedError = std::max(maxError, 0);
+	learnedLeaves.clear();
+	learnedSegments.clear();
+
+	// walk the leaves from the leftmost one, noting the first key of each
+	std::vector<int> lowKeys;
+	PageId leafPageNum;
+	Page *leafPage;
+	std::uint64_t version;
+	bool root_leaf;
+	findLeaf(std::numeric_limits<int>::min(), leafPageNum, leafPage, version, root_leaf);
+	while(true){
+		int count = leafCount(leafPage);
+		PageId rightSib = leafSibling(leafPage);
+		if(count > 0){
+			learnedLeaves.push_back(leafPageNum);
+			lowKeys.push_back(leafKey(leafPage, 0));
+		}
+		bufMgr->unPinPage(file, leafPageNum, false);
+		if(rightSib == 0){
+			break;
+		}
+		leafPageNum = rightSib;
+		bufMgr->readPage(file, leafPageNum, leafPage);
+	}
+	if(learnedLeaves.empty()){
+		return 0;
+	}
+	learnSegments(lowKeys);
+	learnedFresh = true;
+	return learnedSegments.size();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::learnedSize
+// -----------------------------------------------------------------------------
+
+const size_t BTreeIndex::learnedSize()
+{
+	return learnedSegments.size() * sizeof(LearnedSegment) + learnedLeaves.size() * sizeof(PageId);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::bloomFilter
+// -----------------------------------------------------------------------------
+
+const void BTreeIndex::bloomFilter(int bitsPerKey, size_t keys)
+{
+	if(!keyAttrs.empty()){
+		throw BadIndexInfoException(file->filename());
+	}
+	if(bitsPerKey > 0){
+		buildBloom(bitsPerKey, keys);
+	}
+	else if(bloom != nullptr){
+		delete bloom;
+		bloom = nullptr;
+		std::remove((file->filename() + ".bloom").c_str());
+	}
+	Page *header_Page;
+	bufMgr->readPage(file, headerPageNum, header_Page);
+	IndexMetaInfo *m = (IndexMetaInfo *)header_Page;
+	m->bloomBits = std::max(bitsPerKey, 0);
+	m->bloomStamp = 0;
+	bufMgr->unPinPage(file, headerPageNum, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::BTreeCursor -- Constructor
+// -----------------------------------------------------------------------------
+
+BTreeCursor::BTreeCursor()
+	: index(nullptr), scanExecuting(false), scanCompleted(false), nextEntry(-1),
+	  currentPageNum(static_cast<PageId>(-1)), currentPageData(nullptr), currentVersion(0),
+	  descending(false), scanReturned(false), hasPending(false), postingHead(0), postingPageNum(0), postingPageData(nullptr),
+	  postingVersion(0), postingNextPage(0), postingCount(0), postingNext(0), postingReturned(false)
+{
+}
+
+BTreeCursor::BTreeCursor(BTreeCursor &&other)
+	: scanExecuting(false)
+{
+	*this = std::move(other);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::operator=
+// -----------------------------------------------------------------------------
+
+BTreeCursor & BTreeCursor::operator=(BTreeCursor &&other)
+{
+	if(this == &other){
+		return *this;
+	}
+	if(scanExecuting){
+		endScan();
+	}
+	index = other.index;
+	scanExecuting = other.scanExecuting;
+	scanCompleted = other.scanCompleted;
+	nextEntry = other.nextEntry;
+	currentPageNum = other.currentPageNum;
+	currentPageData = other.currentPageData;
+	currentVersion = other.currentVersion;
+	lowValInt = other.lowValInt;
+	highValInt = other.highValInt;
+	lowOp = other.lowOp;
+	highOp = other.highOp;
+	descending = other.descending;
+	scanReturned = other.scanReturned;
+	lastKeyInt = other.lastKeyInt;
+	lastKeyRids = std::move(other.lastKeyRids);
+	hasPending = other.hasPending;
+	pendingRid = other.pendingRid;
+	memcpy(pendingPayload, other.pendingPayload, sizeof(pendingPayload));
+	postingHead = other.postingHead;
+	postingPageNum = other.postingPageNum;
+	postingPageData = other.postingPageData;
+	postingVersion = other.postingVersion;
+	postingNextPage = other.postingNextPage;
+	postingRids = std::move(other.postingRids);
+	postingCount = other.postingCount;
+	postingNext = other.postingNext;
+	postingReturned = other.postingReturned;
+	postingLastRid = other.postingLastRid;
+	postingProgress = std::move(other.postingProgress);
+	// the pins on the current leaf and posting page move along
+	other.scanExecuting = false;
+	other.currentPageData = nullptr;
+	other.postingPageData = nullptr;
+	return *this;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::~BTreeCursor -- destructor
+// -----------------------------------------------------------------------------
+
+BTreeCursor::~BTreeCursor()
+{
+	if(scanExecuting){
+		endScan();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::scanNext
+// -----------------------------------------------------------------------------
+
+const void BTreeCursor::scanNext(RecordId& outRid, char *outPayload) 
+{
+	if(!scanExecuting){
+		throw ScanNotInitializedException();
+	}
+	if(hasPending){
+		outRid = pendingRid;
+		if(outPayload != nullptr){
+			memcpy(outPayload, pendingPayload, index->payloadBytes);
+		}
+		hasPending = false;
+		return;
+	}
+	if(!fetch(outRid, outPayload)){
+		throw IndexScanCompletedException();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::endScan
+// -----------------------------------------------------------------------------
+//
+const void BTreeCursor::endScan() 
+{
+	if(!scanExecuting){
+		throw ScanNotInitializedException();
+	}
+	scanExecuting = false;
+	postingClose();
+	index->bufMgr->unPinPage(index->file, currentPageNum, false);
+	currentPageNum = static_cast<PageId>(-1);
+	currentPageData = nullptr;
+	nextEntry = -1;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::nextBatch
+// -----------------------------------------------------------------------------
+
+const size_t BTreeCursor::nextBatch(RecordId *out, size_t max, char *outPayloads)
+{
+	if(!scanExecuting){
+		throw ScanNotInitializedException();
+	}
+	const int payloadBytes = outPayloads != nullptr ? index->payloadBytes : 0;
+	size_t count = 0;
+	if(hasPending && max > 0){
+		if(payloadBytes > 0){
+			memcpy(outPayloads, pendingPayload, payloadBytes);
+		}
+		out[count++] = pendingRid;
+		hasPending = false;
+	}
+	while(count < max && !scanCompleted){
+		if(postingPageData != nullptr){
+			// the decoded rest of a posting page is copied out at once, unless entries
+			// of the key returned from leaves may have to be skipped
+			size_t left = postingCount - postingNext;
+			if(left > 0 && lastKeyRids.empty()){
+				size_t n = std::min(max - count, left);
+				memcpy(out + count, &postingRids[postingNext], n * sizeof(RecordId));
+				count += n;
+				postingNext += n;
+				postingReturned = true;
+				postingLastRid = postingRids[postingNext - 1];
+			}
+			else if(fetch(out[count], outPayloads + count * payloadBytes)){
+				count++;
+			}
+			continue;
+		}
+
+		LeafNodeInt *leaf = (LeafNodeInt *)currentPageData;
+		int size = index->leafCount(currentPageData);
+		int start = nextEntry;
+		// leaf ends, posting lists and entries that may have to be skipped go through fetch one at a time
+		bool clean = start >= 0 && start < size && (index->packedLeaves || leaf->ridArray[start].slot_number != POSTINGSLOT);
+		if(clean){
+			int key = index->leafKey(currentPageData, start);
+			if(scanReturned){
+				clean = descending ? key < lastKeyInt : key > lastKeyInt;
+			}
+			else{
+				clean = descending ? !aboveRange(key) : !belowRange(key);
+			}
+		}
+		if(!clean){
+			if(!fetch(out[count], outPayloads + count * payloadBytes)){
+				break;
+			}
+			count++;
+			continue;
+		}
+
+		// everything from start on in scan order is new and inside the near end of the range,
+		// find where the far end cuts the run of entries [first, end)
+		int first;
+		int end;
+		bool rangeEnd;
+		if(descending){
+			int limit = std::max(-1, start - (int)(max - count));
+			int lo = limit + 1;
+			int hi = start + 1;
+			while(lo < hi){
+				int mid = (lo + hi)/2;
+				if(belowRange(index->leafKey(currentPageData, mid))){
+					lo = mid + 1;
+				}
+				else{
+					hi = mid;
+				}
+			}
+			first = lo;
+			end = start + 1;
+			rangeEnd = first > limit + 1;
+		}
+		else{
+			int limit = std::min(size, start + (int)(max - count));
+			int lo = start;
+			int hi = limit;
+			while(lo < hi){
+				int mid = (lo + hi)/2;
+				if(aboveRange(index->leafKey(currentPageData, mid))){
+					hi = mid;
+				}
+				else{
+					lo = mid + 1;
+				}
+			}
+			first = start;
+			end = lo;
+			rangeEnd = end < limit;
+		}
+		if(!index->packedLeaves){
+			// the run stops short of the first posting list in scan order
+			for(int i = 0; i < end - first; i++){
+				int pos = descending ? end - 1 - i : first + i;
+				if(leaf->ridArray[pos].slot_number == POSTINGSLOT){
+					if(descending){
+						first = pos + 1;
+					}
+					else{
+						end = pos;
+					}
+					rangeEnd = false;
+					break;
+				}
+			}
+		}
+		int n = end - first;
+		if(n > 0){
+			if(index->packedLeaves){
+				// packed leaves are unpacked four entries at a time
+				index->packedDecode((PackedLeafInt *)currentPageData, first, end, nullptr, out + count);
+			}
+			else{
+				memcpy(out + count, leaf->ridArray + first, n * sizeof(RecordId));
+			}
+			if(descending){
+				std::reverse(out + count, out + count + n);
+			}
+			// included attributes come along, entry by entry when the run is reversed
+			if(payloadBytes > 0 && descending){
+				for(int i = 0; i < n; i++){
+					memcpy(outPayloads + (count + i) * payloadBytes, index->leafPayload(leaf, end - 1 - i), payloadBytes);
+				}
+			}
+			else if(payloadBytes > 0){
+				memcpy(outPayloads + count * payloadBytes, index->leafPayload(leaf, first), n * payloadBytes);
+			}
+		}
+		// the returned entries with the last key of the run have to be remembered
+		int runLastKey = index->leafKey(currentPageData, n > 0 ? (descending ? first : end - 1) : start);
+		int same = 0;
+		while(same < n && index->leafKey(currentPageData, descending ? first + same : end - 1 - same) == runLastKey){
+			same++;
+		}
+		if(!index->bufMgr->latch(currentPageData).validate(currentVersion)){
+			index->bufMgr->unPinPage(index->file, currentPageNum, false);
+			seek();
+			continue;
+		}
+
+		if(n > 0){
+			scanReturned = true;
+			lastKeyInt = runLastKey;
+			lastKeyRids.assign(out + count + n - same, out + count + n);
+			postingProgress.clear();
+			postingHead = 0;
+			count += n;
+			nextEntry = descending ? first - 1 : end;
+		}
+		if(rangeEnd){
+			scanCompleted = true;
+		}
+	}
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::setRange
+// -----------------------------------------------------------------------------
+const void BTreeCursor::setRange(const void* lowValParm, const Operator lowOpParm, const void* highValParm, const Operator highOpParm){
+	lowValInt = *((int *)lowValParm);
+	highValInt = *((int *)highValParm);
+	if((lowOpParm == EQ) != (highOpParm == EQ)){
+		throw BadOpcodesException();
+	}
+	if(lowOpParm == EQ){
+		if(lowValInt != highValInt){
+			throw BadScanrangeException();
+		}
+		// an equality scan is the range [key, key]
+		lowOp = GTE;
+		highOp = LTE;
+		return;
+	}
+	if(lowValInt > highValInt){
+		throw BadScanrangeException();
+	}
+	if(!((lowOpParm == GT or lowOpParm == GTE) and (highOpParm == LT or highOpParm == LTE))){
+		throw BadOpcodesException();
+	}
+	lowOp = lowOpParm;
+	highOp = highOpParm;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::fetch
+// -----------------------------------------------------------------------------
+const bool BTreeCursor::fetch(RecordId &outRid, char *outPayload){
+	while(!scanCompleted){
+		// an open posting list is read from its own pages until it ends
+		if(postingPageData != nullptr){
+			if(postingFetch(outRid)){
+				return true;
+			}
+			continue;
+		}
+
+		// read the entry optimistically, it only counts if the leaf did not change meanwhile
+		int key = 0;
+		RecordId rid;
+		bool entry = index->leafEntry(currentPageData, nextEntry, key, rid);
+		if(entry && outPayload != nullptr && index->payloadBytes > 0){
+			memcpy(outPayload, index->leafPayload((LeafNodeInt *)currentPageData, nextEntry), index->payloadBytes);
+		}
+		PageId sibling = descending ? index->leafLeftSibling(currentPageData) : index->leafSibling(currentPageData);
+		if(!index->bufMgr->latch(currentPageData).validate(currentVersion)){
+			index->bufMgr->unPinPage(index->file, currentPageNum, false);
+			seek();
+			continue;
+		}
+
+		if(!entry){
+			// the last leaf stays pinned until endScan
+			if(sibling == 0){
+				scanCompleted = true;
+			}
+			else{
+				moveSibling(sibling);
+			}
+			continue;
+		}
+		if(descending ? belowRange(key) : aboveRange(key)){
+			scanCompleted = true;
+			continue;
+		}
+		if(descending ? aboveRange(key) : belowRange(key)){
+			step();
+			continue;
+		}
+		// entries may move between leaves while the scan runs, skip what was already returned
+		if(scanReturned and ((descending ? key > lastKeyInt : key < lastKeyInt) or (key == lastKeyInt and
+			std::find(lastKeyRids.begin(), lastKeyRids.end(), rid) != lastKeyRids.end()))){
+			step();
+			continue;
+		}
+
+		if(!scanReturned || key != lastKeyInt){
+			scanReturned = true;
+			lastKeyInt = key;
+			lastKeyRids.clear();
+			postingProgress.clear();
+			postingHead = 0;
+		}
+		if(rid.slot_number == POSTINGSLOT){
+			// the entry stands for a posting list, which is returned before moving past the entry
+			if(postingHead != rid.page_number){
+				postingSwitch(rid.page_number);
+			}
+			if(postingFetch(outRid)){
+				return true;
+			}
+			continue;
+		}
+		step();
+		lastKeyRids.push_back(rid);
+		outRid = rid;
+		return true;
+	}
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::seek
+// -----------------------------------------------------------------------------
+const void BTreeCursor::seek(){
+	// a fresh descent also finds entries that moved into leaves before the current one in scan order
+	int key = scanReturned ? lastKeyInt : (descending ? highValInt : lowValInt);
+	while(true){
+		bool root_leaf;
+		index->findLeaf(key, currentPageNum, currentPageData, currentVersion, root_leaf, nullptr, descending);
+		int pos = descending ? index->leafUpperBound(currentPageData, key) - 1 : index->leafLowerBound(currentPageData, key);
+		if(index->bufMgr->latch(currentPageData).validate(currentVersion)){
+			nextEntry = pos;
+			return;
+		}
+		index->bufMgr->unPinPage(index->file, currentPageNum, false);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::moveSibling
+// -----------------------------------------------------------------------------
+const void BTreeCursor::moveSibling(PageId sibPageNo){
+	Page *nextPage;
+	index->bufMgr->readPage(index->file, sibPageNo, nextPage);
+	OptLatch &nextLatch = index->bufMgr->latch(nextPage);
+	std::uint64_t nextVersion;
+	while(!nextLatch.readLock(nextVersion) && !OptLatch::isObsolete(nextVersion)){
+		std::this_thread::yield();
+	}
+	// a descending scan starts at the last entry, the next read of the page validates the count
+	int entry = descending ? index->leafCount(nextPage) - 1 : 0;
+	// the current leaf still links to the page, so it is the right one
+	if(!OptLatch::isObsolete(nextVersion) && index->bufMgr->latch(currentPageData).validate(currentVersion)){
+		index->bufMgr->unPinPage(index->file, currentPageNum, false);
+		currentPageNum = sibPageNo;
+		currentPageData = nextPage;
+		currentVersion = nextVersion;
+		nextEntry = entry;
+		return;
+	}
+	index->bufMgr->unPinPage(index->file, sibPageNo, false);
+	index->bufMgr->unPinPage(index->file, currentPageNum, false);
+	seek();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::step
+// -----------------------------------------------------------------------------
+const void BTreeCursor::step(){
+	nextEntry += descending ? -1 : 1;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::belowRange
+// -----------------------------------------------------------------------------
+const bool BTreeCursor::belowRange(int key){
+	return (lowOp == GT and key <= lowValInt) or (lowOp == GTE and key < lowValInt);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::aboveRange
+// -----------------------------------------------------------------------------
+const bool BTreeCursor::aboveRange(int key){
+	return (highOp == LT and key >= highValInt) or (highOp == LTE and key > highValInt);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::postingSwitch
+// -----------------------------------------------------------------------------
+const void BTreeCursor::postingSwitch(PageId head){
+	// another list of the key can show up in front of the one being returned when
+	// duplicates are moved into a new list, come back to the old one where it was left
+	if(postingHead != 0 && postingReturned){
+		postingProgress.push_back(std::make_pair(postingHead, postingLastRid));
+	}
+	postingClose();
+	postingHead = head;
+	postingReturned = false;
+	for(size_t i = 0; i < postingProgress.size(); i++){
+		if(postingProgress[i].first == head){
+			postingReturned = true;
+			postingLastRid = postingProgress[i].second;
+			postingProgress.erase(postingProgress.begin() + i);
+			break;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::postingFetch
+// -----------------------------------------------------------------------------
+const bool BTreeCursor::postingFetch(RecordId &outRid){
+	while(true){
+		if(postingPageData == nullptr && !postingSeek()){
+			return false;
+		}
+		while(postingNext < postingCount){
+			RecordId rid = postingRids[postingNext++];
+			postingReturned = true;
+			postingLastRid = rid;
+			// entries returned from a leaf may have been moved into the list since
+			if(std::find(lastKeyRids.begin(), lastKeyRids.end(), rid) == lastKeyRids.end()){
+				outRid = rid;
+				return true;
+			}
+		}
+		if(postingNextPage == 0){
+			// the whole list was returned, move past the leaf entry standing for it
+			postingClose();
+			RecordId marker;
+			marker.page_number = postingHead;
+			marker.slot_number = POSTINGSLOT;
+			lastKeyRids.push_back(marker);
+			postingHead = 0;
+			postingReturned = false;
+			step();
+			return false;
+		}
+		if(!postingMoveRight()){
+			postingClose();
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::postingSeek
+// -----------------------------------------------------------------------------
+const bool BTreeCursor::postingSeek(){
+	BufMgr *bufMgr = index->bufMgr;
+	PageId pageNum = postingHead;
+	Page *page;
+	bufMgr->readPage(index->file, pageNum, page);
+	std::uint64_t version;
+	while(!bufMgr->latch(page).readLock(version) && !OptLatch::isObsolete(version)){
+		std::this_thread::yield();
+	}
+	// the list is alive as long as the leaf pointing to it did not change
+	if(OptLatch::isObsolete(version) || !bufMgr->latch(currentPageData).validate(currentVersion)){
+		bufMgr->unPinPage(index->file, pageNum, false);
+		return false;
+	}
+
+	// skip the pages that were returned completely
+	while(true){
+		PostingPageInt *posting = (PostingPageInt *)page;
+		PageId nextPageNum = posting->nextPageNo;
+		bool returned = postingReturned && !(postingLastRid < posting->lastRid);
+		if(!bufMgr->latch(page).validate(version)){
+			bufMgr->unPinPage(index->file, pageNum, false);
+			return false;
+		}
+		if(!returned || nextPageNum == 0){
+			break;
+		}
+		Page *nextPage;
+		bufMgr->readPage(index->file, nextPageNum, nextPage);
+		std::uint64_t nextVersion;
+		while(!bufMgr->latch(nextPage).readLock(nextVersion) && !OptLatch::isObsolete(nextVersion)){
+			std::this_thread::yield();
+		}
+		if(OptLatch::isObsolete(nextVersion) || !bufMgr->latch(page).validate(version)){
+			bufMgr->unPinPage(index->file, nextPageNum, false);
+			bufMgr->unPinPage(index->file, pageNum, false);
+			return false;
+		}
+		bufMgr->unPinPage(index->file, pageNum, false);
+		pageNum = nextPageNum;
+		page = nextPage;
+		version = nextVersion;
+	}
+
+	postingPageNum = pageNum;
+	postingPageData = page;
+	postingVersion = version;
+	if(!postingLoad()){
+		postingClose();
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::postingLoad
+// -----------------------------------------------------------------------------
+const bool BTreeCursor::postingLoad(){
+	PostingPageInt *posting = (PostingPageInt *)postingPageData;
+	if(postingRids.size() < (size_t)POSTINGCAPACITY){
+		postingRids.resize(POSTINGCAPACITY);
+	}
+	int count = index->postingDecode(posting, &postingRids[0]);
+	postingNextPage = posting->nextPageNo;
+	if(!index->bufMgr->latch(postingPageData).validate(postingVersion)){
+		return false;
+	}
+	postingCount = count;
+	postingNext = 0;
+	if(postingReturned){
+		postingNext = std::upper_bound(postingRids.begin(), postingRids.begin() + count, postingLastRid) - postingRids.begin();
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::postingMoveRight
+// -----------------------------------------------------------------------------
+const bool BTreeCursor::postingMoveRight(){
+	Page *nextPage;
+	index->bufMgr->readPage(index->file, postingNextPage, nextPage);
+	OptLatch &nextLatch = index->bufMgr->latch(nextPage);
+	std::uint64_t nextVersion;
+	while(!nextLatch.readLock(nextVersion) && !OptLatch::isObsolete(nextVersion)){
+		std::this_thread::yield();
+	}
+	if(!OptLatch::isObsolete(nextVersion) && index->bufMgr->latch(postingPageData).validate(postingVersion)){
+		index->bufMgr->unPinPage(index->file, postingPageNum, false);
+		postingPageNum = postingNextPage;
+		postingPageData = nextPage;
+		postingVersion = nextVersion;
+		return postingLoad();
+	}
+	index->bufMgr->unPinPage(index->file, postingNextPage, false);
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeCursor::postingClose
+// -----------------------------------------------------------------------------
+const void BTreeCursor::postingClose(){
+	if(postingPageData != nullptr){
+		index->bufMgr->unPinPage(index->file, postingPageNum, false);
+		postingPageData = nullptr;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::findLeaf
+// -----------------------------------------------------------------------------
+const void BTreeIndex::findLeaf(int key, PageId &leafPageNum, Page *&leafPage, std::uint64_t &version, bool &root_leaf, int *upper, bool after){
+	while(true){
+		Descent descent;
+		bool restart = !descendRoot(descent);
+		while(!restart && !descent.leaf){
+			restart = !descendChild(key, descent, after);
+		}
+		if(restart){
+			std::this_thread::yield();
+			continue;
+		}
+		leafPageNum = descent.pageNo;
+		leafPage = descent.page;
+		version = descent.version;
+		root_leaf = descent.rootLeaf;
+		if(upper != nullptr){
+			*upper = descent.upper;
+		}
+		return;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::findKeyLeaf
+// -----------------------------------------------------------------------------
+const void BTreeIndex::findKeyLeaf(const char *key, int length, bool after, PageId &leafPageNum, Page *&leafPage, std::uint64_t &version, bool &root_leaf){
+	while(true){
+		Descent descent;
+		bool restart = !descendRoot(descent);
+		while(!restart && !descent.leaf){
+			restart = !descendTo(keyChildIndex((NonLeafNodeInt *)descent.page, key, length, after), descent);
+		}
+		if(restart){
+			std::this_thread::yield();
+			continue;
+		}
+		leafPageNum = descent.pageNo;
+		leafPage = descent.page;
+		version = descent.version;
+		root_leaf = descent.rootLeaf;
+		return;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::descendRoot
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::descendRoot(Descent &descent){
+	std::uint64_t rootVersion;
+	if(!rootLatch.readLock(rootVersion)){
+		return false;
+	}
+	descent.pageNo = rootPageNum;
+	descent.leaf = initialroot == descent.pageNo;
+	descent.rootLeaf = descent.leaf;
+	descent.held = true;
+	descent.upper = std::numeric_limits<int>::max();
+	if(descent.leaf){
+		bufMgr->readPage(file, descent.pageNo, descent.page);
+	}
+	else{
+		readNode(descent.pageNo, descent.page, descent.held);
+	}
+	if(!bufMgr->latch(descent.page).readLock(descent.version) || !rootLatch.validate(rootVersion)){
+		releaseNode(descent.pageNo, descent.held, false);
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::descendChild
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::descendChild(int key, Descent &descent, bool after){
+	return descendTo(childPosition((NonLeafNodeInt *)descent.page, key, after), descent);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::childPosition
+// -----------------------------------------------------------------------------
+const int BTreeIndex::childPosition(NonLeafNodeInt *currentNode, int key, bool after){
+	int childPos = childIndex(currentNode, key);
+	// children right of a separator equal to key start with it
+	while(after && childPos < nodeOccupancy && currentNode->pageNoArray[childPos+1] != 0
+		&& currentNode->keyArray[childPos] == key){
+		childPos++;
+	}
+	return childPos;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::descendTo
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::descendTo(int childPos, Descent &descent){
+	OptLatch *latch = &bufMgr->latch(descent.page);
+	NonLeafNodeInt *currentNode = (NonLeafNodeInt *)descent.page;
+	PageId ref = currentNode->pageNoArray[childPos];
+	bool next_leaf = currentNode->level == 1;
+	// the separator right of the child bounds it, the last child inherits the bound of its parent
+	int upperKey = descent.upper;
+	if(childPos < nodeOccupancy && currentNode->pageNoArray[childPos+1] != 0){
+		upperKey = currentNode->keyArray[childPos];
+	}
+	if(!latch->validate(descent.version)){
+		releaseNode(descent.pageNo, descent.held, false);
+		return false;
+	}
+	Page *nextPage;
+	PageId nextPageNum;
+	bool nextHeld = true;
+	if(ref & SWIZZLEDBIT){
+		// the child keeps its frame until the reference is turned back, which changes this node.
+		// only the leaf, which is returned pinned, goes through the buffer manager
+		FrameId frame = ref & ~SWIZZLEDBIT;
+		nextPage = bufMgr->framePage(frame);
+		if(!next_leaf){
+			nextHeld = false;
+			nextPageNum = bufMgr->framePageNo(frame);
+		}
+		else if(!bufMgr->pinFrame(file, frame, nextPageNum)){
+			releaseNode(descent.pageNo, descent.held, false);
+			return false;
+		}
+	}
+	else{
+		nextPageNum = ref;
+		if(next_leaf){
+			bufMgr->readPage(file, nextPageNum, nextPage);
+		}
+		else{
+			readNode(nextPageNum, nextPage, nextHeld);
+		}
+	}
+	OptLatch *nextLatch = &bufMgr->latch(nextPage);
+	std::uint64_t nextVersion;
+	if(!nextLatch->readLock(nextVersion) || !latch->validate(descent.version)){
+		releaseNode(nextPageNum, nextHeld, false);
+		releaseNode(descent.pageNo, descent.held, false);
+		return false;
+	}
+	// nothing changed since the child was read, so the slot still refers to it
+	// locking the node makes every other reader of it start over, so not for a swizzle that would be refused
+	if(swizzling && !(ref & SWIZZLEDBIT) && bufMgr->swizzleRoom() && latch->upgrade(descent.version)){
+		if(bufMgr->swizzle(bufMgr->frameOf(descent.page), bufMgr->frameOf(nextPage), this)){
+			currentNode->pageNoArray[childPos] = SWIZZLEDBIT | bufMgr->frameOf(nextPage);
+		}
+		latch->unlock();
+	}
+	releaseNode(descent.pageNo, descent.held, false);
+	descent.pageNo = nextPageNum;
+	descent.page = nextPage;
+	descent.held = nextHeld;
+	descent.version = nextVersion;
+	descent.leaf = next_leaf;
+	descent.upper = upperKey;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::countBelow
+// -----------------------------------------------------------------------------
+const size_t BTreeIndex::countBelow(int key, bool inclusive){
+	while(true){
+		Descent descent;
+		bool restart = !descendRoot(descent);
+		// every entry below the children left of the descent comes before key, none right of it does
+		size_t below = 0;
+		while(!restart && !descent.leaf){
+			NonLeafNodeInt *currentNode = (NonLeafNodeInt *)descent.page;
+			int childPos = childPosition(currentNode, key, inclusive);
+			const int *counts = childCounts(currentNode);
+			for(int i = 0; i < childPos; i++){
+				below += counts[i];
+			}
+			restart = !descendTo(childPos, descent);
+		}
+		if(restart){
+			std::this_thread::yield();
+			continue;
+		}
+		int position = inclusive ? leafUpperBound(descent.page, key) : leafLowerBound(descent.page, key);
+		bool valid = bufMgr->latch(descent.page).validate(descent.version);
+		bufMgr->unPinPage(file, descent.pageNo, false);
+		if(valid){
+			return below + position;
+		}
+		std::this_thread::yield();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::prefetchNode
+// -----------------------------------------------------------------------------
+const void BTreeIndex::prefetchNode(const Page *page, bool leaf){
+	if(leaf && packedLeaves){
+		// the header and the first fields
+		__builtin_prefetch(page);
+		__builtin_prefetch((const char *)page + 64);
+	}
+	else if(leaf){
+		// the first probes of the binary searches for the size of the leaf and for the key
+		const LeafNodeInt *node = (const LeafNodeInt *)page;
+		for(int i = 1; i < 4; i++){
+			__builtin_prefetch(&node->keyArray[leafOccupancy * i / 4]);
+			__builtin_prefetch(&node->ridArray[leafOccupancy * i / 4]);
+		}
+	}
+	else if(blockedNonleaves){
+		// the level and the directory, which picks the one line of keys left to read
+		const NonLeafNodeInt *node = (const NonLeafNodeInt *)page;
+		__builtin_prefetch(node);
+		for(int i = 0; i < BLOCKEDLINES + (BLOCKEDLINES - 1) / LINEKEYS; i += LINEKEYS){
+			__builtin_prefetch(&node->keyArray[INTARRAYBLOCKEDSIZE + i]);
+		}
+	}
+	else{
+		// the level and the end of the child references, where the search starts
+		const NonLeafNodeInt *node = (const NonLeafNodeInt *)page;
+		__builtin_prefetch(node);
+		__builtin_prefetch(&node->pageNoArray[nodeOccupancy]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::prefetchChild
+// -----------------------------------------------------------------------------
+const void BTreeIndex::prefetchChild(int key, const Descent &descent){
+	// a page number has to be looked up in the buffer manager first, the child is prefetched once it is
+	// reached. Searching a plain node twice would cost more than the miss it hides
+	if(!blockedNonleaves){
+		return;
+	}
+	NonLeafNodeInt *node = (NonLeafNodeInt *)descent.page;
+	PageId ref = node->pageNoArray[childIndex(node, key)];
+	bool child_leaf = node->level == 1;
+	if((ref & SWIZZLEDBIT) && bufMgr->latch(descent.page).validate(descent.version)){
+		FrameId frame = ref & ~SWIZZLEDBIT;
+		bufMgr->prefetchFrame(frame);
+		prefetchNode(bufMgr->framePage(frame), child_leaf);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::~BTreeIndex -- nextNonleaf
+// -----------------------------------------------------------------------------
+const void BTreeIndex::nextNonleaf(NonLeafNodeInt *currentNode, PageId &nextNode, int check){
+	nextNode = childPageNo(currentNode, childIndex(currentNode, check));
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::childIndex
+// -----------------------------------------------------------------------------
+const int BTreeIndex::childIndex(NonLeafNodeInt *currentNode, int check){
+	if(blockedNonleaves){
+		return blockedChildIndex(currentNode, check);
+	}
+	int i = nodeOccupancy;
+	while(i >= 0 && (currentNode->pageNoArray[i] == 0)){
+		i--;
+	}
+	while(i > 0 && (currentNode->keyArray[i-1] >= check)){
+		i--;
+	}
+	return i;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::keyChildIndex
+// -----------------------------------------------------------------------------
+const int BTreeIndex::keyChildIndex(NonLeafNodeInt *currentNode, const char *key, int length, bool after){
+	// count the separators before key by their whole keys, which the first four bytes cannot tell apart
+	int lo = 0;
+	int hi;
+	if(compressedNonleaves){
+		// the prefix every separator of the node starts with puts key before or after all of them,
+		// unless key starts with it too
+		const std::uint16_t *header = compressedHeader(currentNode);
+		int prefix = std::min((int)header[1], payloadBytes);
+		hi = std::min((int)header[0], INTARRAYCOMPRESSEDSIZE);
+		int cmp = memcmp(compressedHeap(currentNode), key, std::min(prefix, length));
+		if(cmp != 0 || length <= prefix){
+			return (cmp < 0 || (after && cmp == 0)) ? hi : 0;
+		}
+	}
+	else{
+		hi = nonleafSize(currentNode);
+	}
+	while(lo < hi){
+		int mid = (lo + hi)/2;
+		int cmp = compressedNonleaves ? compareSuffix(currentNode, mid, key, length) : memcmp(separatorKey(currentNode, mid), key, length);
+		if(cmp < 0 || (after && cmp == 0)){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::blockedChildIndex
+// -----------------------------------------------------------------------------
+const int BTreeIndex::blockedChildIndex(NonLeafNodeInt *currentNode, int check){
+	// count the keys below check reading one line of the directory of lines, one line of the
+	// directory and one line of keys, comparing whole lines without branching on the keys
+	const int *lineLast = currentNode->keyArray + INTARRAYBLOCKEDSIZE;
+	const int *groupLast = lineLast + BLOCKEDLINES - 1;
+	// the node may be changing under an optimistic reader, which validates it afterwards
+	int size = std::min(std::max(groupLast[(BLOCKEDLINES - 1) / LINEKEYS], 0), INTARRAYBLOCKEDSIZE);
+	int entries = (size + LINEKEYS) / LINEKEYS - 1;
+
+	int group = 0;
+	while(group < entries / LINEKEYS && groupLast[group] < check){
+		group++;
+	}
+	int line = group * LINEKEYS;
+	int last = std::min(line + LINEKEYS, entries);
+	for(int i = group * LINEKEYS; i < last; i++){
+		line += lineLast[i] < check;
+	}
+	// the first line has one key less, it shares its cache line with the level
+	int i = line == 0 ? 0 : line * LINEKEYS - 1;
+	int end = std::min(line * LINEKEYS + LINEKEYS - 1, size);
+	int index = i;
+	for(; i < end; i++){
+		index += currentNode->keyArray[i] < check;
+	}
+	return index;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::blockNonleaf
+// -----------------------------------------------------------------------------
+const void BTreeIndex::blockNonleaf(NonLeafNodeInt *node){
+	if(!blockedNonleaves){
+		return;
+	}
+	int size = nonleafSize(node);
+	int *lineLast = node->keyArray + INTARRAYBLOCKEDSIZE;
+	int *groupLast = lineLast + BLOCKEDLINES - 1;
+	// every line but the one holding the last key is full
+	int entries = (size + LINEKEYS) / LINEKEYS - 1;
+	for(int i = 0; i < entries; i++){
+		lineLast[i] = node->keyArray[i * LINEKEYS + LINEKEYS - 2];
+	}
+	for(int i = 0; i < entries / LINEKEYS; i++){
+		groupLast[i] = lineLast[i * LINEKEYS + LINEKEYS - 1];
+	}
+	groupLast[(BLOCKEDLINES - 1) / LINEKEYS] = size;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::update
+// -----------------------------------------------------------------------------
+const void BTreeIndex::update(PageId firstPageInRoot, PageKeyPair<int> *newChild, const char *separator){
+	PageId newroot_Num;
+	Page *newRoot;
+	bufMgr->allocPage(file, newroot_Num, newRoot);
+	NonLeafNodeInt *newRootPage = (NonLeafNodeInt *)newRoot;
+
+	newRootPage->pageNoArray[0] = firstPageInRoot;
+	newRootPage->pageNoArray[1] = newChild->pageNo;
+	newRootPage->level = initialroot == rootPageNum ? 1 : 0;
+	newRootPage->keyArray[0] = newChild->key;
+	if(!keyAttrs.empty()){
+		storeSeparators(newRootPage, std::vector<char>(separator, separator + payloadBytes));
+	}
+	blockNonleaf(newRootPage);
+	if(countedNonleaves){
+		recountChild(newRootPage, 0);
+		recountChild(newRootPage, 1);
+	}
+
+	Page *m;
+	bufMgr->readPage(file, headerPageNum, m);
+	IndexMetaInfo *metaPage = (IndexMetaInfo *)m;
+	metaPage->rootPageNo = newroot_Num;
+	metaPage->leafRootPageNo = Page::INVALID_NUMBER;
+	rootPageNum = newroot_Num;
+	initialroot = Page::INVALID_NUMBER;
+
+	bufMgr->unPinPage(file, headerPageNum, true);
+	bufMgr->unPinPage(file, newroot_Num, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insert
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::insert(const RIDKeyPair<int> data, const char *payload){
+	// counted indexes descend to fix the counts anyway, an append would save them nothing
+	if(!countedNonleaves && appendRightmost(data, payload)){
+		return true;
+	}
+
+	std::uint64_t rootVersion;
+	if(!rootLatch.readLock(rootVersion)){
+		return false;
+	}
+	PageId currentPageNum = rootPageNum;
+	bool node_leaf = initialroot == currentPageNum;
+	Page *currentPage;
+	bool held = true;
+	if(node_leaf){
+		bufMgr->readPage(file, currentPageNum, currentPage);
+	}
+	else{
+		readNode(currentPageNum, currentPage, held);
+	}
+	OptLatch *latch = &bufMgr->latch(currentPage);
+	std::uint64_t version;
+	if(!latch->readLock(version) || !rootLatch.validate(rootVersion)){
+		releaseNode(currentPageNum, held, false);
+		return false;
+	}
+
+	// the root latch stands in for the parent of the root
+	Page *parentPage = nullptr;
+	PageId parentPageNum = 0;
+	bool parentHeld = true;
+	OptLatch *parentLatch = &rootLatch;
+	std::uint64_t parentVersion = rootVersion;
+	int index = 0;
+	// true while the descent follows the last child of every node
+	bool rightEdge = true;
+	// level of the current node, the root being at 0
+	int depth = 0;
+
+	while(!node_leaf){
+		NonLeafNodeInt *currentNode = (NonLeafNodeInt *)currentPage;
+		if(nonleafFull(currentNode, currentPageNum)){
+			// split full nodes on the way down so a split below always finds room in its parent
+			if(!parentLatch->upgrade(parentVersion)){
+				releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+				return false;
+			}
+			if(!latch->upgrade(version)){
+				parentLatch->unlock();
+				releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+				return false;
+			}
+			bool append = rightEdge && data.key > currentNode->keyArray[nonleafSize(currentNode)-1];
+			if(compressedNonleaves && parentPage != nullptr){
+				// a compressed parent may not have room for the separator, then it is split first
+				std::vector<char> keys;
+				loadSeparators(currentNode, nonleafSize(currentNode), keys);
+				if(!separatorRoom((NonLeafNodeInt *)parentPage, parentPageNum, index, &keys[nonleafSplitPoint(currentNode, append) * payloadBytes])){
+					latch->unlock();
+					parentLatch->unlock();
+					releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+					return false;
+				}
+			}
+			PageKeyPair<int> newChild;
+			char separator[MAXPAYLOADSIZE];
+			nonleafSplit(currentNode, newChild, separator, append);
+			PageId crowded = currentPageNum;
+			crowdedNode.compare_exchange_strong(crowded, 0);
+			Page *pinned;
+			if(parentPage == nullptr){
+				update(currentPageNum, &newChild, separator);
+				depth++;
+				if(pinnedLevels > 0){
+					pinNode(rootPageNum, pinned);
+				}
+			}
+			else{
+				nonleafInsertion((NonLeafNodeInt *)parentPage, &newChild, separator, index);
+			}
+			if(depth < pinnedLevels){
+				pinNode(newChild.pageNo, pinned);
+			}
+			latch->unlock();
+			parentLatch->unlock();
+			releaseNode(currentPageNum, held, true);
+			if(parentPage != nullptr){
+				releaseNode(parentPageNum, parentHeld, true);
+			}
+			return false;
+		}
+
+		int childPos = keyAttrs.empty() ? childIndex(currentNode, data.key) : keyChildIndex(currentNode, payload, payloadBytes, false);
+		PageId nextPageNum = childPageNo(currentNode, childPos);
+		bool next_leaf = currentNode->level == 1;
+		rightEdge = rightEdge && (childPos == nodeOccupancy || currentNode->pageNoArray[childPos+1] == 0);
+		if(!latch->validate(version)){
+			releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+			return false;
+		}
+		Page *nextPage;
+		bool nextHeld = true;
+		if(next_leaf){
+			bufMgr->readPage(file, nextPageNum, nextPage);
+		}
+		else{
+			readNode(nextPageNum, nextPage, nextHeld);
+		}
+		OptLatch *nextLatch = &bufMgr->latch(nextPage);
+		std::uint64_t nextVersion;
+		if(!nextLatch->readLock(nextVersion) || !latch->validate(version)){
+			releaseNode(nextPageNum, nextHeld, false);
+			releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+			return false;
+		}
+
+		if(parentPage != nullptr){
+			releaseNode(parentPageNum, parentHeld, false);
+		}
+		parentPage = currentPage;
+		parentPageNum = currentPageNum;
+		parentHeld = held;
+		parentLatch = latch;
+		parentVersion = version;
+		index = childPos;
+		currentPage = nextPage;
+		currentPageNum = nextPageNum;
+		held = nextHeld;
+		latch = nextLatch;
+		version = nextVersion;
+		node_leaf = next_leaf;
+		depth++;
+	}
+
+	LeafNodeInt *leaf = (LeafNodeInt *)currentPage;
+	bool room;
+	if(packedLeaves){
+		// packed leaves keep their duplicates, which take no bits of the key field
+		room = packedRoom((PackedLeafInt *)currentPage, data);
+	}
+	else{
+		// duplicates piling up in a leaf go to a posting list, so they neither fill nor split leaves.
+		// a list would count as one entry of its leaf, so counted indexes keep them in the leaves,
+		// and so do covering ones since lists have no room for included attributes
+		int size = leafSize(leaf);
+		int lo = 0;
+		int hi = size;
+		while(lo < hi){
+			int mid = (lo + hi)/2;
+			if(leaf->keyArray[mid] < data.key){
+				lo = mid + 1;
+			}
+			else{
+				hi = mid;
+			}
+		}
+		int run = 0;
+		int list = -1;
+		for(int i = lo; i < size && leaf->keyArray[i] == data.key; i++){
+			if(leaf->ridArray[i].slot_number != POSTINGSLOT){
+				run++;
+			}
+			else if(list < 0){
+				list = i;
+			}
+		}
+		if(!countedNonleaves && payloadBytes == 0 && (list >= 0 || run + 1 >= POSTINGTHRESHOLD)){
+			if(!latch->upgrade(version)){
+				releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+				return false;
+			}
+			if(list >= 0){
+				postingInsert(leaf->ridArray[list].page_number, data.rid);
+			}
+			else{
+				postingCreate(leaf, lo, run, data.rid);
+			}
+			latch->unlock();
+			bufMgr->unPinPage(file, currentPageNum, list < 0);
+			if(parentPage != nullptr){
+				releaseNode(parentPageNum, parentHeld, false);
+			}
+			return true;
+		}
+		room = leaf->ridArray[leafOccupancy - 1].page_number == 0;
+	}
+
+	if (room){
+		if(!latch->upgrade(version)){
+			releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+			return false;
+		}
+		if(packedLeaves){
+			packedInsert((PackedLeafInt *)currentPage, data);
+		}
+		else{
+			leafInsertion(leaf, data, payload);
+		}
+		if(leafSibling(currentPage) == 0){
+			cacheRightmost(currentPageNum, leafKey(currentPage, 0));
+		}
+		latch->unlock();
+		bufMgr->unPinPage(file, currentPageNum, true);
+		if(parentPage != nullptr){
+			releaseNode(parentPageNum, parentHeld, false);
+		}
+		return true;
+	}
+
+	if(!parentLatch->upgrade(parentVersion)){
+		releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+		return false;
+	}
+	if(!latch->upgrade(version)){
+		parentLatch->unlock();
+		releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+		return false;
+	}
+	char separator[MAXPAYLOADSIZE];
+	if(!keyAttrs.empty()){
+		leafSplitSeparator(leaf, data, payload, separator);
+		if(parentPage != nullptr && !separatorRoom((NonLeafNodeInt *)parentPage, parentPageNum, index, separator)){
+			latch->unlock();
+			parentLatch->unlock();
+			releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+			return false;
+		}
+	}
+	// the right sibling gets the new leaf as its left sibling. it is latched without waiting, like
+	// everything else an insert latches, so an insert never waits while holding a latch
+	PageId rightPageNum = leafSibling(currentPage);
+	Page *rightPage = nullptr;
+	if(rightPageNum != 0){
+		bufMgr->readPage(file, rightPageNum, rightPage);
+		OptLatch &rightLatch = bufMgr->latch(rightPage);
+		std::uint64_t rightVersion;
+		if(!rightLatch.readLock(rightVersion) || !rightLatch.upgrade(rightVersion)){
+			bufMgr->unPinPage(file, rightPageNum, false);
+			latch->unlock();
+			parentLatch->unlock();
+			releasePath(currentPageNum, held, parentPage, parentPageNum, parentHeld);
+			return false;
+		}
+	}
+	PageKeyPair<int> newChild;
+	bool rightmost = rightPageNum == 0;
+	if(packedLeaves){
+		packedSplit((PackedLeafInt *)currentPage, currentPageNum, newChild, data);
+	}
+	else{
+		leafSplit(leaf, currentPageNum, newChild, separator, data, payload);
+	}
+	if(rightPage != nullptr){
+		setLeftSibling(rightPage, newChild.pageNo);
+		unlatchPage(rightPageNum, rightPage, true);
+	}
+	if(parentPage == nullptr){
+		update(currentPageNum, &newChild, separator);
+		Page *pinned;
+		if(pinnedLevels > 0){
+			pinNode(rootPageNum, pinned);
+		}
+	}
+	else{
+		nonleafInsertion((NonLeafNodeInt *)parentPage, &newChild, separator, index);
+	}
+	if(rightmost){
+		cacheRightmost(newChild.pageNo, newChild.key);
+	}
+	latch->unlock();
+	parentLatch->unlock();
+	bufMgr->unPinPage(file, currentPageNum, true);
+	if(parentPage != nullptr){
+		releaseNode(parentPageNum, parentHeld, true);
+	}
+	// a packed leaf is split without the entry, which goes into one of the halves on the next attempt
+	return !packedLeaves;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::appendRightmost
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::appendRightmost(const RIDKeyPair<int> data, const char *payload){
+	std::uint64_t cacheVersion;
+	if(!rightmostLatch.readLock(cacheVersion)){
+		return false;
+	}
+	PageId leafPageNum = rightmostLeaf;
+	int lowKey = rightmostLowKey;
+	if(leafPageNum == 0 || data.key <= lowKey || !rightmostLatch.validate(cacheVersion)){
+		return false;
+	}
+	Page *leafPage;
+	bufMgr->readPage(file, leafPageNum, leafPage);
+	OptLatch &latch = bufMgr->latch(leafPage);
+	std::uint64_t version;
+	// a freed leaf is dropped from the cache before it goes back to the file
+	if(!latch.readLock(version) || !rightmostLatch.validate(cacheVersion)){
+		bufMgr->unPinPage(file, leafPageNum, false);
+		return false;
+	}
+
+	// an entry after every key of the last leaf belongs there whatever the separators above it are
+	int count = leafCount(leafPage);
+	bool append = count > 0 && leafSibling(leafPage) == 0 && data.key > leafKey(leafPage, count - 1);
+	if(packedLeaves){
+		append = append && packedRoom((PackedLeafInt *)leafPage, data);
+	}
+	else{
+		append = append && count < leafOccupancy;
+	}
+	if(!append || !latch.upgrade(version)){
+		bufMgr->unPinPage(file, leafPageNum, false);
+		return false;
+	}
+	if(packedLeaves){
+		packedInsert((PackedLeafInt *)leafPage, data);
+	}
+	else{
+		LeafNodeInt *leaf = (LeafNodeInt *)leafPage;
+		leaf->keyArray[count] = data.key;
+		leaf->ridArray[count] = data.rid;
+		if(payloadBytes > 0){
+			memcpy(leafPayload(leaf, count), payload, payloadBytes);
+		}
+	}
+	latch.unlock();
+	bufMgr->unPinPage(file, leafPageNum, true);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::cacheRightmost
+// -----------------------------------------------------------------------------
+const void BTreeIndex::cacheRightmost(PageId leafPageNum, int lowKey){
+	// only bump the version, which sends appends in flight back to the descent, when the leaf changes
+	std::uint64_t cacheVersion;
+	if(rightmostLatch.readLock(cacheVersion) && rightmostLeaf == leafPageNum
+		&& rightmostLatch.validate(cacheVersion)){
+		return;
+	}
+	rightmostLatch.lock();
+	rightmostLeaf = leafPageNum;
+	rightmostLowKey = lowKey;
+	rightmostLatch.unlock();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::insertRun
+// -----------------------------------------------------------------------------
+const size_t BTreeIndex::insertRun(const RIDKeyPair<int> *entries, size_t count){
+	PageId leafPageNum;
+	Page *leafPage;
+	std::uint64_t version;
+	bool root_leaf;
+	int upper;
+	findLeaf(entries[0].key, leafPageNum, leafPage, version, root_leaf, &upper);
+	// the key range of a leaf only changes along with the leaf, which the upgrade checks
+	if(!bufMgr->latch(leafPage).upgrade(version)){
+		bufMgr->unPinPage(file, leafPageNum, false);
+		return 0;
+	}
+
+	size_t placed = 0;
+	bool dirty = false;
+	while(true){
+		size_t run = 0;
+		while(placed + run < count && entries[placed + run].key <= upper){
+			run++;
+		}
+		size_t merged;
+		if(packedLeaves){
+			merged = packedInsertRun((PackedLeafInt *)leafPage, entries + placed, run);
+		}
+		else{
+			merged = leafInsertRun((LeafNodeInt *)leafPage, entries + placed, run);
+		}
+		placed += merged;
+		dirty = merged > 0;
+		if(dirty && leafSibling(leafPage) == 0){
+			cacheRightmost(leafPageNum, leafKey(leafPage, 0));
+		}
+		if(merged < run || placed == count || leafSibling(leafPage) == 0){
+			break;
+		}
+
+		// move right instead of descending again while the next entry falls between the first and last
+		// key of the sibling, which bound the separators around it. the sibling cannot be merged away
+		// while this leaf is latched
+		PageId rightPageNum = leafSibling(leafPage);
+		Page *rightPage;
+		bufMgr->readPage(file, rightPageNum, rightPage);
+		OptLatch &rightLatch = bufMgr->latch(rightPage);
+		std::uint64_t rightVersion;
+		if(!rightLatch.readLock(rightVersion) || !rightLatch.upgrade(rightVersion)){
+			bufMgr->unPinPage(file, rightPageNum, false);
+			break;
+		}
+		int rightCount = leafCount(rightPage);
+		if(rightCount == 0 || entries[placed].key <= leafKey(rightPage, 0)
+			|| entries[placed].key > leafKey(rightPage, rightCount - 1)){
+			unlatchPage(rightPageNum, rightPage, false);
+			break;
+		}
+		upper = leafKey(rightPage, rightCount - 1);
+		unlatchPage(leafPageNum, leafPage, true);
+		leafPageNum = rightPageNum;
+		leafPage = rightPage;
+	}
+	unlatchPage(leafPageNum, leafPage, dirty);
+	return placed;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafInsertRun
+// -----------------------------------------------------------------------------
+const size_t BTreeIndex::leafInsertRun(LeafNodeInt *leaf, const RIDKeyPair<int> *entries, size_t count){
+	int size = leafSize(leaf);
+	size_t room = leafOccupancy - size;
+	// stop at the first entry that would make insert() start or extend a posting list
+	size_t take = 0;
+	int pos = 0;
+	int batchRun = 0;
+	while(take < count && take < room){
+		int key = entries[take].key;
+		while(pos < size && leaf->keyArray[pos] < key){
+			pos++;
+		}
+		int run = 0;
+		bool list = false;
+		for(int i = pos; i < size && leaf->keyArray[i] == key; i++){
+			if(leaf->ridArray[i].slot_number == POSTINGSLOT){
+				list = true;
+			}
+			else{
+				run++;
+			}
+		}
+		batchRun = take > 0 && entries[take-1].key == key ? batchRun + 1 : 0;
+		if(list || run + batchRun + 1 >= POSTINGTHRESHOLD){
+			break;
+		}
+		take++;
+	}
+
+	// merge from the back, each entry going after those with the same key already in the leaf
+	int from = size - 1;
+	int to = size + (int)take - 1;
+	for(int i = (int)take - 1; i >= 0; i--){
+		while(from >= 0 && leaf->keyArray[from] > entries[i].key){
+			leaf->keyArray[to] = leaf->keyArray[from];
+			leaf->ridArray[to] = leaf->ridArray[from];
+			from--;
+			to--;
+		}
+		leaf->keyArray[to] = entries[i].key;
+		leaf->ridArray[to] = entries[i].rid;
+		to--;
+	}
+	return take;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedInsertRun
+// -----------------------------------------------------------------------------
+const size_t BTreeIndex::packedInsertRun(PackedLeafInt *leaf, const RIDKeyPair<int> *entries, size_t count){
+	if(count < 8){
+		// shifting a few entries in place is cheaper than decoding and encoding the whole leaf
+		size_t placed = 0;
+		while(placed < count && packedRoom(leaf, entries[placed])){
+			packedInsert(leaf, entries[placed]);
+			placed++;
+		}
+		return placed;
+	}
+	int size = leaf->count;
+	int oldKeys[PACKEDLEAFSIZE];
+	RecordId oldRids[PACKEDLEAFSIZE];
+	int keys[PACKEDLEAFSIZE];
+	RecordId rids[PACKEDLEAFSIZE];
+	packedDecode(leaf, 0, size, oldKeys, oldRids);
+	// wider fields may leave room for fewer entries, halve the run until it fits
+	size_t take = std::min(count, (size_t)(PACKEDLEAFSIZE - size));
+	while(take > 0){
+		int from = 0;
+		size_t next = 0;
+		for(int to = 0; to < size + (int)take; to++){
+			if(next < take && (from == size || entries[next].key < oldKeys[from])){
+				keys[to] = entries[next].key;
+				rids[to] = entries[next].rid;
+				next++;
+			}
+			else{
+				keys[to] = oldKeys[from];
+				rids[to] = oldRids[from];
+				from++;
+			}
+		}
+		if(packedEncode(leaf, keys, rids, size + (int)take)){
+			return take;
+		}
+		take /= 2;
+	}
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::releasePath
+// -----------------------------------------------------------------------------
+const void BTreeIndex::releasePath(PageId currentPageNum, bool held, Page *parentPage, PageId parentPageNum, bool parentHeld){
+	releaseNode(currentPageNum, held, false);
+	if(parentPage != nullptr){
+		releaseNode(parentPageNum, parentHeld, false);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::readNode
+// -----------------------------------------------------------------------------
+const void BTreeIndex::readNode(PageId pageNum, Page *&page, bool &held){
+	held = !pinnedPage(pageNum, page);
+	if(held){
+		bufMgr->readPage(file, pageNum, page);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::releaseNode
+// -----------------------------------------------------------------------------
+const void BTreeIndex::releaseNode(PageId pageNum, bool held, bool dirty){
+	// a pinned node cannot be evicted before it is unpinned, which always writes it back
+	if(held){
+		bufMgr->unPinPage(file, pageNum, dirty);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::pinnedPage
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::pinnedPage(PageId pageNum, Page *&page){
+	std::uint64_t pinVersion;
+	if(pinnedLevels == 0 || !pinLatch.readLock(pinVersion)){
+		return false;
+	}
+	// the frame may be reused as soon as the node is freed, which changes the version of the parent
+	// that pointed to it, so callers validate the parent after reading the latch of the node
+	Page *found = nullptr;
+	int slot = pageNum & (PINNEDSLOTS - 1);
+	for(int probes = 0; probes < PINNEDSLOTS && pinnedNodes[slot].pageNo != Page::INVALID_NUMBER; probes++){
+		if(pinnedNodes[slot].pageNo == pageNum){
+			found = pinnedNodes[slot].page;
+			break;
+		}
+		slot = (slot + 1) & (PINNEDSLOTS - 1);
+	}
+	if(found == nullptr || !pinLatch.validate(pinVersion)){
+		return false;
+	}
+	page = found;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::pinNode
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::pinNode(PageId pageNum, Page *&page){
+	if(pinnedPage(pageNum, page)){
+		return true;
+	}
+	bufMgr->readPage(file, pageNum, page);
+	pinLatch.lock();
+	int slot = pageNum & (PINNEDSLOTS - 1);
+	while(pinnedNodes[slot].pageNo != Page::INVALID_NUMBER && pinnedNodes[slot].pageNo != pageNum){
+		slot = (slot + 1) & (PINNEDSLOTS - 1);
+	}
+	bool present = pinnedNodes[slot].pageNo == pageNum;
+	bool pinned = !present && pinnedCount < PINNEDSLOTS / 2;
+	if(pinned){
+		pinnedNodes[slot].pageNo = pageNum;
+		pinnedNodes[slot].page = page;
+		pinnedCount++;
+	}
+	pinLatch.unlock();
+	if(!pinned){
+		// either full, or pinned by someone else in between
+		bufMgr->unPinPage(file, pageNum, false);
+	}
+	return pinned || present;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::unpinNode
+// -----------------------------------------------------------------------------
+const void BTreeIndex::unpinNode(PageId pageNum){
+	if(pinnedNodes.empty()){
+		return;
+	}
+	pinLatch.lock();
+	int slot = pageNum & (PINNEDSLOTS - 1);
+	while(pinnedNodes[slot].pageNo != Page::INVALID_NUMBER && pinnedNodes[slot].pageNo != pageNum){
+		slot = (slot + 1) & (PINNEDSLOTS - 1);
+	}
+	bool found = pinnedNodes[slot].pageNo == pageNum;
+	if(found){
+		pinnedNodes[slot].pageNo = Page::INVALID_NUMBER;
+		pinnedNodes[slot].page = nullptr;
+		pinnedCount--;
+		// move later nodes of the probe sequence back so none is cut off from its home slot
+		int hole = slot;
+		slot = (slot + 1) & (PINNEDSLOTS - 1);
+		while(pinnedNodes[slot].pageNo != Page::INVALID_NUMBER){
+			int home = pinnedNodes[slot].pageNo & (PINNEDSLOTS - 1);
+			if(((slot - home) & (PINNEDSLOTS - 1)) >= ((slot - hole) & (PINNEDSLOTS - 1))){
+				pinnedNodes[hole] = pinnedNodes[slot];
+				pinnedNodes[slot].pageNo = Page::INVALID_NUMBER;
+				pinnedNodes[slot].page = nullptr;
+				hole = slot;
+			}
+			slot = (slot + 1) & (PINNEDSLOTS - 1);
+		}
+	}
+	pinLatch.unlock();
+	if(found){
+		bufMgr->unPinPage(file, pageNum, false);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::unpinNodes
+// -----------------------------------------------------------------------------
+const void BTreeIndex::unpinNodes(){
+	if(pinnedNodes.empty()){
+		return;
+	}
+	pinLatch.lock();
+	for(size_t slot = 0; slot < pinnedNodes.size(); slot++){
+		if(pinnedNodes[slot].pageNo != Page::INVALID_NUMBER){
+			bufMgr->unPinPage(file, pinnedNodes[slot].pageNo, true);
+			pinnedNodes[slot].pageNo = Page::INVALID_NUMBER;
+			pinnedNodes[slot].page = nullptr;
+		}
+	}
+	pinnedCount = 0;
+	pinLatch.unlock();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::childPageNo
+// -----------------------------------------------------------------------------
+const PageId BTreeIndex::childPageNo(NonLeafNodeInt *node, int index){
+	PageId ref = node->pageNoArray[index];
+	if(ref & SWIZZLEDBIT){
+		return bufMgr->framePageNo(ref & ~SWIZZLEDBIT);
+	}
+	return ref;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::unswizzleChild
+// -----------------------------------------------------------------------------
+const void BTreeIndex::unswizzleChild(NonLeafNodeInt *node, int index){
+	PageId ref = node->pageNoArray[index];
+	if(ref & SWIZZLEDBIT){
+		node->pageNoArray[index] = bufMgr->unswizzle(ref & ~SWIZZLEDBIT);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::unswizzle
+// -----------------------------------------------------------------------------
+bool BTreeIndex::unswizzle(Page *parent, FrameId child, PageId pageNo){
+	// the buffer pool is locked, so give up rather than wait for whoever holds the parent
+	OptLatch &latch = bufMgr->latch(parent);
+	std::uint64_t version;
+	if(!latch.readLock(version) || !latch.upgrade(version)){
+		return false;
+	}
+	NonLeafNodeInt *node = (NonLeafNodeInt *)parent;
+	bool found = false;
+	for(int i = 0; i <= nodeOccupancy && !found; i++){
+		if(node->pageNoArray[i] == (SWIZZLEDBIT | child)){
+			node->pageNoArray[i] = pageNo;
+			found = true;
+		}
+	}
+	latch.unlock();
+	return found;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafSplit
+// -----------------------------------------------------------------------------
+const void BTreeIndex::leafSplit(LeafNodeInt *leaf, PageId leafPageNum, PageKeyPair<int> &newChild, const char *separator, const RIDKeyPair<int> data, const char *payload){
+	PageId newPageNum;
+	Page *newPage;
+	bufMgr->allocPage(file, newPageNum, newPage);
+	LeafNodeInt *new_leafNode = (LeafNodeInt *)newPage;
+	int median = leafSplitPoint(leaf, data, payload);
+
+	for(int i = median; i < leafOccupancy; i++) {
+		new_leafNode->keyArray[i-median] = leaf->keyArray[i];
+		new_leafNode->ridArray[i-median] = leaf->ridArray[i];
+		leaf->keyArray[i] = 0;
+		leaf->ridArray[i].page_number = 0;
+	}
+	movePayloads(new_leafNode, 0, leaf, median, leafOccupancy - median);
+
+	if (compareEntry(leaf, median-1, data.key, payload) < 0) {
+		leafInsertion(new_leafNode, data, payload);
+	}
+	else{
+		leafInsertion(leaf, data, payload);
+	}
+
+	// the new leaf is complete before the old one links to it
+	new_leafNode->rightSibPageNo = leaf->rightSibPageNo;
+	new_leafNode->leftSibPageNo = leafPageNum;
+	leaf->rightSibPageNo = newPageNum;
+
+	newChild.set(newPageNum, keyAttrs.empty() ? new_leafNode->keyArray[0] : keyPrefix(separator, payloadBytes, 0x00));
+	bufMgr->unPinPage(file, newPageNum, true);
+}
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafInsertion
+// -----------------------------------------------------------------------------
+const void BTreeIndex::leafInsertion(LeafNodeInt *leaf, RIDKeyPair<int> entry, const char *payload)
+{
+	int pos = 0;
+	if (leaf->ridArray[0].page_number == 0){
+		leaf->ridArray[0] = entry.rid;
+		leaf->keyArray[0] = entry.key;
+	}
+	else {
+		int i = leafOccupancy - 1;
+		while(i >= 0 && (leaf->ridArray[i].page_number == 0)) {
+			i--;
+		}
+		int last = i;
+		while(i >= 0 && compareEntry(leaf, i, entry.key, payload) > 0) {
+			leaf->ridArray[i+1] = leaf->ridArray[i];
+			leaf->keyArray[i+1] = leaf->keyArray[i];
+			i--;
+		}
+		leaf->ridArray[i+1] = entry.rid;
+		leaf->keyArray[i+1] = entry.key;
+		pos = i + 1;
+		movePayloads(leaf, pos + 1, leaf, pos, last + 1 - pos);
+	}
+	if (payloadBytes > 0){
+		memcpy(leafPayload(leaf, pos), payload, payloadBytes);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafSplit
+// -----------------------------------------------------------------------------
+const void BTreeIndex::nonleafSplit(NonLeafNodeInt *p_node, PageKeyPair<int> &newChild, char *separator, bool append){
+	PageId newPageNum;
+	Page *newPage;
+	bufMgr->allocPage(file, newPageNum, newPage);
+	NonLeafNodeInt *newNode = (NonLeafNodeInt *)newPage;
+
+	// keys right of the middle one move to the new node, the middle key is pushed up.
+	// compressed nodes may run out of room for separators before they run out of slots
+	int size = nonleafSize(p_node);
+	int median = nonleafSplitPoint(p_node, append);
+	if(!keyAttrs.empty()){
+		std::vector<char> keys;
+		loadSeparators(p_node, size, keys);
+		memcpy(separator, &keys[median * payloadBytes], payloadBytes);
+		storeSeparators(newNode, std::vector<char>(keys.begin() + (median + 1) * payloadBytes, keys.end()));
+		keys.resize(median * payloadBytes);
+		storeSeparators(p_node, keys);
+	}
+	// the buffer manager looks for swizzled children in the node they were swizzled in
+	for(int i = median + 1; i <= size; i++){
+		unswizzleChild(p_node, i);
+	}
+	for(int i = median + 1; i < size; i++){
+		newNode->keyArray[i-median-1] = p_node->keyArray[i];
+		newNode->pageNoArray[i-median-1] = p_node->pageNoArray[i];
+	}
+	newNode->pageNoArray[size-median-1] = p_node->pageNoArray[size];
+	newNode->level = p_node->level;
+	newChild.set(newPageNum, keyAttrs.empty() ? p_node->keyArray[median] : keyPrefix(separator, payloadBytes, 0x00));
+	if(countedNonleaves){
+		// the counts go along with their children
+		for(int i = median + 1; i <= size; i++){
+			childCounts(newNode)[i-median-1] = childCounts(p_node)[i];
+			childCounts(p_node)[i] = 0;
+		}
+	}
+
+	for(int i = median; i < size; i++){
+		p_node->keyArray[i] = 0;
+		p_node->pageNoArray[i+1] = (PageId) 0;
+	}
+	blockNonleaf(p_node);
+	blockNonleaf(newNode);
+	bufMgr->unPinPage(file, newPageNum, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafInsertion
+// -----------------------------------------------------------------------------
+const void BTreeIndex::nonleafInsertion(NonLeafNodeInt *nonleaf, PageKeyPair<int> *entry, const char *separator, int index){
+	// the new page goes right after the child at index that was split
+	int i = nonleafSize(nonleaf);
+	if(!keyAttrs.empty()){
+		std::vector<char> keys;
+		loadSeparators(nonleaf, i, keys);
+		keys.insert(keys.begin() + index * payloadBytes, separator, separator + payloadBytes);
+		storeSeparators(nonleaf, keys);
+	}
+	while( i > index) {
+		nonleaf->keyArray[i] = nonleaf->keyArray[i-1];
+		nonleaf->pageNoArray[i+1] = nonleaf->pageNoArray[i];
+		if(countedNonleaves){
+			childCounts(nonleaf)[i+1] = childCounts(nonleaf)[i];
+		}
+		i--;
+	}
 	nonleaf->keyArray[i] = entry->key;
 	nonleaf->pageNoArray[i+1] = entry->pageNo;
+	blockNonleaf(nonleaf);
+	if(countedNonleaves){
+		// the entries of the child that was split are now below it and the new page
+		recountChild(nonleaf, index);
+		recountChild(nonleaf, index+1);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::childCounts
+// -----------------------------------------------------------------------------
+int *BTreeIndex::childCounts(NonLeafNodeInt *node){
+	return node->keyArray + INTARRAYCOUNTEDSIZE;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::recountChild
+// -----------------------------------------------------------------------------
+const void BTreeIndex::recountChild(NonLeafNodeInt *node, int index){
+	// writers to counted indexes run one at a time, so the child can be read without its latch
+	PageId childNum = childPageNo(node, index);
+	Page *childPage;
+	int count = 0;
+	if(node->level == 1){
+		bufMgr->readPage(file, childNum, childPage);
+		count = leafCount(childPage);
+		bufMgr->unPinPage(file, childNum, false);
+	}
+	else{
+		bool held;
+		readNode(childNum, childPage, held);
+		NonLeafNodeInt *child = (NonLeafNodeInt *)childPage;
+		const int *counts = childCounts(child);
+		int size = nonleafSize(child);
+		for(int i = 0; i <= size; i++){
+			count += counts[i];
+		}
+		releaseNode(childNum, held, false);
+	}
+	childCounts(node)[index] = count;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::recountPath
+// -----------------------------------------------------------------------------
+const void BTreeIndex::recountPath(int key, const char *wholeKey){
+	// the caller holds structureMutex, so the path the insert took is still there
+	if(initialroot == rootPageNum){
+		return;
+	}
+	std::vector<Descent> path;
+	std::vector<int> positions;
+	PageId currentPageNum = rootPageNum;
+	while(true){
+		Descent node;
+		node.pageNo = currentPageNum;
+		readNode(currentPageNum, node.page, node.held);
+		NonLeafNodeInt *currentNode = (NonLeafNodeInt *)node.page;
+		int childPos = keyAttrs.empty() ? childIndex(currentNode, key) : keyChildIndex(currentNode, wholeKey, payloadBytes, false);
+		path.push_back(node);
+		positions.push_back(childPos);
+		if(currentNode->level == 1){
+			break;
+		}
+		currentPageNum = childPageNo(currentNode, childPos);
+	}
+	// every count is the sum of those of the node below it, which is fixed first
+	for(int i = (int)path.size() - 1; i >= 0; i--){
+		OptLatch &latch = bufMgr->latch(path[i].page);
+		latch.lock();
+		recountChild((NonLeafNodeInt *)path[i].page, positions[i]);
+		latch.unlock();
+		releaseNode(path[i].pageNo, path[i].held, true);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::checkKey
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::checkKey(int lowValParm, const Operator lowOp, int highValParm, const Operator highOp, int check){
+	if(lowOp == GTE && highOp == LTE){
+		return check <= highValParm && check >= lowValParm;
+	}
+	else if(lowOp == GT && highOp == LTE){
+		return check <= highValParm && check > lowValParm;
+	}
+	else if(lowOp == GTE && highOp == LT){
+		return check < highValParm && check >= lowValParm;
+	}
+	else{
+		return check < highValParm && check > lowValParm;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::remove
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::remove(Page *currentPage, PageId currentPageNum, bool node_leaf, const RIDKeyPair<int> data, const char *key, int &remaining){
+	if (node_leaf){
+		bool found;
+		if (packedLeaves){
+			PackedLeafInt *leaf = (PackedLeafInt *)currentPage;
+			found = packedRemoval(leaf, data);
+			remaining = leaf->count;
+		}
+		else{
+			LeafNodeInt *leaf = (LeafNodeInt *)currentPage;
+			found = leafRemoval(leaf, data);
+			remaining = leafSize(leaf);
+		}
+		unlatchPage(currentPageNum, currentPage, found);
+		return found;
+	}
+
+	NonLeafNodeInt *currentNode = (NonLeafNodeInt *)currentPage;
+	bool child_leaf = currentNode->level == 1;
+	int size = nonleafSize(currentNode);
+	int i = keyAttrs.empty() ? childIndex(currentNode, data.key) : keyChildIndex(currentNode, key, payloadBytes, false);
+	int childRemaining;
+	bool found;
+	while (true){
+		PageId childNum = childPageNo(currentNode, i);
+		Page *childPage;
+		bufMgr->readPage(file, childNum, childPage);
+		bufMgr->latch(childPage).lock();
+		found = remove(childPage, childNum, child_leaf, data, key, childRemaining);
+		if (found || i == size){
+			break;
+		}
+		// duplicates of the key may continue into the children on the right
+		if (keyAttrs.empty() ? currentNode->keyArray[i] > data.key : compareSeparator(currentNode, i, key, payloadBytes) > 0){
+			break;
+		}
+		i++;
+	}
+
+	bool dirty = false;
+	if (found && child_leaf && packedLeaves){
+		// whether a packed leaf underflows depends on its capacity, which it checks itself
+		packedRebalance(currentNode, i);
+		dirty = true;
+	}
+	else if (found && child_leaf && childRemaining < leafOccupancy/2){
+		leafRebalance(currentNode, i);
+		dirty = true;
+	}
+	else if (found && !child_leaf && childRemaining < nodeOccupancy/2){
+		nonleafRebalance(currentNode, i);
+		dirty = true;
+	}
+	if (found && countedNonleaves){
+		// the child lost the entry, and borrows and merges moved entries between it and its siblings
+		int last = std::min(i + 1, nonleafSize(currentNode));
+		for (int j = std::max(i - 1, 0); j <= last; j++){
+			recountChild(currentNode, j);
+		}
+		dirty = true;
+	}
+	remaining = nonleafSize(currentNode);
+	unlatchPage(currentPageNum, currentPage, dirty);
+	return found;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafRemoval
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::leafRemoval(LeafNodeInt *leaf, const RIDKeyPair<int> entry){
+	int size = leafSize(leaf);
+	int lo = 0;
+	int hi = size;
+	while (lo < hi){
+		int mid = (lo + hi)/2;
+		if (leaf->keyArray[mid] < entry.key){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	int first = lo;
+	while (lo < size && leaf->keyArray[lo] == entry.key && leaf->ridArray[lo] != entry.rid){
+		lo++;
+	}
+	if (lo == size || leaf->keyArray[lo] != entry.key){
+		// not in the leaf itself, it may be in a posting list of the key
+		for (lo = first; lo < size && leaf->keyArray[lo] == entry.key; lo++){
+			bool empty;
+			if (leaf->ridArray[lo].slot_number == POSTINGSLOT &&
+				postingRemove(leaf->ridArray[lo].page_number, entry.rid, empty)){
+				if (!empty){
+					return true;
+				}
+				// the list is gone, so is the entry pointing to it
+				break;
+			}
+		}
+		if (lo == size || leaf->keyArray[lo] != entry.key){
+			return false;
+		}
+	}
+
+	for (int i = lo; i < size - 1; i++){
+		leaf->keyArray[i] = leaf->keyArray[i+1];
+		leaf->ridArray[i] = leaf->ridArray[i+1];
+	}
+	movePayloads(leaf, lo, leaf, lo + 1, size - 1 - lo);
+	leaf->keyArray[size-1] = 0;
+	leaf->ridArray[size-1].page_number = 0;
+	leaf->ridArray[size-1].slot_number = 0;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::postingCreate
+// -----------------------------------------------------------------------------
+const void BTreeIndex::postingCreate(LeafNodeInt *leaf, int start, int count, const RecordId rid){
+	RecordId rids[INTARRAYLEAFSIZE + 1];
+	for (int i = 0; i < count; i++){
+		rids[i] = leaf->ridArray[start + i];
+	}
+	rids[count] = rid;
+	std::sort(rids, rids + count + 1);
+	PageId headPageNum;
+	Page *headPage;
+	bufMgr->allocPage(file, headPageNum, headPage);
+	PostingPageInt *posting = (PostingPageInt *)headPage;
+	posting->nextPageNo = 0;
+	postingStore(posting, rids, count + 1);
+	bufMgr->unPinPage(file, headPageNum, true);
+
+	// a single entry pointing to the list takes the place of the run
+	int size = leafSize(leaf);
+	leaf->ridArray[start].page_number = headPageNum;
+	leaf->ridArray[start].slot_number = POSTINGSLOT;
+	for (int i = start + 1; i + count - 1 < size; i++){
+		leaf->keyArray[i] = leaf->keyArray[i + count - 1];
+		leaf->ridArray[i] = leaf->ridArray[i + count - 1];
+	}
+	for (int i = size - count + 1; i < size; i++){
+		leaf->keyArray[i] = 0;
+		leaf->ridArray[i].page_number = 0;
+		leaf->ridArray[i].slot_number = 0;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::postingInsert
+// -----------------------------------------------------------------------------
+const void BTreeIndex::postingInsert(PageId headPageNum, const RecordId rid){
+	// the latch on the leaf keeps other writers off the list, pages are only latched to be changed
+	PageId pageNum = headPageNum;
+	Page *page;
+	bufMgr->readPage(file, pageNum, page);
+	PostingPageInt *posting = (PostingPageInt *)page;
+	while (posting->nextPageNo != 0 && posting->lastRid < rid){
+		PageId nextPageNum = posting->nextPageNo;
+		bufMgr->unPinPage(file, pageNum, false);
+		pageNum = nextPageNum;
+		bufMgr->readPage(file, pageNum, page);
+		posting = (PostingPageInt *)page;
+	}
+	bufMgr->latch(page).lock();
+
+	// records are mostly indexed in the order they are stored, which only appends to the last page
+	if (!(rid < posting->lastRid)){
+		if (!postingAppend(posting, &rid, 1)){
+			// the last page stays full and the list goes on on a new one
+			PageId newPageNum;
+			Page *newPage;
+			bufMgr->allocPage(file, newPageNum, newPage);
+			PostingPageInt *next = (PostingPageInt *)newPage;
+			next->nextPageNo = 0;
+			postingStore(next, &rid, 1);
+			bufMgr->unPinPage(file, newPageNum, true);
+			posting->nextPageNo = newPageNum;
+		}
+		unlatchPage(pageNum, page, true);
+		return;
+	}
+	RecordId rids[POSTINGCAPACITY + 1];
+	int count = postingDecode(posting, rids);
+	int pos = std::upper_bound(rids, rids + count, rid) - rids;
+	std::copy_backward(rids + pos, rids + count, rids + count + 1);
+	rids[pos] = rid;
+	postingStore(posting, rids, count + 1);
+	unlatchPage(pageNum, page, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::postingRemove
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::postingRemove(PageId headPageNum, const RecordId rid, bool &empty){
+	empty = false;
+	PageId prevPageNum = 0;
+	PageId pageNum = headPageNum;
+	Page *page;
+	bufMgr->readPage(file, pageNum, page);
+	PostingPageInt *posting = (PostingPageInt *)page;
+	while (posting->nextPageNo != 0 && posting->lastRid < rid){
+		PageId nextPageNum = posting->nextPageNo;
+		bufMgr->unPinPage(file, pageNum, false);
+		prevPageNum = pageNum;
+		pageNum = nextPageNum;
+		bufMgr->readPage(file, pageNum, page);
+		posting = (PostingPageInt *)page;
+	}
+	RecordId rids[POSTINGCAPACITY];
+	int count = postingDecode(posting, rids);
+	int pos = std::lower_bound(rids, rids + count, rid) - rids;
+	if (pos == count || rids[pos] != rid){
+		bufMgr->unPinPage(file, pageNum, false);
+		return false;
+	}
+	bufMgr->latch(page).lock();
+	std::copy(rids + pos + 1, rids + count, rids + pos);
+	count--;
+	if (count > 0){
+		postingStore(posting, rids, count);
+		unlatchPage(pageNum, page, true);
+		return true;
+	}
+
+	PageId nextPageNum = posting->nextPageNo;
+	if (prevPageNum != 0){
+		// unlink the empty page
+		Page *prevPage;
+		latchPage(prevPageNum, prevPage);
+		((PostingPageInt *)prevPage)->nextPageNo = nextPageNum;
+		unlatchPage(prevPageNum, prevPage, true);
+		freeLatchedPage(pageNum, page);
+	}
+	else if (nextPageNum != 0){
+		// the leaf keeps pointing to the first page, the second one moves into it
+		Page *nextPage;
+		latchPage(nextPageNum, nextPage);
+		*posting = *(PostingPageInt *)nextPage;
+		unlatchPage(pageNum, page, true);
+		freeLatchedPage(nextPageNum, nextPage);
+	}
+	else{
+		freeLatchedPage(pageNum, page);
+		empty = true;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::postingRead
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::postingRead(PageId headPageNum, Page *leafPage, std::uint64_t leafVersion, std::vector<RecordId> &outRids){
+	PageId pageNum = headPageNum;
+	Page *page;
+	bufMgr->readPage(file, pageNum, page);
+	std::uint64_t version;
+	while (!bufMgr->latch(page).readLock(version) && !OptLatch::isObsolete(version)){
+		std::this_thread::yield();
+	}
+	// the list is alive as long as the leaf pointing to it did not change
+	if (OptLatch::isObsolete(version) || !bufMgr->latch(leafPage).validate(leafVersion)){
+		bufMgr->unPinPage(file, pageNum, false);
+		return false;
+	}
+	while (true){
+		PostingPageInt *posting = (PostingPageInt *)page;
+		size_t start = outRids.size();
+		outRids.resize(start + POSTINGCAPACITY);
+		outRids.resize(start + postingDecode(posting, &outRids[start]));
+		PageId nextPageNum = posting->nextPageNo;
+		if (!bufMgr->latch(page).validate(version)){
+			bufMgr->unPinPage(file, pageNum, false);
+			return false;
+		}
+		if (nextPageNum == 0){
+			bufMgr->unPinPage(file, pageNum, false);
+			return true;
+		}
+		Page *nextPage;
+		bufMgr->readPage(file, nextPageNum, nextPage);
+		std::uint64_t nextVersion;
+		while (!bufMgr->latch(nextPage).readLock(nextVersion) && !OptLatch::isObsolete(nextVersion)){
+			std::this_thread::yield();
+		}
+		if (OptLatch::isObsolete(nextVersion) || !bufMgr->latch(page).validate(version)){
+			bufMgr->unPinPage(file, nextPageNum, false);
+			bufMgr->unPinPage(file, pageNum, false);
+			return false;
+		}
+		bufMgr->unPinPage(file, pageNum, false);
+		pageNum = nextPageNum;
+		page = nextPage;
+		version = nextVersion;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::postingStore
+// -----------------------------------------------------------------------------
+const void BTreeIndex::postingStore(PostingPageInt *posting, const RecordId *rids, int count){
+	posting->count = 0;
+	posting->length = 0;
+	if (postingAppend(posting, rids, count)){
+		return;
+	}
+	// the upper half moves to a new page linked in after this one
+	int half = count/2;
+	PageId newPageNum;
+	Page *newPage;
+	bufMgr->allocPage(file, newPageNum, newPage);
+	PostingPageInt *next = (PostingPageInt *)newPage;
+	next->nextPageNo = posting->nextPageNo;
+	postingStore(next, rids + half, count - half);
+	bufMgr->unPinPage(file, newPageNum, true);
+	posting->nextPageNo = newPageNum;
+	posting->count = 0;
+	posting->length = 0;
+	postingAppend(posting, rids, half);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::postingAppend
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::postingAppend(PostingPageInt *posting, const RecordId *rids, int count){
+	int length = posting->length;
+	RecordId prev;
+	prev.page_number = 0;
+	prev.slot_number = 0;
+	if (posting->count > 0){
+		prev = posting->lastRid;
+	}
+	for (int i = 0; i < count; i++){
+		std::uint32_t pageDelta = rids[i].page_number - prev.page_number;
+		std::uint32_t values[2] = {pageDelta,
+			pageDelta == 0 ? (std::uint32_t)(rids[i].slot_number - prev.slot_number) : rids[i].slot_number};
+		for (int j = 0; j < 2; j++){
+			std::uint32_t value = values[j];
+			do{
+				if (length == POSTINGDATASIZE){
+					return false;
+				}
+				unsigned char byte = value & 0x7F;
+				value >>= 7;
+				posting->data[length++] = value != 0 ? byte | 0x80 : byte;
+			} while (value != 0);
+		}
+		prev = rids[i];
+	}
+	posting->count += count;
+	posting->length = length;
+	posting->lastRid = prev;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::postingDecode
+// -----------------------------------------------------------------------------
+const int BTreeIndex::postingDecode(PostingPageInt *posting, RecordId *rids){
+	// the page may be changing while it is read, stay inside it whatever count and length say
+	int count = std::min(std::max(posting->count, 0), POSTINGCAPACITY);
+	int length = std::min(std::max(posting->length, 0), POSTINGDATASIZE);
+	int pos = 0;
+	RecordId prev;
+	prev.page_number = 0;
+	prev.slot_number = 0;
+	const unsigned char *data = posting->data;
+	for (int i = 0; i < count; i++){
+		// both values mostly fit in one byte each
+		if (pos + 2 <= length && ((data[pos] | data[pos + 1]) & 0x80) == 0){
+			if (data[pos] == 0){
+				prev.slot_number += data[pos + 1];
+			}
+			else{
+				prev.page_number += data[pos];
+				prev.slot_number = data[pos + 1];
+			}
+			pos += 2;
+			rids[i] = prev;
+			continue;
+		}
+		std::uint32_t values[2];
+		for (int j = 0; j < 2; j++){
+			std::uint32_t value = 0;
+			int shift = 0;
+			unsigned char byte;
+			do{
+				if (pos == length){
+					return i;
+				}
+				byte = data[pos++];
+				if (shift < 32){
+					value |= (std::uint32_t)(byte & 0x7F) << shift;
+				}
+				shift += 7;
+			} while (byte & 0x80);
+			values[j] = value;
+		}
+		prev.page_number += values[0];
+		prev.slot_number = values[0] == 0 ? prev.slot_number + values[1] : values[1];
+		rids[i] = prev;
+	}
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafRebalance
+// -----------------------------------------------------------------------------
+const void BTreeIndex::leafRebalance(NonLeafNodeInt *parent, int index){
+	// latch the node and its siblings left to right, then look at their sizes again
+	// since inserts may have refilled them after the entry was removed
+	int size = nonleafSize(parent);
+	PageId leftNum = index > 0 ? childPageNo(parent, index-1) : (PageId) 0;
+	PageId nodeNum = childPageNo(parent, index);
+	PageId rightNum = index < size ? childPageNo(parent, index+1) : (PageId) 0;
+	Page *leftPage = nullptr;
+	Page *nodePage;
+	Page *rightPage = nullptr;
+	if (leftNum != 0){
+		latchPage(leftNum, leftPage);
+	}
+	latchPage(nodeNum, nodePage);
+	if (rightNum != 0){
+		latchPage(rightNum, rightPage);
+	}
+	LeafNodeInt *left = (LeafNodeInt *)leftPage;
+	LeafNodeInt *node = (LeafNodeInt *)nodePage;
+	LeafNodeInt *right = (LeafNodeInt *)rightPage;
+	int leftSize = left != nullptr ? leafSize(left) : 0;
+	int nodeSize = leafSize(node);
+	int rightSize = right != nullptr ? leafSize(right) : 0;
+	// a borrow changes the separator of a composite index, which a compressed parent has to have room for
+	std::vector<char> parentKeys;
+	if (!keyAttrs.empty()){
+		loadSeparators(parent, size, parentKeys);
+	}
+
+	bool leftDirty = false;
+	bool nodeDirty = false;
+	bool rightDirty = false;
+	if (nodeSize >= leafOccupancy/2 || (left == nullptr && right == nullptr)){
+		// nothing to do
+	}
+	// borrow the last entry of the left sibling
+	else if (left != nullptr && leftSize > leafOccupancy/2
+		&& replaceSeparator(parentKeys, index-1, leafPayload(left, leftSize-2), leafPayload(left, leftSize-1))){
+		for (int i = nodeSize; i > 0; i--){
+			node->keyArray[i] = node->keyArray[i-1];
+			node->ridArray[i] = node->ridArray[i-1];
+		}
+		movePayloads(node, 1, node, 0, nodeSize);
+		node->keyArray[0] = left->keyArray[leftSize-1];
+		node->ridArray[0] = left->ridArray[leftSize-1];
+		movePayloads(node, 0, left, leftSize-1, 1);
+		left->keyArray[leftSize-1] = 0;
+		left->ridArray[leftSize-1].page_number = 0;
+		left->ridArray[leftSize-1].slot_number = 0;
+		parent->keyArray[index-1] = node->keyArray[0];
+		if (!keyAttrs.empty()){
+			storeSeparators(parent, parentKeys);
+		}
+		blockNonleaf(parent);
+		leftDirty = nodeDirty = true;
+	}
+	// borrow the first entry of the right sibling
+	else if (right != nullptr && rightSize > leafOccupancy/2
+		&& replaceSeparator(parentKeys, index, leafPayload(right, 0), leafPayload(right, 1))){
+		node->keyArray[nodeSize] = right->keyArray[0];
+		node->ridArray[nodeSize] = right->ridArray[0];
+		movePayloads(node, nodeSize, right, 0, 1);
+		for (int i = 0; i < rightSize - 1; i++){
+			right->keyArray[i] = right->keyArray[i+1];
+			right->ridArray[i] = right->ridArray[i+1];
+		}
+		movePayloads(right, 0, right, 1, rightSize - 1);
+		right->keyArray[rightSize-1] = 0;
+		right->ridArray[rightSize-1].page_number = 0;
+		right->ridArray[rightSize-1].slot_number = 0;
+		parent->keyArray[index] = right->keyArray[0];
+		if (!keyAttrs.empty()){
+			storeSeparators(parent, parentKeys);
+		}
+		blockNonleaf(parent);
+		nodeDirty = rightDirty = true;
+	}
+	// neither sibling can spare an entry, merge the right one of the pair into the left one.
+	// the leaf after the pair is linked back to the left one before the right one is freed,
+	// so descending scans never follow the link to the page once it is reused. A sibling that
+	// could spare one but not its separator is left as it is
+	else if (left != nullptr && leftSize + nodeSize <= leafOccupancy){
+		leafMerge(left, leftSize, node, nodeSize);
+		if (right != nullptr){
+			right->leftSibPageNo = leftNum;
+			rightDirty = true;
+		}
+		else{
+			relinkLeft(left->rightSibPageNo, leftNum);
+		}
+		nonleafRemoval(parent, index-1);
+		leftDirty = true;
+		freeLatchedPage(nodeNum, nodePage);
+		nodePage = nullptr;
+	}
+	else if (right != nullptr && nodeSize + rightSize <= leafOccupancy){
+		leafMerge(node, nodeSize, right, rightSize);
+		relinkLeft(node->rightSibPageNo, nodeNum);
+		nonleafRemoval(parent, index);
+		nodeDirty = true;
+		freeLatchedPage(rightNum, rightPage);
+		rightPage = nullptr;
+	}
+
+	if (leftPage != nullptr){
+		unlatchPage(leftNum, leftPage, leftDirty);
+	}
+	if (nodePage != nullptr){
+		unlatchPage(nodeNum, nodePage, nodeDirty);
+	}
+	if (rightPage != nullptr){
+		unlatchPage(rightNum, rightPage, rightDirty);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafMerge
+// -----------------------------------------------------------------------------
+const void BTreeIndex::leafMerge(LeafNodeInt *left, int leftSize, LeafNodeInt *right, int rightSize){
+	for (int i = 0; i < rightSize; i++){
+		left->keyArray[leftSize+i] = right->keyArray[i];
+		left->ridArray[leftSize+i] = right->ridArray[i];
+	}
+	movePayloads(left, leftSize, right, 0, rightSize);
+	left->rightSibPageNo = right->rightSibPageNo;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedWithin
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::packedWithin(PackedLeafInt *leaf, const RIDKeyPair<int> entry){
+	int bits[3] = {leaf->keyBits, leaf->pageBits, leaf->slotBits};
+	std::uint32_t values[3] = {(std::uint32_t)entry.key - (std::uint32_t)leaf->keyBase,
+		entry.rid.page_number - leaf->pageBase, entry.rid.slot_number};
+	if (entry.key < leaf->keyBase || entry.rid.page_number < leaf->pageBase){
+		return false;
+	}
+	for (int i = 0; i < 3; i++){
+		if (bits[i] < 32 && (values[i] >> bits[i]) != 0){
+			return false;
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedRoom
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::packedRoom(PackedLeafInt *leaf, const RIDKeyPair<int> entry){
+	int count = leafCount((Page *)leaf);
+	if (count >= PACKEDLEAFSIZE){
+		return false;
+	}
+	if (packedWithin(leaf, entry)){
+		return count < leaf->capacity;
+	}
+	// the fields would have to be widened, see how many entries they would have room for then
+	int minKey = entry.key;
+	int maxKey = entry.key;
+	PageId minPage = entry.rid.page_number;
+	PageId maxPage = entry.rid.page_number;
+	std::uint32_t maxSlot = entry.rid.slot_number;
+	if (count > 0){
+		minKey = std::min(minKey, leafKey((Page *)leaf, 0));
+		maxKey = std::max(maxKey, leafKey((Page *)leaf, count - 1));
+	}
+	int pageStart, pageBits, slotStart, slotBits;
+	packedField(leaf, 1, pageStart, pageBits);
+	packedField(leaf, 2, slotStart, slotBits);
+	for (int i = 0; i < count; i++){
+		PageId page = leaf->pageBase + packedGet(leaf, pageStart, pageBits, i);
+		minPage = std::min(minPage, page);
+		maxPage = std::max(maxPage, page);
+		maxSlot = std::max(maxSlot, packedGet(leaf, slotStart, slotBits, i));
+	}
+	std::uint32_t ranges[3] = {(std::uint32_t)maxKey - (std::uint32_t)minKey, maxPage - minPage, maxSlot};
+	int bits[3];
+	for (int i = 0; i < 3; i++){
+		bits[i] = ranges[i] == 0 ? 0 : 32 - __builtin_clz(ranges[i]);
+	}
+	return count < packedCapacity(bits);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedInsert
+// -----------------------------------------------------------------------------
+const void BTreeIndex::packedInsert(PackedLeafInt *leaf, const RIDKeyPair<int> entry){
+	int count = leaf->count;
+	// the entry goes after those with the same key
+	int pos = leafLowerBound((Page *)leaf, entry.key);
+	while (pos < count && leafKey((Page *)leaf, pos) == entry.key){
+		pos++;
+	}
+	if (count < leaf->capacity && packedWithin(leaf, entry)){
+		// records are mostly indexed in key order, which appends without moving anything
+		std::uint32_t entryValues[3] = {(std::uint32_t)entry.key - (std::uint32_t)leaf->keyBase,
+			entry.rid.page_number - leaf->pageBase, entry.rid.slot_number};
+		std::uint32_t values[PACKEDLEAFSIZE + 1];
+		for (int field = 0; field < 3; field++){
+			values[0] = entryValues[field];
+			packedUnpack(leaf, field, pos, count, values + 1);
+			packedPack(leaf, field, pos, count + 1, values);
+		}
+		leaf->count = count + 1;
+		return;
+	}
+	int keys[PACKEDLEAFSIZE + 1];
+	RecordId rids[PACKEDLEAFSIZE + 1];
+	packedDecode(leaf, 0, count, keys, rids);
+	for (int i = count; i > pos; i--){
+		keys[i] = keys[i - 1];
+		rids[i] = rids[i - 1];
+	}
+	keys[pos] = entry.key;
+	rids[pos] = entry.rid;
+	packedEncode(leaf, keys, rids, count + 1);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedSplit
+// -----------------------------------------------------------------------------
+const void BTreeIndex::packedSplit(PackedLeafInt *leaf, PageId leafPageNum, PageKeyPair<int> &newChild, const RIDKeyPair<int> entry){
+	int keys[PACKEDLEAFSIZE];
+	RecordId rids[PACKEDLEAFSIZE];
+	int count = leaf->count;
+	packedDecode(leaf, 0, count, keys, rids);
+	PageId newPageNum;
+	Page *newPage;
+	bufMgr->allocPage(file, newPageNum, newPage);
+	PackedLeafInt *newLeaf = (PackedLeafInt *)newPage;
+
+	// either half takes no more bits than the whole, so both fit
+	int median = count/2;
+	if (leaf->rightSibPageNo == 0 && count > 0 && entry.key > keys[count - 1]){
+		// appending to the rightmost leaf, which stays full and keeps keys equal to the separator,
+		// while the entry goes to the empty new leaf
+		median = count;
+	}
+	packedEncode(newLeaf, keys + median, rids + median, count - median);
+	newLeaf->rightSibPageNo = leaf->rightSibPageNo;
+	newLeaf->leftSibPageNo = leafPageNum;
+	if (median < count){
+		packedEncode(leaf, keys, rids, median);
+	}
+	leaf->rightSibPageNo = newPageNum;
+
+	newChild.set(newPageNum, median < count ? keys[median] : keys[count - 1]);
+	bufMgr->unPinPage(file, newPageNum, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedRemoval
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::packedRemoval(PackedLeafInt *leaf, const RIDKeyPair<int> entry){
+	int count = leaf->count;
+	int pos = leafLowerBound((Page *)leaf, entry.key);
+	int key;
+	RecordId rid;
+	while (leafEntry((Page *)leaf, pos, key, rid) && key == entry.key && rid != entry.rid){
+		pos++;
+	}
+	if (pos == count || key != entry.key){
+		return false;
+	}
+	// the rest moves down one, the fields keep their widths
+	std::uint32_t values[PACKEDLEAFSIZE];
+	for (int field = 0; field < 3; field++){
+		packedUnpack(leaf, field, pos + 1, count, values);
+		values[count - pos - 1] = 0;
+		packedPack(leaf, field, pos, count, values);
+	}
+	leaf->count = count - 1;
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedRebalance
+// -----------------------------------------------------------------------------
+const void BTreeIndex::packedRebalance(NonLeafNodeInt *parent, int index){
+	int size = nonleafSize(parent);
+	PageId leftNum = index > 0 ? childPageNo(parent, index-1) : (PageId) 0;
+	PageId nodeNum = childPageNo(parent, index);
+	PageId rightNum = index < size ? childPageNo(parent, index+1) : (PageId) 0;
+	Page *leftPage = nullptr;
+	Page *nodePage;
+	Page *rightPage = nullptr;
+	if (leftNum != 0){
+		latchPage(leftNum, leftPage);
+	}
+	latchPage(nodeNum, nodePage);
+	if (rightNum != 0){
+		latchPage(rightNum, rightPage);
+	}
+	PackedLeafInt *node = (PackedLeafInt *)nodePage;
+
+	// entries take different numbers of bits in different leaves, so there is nothing to borrow:
+	// the leaf is merged with a sibling if the entries of both fit in one leaf, or left as it is
+	bool leftDirty = false;
+	bool nodeDirty = false;
+	bool rightDirty = false;
+	if (node->count * 2 < node->capacity){
+		for (int side = 0; side < 2; side++){
+			Page *firstPage = side == 0 ? leftPage : nodePage;
+			Page *secondPage = side == 0 ? nodePage : rightPage;
+			if (firstPage == nullptr || secondPage == nullptr){
+				continue;
+			}
+			PackedLeafInt *first = (PackedLeafInt *)firstPage;
+			PackedLeafInt *second = (PackedLeafInt *)secondPage;
+			int count = first->count + second->count;
+			if (count > PACKEDLEAFSIZE){
+				continue;
+			}
+			std::vector<int> keys(count + 1);
+			std::vector<RecordId> rids(count + 1);
+			packedDecode(first, 0, first->count, &keys[0], &rids[0]);
+			packedDecode(second, 0, second->count, &keys[first->count], &rids[first->count]);
+			if (!packedEncode(first, &keys[0], &rids[0], count)){
+				continue;
+			}
+			first->rightSibPageNo = second->rightSibPageNo;
+			// the leaf after the pair is linked back before the second one is freed
+			if (side == 0 && rightPage != nullptr){
+				setLeftSibling(rightPage, leftNum);
+				rightDirty = true;
+			}
+			else{
+				relinkLeft(first->rightSibPageNo, side == 0 ? leftNum : nodeNum);
+			}
+			if (side == 0){
+				nonleafRemoval(parent, index-1);
+				leftDirty = true;
+				freeLatchedPage(nodeNum, nodePage);
+				nodePage = nullptr;
+			}
+			else{
+				nonleafRemoval(parent, index);
+				nodeDirty = true;
+				freeLatchedPage(rightNum, rightPage);
+				rightPage = nullptr;
+			}
+			break;
+		}
+	}
+
+	if (leftPage != nullptr){
+		unlatchPage(leftNum, leftPage, leftDirty);
+	}
+	if (nodePage != nullptr){
+		unlatchPage(nodeNum, nodePage, nodeDirty);
+	}
+	if (rightPage != nullptr){
+		unlatchPage(rightNum, rightPage, rightDirty);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedEncode
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::packedEncode(PackedLeafInt *leaf, const int *keys, const RecordId *rids, int count){
+	int keyBase = count > 0 ? keys[0] : 0;
+	PageId pageBase = count > 0 ? rids[0].page_number : 0;
+	PageId maxPage = pageBase;
+	std::uint32_t maxSlot = 0;
+	for (int i = 0; i < count; i++){
+		pageBase = std::min(pageBase, rids[i].page_number);
+		maxPage = std::max(maxPage, rids[i].page_number);
+		maxSlot = std::max(maxSlot, (std::uint32_t)rids[i].slot_number);
+	}
+	std::uint32_t ranges[3] = {count > 0 ? (std::uint32_t)keys[count - 1] - (std::uint32_t)keyBase : 0,
+		maxPage - pageBase, maxSlot};
+	int bits[3];
+	for (int i = 0; i < 3; i++){
+		bits[i] = ranges[i] == 0 ? 0 : 32 - __builtin_clz(ranges[i]);
+	}
+	int capacity = packedCapacity(bits);
+	if (count > capacity){
+		return false;
+	}
+
+	leaf->count = count;
+	leaf->capacity = capacity;
+	leaf->keyBase = keyBase;
+	leaf->pageBase = pageBase;
+	leaf->keyBits = bits[0];
+	leaf->pageBits = bits[1];
+	leaf->slotBits = bits[2];
+	memset(leaf->words, 0, sizeof(leaf->words));
+	std::uint32_t values[PACKEDLEAFSIZE];
+	for (int field = 0; field < 3; field++){
+		for (int i = 0; i < count; i++){
+			values[i] = field == 0 ? (std::uint32_t)keys[i] - (std::uint32_t)keyBase
+				: field == 1 ? rids[i].page_number - pageBase : rids[i].slot_number;
+		}
+		packedPack(leaf, field, 0, count, values);
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedDecode
+// -----------------------------------------------------------------------------
+const void BTreeIndex::packedDecode(PackedLeafInt *leaf, int from, int to, int *keys, RecordId *rids){
+	std::uint32_t pages[PACKEDLEAFSIZE];
+	std::uint32_t slots[PACKEDLEAFSIZE];
+	if (keys != nullptr){
+		packedUnpack(leaf, 0, from, to, (std::uint32_t *)keys);
+		std::uint32_t keyBase = leaf->keyBase;
+		for (int i = 0; i < to - from; i++){
+			keys[i] = keyBase + (std::uint32_t)keys[i];
+		}
+	}
+	packedUnpack(leaf, 1, from, to, pages);
+	packedUnpack(leaf, 2, from, to, slots);
+	PageId pageBase = leaf->pageBase;
+	for (int i = 0; i < to - from; i++){
+		rids[i].page_number = pageBase + pages[i];
+		rids[i].slot_number = slots[i];
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedUnpack
+// -----------------------------------------------------------------------------
+const void BTreeIndex::packedUnpack(PackedLeafInt *leaf, int field, int from, int to, std::uint32_t *out){
+	int start;
+	int bits;
+	packedField(leaf, field, start, bits);
+	int i = from;
+	// values up to the next group of four one at a time
+	for (; i < to && (i & 3) != 0; i++){
+		out[i - from] = packedGet(leaf, start, bits, i);
+	}
+#ifdef __SSE2__
+	// the four lanes of a group are at the same bit offset of four neighbouring words
+	const __m128i mask = _mm_set1_epi32(bits == 32 ? -1 : (int)((1u << bits) - 1));
+	for (; i + 4 <= to && bits > 0; i += 4){
+		int bit = (i >> 2) * bits;
+		int word = start + 4 * (bit >> 5);
+		int shift = bit & 31;
+		bool spans = shift + bits > 32;
+		if (word + (spans ? 8 : 4) > PACKEDLEAFWORDS){
+			break;
+		}
+		__m128i values = _mm_srl_epi32(_mm_loadu_si128((const __m128i *)(leaf->words + word)), _mm_cvtsi32_si128(shift));
+		if (spans){
+			__m128i high = _mm_loadu_si128((const __m128i *)(leaf->words + word + 4));
+			values = _mm_or_si128(values, _mm_sll_epi32(high, _mm_cvtsi32_si128(32 - shift)));
+		}
+		_mm_storeu_si128((__m128i *)(out + i - from), _mm_and_si128(values, mask));
+	}
+#endif
+	for (; i < to; i++){
+		out[i - from] = packedGet(leaf, start, bits, i);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedGet
+// -----------------------------------------------------------------------------
+const std::uint32_t BTreeIndex::packedGet(PackedLeafInt *leaf, int start, int bits, int index){
+	if (bits == 0){
+		return 0;
+	}
+	int bit = (index >> 2) * bits;
+	int word = start + 4 * (bit >> 5) + (index & 3);
+	int shift = bit & 31;
+	bool spans = shift + bits > 32;
+	// a leaf that is being changed may claim more than it holds, stay inside it
+	if (word + (spans ? 4 : 0) >= PACKEDLEAFWORDS){
+		return 0;
+	}
+	std::uint64_t value = leaf->words[word] >> shift;
+	if (spans){
+		value |= (std::uint64_t)leaf->words[word + 4] << (32 - shift);
+	}
+	return bits == 32 ? (std::uint32_t)value : (std::uint32_t)value & ((1u << bits) - 1);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedPack
+// -----------------------------------------------------------------------------
+const void BTreeIndex::packedPack(PackedLeafInt *leaf, int field, int from, int to, const std::uint32_t *values){
+	int start;
+	int bits;
+	packedField(leaf, field, start, bits);
+	if (bits == 0){
+		return;
+	}
+	std::uint64_t mask = bits == 32 ? 0xFFFFFFFFull : (1ull << bits) - 1;
+	for (int i = from; i < to; i++){
+		int bit = (i >> 2) * bits;
+		int word = start + 4 * (bit >> 5) + (i & 3);
+		int shift = bit & 31;
+		bool spans = shift + bits > 32;
+		std::uint64_t pair = leaf->words[word];
+		if (spans){
+			pair |= (std::uint64_t)leaf->words[word + 4] << 32;
+		}
+		pair = (pair & ~(mask << shift)) | ((values[i - from] & mask) << shift);
+		leaf->words[word] = (std::uint32_t)pair;
+		if (spans){
+			leaf->words[word + 4] = (std::uint32_t)(pair >> 32);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedField
+// -----------------------------------------------------------------------------
+const void BTreeIndex::packedField(PackedLeafInt *leaf, int field, int &start, int &bits){
+	// every field has room for capacity values, keys first, then page and slot numbers
+	int rows = std::min(std::max(leaf->capacity, 0), PACKEDLEAFSIZE) / 4;
+	int widths[3] = {std::min((int)leaf->keyBits, 32), std::min((int)leaf->pageBits, 32), std::min((int)leaf->slotBits, 32)};
+	start = 0;
+	for (int i = 0; i < field; i++){
+		start += 4 * ((rows * widths[i] + 31) / 32);
+	}
+	bits = widths[field];
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::packedCapacity
+// -----------------------------------------------------------------------------
+const int BTreeIndex::packedCapacity(const int *bits){
+	// each of the four lanes gets a quarter of the words
+	int laneBits = PACKEDLEAFWORDS / 4 * 32;
+	int total = bits[0] + bits[1] + bits[2];
+	int rows = total == 0 ? PACKEDLEAFSIZE / 4 : std::min(PACKEDLEAFSIZE / 4, laneBits / total);
+	while (rows > 0 && (rows * bits[0] + 31) / 32 + (rows * bits[1] + 31) / 32 + (rows * bits[2] + 31) / 32 > PACKEDLEAFWORDS / 4){
+		rows--;
+	}
+	return rows * 4;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafRebalance
+// -----------------------------------------------------------------------------
+const void BTreeIndex::nonleafRebalance(NonLeafNodeInt *parent, int index){
+	int size = nonleafSize(parent);
+	PageId leftNum = index > 0 ? childPageNo(parent, index-1) : (PageId) 0;
+	PageId nodeNum = childPageNo(parent, index);
+	PageId rightNum = index < size ? childPageNo(parent, index+1) : (PageId) 0;
+	Page *leftPage = nullptr;
+	Page *nodePage;
+	Page *rightPage = nullptr;
+	if (leftNum != 0){
+		latchPage(leftNum, leftPage);
+	}
+	latchPage(nodeNum, nodePage);
+	if (rightNum != 0){
+		latchPage(rightNum, rightPage);
+	}
+	NonLeafNodeInt *left = (NonLeafNodeInt *)leftPage;
+	NonLeafNodeInt *node = (NonLeafNodeInt *)nodePage;
+	NonLeafNodeInt *right = (NonLeafNodeInt *)rightPage;
+	int leftSize = left != nullptr ? nonleafSize(left) : 0;
+	int nodeSize = nonleafSize(node);
+	int rightSize = right != nullptr ? nonleafSize(right) : 0;
+	bool underflow = nonleafUnderflow(node, nodeSize) && (left != nullptr || right != nullptr);
+	// the separators of a composite index move with their keys, as long as compressed nodes have room for them
+	std::vector<char> parentKeys;
+	std::vector<char> leftKeys;
+	std::vector<char> nodeKeys;
+	std::vector<char> rightKeys;
+	if (!keyAttrs.empty() && underflow){
+		loadSeparators(parent, size, parentKeys);
+		loadSeparators(node, nodeSize, nodeKeys);
+		if (left != nullptr){
+			loadSeparators(left, leftSize, leftKeys);
+		}
+		if (right != nullptr){
+			loadSeparators(right, rightSize, rightKeys);
+		}
+	}
+
+	bool leftDirty = false;
+	bool nodeDirty = false;
+	bool rightDirty = false;
+	if (!underflow){
+		// nothing to do
+	}
+	// rotate the last child of the left sibling through the parent
+	else if (left != nullptr && !nonleafUnderflow(left, leftSize - 1) && rotateSeparators(parentKeys, index-1, leftKeys, nodeKeys, true)){
+		node->pageNoArray[nodeSize+1] = node->pageNoArray[nodeSize];
+		for (int i = nodeSize; i > 0; i--){
+			node->keyArray[i] = node->keyArray[i-1];
+			node->pageNoArray[i] = node->pageNoArray[i-1];
+		}
+		node->keyArray[0] = parent->keyArray[index-1];
+		unswizzleChild(left, leftSize);
+		node->pageNoArray[0] = left->pageNoArray[leftSize];
+		if (countedNonleaves){
+			int *counts = childCounts(node);
+			for (int i = nodeSize + 1; i > 0; i--){
+				counts[i] = counts[i-1];
+			}
+			counts[0] = childCounts(left)[leftSize];
+			childCounts(left)[leftSize] = 0;
+		}
+		parent->keyArray[index-1] = left->keyArray[leftSize-1];
+		left->keyArray[leftSize-1] = 0;
+		left->pageNoArray[leftSize] = (PageId) 0;
+		if (!keyAttrs.empty()){
+			storeSeparators(parent, parentKeys);
+			storeSeparators(left, leftKeys);
+			storeSeparators(node, nodeKeys);
+		}
+		blockNonleaf(parent);
+		blockNonleaf(left);
+		blockNonleaf(node);
+		leftDirty = nodeDirty = true;
+	}
+	// rotate the first child of the right sibling through the parent
+	else if (right != nullptr && !nonleafUnderflow(right, rightSize - 1) && rotateSeparators(parentKeys, index, rightKeys, nodeKeys, false)){
+		node->keyArray[nodeSize] = parent->keyArray[index];
+		unswizzleChild(right, 0);
+		node->pageNoArray[nodeSize+1] = right->pageNoArray[0];
+		if (countedNonleaves){
+			int *counts = childCounts(right);
+			childCounts(node)[nodeSize+1] = counts[0];
+			for (int i = 0; i < rightSize; i++){
+				counts[i] = counts[i+1];
+			}
+			counts[rightSize] = 0;
+		}
+		parent->keyArray[index] = right->keyArray[0];
+		for (int i = 0; i < rightSize - 1; i++){
+			right->keyArray[i] = right->keyArray[i+1];
+			right->pageNoArray[i] = right->pageNoArray[i+1];
+		}
+		right->pageNoArray[rightSize-1] = right->pageNoArray[rightSize];
+		right->keyArray[rightSize-1] = 0;
+		right->pageNoArray[rightSize] = (PageId) 0;
+		if (!keyAttrs.empty()){
+			storeSeparators(parent, parentKeys);
+			storeSeparators(node, nodeKeys);
+			storeSeparators(right, rightKeys);
+		}
+		blockNonleaf(parent);
+		blockNonleaf(node);
+		blockNonleaf(right);
+		nodeDirty = rightDirty = true;
+	}
+	// merge the right one of the pair into the left one, pulling the separator down
+	else if (left != nullptr && mergeSeparators(leftKeys, parentKeys, index-1, nodeKeys)){
+		nonleafMerge(left, leftSize, parent->keyArray[index-1], node, nodeSize);
+		if (!keyAttrs.empty()){
+			storeSeparators(left, leftKeys);
+		}
+		nonleafRemoval(parent, index-1);
+		leftDirty = true;
+		freeLatchedPage(nodeNum, nodePage);
+		nodePage = nullptr;
+	}
+	else if (right != nullptr && mergeSeparators(nodeKeys, parentKeys, index, rightKeys)){
+		nonleafMerge(node, nodeSize, parent->keyArray[index], right, rightSize);
+		if (!keyAttrs.empty()){
+			storeSeparators(node, nodeKeys);
+		}
+		nonleafRemoval(parent, index);
+		nodeDirty = true;
+		freeLatchedPage(rightNum, rightPage);
+		rightPage = nullptr;
+	}
+
+	if (leftPage != nullptr){
+		unlatchPage(leftNum, leftPage, leftDirty);
+	}
+	if (nodePage != nullptr){
+		unlatchPage(nodeNum, nodePage, nodeDirty);
+	}
+	if (rightPage != nullptr){
+		unlatchPage(rightNum, rightPage, rightDirty);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafMerge
+// -----------------------------------------------------------------------------
+const void BTreeIndex::nonleafMerge(NonLeafNodeInt *left, int leftSize, int separator, NonLeafNodeInt *right, int rightSize){
+	left->keyArray[leftSize] = separator;
+	for (int i = 0; i < rightSize; i++){
+		left->keyArray[leftSize+1+i] = right->keyArray[i];
+	}
+	for (int i = 0; i <= rightSize; i++){
+		unswizzleChild(right, i);
+		left->pageNoArray[leftSize+1+i] = right->pageNoArray[i];
+		if (countedNonleaves){
+			childCounts(left)[leftSize+1+i] = childCounts(right)[i];
+		}
+	}
+	blockNonleaf(left);
 }
 
 // -----------------------------------------------------------------------------
-// BTreeIndex::checkKey
+// BTreeIndex::nonleafRemoval
 // -----------------------------------------------------------------------------
-const bool BTreeIndex::checkKey(int lowValParm, const Operator lowOp, int highValParm, const Operator highOp, int check){
-	if(lowOp == GTE && highOp == LTE){
-		return check <= highValParm && check >= lowValParm;
+const void BTreeIndex::nonleafRemoval(NonLeafNodeInt *nonleaf, int index){
+	int size = nonleafSize(nonleaf);
+	if (!keyAttrs.empty()){
+		std::vector<char> keys;
+		loadSeparators(nonleaf, size, keys);
+		keys.erase(keys.begin() + index * payloadBytes, keys.begin() + (index + 1) * payloadBytes);
+		storeSeparators(nonleaf, keys);
 	}
-	else if(lowOp == GT && highOp == LTE){
-		return check <= highValParm && check > lowValParm;
+	unswizzleChild(nonleaf, index+1);
+	for (int i = index; i < size - 1; i++){
+		nonleaf->keyArray[i] = nonleaf->keyArray[i+1];
+		nonleaf->pageNoArray[i+1] = nonleaf->pageNoArray[i+2];
+		if (countedNonleaves){
+			childCounts(nonleaf)[i+1] = childCounts(nonleaf)[i+2];
+		}
 	}
-	else if(lowOp == GTE && highOp == LT){
-		return check < highValParm && check >= lowValParm;
+	nonleaf->keyArray[size-1] = 0;
+	nonleaf->pageNoArray[size] = (PageId) 0;
+	if (countedNonleaves){
+		childCounts(nonleaf)[size] = 0;
+	}
+	blockNonleaf(nonleaf);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::collapseRoot
+// -----------------------------------------------------------------------------
+const void BTreeIndex::collapseRoot(){
+	rootLatch.lock();
+	Page *rootPage;
+	PageId oldRootNum = rootPageNum;
+	latchPage(oldRootNum, rootPage);
+	NonLeafNodeInt *root = (NonLeafNodeInt *)rootPage;
+	// an insert may have split a child into the root in the meantime
+	if (nonleafSize(root) > 0){
+		unlatchPage(oldRootNum, rootPage, false);
+		rootLatch.unlock();
+		return;
+	}
+	unswizzleChild(root, 0);
+	PageId childNum = root->pageNoArray[0];
+	bool child_leaf = root->level == 1;
+
+	Page *m;
+	bufMgr->readPage(file, headerPageNum, m);
+	IndexMetaInfo *metaPage = (IndexMetaInfo *)m;
+	rootPageNum = childNum;
+	initialroot = child_leaf ? childNum : Page::INVALID_NUMBER;
+	metaPage->rootPageNo = rootPageNum;
+	metaPage->leafRootPageNo = initialroot;
+	bufMgr->unPinPage(file, headerPageNum, true);
+
+	freeLatchedPage(oldRootNum, rootPage);
+	Page *pinned;
+	if(pinnedLevels > 0 && !child_leaf){
+		pinNode(childNum, pinned);
+	}
+	rootLatch.unlock();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::latchPage
+// -----------------------------------------------------------------------------
+const void BTreeIndex::latchPage(PageId pageNum, Page *&page){
+	bufMgr->readPage(file, pageNum, page);
+	bufMgr->latch(page).lock();
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::unlatchPage
+// -----------------------------------------------------------------------------
+const void BTreeIndex::unlatchPage(PageId pageNum, Page *page, bool dirty){
+	bufMgr->latch(page).unlock();
+	bufMgr->unPinPage(file, pageNum, dirty);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::freeLatchedPage
+// -----------------------------------------------------------------------------
+const void BTreeIndex::freeLatchedPage(PageId pageNum, Page *page){
+	// appends validate the cache after latching the leaf, so none reaches the page once it is reused
+	rightmostLatch.lock();
+	if (rightmostLeaf == pageNum){
+		rightmostLeaf = 0;
+	}
+	rightmostLatch.unlock();
+	unpinNode(pageNum);
+	// optimistic readers still holding the page see it is obsolete and restart
+	bufMgr->latch(page).unlockObsolete();
+	bufMgr->unPinPage(file, pageNum, false);
+	bufMgr->disposePage(file, pageNum);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafCount
+// -----------------------------------------------------------------------------
+const int BTreeIndex::leafCount(Page *leaf){
+	if (!packedLeaves){
+		return leafSize((LeafNodeInt *)leaf);
+	}
+	PackedLeafInt *packed = (PackedLeafInt *)leaf;
+	return std::min(std::max(packed->count, 0), std::min(std::max(packed->capacity, 0), PACKEDLEAFSIZE));
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafKey
+// -----------------------------------------------------------------------------
+const int BTreeIndex::leafKey(Page *leaf, int index){
+	if (!packedLeaves){
+		return ((LeafNodeInt *)leaf)->keyArray[index];
+	}
+	PackedLeafInt *packed = (PackedLeafInt *)leaf;
+	int start, bits;
+	packedField(packed, 0, start, bits);
+	return (std::uint32_t)packed->keyBase + packedGet(packed, start, bits, index);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafEntry
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::leafEntry(Page *leaf, int index, int &key, RecordId &rid){
+	if (!packedLeaves){
+		LeafNodeInt *node = (LeafNodeInt *)leaf;
+		if (index < 0 || index >= leafOccupancy){
+			return false;
+		}
+		key = node->keyArray[index];
+		rid = node->ridArray[index];
+		return rid.page_number != 0;
+	}
+	PackedLeafInt *packed = (PackedLeafInt *)leaf;
+	if (index < 0 || index >= leafCount(leaf)){
+		return false;
+	}
+	int start[3], bits[3];
+	for (int field = 0; field < 3; field++){
+		packedField(packed, field, start[field], bits[field]);
+	}
+	key = (std::uint32_t)packed->keyBase + packedGet(packed, start[0], bits[0], index);
+	rid.page_number = packed->pageBase + packedGet(packed, start[1], bits[1], index);
+	rid.slot_number = packedGet(packed, start[2], bits[2], index);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafSibling
+// -----------------------------------------------------------------------------
+const PageId BTreeIndex::leafSibling(Page *leaf){
+	if (!packedLeaves){
+		return ((LeafNodeInt *)leaf)->rightSibPageNo;
+	}
+	return ((PackedLeafInt *)leaf)->rightSibPageNo;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafLeftSibling
+// -----------------------------------------------------------------------------
+const PageId BTreeIndex::leafLeftSibling(Page *leaf){
+	if (!packedLeaves){
+		return ((LeafNodeInt *)leaf)->leftSibPageNo;
+	}
+	return ((PackedLeafInt *)leaf)->leftSibPageNo;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::setLeftSibling
+// -----------------------------------------------------------------------------
+const void BTreeIndex::setLeftSibling(Page *leaf, PageId leftPageNum){
+	if (!packedLeaves){
+		((LeafNodeInt *)leaf)->leftSibPageNo = leftPageNum;
 	}
 	else{
-		return check < highValParm && check > lowValParm;
+		((PackedLeafInt *)leaf)->leftSibPageNo = leftPageNum;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::relinkLeft
+// -----------------------------------------------------------------------------
+const void BTreeIndex::relinkLeft(PageId pageNum, PageId leftPageNum){
+	// only structure changing deletes wait for leaves, so waiting here cannot close a cycle
+	if (pageNum == 0){
+		return;
+	}
+	Page *page;
+	latchPage(pageNum, page);
+	setLeftSibling(page, leftPageNum);
+	unlatchPage(pageNum, page, true);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafLowerBound
+// -----------------------------------------------------------------------------
+const int BTreeIndex::leafLowerBound(Page *leaf, int key){
+	int lo = 0;
+	int hi = leafCount(leaf);
+	while (lo < hi){
+		int mid = (lo + hi)/2;
+		if (leafKey(leaf, mid) < key){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafUpperBound
+// -----------------------------------------------------------------------------
+const int BTreeIndex::leafUpperBound(Page *leaf, int key){
+	int lo = 0;
+	int hi = leafCount(leaf);
+	while (lo < hi){
+		int mid = (lo + hi)/2;
+		if (leafKey(leaf, mid) <= key){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafPayload
+// -----------------------------------------------------------------------------
+char *BTreeIndex::leafPayload(LeafNodeInt *leaf, int index){
+	return (char *)&leaf->ridArray[leafOccupancy] + index * payloadBytes;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::movePayloads
+// -----------------------------------------------------------------------------
+const void BTreeIndex::movePayloads(LeafNodeInt *to, int toIndex, LeafNodeInt *from, int fromIndex, int count){
+	if (payloadBytes > 0 && count > 0){
+		memmove(leafPayload(to, toIndex), leafPayload(from, fromIndex), count * payloadBytes);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compareEntry
+// -----------------------------------------------------------------------------
+const int BTreeIndex::compareEntry(LeafNodeInt *leaf, int index, int key, const char *payload){
+	if (leaf->keyArray[index] != key){
+		return leaf->keyArray[index] < key ? -1 : 1;
+	}
+	// entries of a composite index sharing the first four bytes go by the rest of their keys
+	return keyAttrs.empty() ? 0 : memcmp(leafPayload(leaf, index), payload, payloadBytes);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::separatorKey
+// -----------------------------------------------------------------------------
+char *BTreeIndex::separatorKey(NonLeafNodeInt *node, int index){
+	return (char *)&node->pageNoArray[nodeOccupancy + 1] + index * payloadBytes;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compressedHeader
+// -----------------------------------------------------------------------------
+std::uint16_t *BTreeIndex::compressedHeader(NonLeafNodeInt *node){
+	return (std::uint16_t *)&node->keyArray[INTARRAYCOMPRESSEDSIZE];
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compressedHeap
+// -----------------------------------------------------------------------------
+char *BTreeIndex::compressedHeap(NonLeafNodeInt *node){
+	return (char *)&node->pageNoArray[INTARRAYCOMPRESSEDSIZE + 1];
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::loadSeparators
+// -----------------------------------------------------------------------------
+const void BTreeIndex::loadSeparators(NonLeafNodeInt *node, int count, std::vector<char> &keys){
+	keys.assign(count * payloadBytes, 0);
+	if (count == 0){
+		return;
+	}
+	if (!compressedNonleaves){
+		memcpy(&keys[0], separatorKey(node, 0), count * payloadBytes);
+		return;
+	}
+	// each separator is the prefix, its suffix and the zero bytes trimmed off its end
+	const std::uint16_t *header = compressedHeader(node);
+	const char *heap = compressedHeap(node);
+	int prefix = std::min((int)header[1], payloadBytes);
+	for (int i = 0; i < count; i++){
+		char *key = &keys[i * payloadBytes];
+		int start = i == 0 ? prefix : std::min((int)header[i + 1], COMPRESSEDHEAPSIZE);
+		int end = std::min((int)header[i + 2], COMPRESSEDHEAPSIZE);
+		memcpy(key, heap, prefix);
+		if (end > start){
+			memcpy(key + prefix, heap + start, std::min(end - start, payloadBytes - prefix));
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::storeSeparators
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::storeSeparators(NonLeafNodeInt *node, const std::vector<char> &keys){
+	int count = keys.size() / payloadBytes;
+	if (!separatorsFit(keys)){
+		return false;
+	}
+	if (!compressedNonleaves){
+		if (count > 0){
+			memcpy(separatorKey(node, 0), &keys[0], count * payloadBytes);
+		}
+	}
+	else{
+		std::uint16_t *header = compressedHeader(node);
+		char *heap = compressedHeap(node);
+		int prefix = sharedPrefix(keys);
+		header[0] = count;
+		header[1] = prefix;
+		if (count > 0){
+			memcpy(heap, &keys[0], prefix);
+		}
+		int end = prefix;
+		for (int i = 0; i < count; i++){
+			const char *key = &keys[i * payloadBytes];
+			int length = separatorLength(key);
+			if (length > prefix){
+				memcpy(heap + end, key + prefix, length - prefix);
+				end += length - prefix;
+			}
+			header[i + 2] = end;
+		}
+	}
+	for (int i = 0; i < count; i++){
+		node->keyArray[i] = keyPrefix(&keys[i * payloadBytes], payloadBytes, 0x00);
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::separatorsFit
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::separatorsFit(const std::vector<char> &keys){
+	// plain non leaves have a slot for the key of every child they have room for
+	if (!compressedNonleaves){
+		return true;
+	}
+	int count = keys.size() / payloadBytes;
+	if (count > INTARRAYCOMPRESSEDSIZE){
+		return false;
+	}
+	int prefix = sharedPrefix(keys);
+	int bytes = prefix;
+	for (int i = 0; i < count; i++){
+		bytes += std::max(separatorLength(&keys[i * payloadBytes]) - prefix, 0);
+	}
+	return bytes <= COMPRESSEDHEAPSIZE;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::sharedPrefix
+// -----------------------------------------------------------------------------
+const int BTreeIndex::sharedPrefix(const std::vector<char> &keys){
+	// separators are in order, whatever the first and last share all of them do
+	if (keys.empty()){
+		return 0;
+	}
+	const char *first = &keys[0];
+	const char *last = &keys[keys.size() - payloadBytes];
+	int length = 0;
+	while (length < payloadBytes && first[length] == last[length]){
+		length++;
+	}
+	return length;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::separatorLength
+// -----------------------------------------------------------------------------
+const int BTreeIndex::separatorLength(const char *key){
+	int length = payloadBytes;
+	while (length > 0 && key[length - 1] == 0){
+		length--;
+	}
+	return length;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compareSeparator
+// -----------------------------------------------------------------------------
+const int BTreeIndex::compareSeparator(NonLeafNodeInt *node, int index, const char *key, int length){
+	if (!compressedNonleaves){
+		return memcmp(separatorKey(node, index), key, length);
+	}
+	int prefix = std::min((int)compressedHeader(node)[1], payloadBytes);
+	int cmp = memcmp(compressedHeap(node), key, std::min(prefix, length));
+	if (cmp != 0 || length <= prefix){
+		return cmp;
+	}
+	return compareSuffix(node, index, key, length);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::compareSuffix
+// -----------------------------------------------------------------------------
+const int BTreeIndex::compareSuffix(NonLeafNodeInt *node, int index, const char *key, int length){
+	// the bounds are checked since optimistic readers may see a node while it changes
+	const std::uint16_t *header = compressedHeader(node);
+	int prefix = std::min((int)header[1], payloadBytes);
+	int end = std::min((int)header[index + 2], COMPRESSEDHEAPSIZE);
+	int start = std::min(index == 0 ? prefix : (int)header[index + 1], end);
+	int common = std::min(end - start, length - prefix);
+	int cmp = memcmp(compressedHeap(node) + start, key + prefix, common);
+	if (cmp != 0){
+		return cmp;
+	}
+	// the separator goes on in zero bytes
+	for (int b = prefix + common; b < length; b++){
+		if (key[b] != 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::shortSeparator
+// -----------------------------------------------------------------------------
+const void BTreeIndex::shortSeparator(const char *left, const char *right, char *separator){
+	// right cut after the first byte it goes past left in is still above left and not above right
+	int length = 0;
+	while (length < payloadBytes && left[length] == right[length]){
+		length++;
+	}
+	length = std::min(length + 1, payloadBytes);
+	memcpy(separator, right, length);
+	memset(separator + length, 0, payloadBytes - length);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafSplitPoint
+// -----------------------------------------------------------------------------
+const int BTreeIndex::leafSplitPoint(LeafNodeInt *leaf, const RIDKeyPair<int> data, const char *payload){
+	int median = leafOccupancy/2;
+	if (leaf->rightSibPageNo == 0 && compareEntry(leaf, leafOccupancy-1, data.key, payload) < 0){
+		// appending to the rightmost leaf, which stays full while the new leaf starts with the entry
+		median = leafOccupancy;
+	}
+	else if (leafOccupancy %2 == 1 && compareEntry(leaf, median, data.key, payload) < 0){
+		median = median + 1;
+	}
+	return median;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafSplitSeparator
+// -----------------------------------------------------------------------------
+const void BTreeIndex::leafSplitSeparator(LeafNodeInt *leaf, const RIDKeyPair<int> data, const char *payload, char *separator){
+	// the entry goes right if it sorts after the last entry staying left, and is the first
+	// one there unless an entry moving right sorts before it
+	int median = leafSplitPoint(leaf, data, payload);
+	bool right = compareEntry(leaf, median-1, data.key, payload) < 0;
+	bool first = right && (median == leafOccupancy || compareEntry(leaf, median, data.key, payload) > 0);
+	shortSeparator(leafPayload(leaf, median-1), first ? payload : leafPayload(leaf, median), separator);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafFull
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::nonleafFull(NonLeafNodeInt *node, PageId pageNum){
+	if (node->pageNoArray[nodeOccupancy] != 0){
+		return true;
+	}
+	if (!compressedNonleaves){
+		return false;
+	}
+	// a separator cut short mostly fits into the room of a whole key, one that does not gets the
+	// node marked by the insert that brought it, for the next insert through it to split
+	const std::uint16_t *header = compressedHeader(node);
+	int count = std::min((int)header[0], INTARRAYCOMPRESSEDSIZE);
+	int used = count == 0 ? header[1] : header[count + 1];
+	return count > 1 && (used + payloadBytes > COMPRESSEDHEAPSIZE || crowdedNode.load(std::memory_order_relaxed) == pageNum);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafUnderflow
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::nonleafUnderflow(NonLeafNodeInt *node, int size){
+	if (size >= nodeOccupancy/2){
+		return false;
+	}
+	// compressed nodes run out of room for long separators with fewer children, half of it filled will do
+	if (!compressedNonleaves || size == 0){
+		return true;
+	}
+	return compressedHeader(node)[size + 1] < COMPRESSEDHEAPSIZE/2;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafSplitPoint
+// -----------------------------------------------------------------------------
+const int BTreeIndex::nonleafSplitPoint(NonLeafNodeInt *node, bool append){
+	// appends only ever descend into the last child, so that is all the new node gets then
+	int size = nonleafSize(node);
+	return append ? size - 1 : size/2;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::separatorRoom
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::separatorRoom(NonLeafNodeInt *parent, PageId parentPageNum, int index, const char *separator){
+	if (!compressedNonleaves){
+		return true;
+	}
+	std::vector<char> keys;
+	loadSeparators(parent, nonleafSize(parent), keys);
+	keys.insert(keys.begin() + index * payloadBytes, separator, separator + payloadBytes);
+	if (separatorsFit(keys)){
+		return true;
+	}
+	crowdedNode.store(parentPageNum, std::memory_order_relaxed);
+	return false;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::replaceSeparator
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::replaceSeparator(std::vector<char> &keys, int index, const char *left, const char *right){
+	if (keyAttrs.empty()){
+		return true;
+	}
+	std::vector<char> changed(keys);
+	shortSeparator(left, right, &changed[index * payloadBytes]);
+	if (!separatorsFit(changed)){
+		return false;
+	}
+	keys.swap(changed);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::rotateSeparators
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::rotateSeparators(std::vector<char> &parentKeys, int index, std::vector<char> &siblingKeys, std::vector<char> &childKeys, bool fromLeft){
+	if (keyAttrs.empty()){
+		return true;
+	}
+	std::vector<char> parent(parentKeys);
+	std::vector<char> sibling(siblingKeys);
+	std::vector<char> child(childKeys);
+	char *separator = &parent[index * payloadBytes];
+	if (fromLeft){
+		child.insert(child.begin(), separator, separator + payloadBytes);
+		memcpy(separator, &sibling[sibling.size() - payloadBytes], payloadBytes);
+		sibling.resize(sibling.size() - payloadBytes);
+	}
+	else{
+		child.insert(child.end(), separator, separator + payloadBytes);
+		memcpy(separator, &sibling[0], payloadBytes);
+		sibling.erase(sibling.begin(), sibling.begin() + payloadBytes);
+	}
+	// the sibling only loses a separator
+	if (!separatorsFit(parent) || !separatorsFit(child)){
+		return false;
+	}
+	parentKeys.swap(parent);
+	siblingKeys.swap(sibling);
+	childKeys.swap(child);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::mergeSeparators
+// -----------------------------------------------------------------------------
+const bool BTreeIndex::mergeSeparators(std::vector<char> &leftKeys, const std::vector<char> &parentKeys, int index, const std::vector<char> &rightKeys){
+	if (keyAttrs.empty()){
+		return true;
+	}
+	std::vector<char> merged(leftKeys);
+	merged.insert(merged.end(), parentKeys.begin() + index * payloadBytes, parentKeys.begin() + (index + 1) * payloadBytes);
+	merged.insert(merged.end(), rightKeys.begin(), rightKeys.end());
+	if (!separatorsFit(merged)){
+		return false;
+	}
+	leftKeys.swap(merged);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::gatherPayload
+// -----------------------------------------------------------------------------
+const void BTreeIndex::gatherPayload(const char *record, char *payload){
+	for (size_t i = 0; i < includedAttrs.size(); i++){
+		memcpy(payload, record + includedAttrs[i].offset, includedAttrs[i].length);
+		payload += includedAttrs[i].length;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::keyPrefix
+// -----------------------------------------------------------------------------
+const int BTreeIndex::keyPrefix(const char *key, int length, unsigned char fill){
+	std::uint32_t bits = 0;
+	for (int b = 0; b < 4; b++){
+		bits = bits << 8 | (b < length ? (unsigned char)key[b] : fill);
+	}
+	return (int)(bits ^ 0x80000000u);
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::leafSize
+// -----------------------------------------------------------------------------
+const int BTreeIndex::leafSize(LeafNodeInt *leaf){
+	// used slots are always packed at the front of the leaf
+	int lo = 0;
+	int hi = leafOccupancy;
+	while (lo < hi){
+		int mid = (lo + hi)/2;
+		if (leaf->ridArray[mid].page_number == 0){
+			hi = mid;
+		}
+		else{
+			lo = mid + 1;
+		}
+	}
+	return lo;
+}
+
+// -----------------------------------------------------------------------------
+// BTreeIndex::nonleafSize
+// -----------------------------------------------------------------------------
+const int BTreeIndex::nonleafSize(NonLeafNodeInt *nonleaf){
+	int i = nodeOccupancy;
+	while (i > 0 && nonleaf->pageNoArray[i] == 0){
+		i--;
 	}
+	return i;
 }
 
 }
@@ -11,11 +11,18 @@
 #include <string>
 #include "string.h"
 #include <sstream>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 #include "types.h"
 #include "page.h"
 #include "file.h"
 #include "buffer.h"
+#include "latch.h"
+#include "bloomfilter.h"
 
 namespace badgerdb
 {
@@ -38,15 +45,46 @@ enum Operator
 	LT, 	/* Less Than */
 	LTE,	/* Less Than or Equal to */
 	GTE,	/* Greater Than or Equal to */
-	GT		/* Greater Than */
+	GT,		/* Greater Than */
+	EQ		/* Equal to */
+};
+
+/**
+ * @brief Leaf page formats. Passed to the BTreeIndex constructor.
+ */
+enum LeafFormat
+{
+	PLAIN_LEAVES = 0,	/* Arrays of keys and RecordIds */
+	PACKED_LEAVES = 1,	/* Bit packed differences to the smallest key and RecordId of the leaf */
+	RECORD_LEAVES = 2	/* Arrays of keys and row ids followed by the records of an index-organized table */
+};
+
+/**
+ * @brief Orders in which a scan returns entries. Passed to BTreeIndex::startScan() method.
+ */
+enum ScanOrder
+{
+	ASCENDING = 0,	/* From the low end of the range up */
+	DESCENDING = 1	/* From the high end of the range down */
+};
+
+/**
+ * @brief Non-leaf page formats. Passed to the BTreeIndex constructor.
+ */
+enum NonLeafFormat
+{
+	PLAIN_NONLEAVES = 0,	/* Array of keys searched from its end */
+	BLOCKED_NONLEAVES = 1,	/* Array of keys cut into cache lines, below a directory of the last key of each line */
+	COUNTED_NONLEAVES = 2,	/* Array of keys followed by the number of entries below each child */
+	COMPRESSED_NONLEAVES = 3	/* Separators of a composite key cut short, past a prefix the node keeps once */
 };
 
 
 /**
  * @brief Number of key slots in B+Tree leaf for INTEGER key.
  */
-//                                                  sibling ptr             key               rid
-const  int INTARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
+//                                                  sibling ptrs                key               rid
+const  int INTARRAYLEAFSIZE = ( Page::SIZE - 2 * sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
 
 /**
  * @brief Number of key slots in B+Tree non-leaf for INTEGER key.
@@ -54,6 +92,109 @@ const  int INTARRAYLEAFSIZE = ( Page::SIZE - sizeof( PageId ) ) / ( sizeof( int
 //                                                     level     extra pageNo                  key       pageNo
 const  int INTARRAYNONLEAFSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( PageId ) );
 
+/**
+ * @brief Number of keys in a 64 byte cache line.
+ */
+const int LINEKEYS = 64 / sizeof( int );
+
+/**
+ * @brief Number of cache lines holding the keys of a blocked non-leaf. The level shares the first one.
+ */
+const int BLOCKEDLINES = 60;
+
+/**
+ * @brief Number of key slots in a blocked B+Tree non-leaf for INTEGER key. The slots of keyArray past
+ * them hold the directory of the node: the last key of every full line, then the last directory entry
+ * of every full line of the directory, then the number of keys. The directory starts on a line of its own.
+ */
+const int INTARRAYBLOCKEDSIZE = BLOCKEDLINES * LINEKEYS - 1;
+
+static_assert(INTARRAYBLOCKEDSIZE + ( BLOCKEDLINES - 1 ) + ( BLOCKEDLINES - 1 ) / LINEKEYS + 1 <= INTARRAYNONLEAFSIZE,
+              "The directory of a blocked non-leaf has to fit into keyArray.");
+
+/**
+ * @brief Number of key slots in a counted B+Tree non-leaf for INTEGER key. The slots of keyArray past
+ * them hold the number of entries below each child, in the order of pageNoArray.
+ */
+const int INTARRAYCOUNTEDSIZE = ( INTARRAYNONLEAFSIZE - 1 ) / 2;
+
+static_assert(INTARRAYCOUNTEDSIZE + INTARRAYCOUNTEDSIZE + 1 <= INTARRAYNONLEAFSIZE,
+              "The counts of a counted non-leaf have to fit into keyArray.");
+
+/**
+ * @brief Number of key slots in a compressed B+Tree non-leaf. The slots of keyArray past them hold the
+ * number of separators, the length of the prefix they share and where each separator ends, as 16 bit
+ * numbers. The slots of pageNoArray past the children hold the prefix, then what follows it in each
+ * separator up to the zero bytes it ends in.
+ */
+const int INTARRAYCOMPRESSEDSIZE = INTARRAYNONLEAFSIZE / 2;
+
+/**
+ * @brief Number of bytes of prefix and separators a compressed B+Tree non-leaf holds.
+ */
+const int COMPRESSEDHEAPSIZE = ( INTARRAYNONLEAFSIZE - INTARRAYCOMPRESSEDSIZE ) * sizeof( PageId );
+
+static_assert(( 2 + INTARRAYCOMPRESSEDSIZE ) * sizeof( std::uint16_t ) <= ( INTARRAYNONLEAFSIZE - INTARRAYCOMPRESSEDSIZE ) * sizeof( int ),
+              "The separator ends of a compressed non-leaf have to fit into keyArray.");
+
+/**
+ * @brief Most attributes of the relation an index can include in its leaf entries.
+ */
+const int MAXINCLUDED = 4;
+
+/**
+ * @brief Most bytes of included attributes a leaf entry can carry.
+ */
+const int MAXPAYLOADSIZE = 64;
+
+/**
+ * @brief Most bytes of a record of an index-organized table, which its leaf entries carry whole.
+ */
+const int MAXRECORDSIZE = 256;
+
+/**
+ * @brief Attribute of the relation stored in the leaf entries of a covering index next to the key,
+ * so scans can return it without reading the record. Passed to the BTreeIndex constructor.
+*/
+struct IncludedAttr{
+  /**
+   * Offset of the attribute inside records.
+   */
+	int offset;
+
+  /**
+   * Number of bytes of the attribute.
+   */
+	int length;
+};
+
+/**
+ * @brief Most attributes of the relation a composite key can be made of.
+ */
+const int MAXKEYATTRS = 4;
+
+/**
+ * @brief Attribute of the relation that is part of a composite key. Passed to the BTreeIndex constructor.
+ * Each is normalized into bytes that compare with memcmp the way the values compare: integers and
+ * doubles big endian with their sign flipped, strings padded with zero bytes to their length.
+*/
+struct KeyAttr{
+  /**
+   * Offset of the attribute inside records.
+   */
+	int offset;
+
+  /**
+   * Type of the attribute.
+   */
+	Datatype type;
+
+  /**
+   * Number of bytes of a STRING attribute, longer strings are cut. Ignored for the other types.
+   */
+	int length;
+};
+
 /**
  * @brief Structure to store a key-rid pair. It is used to pass the pair to functions that 
  * add to or make changes to the leaf node pages of the tree. Is templated for the key member.
@@ -100,15 +241,36 @@ bool operator<( const RIDKeyPair<T>& r1, const RIDKeyPair<T>& r2 )
 		return r1.rid.page_number < r2.rid.page_number;
 }
 
+/**
+ * @brief Word the meta page of every index file starts with, "BTIX" in little endian.
+*/
+const std::uint32_t INDEXMAGIC = 0x58495442;
+
+/**
+ * @brief Layout version of index files. Raised whenever the meta page or a node format changes, so files
+ * written in another layout are rejected instead of read as garbage.
+*/
+const std::uint32_t INDEXVERSION = 1;
+
 /**
  * @brief The meta page, which holds metadata for Index file, is always first page of the btree index file and is cast
  * to the following structure to store or retrieve information from it.
- * Contains the relation name for which the index is created, the byte offset
+ * Contains the magic word and layout version of the file, the relation name for which the index is created, the byte offset
  * of the key value on which the index is made, the type of the key and the page no
  * of the root page. Root page starts as page 2 but since a split can occur
  * at the root the root page may get moved up and get a new page no.
 */
 struct IndexMetaInfo{
+  /**
+   * INDEXMAGIC, to tell an index file from any other file.
+   */
+	std::uint32_t magic;
+
+  /**
+   * INDEXVERSION of the layout the file was written in.
+   */
+	std::uint32_t version;
+
   /**
    * Name of base relation.
    */
@@ -128,6 +290,57 @@ struct IndexMetaInfo{
    * Page number of root page of the B+ Tree inside the file index file.
    */
 	PageId rootPageNo;
+
+  /**
+   * Page number of the root while the tree consists of a single leaf. Starts as the
+   * first root page and changes when deletes collapse the tree back into one leaf.
+   */
+	PageId leafRootPageNo;
+
+  /**
+   * Format of the leaf pages.
+   */
+	LeafFormat leafFormat;
+
+  /**
+   * Format of the non-leaf pages.
+   */
+	NonLeafFormat nonLeafFormat;
+
+  /**
+   * Number of attributes included in leaf entries.
+   */
+	int includedCount;
+
+  /**
+   * Attributes included in leaf entries, in the order they are stored.
+   */
+	IncludedAttr included[ MAXINCLUDED ];
+
+  /**
+   * Number of attributes of a composite key, 0 for an index on attrByteOffset.
+   */
+	int keyCount;
+
+  /**
+   * Attributes of a composite key, in the order they are compared.
+   */
+	KeyAttr keys[ MAXKEYATTRS ];
+
+  /**
+   * Row id the next record inserted into an index-organized table gets.
+   */
+	PageId nextRowId;
+
+  /**
+   * Bits per key of the Bloom filter kept next to the index, 0 if there is none.
+   */
+	int bloomBits;
+
+  /**
+   * Stamp of the Bloom filter file written when the index was last closed, 0 if there is no current one.
+   */
+	std::uint64_t bloomStamp;
 };
 
 /*
@@ -147,16 +360,27 @@ struct NonLeafNodeInt{
 	int level;
 
   /**
-   * Stores keys.
+   * Stores keys. Blocked non-leaves only use the first INTARRAYBLOCKEDSIZE slots for keys and keep
+   * their directory in the rest, counted ones use the first INTARRAYCOUNTEDSIZE and keep their counts.
    */
 	int keyArray[ INTARRAYNONLEAFSIZE ];
 
   /**
    * Stores page numbers of child pages which themselves are other non-leaf/leaf nodes in the tree.
+   * While a node is in the buffer pool, the number of the frame holding a child may stand in for
+   * the page number of the child, marked with SWIZZLEDBIT. Pages never go to disk that way.
+   * Non-leaves of a composite index have fewer children and keep the whole normalized keys of their
+   * separators in the slots past them, see BTreeIndex::separatorKey, compressed ones keep them shortened.
    */
 	PageId pageNoArray[ INTARRAYNONLEAFSIZE + 1 ];
 };
 
+/**
+ * @brief Bit marking a child reference of a non leaf node as the frame number of the child rather
+ * than its page number. Index files never get anywhere near 2^31 pages.
+ */
+const PageId SWIZZLEDBIT = 0x80000000u;
+
 
 /**
  * @brief Structure for all leaf nodes when the key is of INTEGER type.
@@ -168,7 +392,8 @@ struct LeafNodeInt{
 	int keyArray[ INTARRAYLEAFSIZE ];
 
   /**
-   * Stores RecordIds.
+   * Stores RecordIds. Leaves of covering indexes hold fewer entries and keep the included
+   * attributes of each in the slots past them, see BTreeIndex::leafPayload.
    */
 	RecordId ridArray[ INTARRAYLEAFSIZE ];
 
@@ -177,212 +402,1350 @@ struct LeafNodeInt{
 	 * This linking of leaves allows to easily move from one leaf to the next leaf during index scan.
    */
 	PageId rightSibPageNo;
+
+  /**
+   * Page number of the leaf on the left side, 0 for the leftmost leaf. Followed by descending scans.
+   */
+	PageId leftSibPageNo;
 };
 
+/**
+ * @brief Slot number of a leaf entry that stands for a posting list. Slots are numbered from 1 and
+ * never get this high, so the page number of such an entry holds the first page of the list instead.
+ */
+const SlotId POSTINGSLOT = 0xFFFF;
+
+/**
+ * @brief Number of entries with the same key a leaf holds before they are moved into a posting list.
+ * Smaller runs stay in the leaf, where they take less room than a posting page.
+ */
+const int POSTINGTHRESHOLD = INTARRAYLEAFSIZE / 2;
 
 /**
- * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
- * relation. This index supports only one scan at a time.
-*/
-class BTreeIndex {
+ * @brief Number of bytes of encoded RecordIds in a posting page.
+ */
+//                                                 next page         count, length         last rid
+const int POSTINGDATASIZE = Page::SIZE - sizeof( PageId ) - 2 * sizeof( int ) - sizeof( RecordId );
 
- private:
+/**
+ * @brief Most RecordIds a posting page can hold, every one of them takes at least two bytes.
+ */
+const int POSTINGCAPACITY = POSTINGDATASIZE / 2;
 
+/**
+ * @brief Structure for the pages of a posting list, which holds the RecordIds of one key in
+ * RecordId order. Each one is stored as the difference of its page number to the previous
+ * one, followed by the slot number, or by the difference of slot numbers when both are on
+ * the same page, in 7 bit groups. Records of one key that are close in the relation take two
+ * or three bytes instead of the twelve of a leaf entry.
+*/
+struct PostingPageInt{
   /**
-   * File object for the index file.
+   * Page number of the next page of the list, 0 on the last one.
+   * Every RecordId on a page comes before those on the next page.
    */
-	File		*file;
+	PageId nextPageNo;
 
   /**
-   * Buffer Manager Instance.
+   * Number of RecordIds on the page.
    */
-	BufMgr	*bufMgr;
+	int count;
 
   /**
-   * Page number of meta page.
+   * Number of bytes of data in use.
    */
-	PageId	headerPageNum;
+	int length;
 
   /**
-   * page number of root page of B+ tree inside index file.
+   * Last RecordId on the page, so the list can be walked without decoding every page.
    */
-	PageId	rootPageNum;
+	RecordId lastRid;
 
   /**
-   * Datatype of attribute over which index is built.
+   * Encoded RecordIds.
    */
-	Datatype	attributeType;
+	unsigned char data[ POSTINGDATASIZE ];
+};
+
+/**
+ * @brief Number of 32 bit words of packed fields in a packed leaf.
+ */
+//                                                count, capacity      sibling ptrs           key base           page base        widths
+const int PACKEDLEAFWORDS = ( Page::SIZE - 2 * sizeof( int ) - 2 * sizeof( PageId ) - sizeof( int ) - sizeof( PageId ) - 4 ) / sizeof( std::uint32_t );
+
+/**
+ * @brief Most entries a packed leaf holds, however few bits they take. A multiple of four.
+ */
+const int PACKEDLEAFSIZE = 4 * INTARRAYLEAFSIZE;
 
+/**
+ * @brief Structure for leaf nodes of indexes created with PACKED_LEAVES. Keys, page numbers and slot
+ * numbers are stored in three fields, each value as its difference to the smallest one of the leaf
+ * in just as many bits as the largest difference needs. Dense keys of records stored in key order
+ * take about three bytes an entry instead of twelve. Entry i is kept in lane i % 4 of its field,
+ * every lane being a stream of bits spread over every fourth word, so four neighbouring entries
+ * sit at the same offset of four neighbouring words and are unpacked together.
+*/
+struct PackedLeafInt{
   /**
-   * Offset of attribute, over which index is built, inside records. 
+   * Number of entries.
    */
-	int 		attrByteOffset;
+	int count;
 
   /**
-   * Number of keys in leaf node, depending upon the type of key.
+   * Number of entries the fields have room for with the current widths, a multiple of four.
    */
-	int			leafOccupancy;
+	int capacity;
 
   /**
-   * Number of keys in non-leaf node, depending upon the type of key.
+   * Page number of the leaf on the right side.
    */
-	int			nodeOccupancy;
+	PageId rightSibPageNo;
 
+  /**
+   * Page number of the leaf on the left side.
+   */
+	PageId leftSibPageNo;
 
-	// MEMBERS SPECIFIC TO SCANNING
+  /**
+   * Smallest key, the first one.
+   */
+	int keyBase;
 
   /**
-   * True if an index scan has been started.
+   * Smallest page number.
    */
-	bool		scanExecuting;
+	PageId pageBase;
 
   /**
-   * Index of next entry to be scanned in current leaf being scanned.
+   * Bits taken by every key, page number and slot number.
    */
-	int			nextEntry;
+	unsigned char keyBits;
+	unsigned char pageBits;
+	unsigned char slotBits;
+	unsigned char unused;
 
   /**
-   * Page number of current page being scanned.
+   * The key field, followed by the page number and the slot number fields.
    */
-	PageId	currentPageNum;
+	std::uint32_t words[ PACKEDLEAFWORDS ];
+};
 
+/**
+ * @brief Number of slots of the table of pinned non leaf nodes. At most half of them are used,
+ * which with fanouts around a thousand covers the root and the level below it.
+ */
+const int PINNEDSLOTS = 4096;
+
+/**
+ * @brief Slot of the table of non leaf nodes an index keeps pinned, with the frame holding each.
+*/
+struct PinnedNode{
   /**
-   * Current Page being scanned.
+   * Page number of the node, 0 in an empty slot.
    */
-	Page		*currentPageData;
+	PageId pageNo;
 
   /**
-   * Low INTEGER value for scan.
+   * Buffer frame holding the node for as long as it is pinned.
    */
-	int			lowValInt;
+	Page *page;
+};
+
+/**
+ * @brief Default bound on how many leaves away from the one holding a key BTreeIndex::learnLeaves lets
+ * its model predict for it.
+ */
+const int LEARNEDERROR = 2;
 
+/**
+ * @brief Line of the piecewise linear model of BTreeIndex::learnLeaves. It predicts the position in key
+ * order of the leaf covering a key from firstKey up to the firstKey of the next segment.
+*/
+struct LearnedSegment{
   /**
-   * Low DOUBLE value for scan.
+   * Smallest key the segment covers, the first key of leaf firstLeaf.
    */
-	double	lowValDouble;
+	int firstKey;
 
   /**
-   * Low STRING value for scan.
+   * Position of the first leaf the segment covers.
    */
-	std::string	lowValString;
+	int firstLeaf;
 
   /**
-   * High INTEGER value for scan.
+   * Position of the last leaf the segment covers.
    */
-	int			highValInt;
+	int lastLeaf;
 
   /**
-   * High DOUBLE value for scan.
+   * Leaves per unit of key above firstKey.
    */
-	double	highValDouble;
+	double slope;
+};
+
+/**
+ * @brief Most descents BTreeIndex::lookupBatch interleaves. Each holds a page pinned.
+ */
+const size_t LOOKUPGROUP = 64;
 
+/**
+ * @brief Where an optimistic descent of the tree is, so that several of them can be taken a level at a time.
+*/
+struct Descent{
   /**
-   * High STRING value for scan.
+   * Page number of the node the descent is at.
    */
-	std::string highValString;
-	
+	PageId pageNo;
+
   /**
-   * Low Operator. Can only be GT(>) or GTE(>=).
+   * Buffer frame holding the node.
    */
-	Operator	lowOp;
+	Page *page;
 
   /**
-   * High Operator. Can only be LT(<) or LTE(<=).
+   * True if the node was pinned for the descent, see BTreeIndex::readNode.
    */
-	Operator	highOp;
+	bool held;
 
-// page id for non split root
-PageId initialroot;
+  /**
+   * Version of the node read before its contents.
+   */
+	std::uint64_t version;
 
-public:
+  /**
+   * True once the descent is at a leaf.
+   */
+	bool leaf;
 
   /**
-   * BTreeIndex Constructor. 
-	 * Check to see if the corresponding index file exists. If so, open the file.
-	 * If not, create it and insert entries for every tuple in the base relation using FileScan class.
-   *
-   * @param relationName        Name of file.
-   * @param outIndexName        Return the name of index file.
-   * @param bufMgrIn						Buffer Manager Instance
-   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
-   * @param attrType						Datatype of attribute over which index is built
-   * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type etc.) do not match with values received through constructor parameters.
+   * True if the leaf is the root of the tree.
    */
-	BTreeIndex(const std::string & relationName, std::string & outIndexName,
-						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
-	
+	bool rootLeaf;
 
   /**
-   * BTreeIndex Destructor. 
-	 * End any initialized scan, flush index file, after unpinning any pinned pages, from the buffer manager
-	 * and delete file instance thereby closing the index file.
-	 * Destructor should not throw any exceptions. All exceptions should be caught in here itself. 
-	 * */
-	~BTreeIndex();
+   * Largest key that belongs below the node.
+   */
+	int upper;
+};
 
 
-  /**
-	 * Insert a new entry using the pair <value,rid>. 
-	 * Start from root to recursively find out the leaf to insert the entry in. The insertion may cause splitting of leaf node.
-	 * This splitting will require addition of new leaf page number entry into the parent non-leaf, which may in-turn get split.
-	 * This may continue all the way upto the root causing the root to get split. If root gets split, metapage needs to be changed accordingly.
-	 * Make sure to unpin pages as soon as you can.
-   * @param key			Key to insert, pointer to integer/double/char string
-   * @param rid			Record ID of a record whose entry is getting inserted into the index.
-	**/
-	const void insertEntry(const void* key, const RecordId rid);
+class BTreeIndex;
+
+/**
+ * @brief Cursor over a range of a BTreeIndex, returned by BTreeIndex::startScan().
+ * Each cursor owns its position, bounds and pinned leaf, so any number of them can be
+ * open on one index at the same time, from one or several threads. A cursor only pins
+ * one leaf and allocates nothing unless the scan meets duplicate keys, so it is cheap
+ * enough to open one per probe of a nested loop join.
+ * Cursors can be moved but not copied. They end their scan when destroyed and must
+ * not outlive the index they scan.
+*/
+class BTreeCursor {
+
+ private:
 
+	friend class BTreeIndex;
 
   /**
-	 * Begin a filtered scan of the index.  For instance, if the method is called 
-	 * using ("a",GT,"d",LTE) then we should seek all entries with a value 
-	 * greater than "a" and less than or equal to "d".
-	 * If another scan is already executing, that needs to be ended here.
-	 * Set up all the variables for scan. Start from root to find out the leaf page that contains the first RecordID
-	 * that satisfies the scan parameters. Keep that page pinned in the buffer pool.
-   * @param lowVal	Low value of range, pointer to integer / double / char string
-   * @param lowOp		Low operator (GT/GTE)
-   * @param highVal	High value of range, pointer to integer / double / char string
-   * @param highOp	High operator (LT/LTE)
-   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values 
-   * @throws  BadScanrangeException If lowVal > highval
-	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
-	**/
-	const void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+   * Index being scanned.
+   */
+	BTreeIndex	*index;
 
+  /**
+   * True if the cursor holds a scan.
+   */
+	bool		scanExecuting;
 
   /**
-	 * Fetch the record id of the next index entry that matches the scan.
-	 * Return the next record from current page being scanned. If current page has been scanned to its entirety, move on to the right sibling of current page, if any exists, to start scanning that page. Make sure to unpin any pages that are no longer required.
-   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
-	 * @throws ScanNotInitializedException If no scan has been initialized.
-	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
-	**/
-	const void scanNext(RecordId& outRid);  // returned record id
+   * True once no more entries can match.
+   */
+	bool		scanCompleted;
 
+  /**
+   * Index of next entry to be scanned in current leaf being scanned.
+   */
+	int			nextEntry;
 
   /**
-	 * Terminate the current scan. Unpin any pinned pages. Reset scan specific variables.
-	 * @throws ScanNotInitializedException If no scan has been initialized.
-	**/
-	const void endScan();
+   * Page number of current page being scanned.
+   */
+	PageId	currentPageNum;
+
+  /**
+   * Current Page being scanned.
+   */
+	Page		*currentPageData;
+
+  /**
+   * Version of the current leaf that nextEntry refers to.
+   */
+	std::uint64_t	currentVersion;
+
+  /**
+   * Low INTEGER value for scan.
+   */
+	int			lowValInt;
+
+  /**
+   * High INTEGER value for scan.
+   */
+	int			highValInt;
+
+  /**
+   * Low Operator. Can only be GT(>) or GTE(>=).
+   */
+	Operator	lowOp;
+
+  /**
+   * High Operator. Can only be LT(<) or LTE(<=).
+   */
+	Operator	highOp;
+
+  /**
+   * True if entries are returned from the high end of the range down, walking leaves to the left.
+   */
+	bool		descending;
+
+  /**
+   * True once the scan has returned an entry.
+   */
+	bool		scanReturned;
+
+  /**
+   * Key of the last entry returned. Entries can move between leaves while the scan runs,
+   * so anything at or before it in scan order that was already returned is skipped.
+   */
+	int			lastKeyInt;
+
+  /**
+   * RecordIds returned so far with key lastKeyInt.
+   */
+	std::vector<RecordId> lastKeyRids;
+
+  /**
+   * True if pendingRid holds the entry startScan found but scanNext has not returned yet.
+   */
+	bool		hasPending;
+
+  /**
+   * First matching entry, looked up by startScan.
+   */
+	RecordId	pendingRid;
+
+  /**
+   * Included attributes, normalized key or record of pendingRid.
+   */
+	char		pendingPayload[ MAXRECORDSIZE ];
+
+  /**
+   * First page of the posting list being returned, 0 if none.
+   */
+	PageId		postingHead;
+
+  /**
+   * Page number of the posting page postingRids was decoded from.
+   */
+	PageId		postingPageNum;
+
+  /**
+   * Posting page postingRids was decoded from, kept pinned. Null while no list is open.
+   */
+	Page		*postingPageData;
+
+  /**
+   * Version of the posting page postingRids was decoded from.
+   */
+	std::uint64_t	postingVersion;
+
+  /**
+   * Page number of the page after it when it was decoded.
+   */
+	PageId		postingNextPage;
+
+  /**
+   * RecordIds decoded from the current posting page. Sized for a full page once a list is met.
+   */
+	std::vector<RecordId> postingRids;
+
+  /**
+   * Number of RecordIds in postingRids.
+   */
+	size_t		postingCount;
+
+  /**
+   * Index of next RecordId to be returned from postingRids.
+   */
+	size_t		postingNext;
+
+  /**
+   * True once a RecordId of the posting list at postingHead has been returned.
+   */
+	bool		postingReturned;
+
+  /**
+   * Last RecordId returned from the posting list. Lists are kept in RecordId order, so the
+   * cursor picks up after it wherever the list moved it meanwhile.
+   */
+	RecordId	postingLastRid;
+
+  /**
+   * Progress on other posting lists with key lastKeyInt the scan left before their end.
+   */
+	std::vector<std::pair<PageId, RecordId> > postingProgress;
+
+	BTreeCursor(const BTreeCursor &other);
+	BTreeCursor & operator=(const BTreeCursor &other);
+
+	// fetch the next matching entry and its included attributes if outPayload is given, false once there is none
+	const bool fetch(RecordId &outRid, char *outPayload = nullptr);
+	// descend to the first entry at or after the scan position in scan order
+	const void seek();
+	// follow the sibling link of the current leaf in scan order
+	const void moveSibling(PageId sibPageNo);
+	// move to the next entry of the current leaf in scan order
+	const void step();
+	// true if key is below the low end of the range
+	const bool belowRange(int key);
+	// true if key is above the high end of the range
+	const bool aboveRange(int key);
+	// make the posting list at head the one being returned, keeping what was returned of the previous one
+	const void postingSwitch(PageId head);
+	// next RecordId of the open posting list, false at its end or if the leaf has to be read again
+	const bool postingFetch(RecordId &outRid);
+	// open the posting list from its first page, false if it changed meanwhile
+	const bool postingSeek();
+	// decode the current posting page, false if it changed meanwhile
+	const bool postingLoad();
+	// follow the next page link of the current posting page, false if it changed meanwhile
+	const bool postingMoveRight();
+	// unpin the current posting page
+	const void postingClose();
+	// set bounds from startScan parameters
+	const void setRange(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+ public:
+
+  /**
+   * Constructs a cursor that holds no scan.
+   */
+	BTreeCursor();
+
+  /**
+   * Takes over the scan of other, which is left without one.
+   */
+	BTreeCursor(BTreeCursor &&other);
+
+  /**
+   * Ends the scan held by this cursor and takes over the scan of other.
+   */
+	BTreeCursor & operator=(BTreeCursor &&other);
+
+  /**
+   * Ends the scan, if any.
+   */
+	~BTreeCursor();
+
+  /**
+	 * Fetch the record id of the next index entry that matches the scan.
+	 * Entries present for the whole scan are returned exactly once even while other threads change the tree.
+   * @param outRid	RecordId of next record found that satisfies the scan criteria returned in this
+   * @param outPayload	If given, the included attributes of the entry are copied here, see BTreeIndex::payloadSize
+	 * @throws ScanNotInitializedException If the cursor holds no scan.
+	 * @throws IndexScanCompletedException If no more records, satisfying the scan criteria, are left to be scanned.
+	**/
+	const void scanNext(RecordId& outRid, char *outPayload = nullptr);
+
+  /**
+	 * Terminate the scan. Unpin the leaf held by the cursor.
+	 * @throws ScanNotInitializedException If the cursor holds no scan.
+	**/
+	const void endScan();
+
+  /**
+	 * Fetch the record ids of up to max further entries that match the scan. Runs of matching
+	 * entries are copied out of a leaf at once. Unlike scanNext, the end of the range is not an
+	 * exception: fewer than max entries are returned only when the scan is complete.
+   * @param out	Array receiving the record ids, with room for max of them
+   * @param max	Maximum number of record ids to return
+   * @param outPayloads	If given, the included attributes of entry i are copied to outPayloads + i * payloadSize
+   * @return  Number of record ids stored in out, 0 once the scan is complete
+	 * @throws ScanNotInitializedException If the cursor holds no scan.
+	**/
+	const size_t nextBatch(RecordId *out, size_t max, char *outPayloads = nullptr);
+};
+
+
+/**
+ * @brief BTreeIndex class. It implements a B+ Tree index on a single attribute of a
+ * relation. Scans are run through BTreeCursor objects, any number of which may be open at once.
+ *
+ * Inserts, deletes and the scan may run from several threads at once. Nodes are protected
+ * with optimistic lock coupling: every buffer frame carries an OptLatch, readers descend
+ * without latching and validate node versions as they go, and writers latch only the nodes
+ * they change. Deletes that have to merge or redistribute nodes latch their whole path and
+ * run one at a time. Indexes with counted non-leaves run every insert and delete that way.
+*/
+class BTreeIndex : public Swizzler {
+
+ private:
+
+	friend class BTreeCursor;
+
+  /**
+   * File object for the index file.
+   */
+	File		*file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+	BufMgr	*bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+	PageId	headerPageNum;
+
+  /**
+   * page number of root page of B+ tree inside index file.
+   */
+	PageId	rootPageNum;
+
+  /**
+   * Datatype of attribute over which index is built.
+   */
+	Datatype	attributeType;
+
+  /**
+   * Offset of attribute, over which index is built, inside records. 
+   */
+	int 		attrByteOffset;
+
+  /**
+   * Number of keys in leaf node, depending upon the type of key.
+   */
+	int			leafOccupancy;
+
+  /**
+   * Number of keys in non-leaf node, depending upon the type of key.
+   */
+	int			nodeOccupancy;
+
+  /**
+   * True if leaves are PackedLeafInt pages rather than LeafNodeInt ones.
+   */
+	bool		packedLeaves;
+
+  /**
+   * True if non-leaves hold INTARRAYBLOCKEDSIZE keys and the directory of their cache lines.
+   */
+	bool		blockedNonleaves;
+
+  /**
+   * True if non-leaves hold INTARRAYCOUNTEDSIZE keys and the number of entries below each of their children.
+   */
+	bool		countedNonleaves;
+
+  /**
+   * True if non-leaves of a composite index hold up to INTARRAYCOMPRESSEDSIZE separators as suffixes of a prefix they share.
+   */
+	bool		compressedNonleaves;
+
+  /**
+   * Compressed non-leaf an insert found without room for the separator of a split below it, which the next
+   * insert to reach it splits first. 0 if there is none.
+   */
+	std::atomic<PageId>	crowdedNode;
+
+  /**
+   * Attributes of the relation included in leaf entries, none unless the index is covering.
+   */
+	std::vector<IncludedAttr>	includedAttrs;
+
+  /**
+   * Bytes of included attributes of each leaf entry, 0 unless the index is covering.
+   */
+	int			payloadBytes;
+
+  /**
+   * Relation the index is on, kept open by covering indexes to read the attributes of inserted records.
+   */
+	File		*relationFile;
+
+  /**
+   * Attributes of the composite key, none for an index on a single INTEGER attribute. The normalized
+   * key is kept in each leaf entry where covering indexes keep their included attributes, and its
+   * first four bytes, read as a big endian integer with the sign flipped back, are the key of the tree.
+   */
+	std::vector<KeyAttr>	keyAttrs;
+
+  /**
+   * True if the index is an index-organized table, whose leaf entries carry whole records where covering
+   * indexes keep their included attributes. There is no relation, records are inserted with insertRecord.
+   */
+	bool		recordLeaves;
+
+  /**
+   * Row id the next record inserted into an index-organized table gets, written to the meta page when
+   * the table is closed.
+   */
+	std::atomic<PageId>	nextRowId;
+
+  /**
+   * Most inserts kept in insertBuffer before they are applied to the tree, 0 while inserts are not buffered.
+   */
+	std::atomic<size_t>	insertBufferLimit;
+
+  /**
+   * Inserts not applied to the tree yet, in the order they came.
+   */
+	std::vector<RIDKeyPair<int> >	insertBuffer;
+
+  /**
+   * Number of buffered inserts, including those being applied, so reads know when there is nothing to wait for.
+   */
+	std::atomic<size_t>	bufferedCount;
+
+  /**
+   * Protects insertBuffer.
+   */
+	std::mutex	bufferMutex;
+
+  /**
+   * Held while buffered inserts are applied, so reads wait until the entries they are after are in the tree.
+   */
+	std::mutex	flushMutex;
+
+  /**
+   * Constructor the public ones take, for a composite index if keys is not empty.
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType,
+						const LeafFormat leafFormat, const NonLeafFormat nonLeafFormat,
+						const std::vector<IncludedAttr> &included, const std::vector<KeyAttr> &keys);
+
+// page id for non split root
+PageId initialroot;
+
+  /**
+   * Protects rootPageNum and initialroot. Acts as the parent latch of the root node.
+   */
+	OptLatch	rootLatch;
+
+  /**
+   * Serializes deletes that change the structure of the tree.
+   */
+	std::mutex	structureMutex;
+
+  /**
+   * Page number of the rightmost leaf, where appends of ever increasing keys go without
+   * descending the tree, or 0 if it is not known.
+   */
+	PageId	rightmostLeaf;
+
+  /**
+   * First key of the rightmost leaf when it was cached. Keys not above it are not appends
+   * and do not look at the leaf.
+   */
+	int			rightmostLowKey;
+
+  /**
+   * Protects rightmostLeaf and rightmostLowKey.
+   */
+	OptLatch	rightmostLatch;
+
+  /**
+   * Number of levels, counted from the root, whose non leaf nodes stay pinned. 0 if none do.
+   */
+	int			pinnedLevels;
+
+  /**
+   * Open addressing table of the pinned non leaf nodes, indexed by page number. Nodes are added when
+   * they are pinned or split off a pinned level, and only leave the table when they are freed or the
+   * index is closed, so a root split leaves the former top levels pinned one level further down.
+   */
+	std::vector<PinnedNode>	pinnedNodes;
+
+  /**
+   * Number of nodes in pinnedNodes.
+   */
+	int			pinnedCount;
+
+  /**
+   * Protects pinnedNodes and pinnedCount.
+   */
+	OptLatch	pinLatch;
+
+  /**
+   * True if optimistic descents replace the page numbers of the children they find in the
+   * buffer pool with their frame numbers, so later descents skip the buffer manager lookup.
+   */
+	bool		swizzling;
+
+  /**
+   * Segments of the learned model of the leaves, by firstKey. Empty until learnLeaves is called.
+   */
+	std::vector<LearnedSegment>	learnedSegments;
+
+  /**
+   * Page numbers of the leaves in key order when the model was learned.
+   */
+	std::vector<PageId>	learnedLeaves;
+
+  /**
+   * Bound on the error of the model in leaves.
+   */
+	int			learnedError;
+
+  /**
+   * True while no insert or delete has changed the leaves since the model was learned. Writers clear
+   * it before they change a leaf, so lookups that find it still set after reading a leaf read it
+   * as it was learned.
+   */
+	std::atomic<bool>	learnedFresh;
+
+  /**
+   * Filter of the keys of the index, null if it keeps none.
+   */
+	BloomFilter	*bloom;
+
+public:
+
+  /**
+   * BTreeIndex Constructor. 
+	 * Check to see if the corresponding index file exists. If so, open the file.
+	 * If not, create it and insert entries for every tuple in the base relation using FileScan class.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
+   * @param attrType						Datatype of attribute over which index is built
+   * @param leafFormat					Format of the leaf pages. PACKED_LEAVES fits several times more entries in a leaf
+   *                            when keys are dense, making the tree shallower and scans read fewer pages, at the
+   *                            price of inserts and deletes that shift bit packed fields.
+   * @param nonLeafFormat				Format of the non-leaf pages. BLOCKED_NONLEAVES finds the child to descend to
+   *                            reading three cache lines of keys, at the price of fewer keys per node and
+   *                            rebuilding the directory whenever the keys of a node change. COUNTED_NONLEAVES keeps
+   *                            the number of entries below each child, so ranges are counted and entries found by
+   *                            their position in two descents, at the price of fewer keys per node, inserts and
+   *                            deletes that run one at a time to fix the counts of their path, and duplicates that
+   *                            stay in the leaves instead of going to posting lists.
+   * @param included						Attributes of the relation to store in every leaf entry next to the key, so that
+   *                            scans return them without reading the records. Each entry takes their length
+   *                            on top of its 12 bytes, which leaves fewer entries a leaf and more leaves to scan,
+   *                            see leafCapacity. Duplicates stay in the leaves instead of going to posting lists.
+   * @throws  BadIndexInfoException     If attrType is not INTEGER. STRING and DOUBLE attributes are indexed as
+   *                            composite keys of one attribute, see KeyAttr.
+   * @throws  BadIndexInfoException     If attrByteOffset is negative.
+   * @throws  BadIndexInfoException     If attributes are included in packed leaves, more than MAXINCLUDED of them or
+   *                            more than MAXPAYLOADSIZE bytes.
+   * @throws  BadIndexInfoException     If the index file already exists for the corresponding attribute, but values in metapage(relationName, attribute byte offset, attribute type, leaf and non-leaf format etc.) do not match with values received through constructor parameters.
+   * @throws  BadIndexInfoException     If the index file already exists but was not written by this layout version (INDEXMAGIC, INDEXVERSION).
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType,
+						const LeafFormat leafFormat = PLAIN_LEAVES, const NonLeafFormat nonLeafFormat = PLAIN_NONLEAVES,
+						const std::vector<IncludedAttr> &included = std::vector<IncludedAttr>());
+
+  /**
+   * BTreeIndex Constructor for a composite key over several attributes, compared in the order given.
+	 * Keys are normalized into byte strings, see KeyAttr, which one memcmp compares whatever the attributes
+	 * are. Entries are ordered by the whole normalized key, which the leaves keep next to its first four
+	 * bytes and the non-leaves keep for their separators, so lookupKeys seeks to its low bound and stops
+	 * at its high one without reading records, however many keys share their leading bytes. The index file
+	 * is named after the relation and the offsets of the attributes. Inserts and deletes take normalized
+	 * keys, see encodeKey and encodePrefix.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param keys								Attributes of the key, the most significant first
+   * @param nonLeafFormat				Format of the non-leaf pages, see the other constructor. Blocked ones have no room for the
+   *                            separators. COMPRESSED_NONLEAVES keeps the prefix the separators of a node share once
+   *                            and cuts each separator of two leaves short after the first byte telling them apart,
+   *                            so keys sharing long prefixes, like strings, get up to INTARRAYCOMPRESSEDSIZE
+   *                            children a node and a shallower tree, at the price of decoding the separators
+   *                            whenever a node changes.
+   * @throws  BadIndexInfoException     If there are no attributes or more than MAXKEYATTRS of them, their
+   *                            normalized key takes more than MAXPAYLOADSIZE bytes, or the non-leaves are blocked.
+   * @throws  BadIndexInfoException     If non-leaves are compressed for an index that does not have a composite key.
+   * @throws  BadIndexInfoException     If the index file already exists with other attributes or format.
+   */
+	BTreeIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn, const std::vector<KeyAttr> &keys,
+						const NonLeafFormat nonLeafFormat = PLAIN_NONLEAVES);
+
+  /**
+   * BTreeIndex Constructor for an index-organized table, whose records live in the leaves of the tree
+	 * next to their keys instead of in a relation. Range scans read the records from consecutive leaves
+	 * in key order and point lookups read one leaf, neither reads a heap page. Each record gets a row id,
+	 * which scans return for it and deletes take with its key, the way a relation hands out record ids.
+	 * Opens the table if its file exists, otherwise creates an empty one named after the table.
+   *
+   * @param tableName						Name of the table.
+   * @param outIndexName        Return the name of the table file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param attrByteOffset			Offset of the INTEGER attribute the records are ordered by
+   * @param recordLength				Number of bytes of every record
+   * @param nonLeafFormat				Format of the non-leaf pages, see the first constructor
+   * @throws  BadIndexInfoException     If records take more than MAXRECORDSIZE bytes or the key is not inside them.
+   * @throws  BadIndexInfoException     If the table file already exists with another key, record length or format.
+   */
+	BTreeIndex(const std::string & tableName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset, const int recordLength,
+						const NonLeafFormat nonLeafFormat = PLAIN_NONLEAVES);
+	
+
+  /**
+   * BTreeIndex Destructor. 
+	 * Flush index file from the buffer manager
+	 * and delete file instance thereby closing the index file.
+	 * All cursors on the index have to be ended before it is destroyed.
+	 * Destructor should not throw any exceptions. All exceptions should be caught in here itself. 
+	 * */
+	~BTreeIndex();
+
+
+  /**
+	 * Insert a new entry using the pair <value,rid>. 
+	 * Start from root to find out the leaf to insert the entry in. Full non-leaf nodes met on the way down are split
+	 * right away, so a leaf split only ever adds one entry to a parent that has room for it. If root gets split,
+	 * metapage needs to be changed accordingly. Whenever a concurrent change invalidates what was read the
+	 * insertion starts over from the root. Once a leaf holds POSTINGTHRESHOLD entries with the same key they
+	 * are replaced by a single entry pointing to a posting list, which takes the further duplicates. Packed leaves
+	 * keep their duplicates, which take no bits of the key field. With counted non-leaves inserts run one at a time,
+	 * duplicates stay in the leaves and the counts on the path of the entry are fixed before the next insert.
+	 * Covering indexes read the record from the relation for its included attributes. Composite indexes take
+	 * the normalized key, see encodeKey. Once bufferInserts is called the entry goes into the insert buffer.
+   * @param key			Key to insert, pointer to integer/double/char string
+   * @param rid			Record ID of a record whose entry is getting inserted into the index.
+	**/
+	const void insertEntry(const void* key, const RecordId rid);
+
+  /**
+	 * Insert a new entry like insertEntry(key, rid), taking the included attributes of a covering index
+	 * from the record instead of reading it from the relation. insertEntry(key, rid) reads the record.
+   * @param key			Key to insert, pointer to integer/double/char string
+   * @param rid			Record ID of a record whose entry is getting inserted into the index.
+   * @param record	The record, attributes are taken from their offsets in it. Null to read it from the relation
+	 * @throws  BadIndexInfoException If record is null in an index-organized table, which has no relation.
+	**/
+	const void insertEntry(const void* key, const RecordId rid, const char* record);
+
+  /**
+	 * Insert a record into an index-organized table, in the leaf its key belongs in. Delete it with
+	 * deleteEntry, passing its key and the row id returned.
+   * @param record	The record, of the length the table was created with
+   * @return  Row id of the record
+	 * @throws  BadIndexInfoException If the index is not an index-organized table or the record is of another length.
+	**/
+	const RecordId insertRecord(const std::string &record);
+
+
+  /**
+	 * Insert a batch of entries, sorting it first. Consecutive entries that fall into the same leaf are merged
+	 * into it after a single descent from the root, so batches of nearby keys pin each level once per leaf
+	 * rather than once per entry. Entries that find their leaf full, or that start or join a posting list, are
+	 * inserted one at a time like insertEntry does, and the batch carries on in the leaves that split. With counted
+	 * non-leaves or included attributes every entry is inserted like insertEntry does.
+   * @param entries	Pairs of key and Record ID to insert, which are left sorted by key
+   * @param count		Number of entries
+	 * @throws  BadIndexInfoException If the index has a composite key, which integers cannot stand for.
+	**/
+	const void insertBatch(RIDKeyPair<int> *entries, size_t count);
+
+  /**
+	 * Buffer inserts in memory instead of applying each to its leaf right away. Once the buffer holds
+	 * the given number of entries they are sorted and applied with insertBatch, which reads and writes
+	 * each leaf they fall into once, however many of them it takes. An index much larger than the buffer
+	 * pool then reads a leaf per buffer-load of inserts landing in it rather than per insert. Reads of the
+	 * index (scans, lookups, counts and deletes) apply the buffered inserts first, so they see every
+	 * insert that came before them, and closing the index applies the rest.
+   * @param entries	Most inserts to buffer, 0 to apply the buffered ones and stop buffering
+	 * @throws  BadIndexInfoException If the index has a composite key or is an index-organized table, whose
+	 *                            entries insertBatch cannot take.
+	**/
+	const void bufferInserts(size_t entries);
+
+  /**
+	 * Apply the buffered inserts to the tree, waiting for those another thread is applying.
+	**/
+	const void flushInserts();
+
+
+  /**
+	 * Delete the entry <value,rid> from the index.
+	 * Start from root to recursively find the leaf holding the entry and remove it. A node left with fewer than half
+	 * of its slots in use borrows an entry from a sibling under the same parent, or is merged with that sibling when the
+	 * sibling has none to spare. Packed leaves are only merged, and only with a sibling they fit in one leaf with.
+	 * Merges remove an entry from the parent, which may underflow in turn. When the root is left with a single child
+	 * that child becomes the new root. Pages freed by merges are returned to the index file and reused by later splits.
+	 * With counted non-leaves every delete latches its path and recounts the children it changed on the way back up.
+	 * Composite indexes take the normalized key, see encodeKey.
+   * @param key			Key to delete, pointer to integer/double/char string
+   * @param rid			Record ID of the record whose entry is getting deleted from the index.
+	 * @throws  NoSuchKeyFoundException If there is no entry <value,rid> in the B+ tree.
+	**/
+	const void deleteEntry(const void* key, const RecordId rid);
+
+
+  /**
+	 * Begin a filtered scan of the index.  For instance, if the method is called 
+	 * using ("a",GT,"d",LTE) then we should seek all entries with a value 
+	 * greater than "a" and less than or equal to "d". Called using ("a",EQ,"a",EQ)
+	 * it seeks all entries with a value equal to "a".
+	 * Start from root to find out the leaf page that contains the first RecordID that satisfies the scan
+	 * parameters. The returned cursor keeps that page pinned in the buffer pool. Scans already open on the
+	 * index are not affected.
+	 * A DESCENDING scan starts at the high end of the range and follows left sibling links, so the
+	 * largest entries of a range are found without reading the leaves below them.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE/EQ)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE/EQ)
+   * @param order		ASCENDING to return entries in key order, DESCENDING for the reverse
+   * @return  Cursor positioned at the first matching entry
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values, or only one of them is EQ
+   * @throws  BadScanrangeException If lowVal > highval, or lowVal != highVal for EQ
+	 * @throws  NoSuchKeyFoundException If there is no key in the B+ tree that satisfies the scan criteria.
+	**/
+	BTreeCursor startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp,
+						const ScanOrder order = ASCENDING);
+
+  /**
+	 * Begin a filtered scan of the index like startScan, without checking that any entry matches.
+	 * Meant for BTreeCursor::nextBatch, which reports an empty range by returning 0.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE/EQ)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE/EQ)
+   * @param order		ASCENDING to return entries in key order, DESCENDING for the reverse
+   * @return  Cursor positioned before the first matching entry, if any
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values, or only one of them is EQ
+   * @throws  BadScanrangeException If lowVal > highval, or lowVal != highVal for EQ
+	**/
+	BTreeCursor openScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp,
+						const ScanOrder order = ASCENDING);
+
+  /**
+	 * Find all entries with the given key. Descends once, binary searches the leaf and copies the
+	 * matching record ids out, following right siblings only while duplicates of the key continue.
+	 * No cursor is set up and no page stays pinned.
+   * @param key			Key to look up, pointer to integer/double/char string
+   * @param outRids	Record ids of the matching entries are appended to this
+   * @return  Number of matching entries found
+	**/
+	const size_t lookup(const void* key, std::vector<RecordId> &outRids);
+
+  /**
+	 * Find all entries of each of several keys, like calling lookup for each of them in turn. Up to
+	 * LOOKUPGROUP descents are taken a level at a time, prefetching the lines of each node they reach
+	 * for the search in it, so that the cache misses of different keys overlap instead of adding up.
+	 * Keys need not be sorted. Pins up to LOOKUPGROUP pages at a time.
+   * @param keys		Keys to look up, pointer to an array of count integers
+   * @param count		Number of keys
+   * @param outRids	Record ids of the matching entries of every key are appended to this, key after key
+   * @param ends		Array of count positions, ends[i] is set to the size of outRids once the entries of keys[i] are in
+   * @return  Number of matching entries found
+	**/
+	const size_t lookupBatch(const void* keys, size_t count, std::vector<RecordId> &outRids, size_t *ends);
+
+  /**
+	 * Count the entries in a range, taking the same parameters as startScan. With counted non-leaves the
+	 * counts of the children left of the descents to either end of the range are added up, so any range
+	 * costs two descents. Other indexes scan the range with nextBatch. Entries inserted or deleted while
+	 * the count runs may or may not be counted.
+   * @param lowVal	Low value of range, pointer to integer / double / char string
+   * @param lowOp		Low operator (GT/GTE/EQ)
+   * @param highVal	High value of range, pointer to integer / double / char string
+   * @param highOp	High operator (LT/LTE/EQ)
+   * @return  Number of entries in the range
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values, or only one of them is EQ
+   * @throws  BadScanrangeException If lowVal > highval, or lowVal != highVal for EQ
+	**/
+	const size_t countRange(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  /**
+	 * Number of entries with a key less than the given one, which is the position the first entry with
+	 * that key has or would have in key order. One descent with counted non-leaves, a scan otherwise.
+   * @param key			Key to rank, pointer to integer/double/char string
+   * @return  Number of entries with smaller keys
+	**/
+	const size_t rank(const void* key);
+
+  /**
+	 * Find the entry at a position of the index in key order, entries with the same key coming in the
+	 * order they are in the leaves. With counted non-leaves one descent follows the counts down to it,
+	 * other indexes scan up to it.
+   * @param position	Number of entries before the one to find
+   * @param outKey		Key of the entry found, pointer to integer/double/char string
+   * @param outRid		Record id of the entry found
+   * @return  False if the index holds no more than position entries
+	**/
+	const bool select(size_t position, void* outKey, RecordId &outRid);
+
+  /**
+	 * Write every entry of the index in key order to a read-only StaticTree file, whose nodes are all full
+	 * and found by their position instead of pointers. The file can then be opened and queried without
+	 * the buffer manager while this index keeps changing or is dropped.
+   * @param fileName	Name of the file to write, replaced if it exists
+	 * @throws  BadIndexInfoException If the index has a composite key or is an index-organized table.
+	**/
+	const void freeze(const std::string &fileName);
+
+  /**
+	 * Keep the non leaf nodes of the top levels of the tree pinned in the buffer pool. Descents find
+	 * them through a table of their frames instead of asking the buffer manager, which saves a lookup
+	 * in the buffer pool, a pin and an unpin on each of those levels. Nodes split off a pinned level are
+	 * pinned as well, and nodes freed by merges are unpinned. Pinned nodes are written back when they
+	 * are freed or the index is closed. Has to be called while no other thread uses the index.
+   * @param levels	Number of levels to pin counting the root as the first one, 0 to unpin them all.
+   *                Pinning stops early once PINNEDSLOTS / 2 nodes are pinned.
+   * @return  Number of nodes pinned
+	**/
+	const int pinUpperLevels(int levels);
+
+  /**
+	 * Turn swizzling of child references on or off, it starts out on. Descents that find a child in the buffer
+	 * pool through its page number store the frame number of the child in its parent instead, and later descents
+	 * go straight to that frame without looking the page up or pinning it, except for the leaf. The buffer manager
+	 * turns the reference back into the page number before it evicts the child, and keeps the parent until then.
+	 * References that move to another node in splits and merges are turned back first. Turning swizzling off turns
+	 * every reference back and has to be done while no other thread uses the index.
+   * @param enable	True to swizzle child references
+	**/
+	const void swizzleChildren(bool enable);
+
+  /**
+	 * Learn a piecewise linear model of the leaf level in place of the non-leaf levels, for the lookups of
+	 * an index that has been bulk loaded and is only read. The model maps a key to the position of the leaf
+	 * covering it, off by at most maxError leaves, and takes a segment per run of leaves whose first keys
+	 * lie close enough to a line. lookup() then reads the predicted leaf and walks at most maxError + 1
+	 * leaves to the right one by comparing its first and last keys, instead of descending the tree. The first
+	 * insert or delete after it makes the model stale and lookups descend the tree again until the model is
+	 * learned anew. Has to be called while no other thread uses the index.
+   * @param maxError	Most leaves the prediction may be off by
+   * @return  Number of segments of the model
+	 * @throws  BadIndexInfoException If the index has a composite key.
+	**/
+	const size_t learnLeaves(int maxError = LEARNEDERROR);
+
+  /**
+	 * Bytes of memory the learned model takes, its segments and the page numbers of the leaves.
+	**/
+	const size_t learnedSize();
+
+  /**
+	 * Keep a blocked Bloom filter of the keys of the index in memory, so that lookups of keys the index does not
+	 * hold return, and equality scans of them throw, before any page is read. Inserts add their keys to it first.
+	 * Deleted keys stay in it and only cost a descent. The filter is written to the index file name with ".bloom"
+	 * appended when the index is closed and read back when it is opened. A filter file that was not written at
+	 * the last close, or one whose share of set bits shows it holds twice the keys it was sized for, is rebuilt
+	 * from the leaves instead. Has to be called while no other thread uses the index.
+   * @param bitsPerKey	Bits per key, 0 to drop the filter and its file
+   * @param keys				Number of keys to size the filter for, at least the number of entries the index holds
+	 * @throws  BadIndexInfoException If the index has a composite key.
+	**/
+	const void bloomFilter(int bitsPerKey = BLOOMBITSPERKEY, size_t keys = 0);
+
+  /**
+	 * Find the entries of a composite index in a range of normalized keys. Either bound may be a prefix
+	 * of a key, holding its leading attributes only, and is compared with the same number of leading
+	 * bytes of every key: a prefix with EQ matches every key starting with it, with LTE every key up to
+	 * and including those starting with it. Entries are found in the order of their keys, and in no
+	 * particular order among equal keys.
+   * @param lowKey		Low bound, a normalized key or prefix of one, see encodePrefix
+   * @param lowLength	Number of bytes of lowKey
+   * @param lowOp			Low operator (GT/GTE/EQ)
+   * @param highKey		High bound, a normalized key or prefix of one
+   * @param highLength	Number of bytes of highKey
+   * @param highOp		High operator (LT/LTE/EQ)
+   * @param outRids	Record ids of the matching entries are appended to this
+   * @return  Number of matching entries found
+   * @throws  BadIndexInfoException If the index does not have a composite key.
+   * @throws  BadOpcodesException If lowOp and highOp do not contain one of their their expected values, or only one of them is EQ
+   * @throws  BadScanrangeException If a bound is longer than a key, the low bound is above the high one, or they differ for EQ
+	**/
+	const size_t lookupKeys(const void* lowKey, int lowLength, const Operator lowOp,
+						const void* highKey, int highLength, const Operator highOp, std::vector<RecordId> &outRids);
+
+  /**
+	 * Normalize the key attributes of a record into the key a composite index keeps for it.
+   * @param record	The record, attributes are taken from their offsets in it
+   * @param outKey	Receives the normalized key, keySize bytes
+	**/
+	const void encodeKey(const char* record, char* outKey);
+
+  /**
+	 * Normalize values of the leading attributes of a composite key into a prefix of keys, to bound lookupKeys with.
+   * @param values	Pointers to the values of the first count attributes, in key order
+   * @param count		Number of attributes to normalize, up to all of them for a whole key
+   * @param outKey	Receives the normalized prefix
+   * @return  Number of bytes of the prefix
+	**/
+	const int encodePrefix(const void* const* values, int count, char* outKey);
+
+  /**
+	 * Number of bytes of a normalized key of a composite index, 0 for an index on a single attribute.
+	**/
+	const int keySize();
+
+  /**
+	 * Number of levels of the tree, 1 while the root is a leaf.
+	**/
+	const int height();
+
+  /**
+	 * Number of bytes of included attributes, normalized key or record each entry carries, the room a scan needs
+	 * for them. 0 unless the index is covering, composite or an index-organized table.
+	**/
+	const int payloadSize();
+
+  /**
+	 * Most entries a plain leaf of the index holds, INTARRAYLEAFSIZE less the room taken by included attributes.
+	**/
+	const int leafCapacity();
 	
 	// find next level of page for key placement
 	const void nextNonleaf(NonLeafNodeInt *currentPage, PageId &nextNodenum, int check);
-	// create new root node when split
-	const void update(PageId firstPageInRoot, PageKeyPair<int> *newChild);
-	// recursively place index entry to file
-	const void insert(Page *currentPage, PageId currentPageNum, bool node_leaf, const RIDKeyPair<int> dataEntry, PageKeyPair<int> *&newChild);
-	// split leafnode when full
-	const void leafSplit(LeafNodeInt *leaf, PageId leafPageNum, PageKeyPair<int> *&newChild, const RIDKeyPair<int> dataEntry);
-	// insert entry to leaf
-	const void leafInsertion(LeafNodeInt *leaf, RIDKeyPair<int> entry);
-	// recursively insert index to file
-	const void nonleafSplit(NonLeafNodeInt *p_node, PageId p_pageNum, PageKeyPair<int> *&newChild);
-	// place entry to non leaf node
-	const void nonleafInsertion(NonLeafNodeInt *nonleaf, PageKeyPair<int> *entry);
+	// index of the child of a non leaf node to descend into for key
+	const int childIndex(NonLeafNodeInt *currentNode, int check);
+	// index of the child of a non leaf of a composite index to descend into for the first length bytes of a
+	// normalized key, after skips the children right of separators starting with them
+	const int keyChildIndex(NonLeafNodeInt *currentNode, const char *key, int length, bool after);
+	// index of the child to follow for check in a blocked non leaf, reading its directory
+	const int blockedChildIndex(NonLeafNodeInt *currentNode, int check);
+	// rebuild the directory of a latched blocked non leaf after its keys changed, nothing for plain ones
+	const void blockNonleaf(NonLeafNodeInt *node);
+	// create new root node when split, caller holds rootLatch. separator is the whole key of newChild in a composite index
+	const void update(PageId firstPageInRoot, PageKeyPair<int> *newChild, const char *separator);
+	// one optimistic attempt to place index entry to file with its included attributes, false if it has to be retried
+	const bool insert(const RIDKeyPair<int> dataEntry, const char *payload);
+	// append entry to the cached rightmost leaf if it goes after all its keys and fits, false otherwise
+	const bool appendRightmost(const RIDKeyPair<int> dataEntry, const char *payload);
+	// remember the latched leaf as the rightmost one, with the first key it holds
+	const void cacheRightmost(PageId leafPageNum, int lowKey);
+	// merge the leading entries of a sorted batch into their leaf and on into its right siblings, returns how many were
+	const size_t insertRun(const RIDKeyPair<int> *entries, size_t count);
+	// merge the leading sorted entries into the latched leaf while it has room and no posting list is involved
+	const size_t leafInsertRun(LeafNodeInt *leaf, const RIDKeyPair<int> *entries, size_t count);
+	// merge as many of the leading sorted entries into the latched packed leaf as its fields fit
+	const size_t packedInsertRun(PackedLeafInt *leaf, const RIDKeyPair<int> *entries, size_t count);
+	// unpin the pages held by an abandoned insert attempt, unless they are pinned nodes
+	const void releasePath(PageId currentPageNum, bool held, Page *parentPage, PageId parentPageNum, bool parentHeld);
+	// get the frame of a non leaf node, pinning it unless the index keeps it pinned, held is set if it was pinned
+	const void readNode(PageId pageNum, Page *&page, bool &held);
+	// unpin a node read with readNode if it was pinned for the read, pinned nodes are written back when unpinned
+	const void releaseNode(PageId pageNum, bool held, bool dirty);
+	// frame of the node if the index keeps it pinned
+	const bool pinnedPage(PageId pageNum, Page *&page);
+	// pin the node and add it to the table, false if the table is full
+	const bool pinNode(PageId pageNum, Page *&page);
+	// drop the node from the table and unpin it, if it is there
+	const void unpinNode(PageId pageNum);
+	// unpin every pinned node, writing them back
+	const void unpinNodes();
+	// page number of the child at index of the non leaf node, which may be swizzled
+	const PageId childPageNo(NonLeafNodeInt *node, int index);
+	// turn a swizzled child reference of the latched non leaf node back into a page number
+	const void unswizzleChild(NonLeafNodeInt *node, int index);
+	// called by the buffer manager to turn the reference to the child in a frame about to be evicted back into its page number
+	bool unswizzle(Page *parent, FrameId child, PageId pageNo);
+	// split latched leafnode when full and insert entry, newChild is set to the new leaf. separator is the one
+	// leafSplitSeparator gives in a composite index. the rightmost leaf is kept full when the entry goes after all its keys
+	const void leafSplit(LeafNodeInt *leaf, PageId leafPageNum, PageKeyPair<int> &newChild, const char *separator, const RIDKeyPair<int> dataEntry, const char *payload);
+	// insert entry with its included attributes to leaf
+	const void leafInsertion(LeafNodeInt *leaf, RIDKeyPair<int> entry, const char *payload);
+	// split latched full non leaf node in half, newChild is set to the new node and the key pushed up, separator to
+	// its whole key in a composite index. on append only the last child moves to the new node. compressed nodes
+	// may be split before all their slots are taken
+	const void nonleafSplit(NonLeafNodeInt *p_node, PageKeyPair<int> &newChild, char *separator, bool append);
+	// place entry to non leaf node right after the child at index, with the whole key separator in a composite index
+	const void nonleafInsertion(NonLeafNodeInt *nonleaf, PageKeyPair<int> *entry, const char *separator, int index);
 	// check valditiy of key
 	const bool checkKey(int lowVal, const Operator lowOp, int highVal, const Operator highOp, int check);
+	// optimistically descend to the leaf for key, which is returned pinned with its version.
+	// upper, if given, is set to the largest key that belongs in the leaf. after descends to the
+	// last leaf that can hold key instead, which duplicates of key may reach past separators equal to it
+	const void findLeaf(int key, PageId &leafPageNum, Page *&leafPage, std::uint64_t &version, bool &root_leaf, int *upper = nullptr, bool after = false);
+	// findLeaf for the first length bytes of a normalized key of a composite index, descending by the whole keys of the separators
+	const void findKeyLeaf(const char *key, int length, bool after, PageId &leafPageNum, Page *&leafPage, std::uint64_t &version, bool &root_leaf);
+	// start a descent at the root, false if it has to be started again
+	const bool descendRoot(Descent &descent);
+	// take a descent from its non leaf to the child for key, false with nothing left pinned if it has to be started again
+	const bool descendChild(int key, Descent &descent, bool after = false);
+	// take a descent from its non leaf to the child at childPos, false with nothing left pinned if it has to be started again
+	const bool descendTo(int childPos, Descent &descent);
+	// index of the child a descent for key takes, after skips the children right of separators equal to key
+	const int childPosition(NonLeafNodeInt *currentNode, int key, bool after);
+	// number of entries with keys less than key, or not greater with inclusive, added up along one descent
+	const size_t countBelow(int key, bool inclusive);
+	// counts of the children of a counted non leaf, in the slots of keyArray past its keys
+	int *childCounts(NonLeafNodeInt *node);
+	// set the count of the child at index of the latched counted non leaf to the number of entries below it
+	const void recountChild(NonLeafNodeInt *node, int index);
+	// recount the children on the path to key bottom up, after an insert placed an entry at its end.
+	// wholeKey is the normalized key in a composite index
+	const void recountPath(int key, const char *wholeKey);
+	// prefetch the lines of a node that the search in it reads first
+	const void prefetchNode(const Page *page, bool leaf);
+	// prefetch the child for key of the non leaf of a descent if it is known by its frame, and its frame descriptor
+	const void prefetchChild(int key, const Descent &descent);
+	// copy the entries of key from the pinned leaf onwards, unpinning it. false with outRids as it was if the leaf changed.
+	// start is the position of the first entry not below key in the leaf, or -1 to search for it
+	const bool leafLookup(int key, PageId leafPageNum, Page *leafPage, std::uint64_t version, int start, std::vector<RecordId> &outRids);
+	// look key up through the learned model, false with outRids as it was if the model is stale or the leaves changed meanwhile
+	const bool learnedLookup(int key, std::vector<RecordId> &outRids);
+	// fit the segments of the learned model to the first keys of the leaves, within learnedError leaves of each
+	const void learnSegments(const std::vector<int> &lowKeys);
+	// replace the Bloom filter with one of the keys in the leaves, sized for at least the given number of keys
+	const void buildBloom(int bitsPerKey, size_t keys);
+	// read the Bloom filter written at the last close, or build it again if that one is gone or full
+	const void openBloom(int bitsPerKey, std::uint64_t stamp);
+	// binary search the pinned plain leaves of the descents that started for their keys together, a probe of every
+	// leaf at a time with the next one prefetched, so the misses of one search overlap those of the others
+	const void leafLowerBounds(const int *keys, const Descent *descents, const bool *started, size_t count, int *positions);
+	// recursively remove index entry from the latched node, remaining is set to the number of keys left in the node.
+	// key is the normalized key in a composite index
+	const bool remove(Page *currentPage, PageId currentPageNum, bool node_leaf, const RIDKeyPair<int> dataEntry, const char *key, int &remaining);
+	// remove entry from leaf
+	const bool leafRemoval(LeafNodeInt *leaf, const RIDKeyPair<int> entry);
+	// borrow from or merge with a sibling when a leaf child underflows
+	const void leafRebalance(NonLeafNodeInt *parent, int index);
+	// append the entries of right to left
+	const void leafMerge(LeafNodeInt *left, int leftSize, LeafNodeInt *right, int rightSize);
+	// borrow from or merge with a sibling when a non leaf child underflows
+	const void nonleafRebalance(NonLeafNodeInt *parent, int index);
+	// append separator and the entries of right to left, the caller stores the separators of a composite index
+	const void nonleafMerge(NonLeafNodeInt *left, int leftSize, int separator, NonLeafNodeInt *right, int rightSize);
+	// remove key and right page pointer at index from non leaf node
+	const void nonleafRemoval(NonLeafNodeInt *nonleaf, int index);
+	// replace root with its only child
+	const void collapseRoot();
+	// pin page and latch it exclusively
+	const void latchPage(PageId pageNum, Page *&page);
+	// release latch and unpin page
+	const void unlatchPage(PageId pageNum, Page *page, bool dirty);
+	// mark latched page obsolete and give it back to the file
+	const void freeLatchedPage(PageId pageNum, Page *page);
+	// move the run of count entries with one key starting at start into a new posting list holding rid as well
+	const void postingCreate(LeafNodeInt *leaf, int start, int count, const RecordId rid);
+	// add rid to the posting list starting at headPageNum, caller holds the leaf pointing to it
+	const void postingInsert(PageId headPageNum, const RecordId rid);
+	// remove rid from the posting list starting at headPageNum, empty is set if that freed the list
+	const bool postingRemove(PageId headPageNum, const RecordId rid, bool &empty);
+	// append the RecordIds of the posting list to outRids, false if it changed while read
+	const bool postingRead(PageId headPageNum, Page *leafPage, std::uint64_t leafVersion, std::vector<RecordId> &outRids);
+	// encode sorted rids into the latched posting page, linking in new pages for those that do not fit
+	const void postingStore(PostingPageInt *posting, const RecordId *rids, int count);
+	// append sorted rids, none before the last one on the page, to a posting page, false if they do not fit
+	const bool postingAppend(PostingPageInt *posting, const RecordId *rids, int count);
+	// decode the RecordIds of a posting page, which may be changing, returns how many were decoded
+	const int postingDecode(PostingPageInt *posting, RecordId *rids);
+	// true if the entry fits the fields of the packed leaf as they are
+	const bool packedWithin(PackedLeafInt *leaf, const RIDKeyPair<int> entry);
+	// true if the entry can go into the packed leaf without splitting it, which may be changing
+	const bool packedRoom(PackedLeafInt *leaf, const RIDKeyPair<int> entry);
+	// insert entry to latched packed leaf, which has room for it
+	const void packedInsert(PackedLeafInt *leaf, const RIDKeyPair<int> entry);
+	// move the upper half of the entries of the latched packed leaf to a new leaf, newChild is set to it.
+	// the new leaf starts empty when entry goes after all keys of the rightmost leaf
+	const void packedSplit(PackedLeafInt *leaf, PageId leafPageNum, PageKeyPair<int> &newChild, const RIDKeyPair<int> entry);
+	// remove entry from packed leaf
+	const bool packedRemoval(PackedLeafInt *leaf, const RIDKeyPair<int> entry);
+	// merge a packed leaf child with fewer entries than half its capacity into a sibling, if they fit in one leaf
+	const void packedRebalance(NonLeafNodeInt *parent, int index);
+	// pack sorted entries into the packed leaf with the narrowest fields, false and unchanged if they do not fit
+	const bool packedEncode(PackedLeafInt *leaf, const int *keys, const RecordId *rids, int count);
+	// unpack the entries from up to to of the packed leaf, which may be changing, keys may be null
+	const void packedDecode(PackedLeafInt *leaf, int from, int to, int *keys, RecordId *rids);
+	// unpack values from up to to of one field of the packed leaf, four at a time
+	const void packedUnpack(PackedLeafInt *leaf, int field, int from, int to, std::uint32_t *out);
+	// store values from up to to of one field of the latched packed leaf
+	const void packedPack(PackedLeafInt *leaf, int field, int from, int to, const std::uint32_t *values);
+	// value at index of the field of the packed leaf starting at word start
+	const std::uint32_t packedGet(PackedLeafInt *leaf, int start, int bits, int index);
+	// first word and width of one field of the packed leaf
+	const void packedField(PackedLeafInt *leaf, int field, int &start, int &bits);
+	// entries the fields have room for with the given widths of key, page and slot number
+	const int packedCapacity(const int *bits);
+	// number of entries in leaf of either format
+	const int leafCount(Page *leaf);
+	// key of the entry at index of leaf of either format
+	const int leafKey(Page *leaf, int index);
+	// read the entry at index of leaf of either format, false past its last entry
+	const bool leafEntry(Page *leaf, int index, int &key, RecordId &rid);
+	// right sibling of leaf of either format
+	const PageId leafSibling(Page *leaf);
+	// left sibling of leaf of either format
+	const PageId leafLeftSibling(Page *leaf);
+	// set the left sibling of latched leaf of either format
+	const void setLeftSibling(Page *leaf, PageId leftPageNum);
+	// latch the leaf at pageNum, if any, and set its left sibling
+	const void relinkLeft(PageId pageNum, PageId leftPageNum);
+	// index of the first entry of leaf of either format with a key not less than key
+	const int leafLowerBound(Page *leaf, int key);
+	// index of the first entry of leaf of either format with a key greater than key
+	const int leafUpperBound(Page *leaf, int key);
+	// included attributes of the entry at index of a plain leaf of a covering index
+	char *leafPayload(LeafNodeInt *leaf, int index);
+	// copy the included attributes of count entries of plain leaves, the ranges may overlap
+	const void movePayloads(LeafNodeInt *to, int toIndex, LeafNodeInt *from, int fromIndex, int count);
+	// copy the included attributes of a record into payload
+	const void gatherPayload(const char *record, char *payload);
+	// key of the tree for a normalized key or prefix of length bytes, missing bytes taken as fill
+	const int keyPrefix(const char *key, int length, unsigned char fill);
+	// compare the entry at index of a plain leaf with an entry to insert, by the whole normalized key in a composite index
+	const int compareEntry(LeafNodeInt *leaf, int index, int key, const char *payload);
+	// whole normalized key of the separator at index of a non leaf of a composite index, in the slots past its children
+	char *separatorKey(NonLeafNodeInt *node, int index);
+	// number of separators, prefix length and separator ends of a compressed non leaf, in the slots of keyArray past its keys
+	std::uint16_t *compressedHeader(NonLeafNodeInt *node);
+	// prefix and separator suffixes of a compressed non leaf, in the slots of pageNoArray past its children
+	char *compressedHeap(NonLeafNodeInt *node);
+	// copy the whole keys of the first count separators of a non leaf of a composite index into keys
+	const void loadSeparators(NonLeafNodeInt *node, int count, std::vector<char> &keys);
+	// make keys the separators of the latched non leaf of a composite index and set its int keys from them,
+	// false with the node unchanged if they do not fit
+	const bool storeSeparators(NonLeafNodeInt *node, const std::vector<char> &keys);
+	// true if the whole keys fit into a non leaf as its separators
+	const bool separatorsFit(const std::vector<char> &keys);
+	// number of leading bytes all of the whole keys of separators in order share
+	const int sharedPrefix(const std::vector<char> &keys);
+	// length of a separator without the zero bytes it ends in
+	const int separatorLength(const char *key);
+	// compare the separator at index of a non leaf of a composite index with the first length bytes of a normalized key
+	const int compareSeparator(NonLeafNodeInt *node, int index, const char *key, int length);
+	// compareSeparator for a compressed non leaf, once key is known to start with its prefix
+	const int compareSuffix(NonLeafNodeInt *node, int index, const char *key, int length);
+	// shortest key above left and not above right, padded with zero bytes to a whole key
+	const void shortSeparator(const char *left, const char *right, char *separator);
+	// index of the first entry of the full latched leaf a split moves to the new leaf
+	const int leafSplitPoint(LeafNodeInt *leaf, const RIDKeyPair<int> dataEntry, const char *payload);
+	// separator of a composite index that a split of the full latched leaf to insert the entry would push up
+	const void leafSplitSeparator(LeafNodeInt *leaf, const RIDKeyPair<int> dataEntry, const char *payload, char *separator);
+	// true if an insert has to split the non leaf on its way down
+	const bool nonleafFull(NonLeafNodeInt *node, PageId pageNum);
+	// true if the latched non leaf with size separators is too empty to stay without borrowing or merging
+	const bool nonleafUnderflow(NonLeafNodeInt *node, int size);
+	// index of the separator a split of the latched non leaf pushes up
+	const int nonleafSplitPoint(NonLeafNodeInt *node, bool append);
+	// true if the separator of a split fits into the latched parent at index, otherwise the parent is marked crowded
+	const bool separatorRoom(NonLeafNodeInt *parent, PageId parentPageNum, int index, const char *separator);
+	// replace the separator at index of the whole keys by the shortest one between left and right,
+	// false with them unchanged if they would not fit
+	const bool replaceSeparator(std::vector<char> &keys, int index, const char *left, const char *right);
+	// rotate the last (fromLeft) or first separator of the sibling through the one at index of the parent into
+	// the child, false with the keys unchanged if they would not fit
+	const bool rotateSeparators(std::vector<char> &parentKeys, int index, std::vector<char> &siblingKeys, std::vector<char> &childKeys, bool fromLeft);
+	// append the separator at index of the parent and the right keys to the left keys, false with them unchanged if they would not fit
+	const bool mergeSeparators(std::vector<char> &leftKeys, const std::vector<char> &parentKeys, int index, const std::vector<char> &rightKeys);
+	// number of keys in leaf
+	const int leafSize(LeafNodeInt *leaf);
+	// number of keys in non leaf
+	const int nonleafSize(NonLeafNodeInt *nonleaf);
 	
 };
 
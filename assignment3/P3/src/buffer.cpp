@@ -6,6 +6,8 @@
  */
 
 #include <memory>
+#include <new>
+#include <cstdint>
 #include <iostream>
 #include "buffer.h"
 #include "exceptions/buffer_exceeded_exception.h"
@@ -30,12 +32,19 @@ BufMgr::BufMgr(std::uint32_t bufs)
   	bufDescTable[i].valid = false;
   }
 
-  bufPool = new Page[bufs];
+  // align frames to cache lines, node layouts place their keys by them
+  poolMemory = new char[bufs * sizeof(Page) + 64];
+  bufPool = (Page *)(((std::uintptr_t)poolMemory + 63) & ~(std::uintptr_t)63);
+  for (FrameId i = 0; i < bufs; i++)
+  {
+  	new (&bufPool[i]) Page();
+  }
 
   int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
   hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
 
   clockHand = bufs - 1;
+  swizzledFrames = 0;
 }
 
 
@@ -51,7 +60,7 @@ BufMgr::~BufMgr() {
   }
 
   delete [] bufDescTable;
-  delete [] bufPool;
+  delete [] poolMemory;
 }
 
 void BufMgr::allocBuf(FrameId & frame) 
@@ -80,6 +89,13 @@ void BufMgr::allocBuf(FrameId & frame)
       // check to see if someone has it pinned
       if (bufDescTable[clockHand].pinCnt == 0)
       {
+        // pages referred to by frame number wait for the pages they refer to, and for the reference to be undone
+        if (bufDescTable[clockHand].swizzledChildren > 0
+          || (bufDescTable[clockHand].swizzled && !evictSwizzled(clockHand)))
+        {
+          continue;
+        }
+
         // hasn't been referenced and is not pinned, use it
         // remove previous entry from hash table
         hashTable->remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
@@ -116,9 +132,46 @@ void BufMgr::allocBuf(FrameId & frame)
   frame = clockHand;
 } // end allocBuf
 
+
+bool BufMgr::evictSwizzled(FrameId frame)
+{
+  BufDesc* tmpbuf = &bufDescTable[frame];
+
+  // readers following the reference use the page without pinning it; keep writers out of it
+  // until Set() publishes a new version for the next page
+  std::uint64_t version;
+  if (!tmpbuf->latch.readLock(version) || !tmpbuf->latch.upgrade(version))
+  {
+    return false;
+  }
+  if (!tmpbuf->swizzler->unswizzle(&bufPool[tmpbuf->swizzleParent], frame, tmpbuf->pageNo))
+  {
+    tmpbuf->latch.unlock();
+    return false;
+  }
+  dropSwizzle(frame);
+  return true;
+}
+
+
+void BufMgr::dropSwizzle(FrameId frame)
+{
+  BufDesc* tmpbuf = &bufDescTable[frame];
+  if (tmpbuf->swizzled)
+  {
+    bufDescTable[tmpbuf->swizzleParent].swizzledChildren--;
+    swizzledFrames--;
+    tmpbuf->swizzled = false;
+    tmpbuf->swizzler = NULL;
+  }
+}
+
+
 	
 void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   // check to see if it is already in the buffer pool
   // std::cout << "readPage called on file.page " << file << "." << pageNo << endl;
   FrameId frameNo = 0;
@@ -154,6 +207,8 @@ void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
 void BufMgr::unPinPage(File* file, const PageId pageNo, 
 			     const bool dirty) 
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   // lookup in hashtable
   FrameId frameNo = 0;
   hashTable->lookup(file, pageNo, frameNo);
@@ -166,10 +221,24 @@ void BufMgr::unPinPage(File* file, const PageId pageNo,
   	throw PageNotPinnedException(file->filename(), pageNo, frameNo);
   }
   else bufDescTable[frameNo].pinCnt--;
+
+  // finish a dispose that was waiting for this pin
+  if (bufDescTable[frameNo].pinCnt == 0 && bufDescTable[frameNo].disposed)
+  {
+		dropSwizzle(frameNo);
+		bufDescTable[frameNo].Clear();
+		hashTable->remove(file, pageNo);
+		file->deletePage(pageNo);
+  }
 }
 
 void BufMgr::flushFile(const File* file) 
 {
+  // pages go to disk with page numbers only
+  unswizzleFile(file);
+
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   for (std::uint32_t i = 0; i < numBufs; i++)
 	{
   	BufDesc* tmpbuf = &(bufDescTable[i]);
@@ -186,6 +255,7 @@ void BufMgr::flushFile(const File* file)
     	}
 
     	hashTable->remove(file,tmpbuf->pageNo);
+    	dropSwizzle(i);
     	tmpbuf->Clear();
   	}
 		else if (tmpbuf->valid == false && tmpbuf->file == file)
@@ -195,15 +265,31 @@ void BufMgr::flushFile(const File* file)
 
 void BufMgr::disposePage(File* file, const PageId pageNo) 
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
 	//Deallocate from file altogether
   //See if it is in the buffer pool
   FrameId frameNo = 0;
-  hashTable->lookup(file, pageNo, frameNo);
+	try
+	{
+  	hashTable->lookup(file, pageNo, frameNo);
 
-	// clear the page
-	bufDescTable[frameNo].Clear();
+		// somebody still reads the page, leave it to the last unPinPage
+		if (bufDescTable[frameNo].pinCnt > 0)
+		{
+			bufDescTable[frameNo].disposed = true;
+			return;
+		}
+
+		// clear the page
+		dropSwizzle(frameNo);
+		bufDescTable[frameNo].Clear();
 
-	hashTable->remove(file, pageNo);
+		hashTable->remove(file, pageNo);
+	}
+	catch(HashNotFoundException e) //not in the buffer pool, nothing to evict
+	{
+	}
 
   // deallocate it in the file	
   file->deletePage(pageNo);
@@ -212,6 +298,8 @@ void BufMgr::disposePage(File* file, const PageId pageNo)
 
 void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) 
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   FrameId frameNo;
 
   // alloc a new frame
@@ -229,8 +317,65 @@ void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page)
   hashTable->insert(file, pageNo, frameNo);
 }
 
+bool BufMgr::pinFrame(File* file, FrameId frame, PageId &pageNo)
+{
+  std::lock_guard<std::mutex> guard(bufMutex);
+
+  BufDesc* tmpbuf = &bufDescTable[frame];
+  if (tmpbuf->valid == false || tmpbuf->file != file || tmpbuf->disposed)
+  {
+    return false;
+  }
+  tmpbuf->refbit = true;
+  tmpbuf->pinCnt++;
+  pageNo = tmpbuf->pageNo;
+  return true;
+}
+
+bool BufMgr::swizzle(FrameId parent, FrameId child, Swizzler *swizzler)
+{
+  std::lock_guard<std::mutex> guard(bufMutex);
+
+  BufDesc* tmpbuf = &bufDescTable[child];
+  if (tmpbuf->swizzled || swizzledFrames >= numBufs / 2)
+  {
+    return false;
+  }
+  swizzledFrames++;
+  tmpbuf->swizzled = true;
+  tmpbuf->swizzleParent = parent;
+  tmpbuf->swizzler = swizzler;
+  bufDescTable[parent].swizzledChildren++;
+  return true;
+}
+
+PageId BufMgr::unswizzle(FrameId frame)
+{
+  std::lock_guard<std::mutex> guard(bufMutex);
+
+  dropSwizzle(frame);
+  return bufDescTable[frame].pageNo;
+}
+
+void BufMgr::unswizzleFile(const File* file)
+{
+  std::lock_guard<std::mutex> guard(bufMutex);
+
+  for (std::uint32_t i = 0; i < numBufs; i++)
+	{
+  	BufDesc* tmpbuf = &(bufDescTable[i]);
+  	if (tmpbuf->valid == true && tmpbuf->file == file && tmpbuf->swizzled
+  		&& tmpbuf->swizzler->unswizzle(&bufPool[tmpbuf->swizzleParent], i, tmpbuf->pageNo))
+		{
+			dropSwizzle(i);
+  	}
+  }
+}
+
 void BufMgr::printSelf(void) 
 {
+  std::lock_guard<std::mutex> guard(bufMutex);
+
   BufDesc* tmpbuf;
 	int validFrames = 0;
   
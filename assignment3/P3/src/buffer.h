@@ -9,7 +9,10 @@
 
 #include "file.h"
 #include "bufHashTbl.h"
+#include "latch.h"
 #include <iostream>
+#include <mutex>
+#include <atomic>
 
 namespace badgerdb {
 
@@ -18,6 +21,26 @@ namespace badgerdb {
 */
 class BufMgr;
 
+/**
+* @brief Interface of the owners of pages that refer to other pages by their frame number rather than their
+* page number, called back by the buffer manager before it evicts a page referred to that way.
+*/
+class Swizzler {
+ public:
+  virtual ~Swizzler() {}
+
+	/**
+	 * Turns the reference to the page in frame child held by the page in frame parent back into its page number.
+	 * Called with the buffer pool locked, so it must not wait for anything.
+	 *
+	 * @param parent  Page holding the reference
+	 * @param child   Frame the reference names
+	 * @param pageNo  Page number of the page in that frame
+	 * @return  False if the parent cannot be changed right now, in which case the page is not evicted
+	 */
+  virtual bool unswizzle(Page *parent, FrameId child, PageId pageNo) = 0;
+};
+
 /**
 * @brief Class for maintaining information about buffer pool frames
 */
@@ -61,6 +84,37 @@ class BufDesc {
 	 */
   bool refbit;
 
+	/**
+   * True if the page was disposed while pinned; it is dropped when the last pin is released
+	 */
+  bool disposed;
+
+	/**
+   * Latch protecting the contents of the frame for optimistic readers. It survives
+   * Clear() so that versions of a frame never repeat.
+	 */
+  OptLatch latch;
+
+	/**
+   * True if the page is referred to by its frame number from the page in frame swizzleParent
+	 */
+  bool swizzled;
+
+	/**
+   * Frame of the page referring to this one by its frame number, if swizzled
+	 */
+  FrameId swizzleParent;
+
+	/**
+   * Owner of the reference, which turns it back into a page number before the page is evicted
+	 */
+  Swizzler *swizzler;
+
+	/**
+   * Number of pages this page refers to by their frame numbers. It is not evicted before them
+	 */
+  int swizzledChildren;
+
 	/**
    * Initialize buffer frame for a new user
 	 */
@@ -72,6 +126,11 @@ class BufDesc {
     dirty = false;
     refbit = false;
 		valid = false;
+		disposed = false;
+		swizzled = false;
+		swizzleParent = 0;
+		swizzler = NULL;
+		swizzledChildren = 0;
   };
 
 	/**
@@ -89,6 +148,8 @@ class BufDesc {
     dirty = false;
     valid = true;
     refbit = true;
+    disposed = false;
+    latch.reset();
   }
 
   void Print()
@@ -187,6 +248,17 @@ class BufMgr
   BufStats bufStats;
 
 	/**
+   * Serializes access to the frame table, hash table and clock, so the buffer manager can be shared by threads
+	 */
+  std::mutex bufMutex;
+
+	/**
+   * Number of frames holding pages referred to by their frame number. Kept to half of the frames, so whoever
+   * holds the pages with the references latched can still have pages evicted. Changed under bufMutex
+	 */
+  std::atomic<std::uint32_t> swizzledFrames;
+
+	/**
 	 * Allocate a free frame.  
 	 *
 	 * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
@@ -202,6 +274,27 @@ class BufMgr
 		clockHand = (clockHand + 1) % numBufs;
   }
 
+	/**
+	 * Have the owner of the reference to the page in the frame turn it back into a page number, so the page
+	 * can be evicted. The frame is left latched until it is set up for its next page.
+	 *
+	 * @param frame   	Frame of a swizzled page
+	 * @return  False if the reference could not be changed, the page has to stay
+	 */
+  bool evictSwizzled(FrameId frame);
+
+	/**
+	 * Forget that the page in the frame is referred to by its frame number.
+	 *
+	 * @param frame   	Frame of a swizzled page
+	 */
+  void dropSwizzle(FrameId frame);
+
+	/**
+	 * Memory the buffer pool is carved out of, so that frames start on a cache line.
+	 */
+  char* poolMemory;
+
 
  public:
 	/**
@@ -251,7 +344,7 @@ class BufMgr
   void allocPage(File* file, PageId &PageNo, Page*& page); 
 
 	/**
-	 * Writes out all dirty pages of the file to disk.
+	 * Writes out all dirty pages of the file to disk, after turning references by frame number in them back into page numbers.
 	 * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
 	 * Otherwise Error returned.
 	 *
@@ -264,6 +357,7 @@ class BufMgr
 	/**
 	 * Delete page from file and also from buffer pool if present.
 	 * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
+	 * If other threads still have the page pinned, it is deleted when the last of them unpins it.
 	 *
 	 * @param file   	File object
 	 * @param PageNo  Page number
@@ -276,6 +370,107 @@ class BufMgr
   void  printSelf();
 
 	/**
+	 * Returns the latch of the frame holding the page. Only valid while the page is pinned.
+	 *
+	 * @param page  	Page pointer returned by readPage() or allocPage()
+	 */
+  OptLatch & latch(const Page* page)
+  {
+		return bufDescTable[page - bufPool].latch;
+  }
+
+	/**
+	 * Returns the frame holding the page.
+	 *
+	 * @param page  	Page pointer returned by readPage() or allocPage()
+	 */
+  FrameId frameOf(const Page* page)
+  {
+		return page - bufPool;
+  }
+
+	/**
+	 * Returns the page in the frame, without pinning it. Whatever is read from it has to be validated
+	 * against its latch, the frame may be given to another page at any time.
+	 *
+	 * @param frame   	Frame number
+	 */
+  Page* framePage(FrameId frame)
+  {
+		return &bufPool[frame];
+  }
+
+	/**
+	 * Returns the page number of the page in the frame, without locking the buffer pool. Only stable
+	 * while the page cannot be evicted.
+	 *
+	 * @param frame   	Frame number
+	 */
+  PageId framePageNo(FrameId frame)
+  {
+		return bufDescTable[frame].pageNo;
+  }
+
+	/**
+	 * Starts moving the descriptor of the frame, which holds its latch, into the processor caches
+	 * ahead of pinning or latching the page in it.
+	 *
+	 * @param frame   	Frame number
+	 */
+  void prefetchFrame(FrameId frame)
+  {
+  	__builtin_prefetch(&bufDescTable[frame]);
+  }
+
+	/**
+	 * Pins the page in the frame if it belongs to the file, without looking it up by its page number.
+	 *
+	 * @param file   	File object
+	 * @param frame   Frame number
+	 * @param pageNo  Set to the page number of the pinned page, which is unpinned with unPinPage()
+	 * @return  False if the frame holds no page of the file
+	 */
+  bool pinFrame(File* file, FrameId frame, PageId &pageNo);
+
+	/**
+	 * Records that the page in frame parent refers to the page in frame child by its frame number. The child
+	 * is not evicted before swizzler turned the reference back into a page number, and the parent is not
+	 * evicted before its swizzled children. Both pages have to be pinned or latched by the caller.
+	 *
+	 * @param parent  Frame of the page holding the reference
+	 * @param child   Frame of the page it refers to
+	 * @param swizzler  Owner of the reference
+	 * @return  False if the child is already referred to by its frame number, or half of the frames are
+	 */
+  bool swizzle(FrameId parent, FrameId child, Swizzler *swizzler);
+
+	/**
+	 * Tells whether swizzle() has room for another frame, so callers can skip latching a parent for a
+	 * reference that would not be swizzled anyway. The answer may be stale by the time swizzle() is called.
+	 */
+  bool swizzleRoom() const
+  {
+  	return swizzledFrames.load(std::memory_order_relaxed) < numBufs / 2;
+  }
+
+	/**
+	 * Forgets the reference by frame number to the page in the frame, which the caller turns back into
+	 * a page number while holding the page with the reference latched.
+	 *
+	 * @param frame   	Frame of a swizzled page
+	 * @return  Page number of the page in the frame
+	 */
+  PageId unswizzle(FrameId frame);
+
+	/**
+	 * Turns every reference by frame number to a page of the file back into a page number. Nobody else
+	 * may be using the pages of the file.
+	 *
+	 * @param file   	File object
+	 */
+  void unswizzleFile(const File* file);
+
+	/**
    * Get buffer pool usage statistics
 	 */
   BufStats & getBufStats()
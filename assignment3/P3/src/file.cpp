@@ -212,8 +212,10 @@ Page PageFile::allocatePage(PageId &new_page_number) {
 		else
 		{
       // If we have pages allocated, we need to add the new page to the tail
-      // of the linked list.
-      for (FileIterator iter = begin(); iter != end(); ++iter) {
+      // of the linked list. The list is in page number order, so the last
+      // page of the file is the tail whenever it is in use.
+      existing_page = readPage(header.num_pages - 1, true /* allow_free */);
+      for (FileIterator iter = begin(); !existing_page.isUsed() && iter != end(); ++iter) {
         if ((*iter).next_page_number() == Page::INVALID_NUMBER) {
           existing_page = *iter;
           break;
@@ -365,6 +367,20 @@ Page BlobFile::allocatePage(PageId &new_page_number) {
   FileHeader header = readHeader();
 	Page new_page;
 
+	if (header.num_free_pages > 0) {
+		// Reuse the page at the head of the free list; its first bytes hold the
+		// number of the next free page.
+		new_page_number = header.first_free_page;
+		Page free_page = readPage(new_page_number);
+		header.first_free_page = *reinterpret_cast<const PageId*>(&free_page);
+		--header.num_free_pages;
+
+		writePage(new_page_number, new_page);
+		writeHeader(header);
+
+		return new_page;
+	}
+
 	new_page_number = header.num_pages;
 
 	if (header.first_used_page == Page::INVALID_NUMBER) {
@@ -392,9 +408,50 @@ void BlobFile::writePage(const PageId new_page_number, const Page& new_page) {
 	stream_->flush();
 }
 
-//delePage should not be called for a blob_file, not supported
 void BlobFile::deletePage(const PageId page_number) {
-	throw InvalidPageException(page_number, filename_);
+  FileHeader header = readHeader();
+
+	if (page_number >= header.num_pages || page_number == header.first_used_page)
+	{
+		throw InvalidPageException(page_number, filename_);
+	}
+
+	// A page already on the free list would be linked in twice and handed out
+	// by two later allocations.
+	if (isFree(header, page_number, readPage(page_number)))
+	{
+		throw InvalidPageException(page_number, filename_);
+	}
+
+	// Blob pages carry no header, so the free list is threaded through the first
+	// bytes of the freed pages themselves, each followed by the free page mark.
+	Page free_page;
+	PageId* link = reinterpret_cast<PageId*>(&free_page);
+	link[0] = header.first_free_page;
+	link[1] = FREE_PAGE_MARK;
+	header.first_free_page = page_number;
+	++header.num_free_pages;
+
+	writePage(page_number, free_page);
+	writeHeader(header);
+}
+
+bool BlobFile::isFree(const FileHeader& header, const PageId page_number,
+                      const Page& page) const {
+	// Only a page carrying the mark can be free; the list is walked to tell it
+	// from a used page whose data happens to hold the same word.
+	if (reinterpret_cast<const PageId*>(&page)[1] != FREE_PAGE_MARK) {
+		return false;
+	}
+	PageId free_page_number = header.first_free_page;
+	for (std::uint32_t i = 0; i < header.num_free_pages; i++) {
+		if (free_page_number == page_number) {
+			return true;
+		}
+		Page free_page = readPage(free_page_number);
+		free_page_number = *reinterpret_cast<const PageId*>(&free_page);
+	}
+	return false;
 }
 
 }
@@ -443,6 +443,8 @@ class BlobFile : public File {
 
   /**
    * Allocates a new page in the file.
+   * Pages previously released with deletePage() are reused before the file
+   * is extended.
    *
    * @return The new page.
    */
@@ -469,10 +471,32 @@ class BlobFile : public File {
 
   /**
    * Deletes a page from the file.
+   * The page is added to the head of the file's free list and handed out
+   * again by the next call to allocatePage().
    *
    * @param page_number   Number of page to delete.
+   * @throws  InvalidPageException  If the page doesn't exist in the file, is
+   *                                the first page of the file or is already
+   *                                on the free list.
    */
   void deletePage(const PageId page_number);
+
+ private:
+  /**
+   * Word stored right after the next-free link of every page on the free
+   * list, so deleting a page twice is caught before it is linked in twice.
+   */
+  static const std::uint32_t FREE_PAGE_MARK = 0x65657246;
+
+  /**
+   * Returns true if the page is on the file's free list.
+   *
+   * @param header        Header of this file.
+   * @param page_number   Number of page to look for.
+   * @param page          Current contents of that page.
+   */
+  bool isFree(const FileHeader& header, const PageId page_number,
+              const Page& page) const;
 };
 
 }
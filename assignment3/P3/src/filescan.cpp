@@ -5,8 +5,12 @@
  * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
  */
 
+#include <algorithm>
+#include <limits>
 #include "filescan.h"
 #include "exceptions/end_of_file_exception.h"
+#include "exceptions/index_scan_completed_exception.h"
+#include "exceptions/scan_not_initialized_exception.h"
 
 namespace badgerdb { 
 
@@ -117,4 +121,196 @@ void FileScan::markDirty()
   curDirtyFlag = true;
 }
 
+HeapFetch::HeapFetch(const std::string &name, BufMgr *bufferMgr, BTreeIndex *indexIn,
+                     size_t batchSizeIn, size_t directLimitIn)
+{
+  file = new PageFile(name, false);	//dont create new file
+	bufMgr = bufferMgr;
+	index = indexIn;
+	batchSize = std::max(batchSizeIn, directLimitIn + 1);
+	directLimit = directLimitIn;
+	nextRid = 0;
+	rangeDone = true;
+	scanExecuting = false;
+  curPage = NULL;
+}
+
+HeapFetch::~HeapFetch()
+{
+  releasePage();
+  bufMgr->flushFile(file);
+  delete file;
+}
+
+void HeapFetch::startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp)
+{
+  releasePage();
+	cursor = index->openScan(lowVal, lowOp, highVal, highOp);
+	rids.clear();
+	nextRid = 0;
+	rangeDone = false;
+	scanExecuting = true;
+	fillBatch(true);
+}
+
+void HeapFetch::scanNext(RecordId& outRid)
+{
+	if (!scanExecuting)
+	{
+		throw ScanNotInitializedException();
+	}
+  while (nextRid == rids.size())
+  {
+    if (rangeDone)
+    {
+      releasePage();
+      throw IndexScanCompletedException();
+    }
+    fillBatch(false);
+  }
+
+  // records of a batch on the same page follow each other, the page stays pinned for all of them
+  RecordId rid = rids[nextRid++];
+  if (curPage == NULL || rid.page_number != curRid.page_number)
+  {
+    releasePage();
+    bufMgr->readPage(file, rid.page_number, curPage);
+  }
+  curRid = rid;
+  outRid = rid;
+}
+
+std::string HeapFetch::getRecord()
+{
+  return curPage->getRecord(curRid);
+}
+
+void HeapFetch::endScan()
+{
+	if (!scanExecuting)
+	{
+		throw ScanNotInitializedException();
+	}
+  releasePage();
+	cursor.endScan();
+	rids.clear();
+	nextRid = 0;
+	rangeDone = true;
+	scanExecuting = false;
+}
+
+void HeapFetch::fillBatch(bool first)
+{
+	// taken a chunk at a time, so a small range never pays for a whole batch of room
+	rids.clear();
+	nextRid = 0;
+	while (rids.size() < batchSize)
+	{
+		size_t have = rids.size();
+		size_t chunk = std::min(HEAPFETCHCHUNK, batchSize - have);
+		rids.resize(have + chunk);
+		// fewer than asked for only come back at the end of the range
+		size_t n = cursor.nextBatch(&rids[have], chunk);
+		rids.resize(have + n);
+		if (n < chunk)
+		{
+			rangeDone = true;
+			break;
+		}
+	}
+	if (first && rangeDone && rids.size() <= directLimit)
+	{
+		return;
+	}
+	std::sort(rids.begin(), rids.end());
+}
+
+void HeapFetch::releasePage()
+{
+  if (curPage != NULL)
+  {
+    bufMgr->unPinPage(file, curRid.page_number, false);
+    curPage = NULL;
+  }
+}
+
+TableScan::TableScan(BTreeIndex *tableIn, size_t batchSizeIn)
+{
+	table = tableIn;
+	batchSize = std::max(batchSizeIn, (size_t)1);
+	recordLength = table->payloadSize();
+	rids.resize(batchSize);
+	records.resize(batchSize * recordLength);
+	count = 0;
+	nextRecord = 0;
+	rangeDone = true;
+	scanExecuting = false;
+}
+
+TableScan::~TableScan()
+{
+}
+
+void TableScan::startScan()
+{
+	int low = std::numeric_limits<int>::min();
+	int high = std::numeric_limits<int>::max();
+	startScan(&low, GTE, &high, LTE);
+}
+
+void TableScan::startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp)
+{
+	cursor = table->openScan(lowVal, lowOp, highVal, highOp);
+	count = 0;
+	nextRecord = 0;
+	rangeDone = false;
+	scanExecuting = true;
+}
+
+void TableScan::scanNext(RecordId& outRid)
+{
+	if (!scanExecuting)
+	{
+		throw ScanNotInitializedException();
+	}
+  while (nextRecord == count)
+  {
+    if (rangeDone)
+    {
+      throw IndexScanCompletedException();
+    }
+    fillBatch();
+  }
+  outRid = rids[nextRecord++];
+}
+
+std::string TableScan::getRecord()
+{
+  return std::string(&records[(nextRecord - 1) * recordLength], recordLength);
+}
+
+void TableScan::endScan()
+{
+	if (!scanExecuting)
+	{
+		throw ScanNotInitializedException();
+	}
+	cursor.endScan();
+	count = 0;
+	nextRecord = 0;
+	rangeDone = true;
+	scanExecuting = false;
+}
+
+void TableScan::fillBatch()
+{
+	// the cursor copies the records of a leaf at a time, so the leaf is only latched while it copies
+	count = cursor.nextBatch(&rids[0], batchSize, &records[0]);
+	nextRecord = 0;
+	if (count < batchSize)
+	{
+		rangeDone = true;
+	}
+}
+
 }
@@ -9,11 +9,13 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "types.h"
 #include "page.h"
 #include "buffer.h"
 #include "file_iterator.h"
 #include "page_iterator.h"
+#include "btree.h"
 
 namespace badgerdb {
 
@@ -62,4 +64,203 @@ class FileScan
   bool  	      curDirtyFlag;
 };
 
+/**
+ * @brief Most record ids HeapFetch takes from the index before it reads the pages they are on.
+ */
+const size_t HEAPFETCHBATCH = 1048576;
+
+/**
+ * @brief Number of record ids HeapFetch asks the index for at a time while it fills a batch.
+ */
+const size_t HEAPFETCHCHUNK = 1024;
+
+/**
+ * @brief Ranges with at most this many entries are fetched by HeapFetch straight from the index, in key order.
+ */
+const size_t HEAPFETCHDIRECT = 32;
+
+/**
+ * @brief This class is used to fetch the records a range of an index points to. Record ids are taken
+ * from the index a batch at a time and sorted, so each page holding records of a batch is read once
+ * and pages are read in the order they are in the file, however the index spreads the records over
+ * the relation. Ranges of up to directLimit entries are fetched in key order instead, one page read a
+ * record, which saves sorting when there are too few records to share pages.
+ */
+class HeapFetch
+{
+ public:
+
+  HeapFetch(const std::string &name, BufMgr *bufMgr, BTreeIndex *index,
+            size_t batchSize = HEAPFETCHBATCH, size_t directLimit = HEAPFETCHDIRECT);
+
+  ~HeapFetch();
+
+  //start fetching the records of a range, same parameters as BTreeIndex::openScan
+  void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  //return RecordId of next record of the range, IndexScanCompletedException after the last one
+  void scanNext(RecordId& outRid);
+
+  //read current record
+  std::string getRecord();
+
+  //end the scan, unpinning the current page
+  void endScan();
+
+ private:
+  //take the next batch of record ids from the index, sorting them unless first finds the whole range small enough to fetch directly
+  void fillBatch(bool first);
+
+  //unpin the current page, if any
+  void releasePage();
+
+  /**
+   * Relation the index points into.
+   */
+  PageFile      *file;
+
+  /**
+   * Buffer Manager instance used to read pages into the buffer pool.
+   */
+	BufMgr				*bufMgr;
+
+  /**
+   * Index the record ids are taken from.
+   */
+  BTreeIndex    *index;
+
+  /**
+   * Scan of the range in the index.
+   */
+  BTreeCursor   cursor;
+
+  /**
+   * Most record ids taken from the index at a time.
+   */
+  size_t        batchSize;
+
+  /**
+   * Largest range fetched in key order.
+   */
+  size_t        directLimit;
+
+  /**
+   * Record ids of the current batch, in the order they are fetched.
+   */
+  std::vector<RecordId> rids;
+
+  /**
+   * Number of record ids of the batch fetched so far.
+   */
+  size_t        nextRid;
+
+  /**
+   * True once the index has no more record ids of the range.
+   */
+  bool          rangeDone;
+
+  /**
+   * True if a scan was started and not ended.
+   */
+  bool          scanExecuting;
+
+  /**
+   * Page holding the current record, kept pinned until the scan moves off it.
+   */
+  Page*         curPage;
+
+  /**
+   * Current record.
+   */
+  RecordId      curRid;
+};
+
+/**
+ * @brief Number of records TableScan copies out of the leaves of a table at a time.
+ */
+const size_t TABLESCANBATCH = 256;
+
+/**
+ * @brief This class is used to scan the records of an index-organized table in key order, see the
+ * BTreeIndex constructor taking a record length. Records are copied out of the leaf entries a batch
+ * at a time, reading leaves in key order and no other pages.
+ */
+class TableScan
+{
+ public:
+
+  TableScan(BTreeIndex *table, size_t batchSize = TABLESCANBATCH);
+
+  ~TableScan();
+
+  //start scanning every record of the table
+  void startScan();
+
+  //start scanning the records of a range of keys, same parameters as BTreeIndex::openScan
+  void startScan(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp);
+
+  //return row id of next record of the scan, IndexScanCompletedException after the last one
+  void scanNext(RecordId& outRid);
+
+  //read current record
+  std::string getRecord();
+
+  //end the scan
+  void endScan();
+
+ private:
+  //copy the next batch of records out of the table
+  void fillBatch();
+
+  /**
+   * Table being scanned.
+   */
+  BTreeIndex    *table;
+
+  /**
+   * Scan of the range in the table.
+   */
+  BTreeCursor   cursor;
+
+  /**
+   * Most records copied out of the table at a time.
+   */
+  size_t        batchSize;
+
+  /**
+   * Number of bytes of each record.
+   */
+  size_t        recordLength;
+
+  /**
+   * Row ids of the current batch.
+   */
+  std::vector<RecordId> rids;
+
+  /**
+   * Records of the current batch, recordLength bytes each.
+   */
+  std::vector<char> records;
+
+  /**
+   * Number of records of the batch.
+   */
+  size_t        count;
+
+  /**
+   * Number of records of the batch returned so far.
+   */
+  size_t        nextRecord;
+
+  /**
+   * True once the table has no more records in the range.
+   */
+  bool          rangeDone;
+
+  /**
+   * True if a scan was started and not ended.
+   */
+  bool          scanExecuting;
+};
+
 }
@@ -0,0 +1,378 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include "hashindex.h"
+#include "filescan.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/no_such_key_found_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/end_of_file_exception.h"
+
+namespace badgerdb
+{
+
+// -----------------------------------------------------------------------------
+// HashIndex::HashIndex -- Constructor
+// -----------------------------------------------------------------------------
+
+HashIndex::HashIndex(const std::string & relationName,
+		std::string & outIndexName,
+		BufMgr *bufMgrIn,
+		const int attrByteOffset,
+		const Datatype attrType)
+{
+	bufMgr = bufMgrIn;
+
+	std::ostringstream index_string;
+	index_string << relationName << ".hash." << attrByteOffset;
+	outIndexName = index_string.str();
+
+	if(attrType != INTEGER){
+		throw BadIndexInfoException(outIndexName);
+	}
+
+	try{
+		file = new BlobFile(outIndexName, false);
+		headerPageNum = file->getFirstPageNo();
+		Page *header_Page;
+		bufMgr->readPage(file, headerPageNum, header_Page);
+		HashMetaInfo *m = (HashMetaInfo *)header_Page;
+		if (relationName != m->relationName || attrType != m->attrType || attrByteOffset != m->attrByteOffset){
+			bufMgr->unPinPage(file, headerPageNum, false);
+			bufMgr->flushFile(file);
+			delete file;
+			throw BadIndexInfoException(outIndexName);
+		}
+		level = m->level;
+		splitNext = m->splitNext;
+		entryCount = m->entryCount;
+		PageId directoryPageNum = m->directoryPageNo;
+		bufMgr->unPinPage(file, headerPageNum, false);
+
+		// the page numbers of the buckets are read into memory once
+		while(directoryPageNum != 0){
+			Page *page;
+			bufMgr->readPage(file, directoryPageNum, page);
+			HashDirectoryPage *directory = (HashDirectoryPage *)page;
+			buckets.insert(buckets.end(), directory->bucketPageNo, directory->bucketPageNo + directory->count);
+			PageId next = directory->nextPageNo;
+			bufMgr->unPinPage(file, directoryPageNum, false);
+			directoryPageNum = next;
+		}
+		roomHints = buckets;
+	}
+	catch(FileNotFoundException e){
+		file = new BlobFile(outIndexName, true);
+		Page *header_Page;
+		bufMgr->allocPage(file, headerPageNum, header_Page);
+		HashMetaInfo *m = (HashMetaInfo *)header_Page;
+		strncpy((char *)(&(m->relationName)), relationName.c_str(), 20);
+		m->relationName[19] = 0;
+		m->attrByteOffset = attrByteOffset;
+		m->attrType = attrType;
+		m->directoryPageNo = 0;
+		bufMgr->unPinPage(file, headerPageNum, true);
+
+		// linear hashing starts from a single bucket
+		level = 0;
+		splitNext = 0;
+		entryCount = 0;
+		PageId bucketPageNum;
+		Page *bucketPage;
+		bufMgr->allocPage(file, bucketPageNum, bucketPage);
+		HashBucketInt *bucket = (HashBucketInt *)bucketPage;
+		bucket->count = 0;
+		bucket->overflowPageNo = 0;
+		bufMgr->unPinPage(file, bucketPageNum, true);
+		buckets.push_back(bucketPageNum);
+		roomHints.push_back(bucketPageNum);
+
+		FileScan fileScan(relationName, bufMgr);
+		RecordId rid;
+		try{
+			while(1){
+				fileScan.scanNext(rid);
+				std::string record = fileScan.getRecord();
+				insertEntry(record.c_str() + attrByteOffset, rid);
+			}
+		}
+		catch(EndOfFileException e){
+			writeDirectory();
+			bufMgr->flushFile(file);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::~HashIndex -- destructor
+// -----------------------------------------------------------------------------
+
+HashIndex::~HashIndex()
+{
+	writeDirectory();
+	bufMgr->flushFile(file);
+	delete file;
+	file = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::insertEntry
+// -----------------------------------------------------------------------------
+
+const void HashIndex::insertEntry(const void *key, const RecordId rid)
+{
+	std::lock_guard<std::mutex> guard(indexMutex);
+	int k = *((int *)key);
+	bucketInsert(bucketOf(k), k, rid);
+	entryCount++;
+	if(entryCount > HASHLOADFACTOR * HASHBUCKETSIZE * buckets.size()){
+		split();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::deleteEntry
+// -----------------------------------------------------------------------------
+
+const void HashIndex::deleteEntry(const void *key, const RecordId rid)
+{
+	std::lock_guard<std::mutex> guard(indexMutex);
+	int k = *((int *)key);
+	int bucketNum = bucketOf(k);
+	PageId previousNum = 0;
+	HashBucketInt *previous = nullptr;
+	PageId pageNum = buckets[bucketNum];
+	bool hintPassed = false;
+	while(pageNum != 0){
+		Page *page;
+		bufMgr->readPage(file, pageNum, page);
+		HashBucketInt *bucket = (HashBucketInt *)page;
+		for(int i = 0; i < bucket->count; i++){
+			if(bucket->keyArray[i] != k || !(bucket->ridArray[i] == rid)){
+				continue;
+			}
+			bucket->count--;
+			bucket->keyArray[i] = bucket->keyArray[bucket->count];
+			bucket->ridArray[i] = bucket->ridArray[bucket->count];
+			entryCount--;
+			// the page has room now, inserts look here first unless the hint is already at or before it
+			if(!hintPassed){
+				roomHints[bucketNum] = pageNum;
+			}
+			// an empty overflow page leaves the chain, the primary page stays even when empty
+			if(bucket->count == 0 && previous != nullptr){
+				if(roomHints[bucketNum] == pageNum){
+					roomHints[bucketNum] = previousNum;
+				}
+				previous->overflowPageNo = bucket->overflowPageNo;
+				bufMgr->unPinPage(file, pageNum, false);
+				bufMgr->disposePage(file, pageNum);
+				bufMgr->unPinPage(file, previousNum, true);
+				return;
+			}
+			bufMgr->unPinPage(file, pageNum, true);
+			if(previous != nullptr){
+				bufMgr->unPinPage(file, previousNum, false);
+			}
+			return;
+		}
+		if(previous != nullptr){
+			bufMgr->unPinPage(file, previousNum, false);
+		}
+		hintPassed = hintPassed || pageNum == roomHints[bucketNum];
+		previous = bucket;
+		previousNum = pageNum;
+		pageNum = bucket->overflowPageNo;
+	}
+	if(previous != nullptr){
+		bufMgr->unPinPage(file, previousNum, false);
+	}
+	throw NoSuchKeyFoundException();
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::lookup
+// -----------------------------------------------------------------------------
+
+const size_t HashIndex::lookup(const void *key, std::vector<RecordId> &outRids)
+{
+	std::lock_guard<std::mutex> guard(indexMutex);
+	int k = *((int *)key);
+	size_t found = 0;
+	PageId pageNum = buckets[bucketOf(k)];
+	while(pageNum != 0){
+		Page *page;
+		bufMgr->readPage(file, pageNum, page);
+		HashBucketInt *bucket = (HashBucketInt *)page;
+		for(int i = 0; i < bucket->count; i++){
+			if(bucket->keyArray[i] == k){
+				outRids.push_back(bucket->ridArray[i]);
+				found++;
+			}
+		}
+		PageId next = bucket->overflowPageNo;
+		bufMgr->unPinPage(file, pageNum, false);
+		pageNum = next;
+	}
+	return found;
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::bucketCount
+// -----------------------------------------------------------------------------
+
+const int HashIndex::bucketCount()
+{
+	std::lock_guard<std::mutex> guard(indexMutex);
+	return buckets.size();
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::bucketOf
+// -----------------------------------------------------------------------------
+const int HashIndex::bucketOf(int key){
+	// the bits of the key are mixed so consecutive keys spread over all buckets
+	std::uint32_t h = key;
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	std::uint32_t bucket = h & ((1u << level) - 1);
+	if(bucket < (std::uint32_t)splitNext){
+		bucket = h & ((2u << level) - 1);
+	}
+	return bucket;
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::bucketInsert
+// -----------------------------------------------------------------------------
+const void HashIndex::bucketInsert(int bucketNum, int key, RecordId rid){
+	PageId pageNum = roomHints[bucketNum];
+	while(true){
+		Page *page;
+		bufMgr->readPage(file, pageNum, page);
+		HashBucketInt *bucket = (HashBucketInt *)page;
+		if(bucket->count < HASHBUCKETSIZE){
+			bucket->keyArray[bucket->count] = key;
+			bucket->ridArray[bucket->count] = rid;
+			bucket->count++;
+			bufMgr->unPinPage(file, pageNum, true);
+			roomHints[bucketNum] = pageNum;
+			return;
+		}
+		if(bucket->overflowPageNo == 0){
+			PageId overflowNum;
+			Page *overflowPage;
+			bufMgr->allocPage(file, overflowNum, overflowPage);
+			HashBucketInt *overflow = (HashBucketInt *)overflowPage;
+			overflow->count = 1;
+			overflow->overflowPageNo = 0;
+			overflow->keyArray[0] = key;
+			overflow->ridArray[0] = rid;
+			bufMgr->unPinPage(file, overflowNum, true);
+			bucket->overflowPageNo = overflowNum;
+			bufMgr->unPinPage(file, pageNum, true);
+			roomHints[bucketNum] = overflowNum;
+			return;
+		}
+		PageId next = bucket->overflowPageNo;
+		bufMgr->unPinPage(file, pageNum, false);
+		pageNum = next;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::split
+// -----------------------------------------------------------------------------
+const void HashIndex::split(){
+	// the entries of the bucket are taken out of its pages, its overflow pages freed and
+	// the entries put back into it or its new image one bit of the hash further up
+	std::vector<int> keys;
+	std::vector<RecordId> rids;
+	PageId primaryNum = buckets[splitNext];
+	roomHints[splitNext] = primaryNum;
+	PageId pageNum = primaryNum;
+	while(pageNum != 0){
+		Page *page;
+		bufMgr->readPage(file, pageNum, page);
+		HashBucketInt *bucket = (HashBucketInt *)page;
+		keys.insert(keys.end(), bucket->keyArray, bucket->keyArray + bucket->count);
+		rids.insert(rids.end(), bucket->ridArray, bucket->ridArray + bucket->count);
+		PageId next = bucket->overflowPageNo;
+		if(pageNum == primaryNum){
+			bucket->count = 0;
+			bucket->overflowPageNo = 0;
+			bufMgr->unPinPage(file, pageNum, true);
+		}
+		else{
+			bufMgr->unPinPage(file, pageNum, false);
+			bufMgr->disposePage(file, pageNum);
+		}
+		pageNum = next;
+	}
+
+	PageId imageNum;
+	Page *imagePage;
+	bufMgr->allocPage(file, imageNum, imagePage);
+	HashBucketInt *image = (HashBucketInt *)imagePage;
+	image->count = 0;
+	image->overflowPageNo = 0;
+	bufMgr->unPinPage(file, imageNum, true);
+	buckets.push_back(imageNum);
+	roomHints.push_back(imageNum);
+
+	splitNext++;
+	if(splitNext == (1 << level)){
+		level++;
+		splitNext = 0;
+	}
+	for(size_t i = 0; i < keys.size(); i++){
+		bucketInsert(bucketOf(keys[i]), keys[i], rids[i]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// HashIndex::writeDirectory
+// -----------------------------------------------------------------------------
+const void HashIndex::writeDirectory(){
+	Page *header_Page;
+	bufMgr->readPage(file, headerPageNum, header_Page);
+	HashMetaInfo *m = (HashMetaInfo *)header_Page;
+	m->level = level;
+	m->splitNext = splitNext;
+	m->entryCount = entryCount;
+
+	// directory pages written before are overwritten, more are chained on as the buckets grow
+	PageId *link = &m->directoryPageNo;
+	PageId linkNum = headerPageNum;
+	size_t written = 0;
+	while(written < buckets.size()){
+		PageId pageNum = *link;
+		Page *page;
+		if(pageNum == 0){
+			bufMgr->allocPage(file, pageNum, page);
+			((HashDirectoryPage *)page)->nextPageNo = 0;
+			*link = pageNum;
+		}
+		else{
+			bufMgr->readPage(file, pageNum, page);
+		}
+		HashDirectoryPage *directory = (HashDirectoryPage *)page;
+		directory->count = std::min((size_t)HASHDIRECTORYSIZE, buckets.size() - written);
+		memcpy(directory->bucketPageNo, &buckets[written], directory->count * sizeof(PageId));
+		written += directory->count;
+		bufMgr->unPinPage(file, linkNum, true);
+		link = &directory->nextPageNo;
+		linkNum = pageNum;
+	}
+	bufMgr->unPinPage(file, linkNum, true);
+}
+
+}
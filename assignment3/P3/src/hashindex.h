@@ -0,0 +1,250 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include "types.h"
+#include "page.h"
+#include "file.h"
+#include "buffer.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Number of entries in a bucket page of a HashIndex on an INTEGER key.
+ */
+const int HASHBUCKETSIZE = ( Page::SIZE - sizeof( int ) - sizeof( PageId ) ) / ( sizeof( int ) + sizeof( RecordId ) );
+
+/**
+ * @brief Number of bucket page numbers in a directory page of a HashIndex.
+ */
+const int HASHDIRECTORYSIZE = ( Page::SIZE - sizeof( PageId ) - sizeof( int ) ) / sizeof( PageId );
+
+/**
+ * @brief Average share of the slots of the buckets a HashIndex fills before it splits the next bucket.
+ */
+const double HASHLOADFACTOR = 0.75;
+
+/**
+ * @brief The meta page, the first page of a hash index file, cast to this structure. Holds the relation
+ * and attribute the index is on and the state of the linear hashing.
+*/
+struct HashMetaInfo{
+  /**
+   * Name of base relation.
+   */
+	char relationName[20];
+
+  /**
+   * Offset of attribute, over which index is built, inside the record stored in pages.
+   */
+	int attrByteOffset;
+
+  /**
+   * Type of the attribute over which index is built.
+   */
+	Datatype attrType;
+
+  /**
+   * Number of times the buckets have all been split, there are at least 2^level of them.
+   */
+	int level;
+
+  /**
+   * Next bucket to split, buckets before it are addressed with one more bit of the hash.
+   */
+	int splitNext;
+
+  /**
+   * Number of entries in the index.
+   */
+	std::int64_t entryCount;
+
+  /**
+   * First page of the directory holding the page numbers of the buckets, 0 while there is none.
+   */
+	PageId directoryPageNo;
+};
+
+/**
+ * @brief Structure for the primary and overflow pages of the buckets of a hash index. Entries are kept
+ * unsorted at the front of the arrays.
+*/
+struct HashBucketInt{
+  /**
+   * Number of entries in the page.
+   */
+	int count;
+
+  /**
+   * Next overflow page of the bucket, 0 if this is the last page.
+   */
+	PageId overflowPageNo;
+
+  /**
+   * Keys of the entries.
+   */
+	int keyArray[ HASHBUCKETSIZE ];
+
+  /**
+   * RecordIds of the entries.
+   */
+	RecordId ridArray[ HASHBUCKETSIZE ];
+};
+
+/**
+ * @brief Structure for the pages of the directory of a hash index, which keeps the page numbers of
+ * the primary pages of the buckets in bucket order while the index is closed.
+*/
+struct HashDirectoryPage{
+  /**
+   * Next page of the directory, 0 if this is the last one.
+   */
+	PageId nextPageNo;
+
+  /**
+   * Number of bucket page numbers in this page.
+   */
+	int count;
+
+  /**
+   * Page numbers of the primary pages of buckets.
+   */
+	PageId bucketPageNo[ HASHDIRECTORYSIZE ];
+};
+
+/**
+ * @brief Hash index on an INTEGER attribute of a relation for equality lookups, kept in a BlobFile
+ * read through the buffer manager. Linear hashing grows the index one bucket at a time: once the
+ * entries fill HASHLOADFACTOR of the slots of the buckets the bucket at splitNext is split in two,
+ * so there are never many overflow pages and a lookup reads about one page. The page numbers of the
+ * buckets are kept in memory while the index is open and written to directory pages when it closes.
+ * One mutex serializes lookups, inserts and deletes.
+*/
+class HashIndex {
+
+ private:
+
+  /**
+   * File object for the index file.
+   */
+	File		*file;
+
+  /**
+   * Buffer Manager Instance.
+   */
+	BufMgr	*bufMgr;
+
+  /**
+   * Page number of meta page.
+   */
+	PageId	headerPageNum;
+
+  /**
+   * Number of times the buckets have all been split.
+   */
+	int			level;
+
+  /**
+   * Next bucket to split.
+   */
+	int			splitNext;
+
+  /**
+   * Number of entries in the index.
+   */
+	std::int64_t	entryCount;
+
+  /**
+   * Page numbers of the primary pages of the buckets, in bucket order.
+   */
+	std::vector<PageId>	buckets;
+
+  /**
+   * Page of each bucket inserts start looking for room at. No page of the bucket before it has room,
+   * so inserts of many duplicates append to the last page instead of walking the chain.
+   */
+	std::vector<PageId>	roomHints;
+
+  /**
+   * Serializes lookups, inserts and deletes.
+   */
+	std::mutex	indexMutex;
+
+ public:
+
+  /**
+   * HashIndex Constructor.
+	 * Check to see if the corresponding index file exists. If so, open the file.
+	 * If not, create it and insert entries for every tuple in the base relation using FileScan class.
+   *
+   * @param relationName        Name of file.
+   * @param outIndexName        Return the name of index file.
+   * @param bufMgrIn						Buffer Manager Instance
+   * @param attrByteOffset			Offset of attribute, over which index is to be built, in the record
+   * @param attrType						Datatype of attribute over which index is built
+   * @throws  BadIndexInfoException     If the attribute is not an INTEGER one.
+   * @throws  BadIndexInfoException     If the index file already exists for another relation or attribute.
+   */
+	HashIndex(const std::string & relationName, std::string & outIndexName,
+						BufMgr *bufMgrIn,	const int attrByteOffset,	const Datatype attrType);
+
+  /**
+   * HashIndex Destructor.
+	 * Write the directory and meta page, flush the index file from the buffer manager and close it.
+	**/
+	~HashIndex();
+
+  /**
+	 * Insert a new entry using the pair <value,rid> into the bucket of the key, in the first of its pages
+	 * with room or a new overflow page. The search starts at the page the last insert or delete found room in. Splits the next bucket if the index is then fuller than HASHLOADFACTOR.
+   * @param key			Key to insert, pointer to integer
+   * @param rid			Record ID of a record whose entry is getting inserted into the index.
+	**/
+	const void insertEntry(const void* key, const RecordId rid);
+
+  /**
+	 * Delete the entry <value,rid> from the index. The last entry of its page takes its slot, and an overflow
+	 * page left empty is freed. Buckets are never merged again.
+   * @param key			Key to delete, pointer to integer
+   * @param rid			Record ID of the record whose entry is getting deleted from the index.
+	 * @throws  NoSuchKeyFoundException If there is no entry <value,rid> in the index.
+	**/
+	const void deleteEntry(const void* key, const RecordId rid);
+
+  /**
+	 * Look up every entry with the key, reading the pages of its bucket.
+   * @param key			Key to look up, pointer to integer
+   * @param outRids	Receives the record ids of the entries, in no particular order
+   * @return  Number of record ids added to outRids
+	**/
+	const size_t lookup(const void* key, std::vector<RecordId> &outRids);
+
+  /**
+	 * Number of buckets of the index.
+	**/
+	const int bucketCount();
+
+ private:
+	// bucket a key belongs in with the current level and split pointer
+	const int bucketOf(int key);
+	// add an entry to a bucket, in the first page with room from its hint on or a new overflow page
+	const void bucketInsert(int bucketNum, int key, RecordId rid);
+	// split the bucket at splitNext in two and move the split pointer on
+	const void split();
+	// write the directory and meta page
+	const void writeDirectory();
+};
+
+}
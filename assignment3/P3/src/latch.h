@@ -0,0 +1,127 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace badgerdb {
+
+/**
+ * @brief Version latch used for optimistic lock coupling.
+ *
+ * Readers never acquire the latch. They remember the version before reading the
+ * protected data and check afterwards that it did not change; if it did, they
+ * throw away what they read and retry. Writers acquire the latch exclusively,
+ * which makes every concurrent optimistic read fail validation, and bump the
+ * version when they release it.
+ *
+ * The low two bits of the version word are flags: bit 0 marks the protected
+ * node as obsolete (it was removed from the tree), bit 1 marks it locked.
+ */
+class OptLatch {
+ public:
+  /**
+   * Constructs an unlocked latch.
+   */
+  OptLatch()
+      : version_(0) {
+  }
+
+  /**
+   * Starts an optimistic read.
+   *
+   * @param version  Set to the current version.
+   * @return  False if the latch is locked or obsolete, in which case the read
+   *          has to be retried.
+   */
+  bool readLock(std::uint64_t &version) const {
+    version = version_.load(std::memory_order_acquire);
+    return (version & (LOCKED | OBSOLETE)) == 0;
+  }
+
+  /**
+   * Checks that nothing was written since the optimistic read started.
+   *
+   * @param version  Version returned by readLock().
+   * @return  True if everything read since then is consistent.
+   */
+  bool validate(const std::uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /**
+   * Turns an optimistic read into an exclusive lock, without waiting.
+   *
+   * @param version  Version returned by readLock().
+   * @return  False if somebody wrote since the read started.
+   */
+  bool upgrade(std::uint64_t version) {
+    return version_.compare_exchange_strong(version, version + LOCKED,
+                                            std::memory_order_acquire);
+  }
+
+  /**
+   * Acquires the latch exclusively, spinning while somebody else holds it.
+   */
+  void lock() {
+    while (true) {
+      std::uint64_t version = version_.load(std::memory_order_relaxed);
+      if ((version & LOCKED) == 0 && upgrade(version)) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Releases an exclusive lock and publishes a new version.
+   */
+  void unlock() {
+    version_.fetch_add(LOCKED, std::memory_order_release);
+  }
+
+  /**
+   * Releases an exclusive lock and marks the protected node obsolete, so
+   * readers still holding it restart instead of waiting for it.
+   */
+  void unlockObsolete() {
+    version_.fetch_add(LOCKED + OBSOLETE, std::memory_order_release);
+  }
+
+  /**
+   * Clears the obsolete flag when the latch starts protecting other data.
+   * Only called when no one else can be holding the latch.
+   */
+  void reset() {
+    std::uint64_t version = version_.load(std::memory_order_relaxed);
+    version_.store((version | LOCKED | OBSOLETE) + 1, std::memory_order_release);
+  }
+
+  /**
+   * Returns true if the version was read from an obsolete node.
+   *
+   * @param version  Version returned by readLock().
+   */
+  static bool isObsolete(const std::uint64_t version) {
+    return (version & OBSOLETE) != 0;
+  }
+
+ private:
+  static const std::uint64_t OBSOLETE = 1;
+  static const std::uint64_t LOCKED = 2;
+
+  /**
+   * Version counter with the lock and obsolete flags in its low bits.
+   */
+  std::atomic<std::uint64_t> version_;
+};
+
+}
@@ -6,7 +6,15 @@
  */
 
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <sstream>
 #include "btree.h"
+#include "hashindex.h"
+#include "statictree.h"
 #include "page.h"
 #include "filescan.h"
 #include "page_iterator.h"
@@ -19,6 +27,8 @@
 #include "exceptions/bad_opcodes_exception.h"
 #include "exceptions/scan_not_initialized_exception.h"
 #include "exceptions/end_of_file_exception.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/invalid_page_exception.h"
 
 #define checkPassFail(a, b) 																				\
 {																																		\
@@ -84,6 +94,72 @@ void MyIndexTests(int input);
 void intTestsEmpty();
 void intTestsOne();
 void intTestsNeg();
+void deleteTests();
+void intTestsDelete();
+long indexFileSize();
+void concurrentTests();
+void intTestsConcurrent();
+void cursorTests();
+void intTestsCursors();
+void postingTests();
+void intTestsPostings();
+void packedTests();
+void intTestsPacked();
+void appendTests();
+void intTestsAppend();
+void batchInsertTests();
+void intTestsInsertBatch(LeafFormat leafFormat);
+void pinnedTests();
+void intTestsPinned();
+void swizzleTests();
+void blockedTests();
+void intTestsBlocked();
+void lookupBatchTests();
+void intTestsLookupBatch(NonLeafFormat nonLeafFormat);
+void descendingTests();
+void intTestsDescending(LeafFormat leafFormat);
+int descendingScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize);
+int entryKey(RecordId rid);
+void countedTests();
+void intTestsCounted(LeafFormat leafFormat, NonLeafFormat nonLeafFormat);
+int sortedCount(const std::vector<int> &keys, int lowVal, Operator lowOp, int highVal, Operator highOp);
+int countedMatches(BTreeIndex *index, const std::vector<int> &keys, int probes);
+void heapFetchTests();
+void intTestsHeapFetch();
+int heapFetchScan(HeapFetch &fetch, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize, bool keyOrder);
+void coveringTests();
+void intTestsCovering(NonLeafFormat nonLeafFormat);
+int coveringScan(BTreeIndex *index, int lowVal, int highVal, ScanOrder order, size_t batchSize, const std::vector<bool> &present);
+void createRelationComposite(int size, int leadingValues);
+void compositeTests();
+void intTestsComposite(NonLeafFormat nonLeafFormat);
+void intTestsCompositeGroup(NonLeafFormat nonLeafFormat);
+int compositeScan(BTreeIndex *index, int lowCount, const RECORD &low, Operator lowOp, int highCount, const RECORD &high, Operator highOp, const std::vector<RECORD> &records, const std::vector<bool> &present);
+int tupleCompare(const RECORD &a, const RECORD &b, int count);
+void createRelationStrings(int size);
+void stringTests();
+int intTestsStrings(NonLeafFormat nonLeafFormat);
+int stringCount(BTreeIndex *index, const char *low, Operator lowOp, const char *high, Operator highOp, std::vector<RecordId> &out);
+void tableTests();
+void intTestsTable(NonLeafFormat nonLeafFormat);
+int tableScan(TableScan &scan, bool whole, int lowVal, int highVal, const std::vector<bool> &present);
+void hashTests();
+void bufferedTests();
+void intTestsBuffered(NonLeafFormat nonLeafFormat);
+int bufferedScan(BTreeIndex *index, int lowVal, int highVal);
+void staticTests();
+void intTestsStatic(LeafFormat leafFormat);
+void learnedTests();
+void intTestsLearned(LeafFormat leafFormat);
+void bloomTests();
+void intTestsBloom();
+void intTestsHash();
+int hashMatches(HashIndex *index, int lowVal, int highVal, const std::vector<RecordId> &rids, const std::vector<bool> &present);
+void intTestsSwizzle();
+int entryCount(BTreeIndex *index, int lowVal, int highVal, size_t batchSize);
+int recordKey(RecordId rid);
+int batchScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize);
+int oddScan(BTreeIndex *index, int lowVal, int highVal);
 
 
 int main(int argc, char **argv)
@@ -99,6 +175,18 @@ int main(int argc, char **argv)
 	catch(FileNotFoundException)
 	{
   }
+	// and the index on the integer field, which another version may have written in another layout
+	{
+		std::ostringstream staleIndexName;
+		staleIndexName << relationName << "." << offsetof(tuple,i);
+		try
+		{
+			File::remove(staleIndexName.str());
+		}
+		catch(FileNotFoundException)
+		{
+		}
+	}
 
 	{
 		// Create a new database file.
@@ -152,6 +240,29 @@ int main(int argc, char **argv)
 	test1();
 	test2();
 	test3();
+	deleteTests();
+	cursorTests();
+	postingTests();
+	packedTests();
+	appendTests();
+	batchInsertTests();
+	pinnedTests();
+	swizzleTests();
+	blockedTests();
+	lookupBatchTests();
+	descendingTests();
+	countedTests();
+	heapFetchTests();
+	coveringTests();
+	compositeTests();
+	stringTests();
+	tableTests();
+	hashTests();
+	bufferedTests();
+	staticTests();
+	learnedTests();
+	bloomTests();
+	concurrentTests();
 	errorTests();
 	std::cout<<"tests pass"<<std::endl;
   return 1;
@@ -199,190 +310,500 @@ void testEmptyTree()
 	MyIndexTests(0);
 	deleteRelation();
 }
-void testOneTree()
+void deleteTests()
 {
+	// Create a relation with tuples valued 0 to relationSize in random order, then
+	// delete entries from its index and make sure deleted pages are reused
   std::cout << "---------------------" << std::endl;
-	std::cout << "test for one" << std::endl;
-	myCreateRelationRandom(500);
-	MyIndexTests(1);
+	std::cout << "test delete" << std::endl;
+	createRelationRandom();
+	intTestsDelete();
+	try
+	{
+		File::remove(intIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
 	deleteRelation();
 }
 
-// -----------------------------------------------------------------------------
-// createRelationForward
-// -----------------------------------------------------------------------------
-
-void createRelationForward()
+void cursorTests()
 {
-	std::vector<RecordId> ridVec;
-  // destroy any old copies of relation file
+	// Create a relation with tuples valued 0 to relationSize in random order and keep
+	// several scans open on its index at once
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test cursors" << std::endl;
+	createRelationRandom();
+	intTestsCursors();
 	try
 	{
-		File::remove(relationName);
+		File::remove(intIndexName);
 	}
 	catch(FileNotFoundException e)
 	{
 	}
+	deleteRelation();
+}
 
-  file1 = new PageFile(relationName, true);
+void postingTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order and add
+	// thousands of duplicates of a few keys to its index
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test posting lists" << std::endl;
+	createRelationRandom();
+	intTestsPostings();
+	try
+	{
+		File::remove(intIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	deleteRelation();
+}
 
-  // initialize all of record1.s to keep purify happy
-  memset(record1.s, ' ', sizeof(record1.s));
-	PageId new_page_number;
-  Page new_page = file1->allocatePage(new_page_number);
+void packedTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in order and index it
+	// with packed leaves, next to thousands of entries inserted out of order
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test packed leaves" << std::endl;
+	createRelationForward();
+	intTestsPacked();
+	try
+	{
+		File::remove(intIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	deleteRelation();
+}
 
-  // Insert a bunch of tuples into the relation.
-  for(int i = 0; i < relationSize; i++ )
+void appendTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in order and index it, then
+	// keep appending entries with increasing keys and delete them from the top
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test appends" << std::endl;
+	createRelationForward();
+	intTestsAppend();
+	try
 	{
-    sprintf(record1.s, "%05d string record", i);
-    record1.i = i;
-    record1.d = (double)i;
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
+		File::remove(intIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	deleteRelation();
+}
 
-		while(1)
+void batchInsertTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order and add
+	// thousands of entries to its index in batches, with plain and with packed leaves
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test batch inserts" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 2; format++){
+		intTestsInsertBatch(format == 0 ? PLAIN_LEAVES : PACKED_LEAVES);
+		try
 		{
-			try
-			{
-    		new_page.insertRecord(new_data);
-				break;
-			}
-			catch(InsufficientSpaceException e)
-			{
-				file1->writePage(new_page_number, new_page);
-  			new_page = file1->allocatePage(new_page_number);
-			}
+			File::remove(intIndexName);
 		}
-  }
-
-	file1->writePage(new_page_number, new_page);
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
 }
 
-//
-// -----------------------------------------------------------------------------
-// myCreateRelationForward
-// -----------------------------------------------------------------------------
-void myCreateRelationForward(int size){
-	int i = 0;
-	
-	std::vector<RecordId> ridVec;
-	try{
-		File::remove(relationName);
-	}
-	catch(FileNotFoundException e){
+void pinnedTests()
+{
+	// Index an empty relation with its upper levels pinned, grow it until the root leaf
+	// splits, delete every entry so the pinned root is freed, then grow it again
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test pinned upper levels" << std::endl;
+	myCreateRelationRandom(0);
+	intTestsPinned();
+	try
+	{
+		File::remove(intIndexName);
 	}
-	file1 = new PageFile(relationName, true);
-	memset(record1.s, ' ', sizeof(record1.s));
-	PageId new_page_number;
-	Page new_page = file1->allocatePage(new_page_number);
-	while(i < size){
-		sprintf(record1.s, "%05d string record", i);
-		record1.i = i;
-		record1.d = (double)i;
-		std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
-		while(1){
-			try{
-				new_page.insertRecord(new_data);
-				break;
-			}
-			catch(InsufficientSpaceException e){
-				file1->writePage(new_page_number, new_page);
-				new_page = file1->allocatePage(new_page_number);
-			}
-		}
-		i++;
+	catch(FileNotFoundException e)
+	{
 	}
-	file1->writePage(new_page_number, new_page);
+	deleteRelation();
 }
 
-// -----------------------------------------------------------------------------
-// createRelationBackward
-// -----------------------------------------------------------------------------
-
-void createRelationBackward()
+void swizzleTests()
 {
-  // destroy any old copies of relation file
+	// Index an empty relation and grow it past the buffer pool, so children whose references
+	// were swizzled by lookups get evicted, then delete half of it to move references around
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test swizzled child references" << std::endl;
+	myCreateRelationRandom(0);
+	intTestsSwizzle();
 	try
 	{
-		File::remove(relationName);
+		File::remove(intIndexName);
 	}
 	catch(FileNotFoundException e)
 	{
 	}
-  file1 = new PageFile(relationName, true);
-
-  // initialize all of record1.s to keep purify happy
-  memset(record1.s, ' ', sizeof(record1.s));
-	PageId new_page_number;
-  Page new_page = file1->allocatePage(new_page_number);
+	deleteRelation();
+}
 
-  // Insert a bunch of tuples into the relation.
-  for(int i = relationSize - 1; i >= 0; i-- )
+void blockedTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order and index it with
+	// blocked non-leaves, then grow the index until they split and shrink it until they merge
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test blocked non-leaves" << std::endl;
+	createRelationRandom();
+	intTestsBlocked();
+	try
 	{
-    sprintf(record1.s, "%05d string record", i);
-    record1.i = i;
-    record1.d = i;
-
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+		File::remove(intIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	deleteRelation();
+}
 
-		while(1)
+void lookupBatchTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, add duplicates and
+	// entries past it, and look keys up in batches of every size, with both non-leaf formats
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test batched lookups" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 2; format++){
+		intTestsLookupBatch(format == 0 ? PLAIN_NONLEAVES : BLOCKED_NONLEAVES);
+		try
 		{
-			try
-			{
-    		new_page.insertRecord(new_data);
-				break;
-			}
-			catch(InsufficientSpaceException e)
-			{
-				file1->writePage(new_page_number, new_page);
-  			new_page = file1->allocatePage(new_page_number);
-			}
+			File::remove(intIndexName);
 		}
-  }
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
+}
 
-	file1->writePage(new_page_number, new_page);
+void descendingTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, add entries past it
+	// and runs of duplicates, and scan ranges from their high end down, with both leaf formats
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test descending scans" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 2; format++){
+		intTestsDescending(format == 0 ? PLAIN_LEAVES : PACKED_LEAVES);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
 }
 
-// -----------------------------------------------------------------------------
-// createRelationRandom
-// -----------------------------------------------------------------------------
+void countedTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, grow and shrink its index
+	// and count ranges and find entries by position, with counted non-leaves over both leaf formats and
+	// with plain non-leaves, which scan instead
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test counted non-leaves" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 3; format++){
+		intTestsCounted(format == 1 ? PACKED_LEAVES : PLAIN_LEAVES, format == 2 ? PLAIN_NONLEAVES : COUNTED_NONLEAVES);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
+}
 
-void createRelationRandom()
+void heapFetchTests()
 {
-  // destroy any old copies of relation file
+	// Create a relation with tuples valued 0 to relationSize in random order, index it and fetch
+	// the records of ranges a page at a time
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test heap fetch" << std::endl;
+	createRelationRandom();
+	intTestsHeapFetch();
 	try
 	{
-		File::remove(relationName);
+		File::remove(intIndexName);
 	}
 	catch(FileNotFoundException e)
 	{
 	}
-  file1 = new PageFile(relationName, true);
+	deleteRelation();
+}
 
-  // initialize all of record1.s to keep purify happy
-  memset(record1.s, ' ', sizeof(record1.s));
-	PageId new_page_number;
-  Page new_page = file1->allocatePage(new_page_number);
+void coveringTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, index it with the
+	// double and string fields included in the leaves and scan them out of the index while it shrinks
+	// and grows again
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test covering index" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 2; format++){
+		intTestsCovering(format == 0 ? PLAIN_NONLEAVES : COUNTED_NONLEAVES);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
+}
 
-  // insert records in random order
+void compositeTests()
+{
+	// Create a relation whose integer and double fields repeat in every combination, index it on
+	// (i, d, s) and look up full keys, leading attributes and ranges across them
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test composite keys" << std::endl;
+	NonLeafFormat formats[] = {PLAIN_NONLEAVES, COUNTED_NONLEAVES, COMPRESSED_NONLEAVES};
+	createRelationComposite(relationSize, 50);
+	for(int format = 0; format < 3; format++){
+		intTestsComposite(formats[format]);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
 
-  std::vector<int> intvec(relationSize);
-  for( int i = 0; i < relationSize; i++ )
-  {
-    intvec[i] = i;
-  }
+	// every record shares the leading attribute, so only the trailing ones tell the entries apart
+	createRelationComposite(relationSize * 4, 1);
+	for(int format = 0; format < 3; format++){
+		intTestsCompositeGroup(formats[format]);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
+}
 
-  long pos;
-  int val;
-	int i = 0;
-  while( i < relationSize )
-  {
-    pos = random() % (relationSize-i);
-    val = intvec[pos];
-    sprintf(record1.s, "%05d string record", val);
-    record1.i = val;
-    record1.d = val;
+void stringTests()
+{
+	// Create a relation of strings sharing a long prefix, index them with plain and compressed non-leaves,
+	// add and delete many more, and check compressed non-leaves make the tree shallower
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test compressed string keys" << std::endl;
+	createRelationStrings(relationSize);
+	int heights[2];
+	for(int format = 0; format < 2; format++){
+		heights[format] = intTestsStrings(format == 0 ? PLAIN_NONLEAVES : COMPRESSED_NONLEAVES);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	checkPassFail((heights[1] < heights[0]), true)
+	deleteRelation();
+}
 
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+void tableTests()
+{
+	// Insert tuples valued 0 to relationSize in random order into an index-organized table, which keeps
+	// them in its leaves, and scan them back in key order while the table shrinks, grows and is reopened
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test index-organized table" << std::endl;
+	for(int format = 0; format < 2; format++){
+		intTestsTable(format == 0 ? PLAIN_NONLEAVES : COUNTED_NONLEAVES);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+}
+
+void hashTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, build a hash index on it
+	// and look keys up while it grows well past its first buckets, shrinks and is reopened
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test hash index" << std::endl;
+	createRelationRandom();
+	intTestsHash();
+	try
+	{
+		File::remove(intIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	deleteRelation();
+}
+
+void bufferedTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, index it and insert keys
+	// past it through the insert buffer, checking reads see the buffered entries
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test buffered inserts" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 2; format++){
+		intTestsBuffered(format == 0 ? PLAIN_NONLEAVES : COUNTED_NONLEAVES);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
+}
+
+void staticTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, index it, freeze the index
+	// into a static tree and check the tree finds what the index does
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test static tree" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 2; format++){
+		intTestsStatic(format == 0 ? PLAIN_LEAVES : PACKED_LEAVES);
+		try
+		{
+			File::remove(intIndexName);
+			File::remove(relationName + ".static");
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
+}
+
+void learnedTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, index it, bulk load keys
+	// spread unevenly past it and check lookups through the learned model of the leaves
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test learned leaves" << std::endl;
+	createRelationRandom();
+	for(int format = 0; format < 2; format++){
+		intTestsLearned(format == 0 ? PLAIN_LEAVES : PACKED_LEAVES);
+		try
+		{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+	}
+	deleteRelation();
+}
+
+void bloomTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, index it with a Bloom filter
+	// and check lookups of keys it holds and does not hold, also after the index is reopened
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test bloom filter" << std::endl;
+	createRelationRandom();
+	intTestsBloom();
+	try
+	{
+		File::remove(intIndexName);
+		File::remove(intIndexName + ".bloom");
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	deleteRelation();
+}
+
+void concurrentTests()
+{
+	// Create a relation with tuples valued 0 to relationSize in random order, then
+	// insert and delete from several threads while scanning the index
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test concurrent" << std::endl;
+	createRelationRandom();
+	intTestsConcurrent();
+	try
+	{
+		File::remove(intIndexName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+	deleteRelation();
+}
+
+void testOneTree()
+{
+  std::cout << "---------------------" << std::endl;
+	std::cout << "test for one" << std::endl;
+	myCreateRelationRandom(500);
+	MyIndexTests(1);
+	deleteRelation();
+}
+
+// -----------------------------------------------------------------------------
+// createRelationForward
+// -----------------------------------------------------------------------------
+
+void createRelationForward()
+{
+	std::vector<RecordId> ridVec;
+  // destroy any old copies of relation file
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+
+  file1 = new PageFile(relationName, true);
+
+  // initialize all of record1.s to keep purify happy
+  memset(record1.s, ' ', sizeof(record1.s));
+	PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  // Insert a bunch of tuples into the relation.
+  for(int i = 0; i < relationSize; i++ )
+	{
+    sprintf(record1.s, "%05d string record", i);
+    record1.i = i;
+    record1.d = (double)i;
+    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
 
 		while(1)
 		{
@@ -393,31 +814,23 @@ void createRelationRandom()
 			}
 			catch(InsufficientSpaceException e)
 			{
-      	file1->writePage(new_page_number, new_page);
+				file1->writePage(new_page_number, new_page);
   			new_page = file1->allocatePage(new_page_number);
 			}
 		}
-
-		int temp = intvec[relationSize-1-i];
-		intvec[relationSize-1-i] = intvec[pos];
-		intvec[pos] = temp;
-		i++;
   }
-  
-  file1->writePage(new_page_number, new_page);
-}
 
+	file1->writePage(new_page_number, new_page);
+}
 
-// modified method
+//
 // -----------------------------------------------------------------------------
-// myCreateRelationRandom
+// myCreateRelationForward
 // -----------------------------------------------------------------------------
-
-void myCreateRelationRandom(int size){
+void myCreateRelationForward(int size){
 	int i = 0;
-	long pos;
-	int val;
 	
+	std::vector<RecordId> ridVec;
 	try{
 		File::remove(relationName);
 	}
@@ -427,19 +840,11 @@ void myCreateRelationRandom(int size){
 	memset(record1.s, ' ', sizeof(record1.s));
 	PageId new_page_number;
 	Page new_page = file1->allocatePage(new_page_number);
-	std::vector<int> intvec(relationSize);
-	while (i < size){
-		intvec[i] = i;
-		i++;
-	}
-	i = 0;
-	while( i < size ){
-		pos = random() % (size-i);
-		val = intvec[pos];
-		sprintf(record1.s, "%05d string record", val);
-		record1.i = val;
-		record1.d = val;
-		std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+	while(i < size){
+		sprintf(record1.s, "%05d string record", i);
+		record1.i = i;
+		record1.d = (double)i;
+		std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
 		while(1){
 			try{
 				new_page.insertRecord(new_data);
@@ -450,290 +855,3184 @@ void myCreateRelationRandom(int size){
 				new_page = file1->allocatePage(new_page_number);
 			}
 		}
-		int temp = intvec[size-1-i];
-		intvec[size-1-i] = intvec[pos];
-		intvec[pos] = temp;
 		i++;
 	}
 	file1->writePage(new_page_number, new_page);
 }
 
 // -----------------------------------------------------------------------------
-// indexTests
+// createRelationBackward
 // -----------------------------------------------------------------------------
 
-void indexTests()
+void createRelationBackward()
 {
-  if(testNum == 1)
-  {
-    intTests();
-		try
+  // destroy any old copies of relation file
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+  file1 = new PageFile(relationName, true);
+
+  // initialize all of record1.s to keep purify happy
+  memset(record1.s, ' ', sizeof(record1.s));
+	PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  // Insert a bunch of tuples into the relation.
+  for(int i = relationSize - 1; i >= 0; i-- )
+	{
+    sprintf(record1.s, "%05d string record", i);
+    record1.i = i;
+    record1.d = i;
+
+    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+
+		while(1)
 		{
-			File::remove(intIndexName);
+			try
+			{
+    		new_page.insertRecord(new_data);
+				break;
+			}
+			catch(InsufficientSpaceException e)
+			{
+				file1->writePage(new_page_number, new_page);
+  			new_page = file1->allocatePage(new_page_number);
+			}
 		}
-  	catch(FileNotFoundException e)
-  	{
-  	}
   }
+
+	file1->writePage(new_page_number, new_page);
+}
+
+// -----------------------------------------------------------------------------
+// createRelationRandom
+// -----------------------------------------------------------------------------
+
+void createRelationRandom()
+{
+  // destroy any old copies of relation file
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+  file1 = new PageFile(relationName, true);
+
+  // initialize all of record1.s to keep purify happy
+  memset(record1.s, ' ', sizeof(record1.s));
+	PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  // insert records in random order
+
+  std::vector<int> intvec(relationSize);
+  for( int i = 0; i < relationSize; i++ )
+  {
+    intvec[i] = i;
+  }
+
+  long pos;
+  int val;
+	int i = 0;
+  while( i < relationSize )
+  {
+    pos = random() % (relationSize-i);
+    val = intvec[pos];
+    sprintf(record1.s, "%05d string record", val);
+    record1.i = val;
+    record1.d = val;
+
+    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+
+		while(1)
+		{
+			try
+			{
+    		new_page.insertRecord(new_data);
+				break;
+			}
+			catch(InsufficientSpaceException e)
+			{
+      	file1->writePage(new_page_number, new_page);
+  			new_page = file1->allocatePage(new_page_number);
+			}
+		}
+
+		int temp = intvec[relationSize-1-i];
+		intvec[relationSize-1-i] = intvec[pos];
+		intvec[pos] = temp;
+		i++;
+  }
+  
+  file1->writePage(new_page_number, new_page);
+}
+
+// -----------------------------------------------------------------------------
+// createRelationComposite
+// -----------------------------------------------------------------------------
+
+void createRelationComposite(int size, int leadingValues)
+{
+  // destroy any old copies of relation file
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+  file1 = new PageFile(relationName, true);
+
+  memset(record1.s, ' ', sizeof(record1.s));
+	PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  // every i of the leadingValues from -25 up meets every d from -20 in steps of 0.5 once, s tells them apart
+  for(int val = size - 1; val >= 0; val--)
+  {
+    sprintf(record1.s, "%05d string record", val);
+    record1.i = val % leadingValues - 25;
+    record1.d = (val / leadingValues) * 0.5 - 20;
+
+    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+
+		while(1)
+		{
+			try
+			{
+    		new_page.insertRecord(new_data);
+				break;
+			}
+			catch(InsufficientSpaceException e)
+			{
+      	file1->writePage(new_page_number, new_page);
+  			new_page = file1->allocatePage(new_page_number);
+			}
+		}
+  }
+
+  file1->writePage(new_page_number, new_page);
+}
+
+// -----------------------------------------------------------------------------
+// createRelationStrings
+// -----------------------------------------------------------------------------
+
+void createRelationStrings(int size)
+{
+  // destroy any old copies of relation file
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+  file1 = new PageFile(relationName, true);
+
+	PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  // the strings look like paths of a web shop, sharing everything up to the customer number
+  for(int val = 0; val < size; val++)
+  {
+    memset(record1.s, 0, sizeof(record1.s));
+    sprintf(record1.s, "https://shop.example.com/customers/%08d/orders", val);
+    record1.i = val;
+    record1.d = val;
+
+    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+
+		while(1)
+		{
+			try
+			{
+    		new_page.insertRecord(new_data);
+				break;
+			}
+			catch(InsufficientSpaceException e)
+			{
+      	file1->writePage(new_page_number, new_page);
+  			new_page = file1->allocatePage(new_page_number);
+			}
+		}
+  }
+
+  file1->writePage(new_page_number, new_page);
+}
+
+// modified method
+// -----------------------------------------------------------------------------
+// myCreateRelationRandom
+// -----------------------------------------------------------------------------
+
+void myCreateRelationRandom(int size){
+	int i = 0;
+	long pos;
+	int val;
+	
+	try{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e){
+	}
+	file1 = new PageFile(relationName, true);
+	memset(record1.s, ' ', sizeof(record1.s));
+	PageId new_page_number;
+	Page new_page = file1->allocatePage(new_page_number);
+	std::vector<int> intvec(relationSize);
+	while (i < size){
+		intvec[i] = i;
+		i++;
+	}
+	i = 0;
+	while( i < size ){
+		pos = random() % (size-i);
+		val = intvec[pos];
+		sprintf(record1.s, "%05d string record", val);
+		record1.i = val;
+		record1.d = val;
+		std::string new_data(reinterpret_cast<char*>(&record1), sizeof(RECORD));
+		while(1){
+			try{
+				new_page.insertRecord(new_data);
+				break;
+			}
+			catch(InsufficientSpaceException e){
+				file1->writePage(new_page_number, new_page);
+				new_page = file1->allocatePage(new_page_number);
+			}
+		}
+		int temp = intvec[size-1-i];
+		intvec[size-1-i] = intvec[pos];
+		intvec[pos] = temp;
+		i++;
+	}
+	file1->writePage(new_page_number, new_page);
+}
+
+// -----------------------------------------------------------------------------
+// indexTests
+// -----------------------------------------------------------------------------
+
+void indexTests()
+{
+  if(testNum == 1)
+  {
+    intTests();
+		try
+		{
+			File::remove(intIndexName);
+		}
+  	catch(FileNotFoundException e)
+  	{
+  	}
+  }
+}
+
+// 
+// -----------------------------------------------------------------------------
+// MyIndexTests
+// -----------------------------------------------------------------------------
+void MyIndexTests(int input){
+	if(testNum == 1){
+		if(input == 0){
+			intTestsEmpty();
+		}
+		else if(input == 1){
+			intTestsOne();
+		}
+		try{
+			File::remove(intIndexName);
+		}
+		catch(FileNotFoundException e){
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// intTests
+// -----------------------------------------------------------------------------
+
+void intTests()
+{
+  std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	// run some tests
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(intScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(intScan(&index,0,GT,1,LT), 0)
+	checkPassFail(intScan(&index,300,GT,400,LT), 99)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+}
+
+// 
+// -----------------------------------------------------------------------------
+// intTestsEmpty
+// -----------------------------------------------------------------------------
+void intTestsEmpty(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+	
+	// run some tests
+	checkPassFail(intScan(&index,25,GT,40,LT), 0)
+	checkPassFail(intScan(&index,20,GTE,35,LTE), 0)
+	checkPassFail(intScan(&index,-3,GT,3,LT), 0)
+}
+
+// 
+// -----------------------------------------------------------------------------
+// intTestsOne
+// -----------------------------------------------------------------------------
+void intTestsOne(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	// run some tests
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
+}
+
+// 
+// -----------------------------------------------------------------------------
+// intTestsDelete
+// -----------------------------------------------------------------------------
+void intTestsDelete(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	// remember where every key lives in the relation
+	std::vector<RecordId> ridVec(relationSize);
+	{
+		FileScan fscan(relationName, bufMgr);
+		try{
+			RecordId scanRid;
+			while(1){
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				ridVec[((RECORD *)recordStr.c_str())->i] = scanRid;
+			}
+		}
+		catch(EndOfFileException e){
+		}
+	}
+
+	// delete every even key, leaves underflow and borrow or merge
+	for(int i = 0; i < relationSize; i += 2){
+		index.deleteEntry(&i, ridVec[i]);
+	}
+	checkPassFail(intScan(&index,25,GT,40,LT), 7)
+	checkPassFail(intScan(&index,20,GTE,35,LTE), 8)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 500)
+
+	std::cout << "Delete an entry that is not in the index" << std::endl;
+	try{
+		int zero = 0;
+		index.deleteEntry(&zero, ridVec[0]);
+		std::cout << "NoSuchKeyFoundException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(NoSuchKeyFoundException e){
+		std::cout << "NoSuchKeyFoundException Test Passed." << std::endl;
+	}
+
+	// delete the rest, the root collapses back into a single leaf
+	for(int i = 1; i < relationSize; i += 2){
+		index.deleteEntry(&i, ridVec[i]);
+	}
+	checkPassFail(intScan(&index,-1,GT,relationSize,LT), 0)
+
+	// repeated fill and drain cycles must reuse the freed pages
+	long size = 0;
+	for(int round = 0; round < 3; round++){
+		for(int i = 0; i < relationSize; i++){
+			index.insertEntry(&i, ridVec[i]);
+		}
+		for(int i = 0; i < relationSize; i++){
+			index.deleteEntry(&i, ridVec[i]);
+		}
+		if(round == 0){
+			size = indexFileSize();
+		}
+	}
+	checkPassFail(indexFileSize(), size)
+
+	for(int i = 0; i < relationSize; i++){
+		index.insertEntry(&i, ridVec[i]);
+	}
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+}
+
+// -----------------------------------------------------------------------------
+// intTestsCursors
+// -----------------------------------------------------------------------------
+void intTestsCursors(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	// nested loop join of the index with itself, probing while the outer scan is open
+	int low = 1000;
+	int high = 1100;
+	int outer = 0;
+	int matches = 0;
+	RecordId outerRid;
+	RecordId innerRid;
+	BTreeCursor outerScan = index.startScan(&low, GTE, &high, LT);
+	try{
+		while(1){
+			outerScan.scanNext(outerRid);
+			outer++;
+			int key = recordKey(outerRid);
+			int probeHigh = key + 1;
+			BTreeCursor probe = index.startScan(&key, GTE, &probeHigh, LT);
+			try{
+				while(1){
+					probe.scanNext(innerRid);
+					if(innerRid == outerRid){
+						matches++;
+					}
+				}
+			}
+			catch(IndexScanCompletedException e){
+			}
+		}
+	}
+	catch(IndexScanCompletedException e){
+	}
+	outerScan.endScan();
+	checkPassFail(outer, 100)
+	checkPassFail(matches, 100)
+
+	// two scans advanced in turns do not disturb each other
+	int low1 = 0;
+	int high1 = 500;
+	int low2 = 4000;
+	int high2 = 4500;
+	BTreeCursor first = index.startScan(&low1, GTE, &high1, LT);
+	BTreeCursor second = index.startScan(&low2, GTE, &high2, LT);
+	int firstCount = 0;
+	int secondCount = 0;
+	int outOfRange = 0;
+	bool firstDone = false;
+	bool secondDone = false;
+	while(!firstDone || !secondDone){
+		try{
+			if(!firstDone){
+				first.scanNext(outerRid);
+				firstCount++;
+				outOfRange += recordKey(outerRid) >= high1;
+			}
+		}
+		catch(IndexScanCompletedException e){
+			firstDone = true;
+		}
+		try{
+			if(!secondDone){
+				second.scanNext(outerRid);
+				secondCount++;
+				outOfRange += recordKey(outerRid) < low2;
+			}
+		}
+		catch(IndexScanCompletedException e){
+			secondDone = true;
+		}
+	}
+	checkPassFail(firstCount, 500)
+	checkPassFail(secondCount, 500)
+	checkPassFail(outOfRange, 0)
+
+	// a moved cursor carries on where the scan was
+	BTreeCursor moved = std::move(first);
+	try{
+		first.scanNext(outerRid);
+		std::cout << "ScanNotInitializedException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(ScanNotInitializedException e){
+		std::cout << "ScanNotInitializedException Test Passed." << std::endl;
+	}
+	moved.endScan();
+	second.endScan();
+	BTreeCursor restarted = index.startScan(&low1, GT, &high1, LTE);
+	moved = std::move(restarted);
+	int count = 0;
+	try{
+		while(1){
+			moved.scanNext(outerRid);
+			count++;
+		}
+	}
+	catch(IndexScanCompletedException e){
+	}
+	checkPassFail(count, 500)
+
+	// batches copy whole runs out of the leaves and end without an exception
+	checkPassFail(batchScan(&index,25,GT,40,LT,4), 14)
+	checkPassFail(batchScan(&index,0,GTE,relationSize,LT,1000), relationSize)
+	checkPassFail(batchScan(&index,0,GTE,relationSize,LT,1), relationSize)
+	checkPassFail(batchScan(&index,relationSize,GT,relationSize+10,LTE,100), 0)
+
+	// point lookups and equality scans
+	std::vector<RecordId> rids;
+	int key = 1234;
+	checkPassFail(index.lookup(&key, rids), 1)
+	checkPassFail(recordKey(rids[0]), 1234)
+	key = relationSize;
+	checkPassFail(index.lookup(&key, rids), 0)
+	checkPassFail(rids.size(), 1)
+	key = 4321;
+	checkPassFail(intScan(&index,key,EQ,key,EQ), 1)
+	try{
+		int other = key + 1;
+		index.startScan(&key, EQ, &other, EQ);
+		std::cout << "BadScanrangeException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadScanrangeException e){
+		std::cout << "BadScanrangeException Test Passed." << std::endl;
+	}
+	try{
+		index.startScan(&key, EQ, &key, LTE);
+		std::cout << "BadOpcodesException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadOpcodesException e){
+		std::cout << "BadOpcodesException Test Passed." << std::endl;
+	}
+
+	// duplicates of a key spread over several leaves
+	key = -5;
+	const int duplicates = 2 * INTARRAYLEAFSIZE + 100;
+	for(int i = 0; i < duplicates; i++){
+		RecordId dupRid;
+		dupRid.page_number = i + 1;
+		dupRid.slot_number = 0;
+		index.insertEntry(&key, dupRid);
+	}
+	rids.clear();
+	checkPassFail(index.lookup(&key, rids), duplicates)
+	std::vector<bool> seen(duplicates + 1);
+	int distinct = 0;
+	for(int i = 0; i < duplicates; i++){
+		if(!seen[rids[i].page_number]){
+			seen[rids[i].page_number] = true;
+			distinct++;
+		}
+	}
+	checkPassFail(distinct, duplicates)
+	for(int i = 0; i < duplicates; i++){
+		index.deleteEntry(&key, rids[i]);
+	}
+	checkPassFail(index.lookup(&key, rids), 0)
+}
+
+// -----------------------------------------------------------------------------
+// intTestsPostings
+// -----------------------------------------------------------------------------
+void intTestsPostings(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+	long size = indexFileSize();
+
+	// keys 1 to 4 get duplicates on pages past the relation, inserted out of record id order
+	const int keys = 4;
+	const int duplicates = 3000;
+	std::vector<RecordId> dupRids(duplicates);
+	for(int i = 0; i < duplicates; i++){
+		dupRids[i].page_number = relationSize + 1 + (i * 7919) % duplicates;
+		dupRids[i].slot_number = 1 + i % 3;
+	}
+	for(int key = 1; key <= keys; key++){
+		for(int i = 0; i < duplicates; i++){
+			index.insertEntry(&key, dupRids[i]);
+		}
+	}
+	// inline the duplicates would take more than twenty leaves
+	checkPassFail(((indexFileSize() - size) / Page::SIZE <= keys * 2), true)
+
+	int key = 3;
+	std::vector<RecordId> rids;
+	checkPassFail(index.lookup(&key, rids), duplicates + 1)
+	checkPassFail(entryCount(&index, key, key, 0), duplicates + 1)
+	checkPassFail(entryCount(&index, 0, 10, 0), 11 + keys * duplicates)
+	checkPassFail(entryCount(&index, 0, 10, 1000), 11 + keys * duplicates)
+	checkPassFail(entryCount(&index, 2, 4, 7), 3 + 3 * duplicates)
+	checkPassFail(intScan(&index,5,GTE,20,LT), 15)
+
+	// drain one list, its record in the relation stays
+	key = 2;
+	for(int i = 0; i < duplicates; i += 2){
+		index.deleteEntry(&key, dupRids[i]);
+	}
+	rids.clear();
+	checkPassFail(index.lookup(&key, rids), duplicates/2 + 1)
+	for(int i = 1; i < duplicates; i += 2){
+		index.deleteEntry(&key, dupRids[i]);
+	}
+	rids.clear();
+	checkPassFail(index.lookup(&key, rids), 1)
+	checkPassFail(recordKey(rids[0]), key)
+	try{
+		index.deleteEntry(&key, dupRids[0]);
+		std::cout << "NoSuchKeyFoundException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(NoSuchKeyFoundException e){
+		std::cout << "NoSuchKeyFoundException Test Passed." << std::endl;
+	}
+
+	// the pages of drained lists are reused
+	for(key = 1; key <= keys; key++){
+		for(int i = 0; i < duplicates; i++){
+			if(key != 2){
+				index.deleteEntry(&key, dupRids[i]);
+			}
+		}
+	}
+	long drained = indexFileSize();
+	checkPassFail(entryCount(&index, 0, 10, 0), 11)
+	for(key = 1; key <= keys; key++){
+		for(int i = 0; i < duplicates; i++){
+			index.insertEntry(&key, dupRids[i]);
+		}
+	}
+	checkPassFail(indexFileSize(), drained)
+	checkPassFail(entryCount(&index, 0, relationSize, 100), relationSize + keys * duplicates)
+}
+
+// -----------------------------------------------------------------------------
+// intTestsPacked
+// -----------------------------------------------------------------------------
+void intTestsPacked(){
+	// entries past the relation, with keys that are dense but arrive in random order
+	const int extra = 50000;
+	std::vector<int> keys(extra);
+	for(int i = 0; i < extra; i++){
+		keys[i] = relationSize + i;
+	}
+	std::random_shuffle(keys.begin(), keys.end());
+	std::vector<RecordId> extraRids(extra);
+	for(int i = 0; i < extra; i++){
+		extraRids[i].page_number = 1000 + keys[i] / 100;
+		extraRids[i].slot_number = 1 + keys[i] % 100;
+	}
+
+	long plainSize;
+	{
+		std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		for(int i = 0; i < extra; i++){
+			index.insertEntry(&keys[i], extraRids[i]);
+		}
+		plainSize = indexFileSize();
+	}
+	File::remove(intIndexName);
+
+	std::cout << "Create a B+ Tree index with packed leaves on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, PACKED_LEAVES);
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(intScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(intScan(&index,0,GT,1,LT), 0)
+	checkPassFail(intScan(&index,300,GT,400,LT), 99)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	checkPassFail(batchScan(&index,300,GT,4000,LTE,64), 3700)
+	int key = 4321;
+	std::vector<RecordId> rids;
+	checkPassFail(index.lookup(&key, rids), 1)
+	checkPassFail(recordKey(rids[0]), key)
+
+	for(int i = 0; i < extra; i++){
+		index.insertEntry(&keys[i], extraRids[i]);
+	}
+	// a packed entry takes about a quarter of a plain one
+	checkPassFail((indexFileSize() * 2 <= plainSize), true)
+	checkPassFail(entryCount(&index, 0, relationSize + extra, 0), relationSize + extra)
+	checkPassFail(entryCount(&index, 0, relationSize + extra, 1000), relationSize + extra)
+	checkPassFail(entryCount(&index, relationSize + 100, relationSize + 30099, 7), 30000)
+	key = relationSize + 12345;
+	rids.clear();
+	checkPassFail(index.lookup(&key, rids), 1)
+	checkPassFail(rids[0].page_number, (PageId)(1000 + key / 100))
+
+	// duplicates stay in the leaves
+	key = 7;
+	for(int i = 0; i < 2000; i++){
+		index.insertEntry(&key, extraRids[i]);
+	}
+	checkPassFail(entryCount(&index, key, key, 0), 2001)
+	for(int i = 0; i < 2000; i++){
+		index.deleteEntry(&key, extraRids[i]);
+	}
+
+	for(int i = 0; i < extra; i += 2){
+		index.deleteEntry(&keys[i], extraRids[i]);
+	}
+	checkPassFail(entryCount(&index, relationSize, relationSize + extra, 100), extra/2)
+	for(int i = 1; i < extra; i += 2){
+		index.deleteEntry(&keys[i], extraRids[i]);
+	}
+	checkPassFail(entryCount(&index, 0, relationSize + extra, 100), relationSize)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	try{
+		index.deleteEntry(&keys[0], extraRids[0]);
+		std::cout << "NoSuchKeyFoundException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(NoSuchKeyFoundException e){
+		std::cout << "NoSuchKeyFoundException Test Passed." << std::endl;
+	}
+
+	// the leaf format is part of what the index file has to match
+	try{
+		std::string otherName;
+		BTreeIndex plain(relationName, otherName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::cout << "BadIndexInfoException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadIndexInfoException e){
+		std::cout << "BadIndexInfoException Test Passed." << std::endl;
+	}
+}
+
+void intTestsAppend(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+	const int extra = 50000;
+	const int total = relationSize + extra;
+	RecordId rid;
+	for(int key = relationSize; key < total; key++){
+		rid.page_number = 1000 + key / 100;
+		rid.slot_number = 1 + key % 100;
+		index.insertEntry(&key, rid);
+	}
+	// every leaf but the last one is full, plus the header and the root
+	checkPassFail((indexFileSize() / Page::SIZE <= total / INTARRAYLEAFSIZE + 3), true)
+	checkPassFail(entryCount(&index, 0, total, 100), total)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	checkPassFail(entryCount(&index, total - 1000, total - 1, 0), 1000)
+	int key = relationSize + 12345;
+	std::vector<RecordId> rids;
+	checkPassFail(index.lookup(&key, rids), 1)
+	checkPassFail(rids[0].page_number, (PageId)(1000 + key / 100))
+
+	// the rightmost leaves are merged away and their pages reused by the next appends
+	for(key = total - 1; key >= relationSize; key--){
+		rid.page_number = 1000 + key / 100;
+		rid.slot_number = 1 + key % 100;
+		index.deleteEntry(&key, rid);
+	}
+	checkPassFail(entryCount(&index, 0, total, 100), relationSize)
+	for(key = relationSize; key < total; key++){
+		rid.page_number = 1000 + key / 100;
+		rid.slot_number = 1 + key % 100;
+		index.insertEntry(&key, rid);
+	}
+	checkPassFail(entryCount(&index, 0, total, 100), total)
+	checkPassFail(entryCount(&index, total - 10, total - 1, 0), 10)
+	checkPassFail(entryCount(&index, relationSize - 5, relationSize + 4, 3), 10)
+}
+
+void intTestsInsertBatch(LeafFormat leafFormat){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, leafFormat);
+
+	// batches of shuffled keys past the relation, the last one also holding duplicates of a relation key
+	const int extra = 50000;
+	const int batchSize = 1000;
+	const int duplicates = 300;
+	std::vector<RIDKeyPair<int> > entries(extra + duplicates);
+	for(int i = 0; i < extra; i++){
+		int key = relationSize + i;
+		RecordId rid;
+		rid.page_number = 1000 + key / 100;
+		rid.slot_number = 1 + key % 100;
+		entries[i].set(rid, key);
+	}
+	for(int i = 0; i < duplicates; i++){
+		RecordId rid;
+		rid.page_number = 2000 + i;
+		rid.slot_number = 1;
+		entries[extra + i].set(rid, 42);
+	}
+	std::random_shuffle(entries.begin(), entries.begin() + extra);
+	std::random_shuffle(entries.begin() + extra - batchSize, entries.end());
+	for(int i = 0; i < extra + duplicates; i += batchSize){
+		index.insertBatch(&entries[i], std::min(batchSize, extra + duplicates - i));
+	}
+
+	checkPassFail(entryCount(&index, 0, relationSize + extra, 100), relationSize + extra + duplicates)
+	checkPassFail(entryCount(&index, relationSize, relationSize + extra, 0), extra)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	int key = relationSize + 12345;
+	std::vector<RecordId> rids;
+	checkPassFail(index.lookup(&key, rids), 1)
+	checkPassFail(rids[0].page_number, (PageId)(1000 + key / 100))
+	key = 42;
+	rids.clear();
+	checkPassFail(index.lookup(&key, rids), 1 + duplicates)
+
+	// a batch in key order appends to the last leaves
+	std::vector<RIDKeyPair<int> > tail(batchSize);
+	for(int i = 0; i < batchSize; i++){
+		RecordId rid;
+		rid.page_number = 3000 + i;
+		rid.slot_number = 1;
+		tail[i].set(rid, relationSize + extra + i);
+	}
+	index.insertBatch(&tail[0], batchSize);
+	checkPassFail(entryCount(&index, relationSize + extra, relationSize + extra + batchSize, 7), batchSize)
+}
+
+// -----------------------------------------------------------------------------
+// entryCount
+// -----------------------------------------------------------------------------
+int entryCount(BTreeIndex *index, int lowVal, int highVal, size_t batchSize)
+{
+	// count the entries of [lowVal, highVal] without reading records, one at a time for batchSize 0
+	BTreeCursor scan = index->openScan(&lowVal, GTE, &highVal, LTE);
+	int numResults = 0;
+	if(batchSize == 0){
+		RecordId scanRid;
+		try{
+			while(1){
+				scan.scanNext(scanRid);
+				numResults++;
+			}
+		}
+		catch(IndexScanCompletedException e){
+		}
+		return numResults;
+	}
+	std::vector<RecordId> batch(batchSize);
+	size_t n;
+	while((n = scan.nextBatch(&batch[0], batchSize)) > 0){
+		numResults += n;
+	}
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// batchScan
+// -----------------------------------------------------------------------------
+int batchScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize)
+{
+	// count the entries of a range fetched batchSize at a time, -1 if one is out of range
+	std::vector<RecordId> batch(batchSize);
+	BTreeCursor scan = index->openScan(&lowVal, lowOp, &highVal, highOp);
+	int numResults = 0;
+	size_t n;
+	while((n = scan.nextBatch(&batch[0], batchSize)) > 0){
+		for(size_t i = 0; i < n; i++){
+			int key = recordKey(batch[i]);
+			if((lowOp == GT && key <= lowVal) || key < lowVal || (highOp == LT && key >= highVal) || key > highVal){
+				return -1;
+			}
+		}
+		numResults += n;
+	}
+	scan.endScan();
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// recordKey
+// -----------------------------------------------------------------------------
+int recordKey(RecordId rid){
+	Page *curPage;
+	bufMgr->readPage(file1, rid.page_number, curPage);
+	RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(rid).data()));
+	bufMgr->unPinPage(file1, rid.page_number, false);
+	return myRec.i;
+}
+
+// -----------------------------------------------------------------------------
+// intTestsConcurrent
+// -----------------------------------------------------------------------------
+void intTestsConcurrent(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	std::vector<RecordId> ridVec(relationSize);
+	{
+		FileScan fscan(relationName, bufMgr);
+		try{
+			RecordId scanRid;
+			while(1){
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				ridVec[((RECORD *)recordStr.c_str())->i] = scanRid;
+			}
+		}
+		catch(EndOfFileException e){
+		}
+	}
+	for(int i = 0; i < relationSize; i += 2){
+		index.deleteEntry(&i, ridVec[i]);
+	}
+
+	// every writer owns a stripe of the even keys, inserts it and deletes half of it again,
+	// while the odd keys stay put and every scan has to see all of them exactly once
+	const int writers = 4;
+	std::atomic<int> finished(0);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < writers; t++){
+		threads.push_back(std::thread([&index, &ridVec, &finished, t, writers](){
+			for(int round = 0; round < 3; round++){
+				for(int i = 2*t; i < relationSize; i += 2*writers){
+					if(round == 0 || i % 4 == 2){
+						index.insertEntry(&i, ridVec[i]);
+					}
+				}
+				for(int i = 2*t; i < relationSize; i += 2*writers){
+					if(i % 4 == 2){
+						index.deleteEntry(&i, ridVec[i]);
+					}
+				}
+			}
+			finished++;
+		}));
+	}
+	// a second reader scans the upper half and looks up the odd keys alongside the main thread
+	std::atomic<int> badScans(0);
+	threads.push_back(std::thread([&index, &ridVec, &finished, &badScans, writers](){
+		std::vector<RecordId> rids;
+		do{
+			if(oddScan(&index, relationSize/2, relationSize) != relationSize/4){
+				badScans++;
+			}
+			for(int i = 1; i < relationSize; i += 2){
+				rids.clear();
+				if(index.lookup(&i, rids) != 1 || rids[0] != ridVec[i]){
+					badScans++;
+				}
+			}
+		}while(finished < writers);
+	}));
+	int scans = 0;
+	do{
+		if(oddScan(&index, 0, relationSize) != relationSize/2){
+			badScans++;
+		}
+		scans++;
+	}while(finished < writers);
+	for(size_t t = 0; t < threads.size(); t++){
+		threads[t].join();
+	}
+	std::cout << "Scans while writing: " << scans << std::endl;
+	checkPassFail(badScans.load(), 0)
+	checkPassFail(intScan(&index,-1,GT,relationSize,LT), relationSize/2 + relationSize/4)
+	checkPassFail(intScan(&index,25,GT,40,LT), 10)
+	checkPassFail(oddScan(&index, 3000, 4000), 500)
+}
+
+// -----------------------------------------------------------------------------
+// oddScan
+// -----------------------------------------------------------------------------
+int oddScan(BTreeIndex * index, int lowVal, int highVal)
+{
+	// count the records with an odd key in [lowVal,highVal), reading them from the relation
+	RecordId scanRid;
+	Page *curPage;
+	int numResults = 0;
+	BTreeCursor scan;
+	try
+	{
+		scan = index->startScan(&lowVal, GTE, &highVal, LT);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+		return 0;
+	}
+	try
+	{
+		while(1)
+		{
+			scan.scanNext(scanRid);
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+			if(myRec.i % 2 == 1){
+				numResults++;
+			}
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	scan.endScan();
+	return numResults;
+}
+
+// -----------------------------------------------------------------------------
+// indexFileSize
+// -----------------------------------------------------------------------------
+long indexFileSize(){
+	std::ifstream indexFile(intIndexName.c_str(), std::ios::binary | std::ios::ate);
+	return indexFile.tellg();
+}
+
+int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+  RecordId scanRid;
+	Page *curPage;
+
+  std::cout << "Scan for ";
+  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
+  std::cout << lowVal << "," << highVal;
+  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
+  std::cout << std::endl;
+
+  int numResults = 0;
+	BTreeCursor scan;
+	
+	try
+	{
+  	scan = index->startScan(&lowVal, lowOp, &highVal, highOp);
+	}
+	catch(NoSuchKeyFoundException e)
+	{
+    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
+		return 0;
+	}
+
+	while(1)
+	{
+		try
+		{
+			scan.scanNext(scanRid);
+			bufMgr->readPage(file1, scanRid.page_number, curPage);
+			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
+			bufMgr->unPinPage(file1, scanRid.page_number, false);
+
+			if( numResults < 5 )
+			{
+				std::cout << "at:" << scanRid.page_number << "," << scanRid.slot_number;
+				std::cout << " -->:" << myRec.i << ":" << myRec.d << ":" << myRec.s << ":" <<std::endl;
+			}
+			else if( numResults == 5 )
+			{
+				std::cout << "..." << std::endl;
+			}
+		}
+		catch(IndexScanCompletedException e)
+		{
+			break;
+		}
+
+		numResults++;
+	}
+
+  if( numResults >= 5 )
+  {
+    std::cout << "Number of results: " << numResults << std::endl;
+  }
+  scan.endScan();
+  std::cout << std::endl;
+
+	return numResults;
+}
+
+
+// -----------------------------------------------------------------------------
+// errorTests
+// -----------------------------------------------------------------------------
+
+void errorTests()
+{
+	std::cout << "Error handling tests" << std::endl;
+	std::cout << "--------------------" << std::endl;
+	// Given error test
+
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+
+  file1 = new PageFile(relationName, true);
+	
+  // initialize all of record1.s to keep purify happy
+  memset(record1.s, ' ', sizeof(record1.s));
+	PageId new_page_number;
+  Page new_page = file1->allocatePage(new_page_number);
+
+  // Insert a bunch of tuples into the relation.
+	for(int i = 0; i <10; i++ )
+	{
+    sprintf(record1.s, "%05d string record", i);
+    record1.i = i;
+    record1.d = (double)i;
+    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
+
+		while(1)
+		{
+			try
+			{
+    		new_page.insertRecord(new_data);
+				break;
+			}
+			catch(InsufficientSpaceException e)
+			{
+				file1->writePage(new_page_number, new_page);
+  			new_page = file1->allocatePage(new_page_number);
+			}
+		}
+  }
+
+	file1->writePage(new_page_number, new_page);
+
+  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	int int2 = 2;
+	int int5 = 5;
+
+	// Scan Tests
+	std::cout << "Call endScan before startScan" << std::endl;
+	try
+	{
+		BTreeCursor scan;
+		scan.endScan();
+		std::cout << "ScanNotInitialized Test 1 Failed." << std::endl;
+	}
+	catch(ScanNotInitializedException e)
+	{
+		std::cout << "ScanNotInitialized Test 1 Passed." << std::endl;
+	}
+
+	std::cout << "Call scanNext before startScan" << std::endl;
+	try
+	{
+		RecordId foo;
+		BTreeCursor scan;
+		scan.scanNext(foo);
+		std::cout << "ScanNotInitialized Test 2 Failed." << std::endl;
+	}
+	catch(ScanNotInitializedException e)
+	{
+		std::cout << "ScanNotInitialized Test 2 Passed." << std::endl;
+	}
+
+	std::cout << "Scan with bad lowOp" << std::endl;
+	try
+	{
+  	index.startScan(&int2, LTE, &int5, LTE);
+		std::cout << "BadOpcodesException Test 1 Failed." << std::endl;
+	}
+	catch(BadOpcodesException e)
+	{
+		std::cout << "BadOpcodesException Test 1 Passed." << std::endl;
+	}
+
+	std::cout << "Scan with bad highOp" << std::endl;
+	try
+	{
+  	index.startScan(&int2, GTE, &int5, GTE);
+		std::cout << "BadOpcodesException Test 2 Failed." << std::endl;
+	}
+	catch(BadOpcodesException e)
+	{
+		std::cout << "BadOpcodesException Test 2 Passed." << std::endl;
+	}
+
+
+	std::cout << "Scan with bad range" << std::endl;
+	try
+	{
+  	index.startScan(&int5, GTE, &int2, LTE);
+		std::cout << "BadScanrangeException Test 1 Failed." << std::endl;
+	}
+	catch(BadScanrangeException e)
+	{
+		std::cout << "BadScanrangeException Test 1 Passed." << std::endl;
+	}
+
+	std::cout << "Index over a string attribute" << std::endl;
+	try
+	{
+		std::string stringIndexName;
+		BTreeIndex stringIndex(relationName, stringIndexName, bufMgr, offsetof(tuple,s), STRING);
+		std::cout << "BadIndexInfoException Test 2 Failed." << std::endl;
+	}
+	catch(BadIndexInfoException e)
+	{
+		std::cout << "BadIndexInfoException Test 2 Passed." << std::endl;
+	}
+
+	std::cout << "Index over no attributes" << std::endl;
+	try
+	{
+		std::string emptyIndexName;
+		BTreeIndex emptyIndex(relationName, emptyIndexName, bufMgr, std::vector<KeyAttr>());
+		std::cout << "BadIndexInfoException Test 3 Failed." << std::endl;
+	}
+	catch(BadIndexInfoException e)
+	{
+		std::cout << "BadIndexInfoException Test 3 Passed." << std::endl;
+	}
+
+	std::cout << "Index file in another layout" << std::endl;
+	{
+		std::string otherIndexName;
+		{
+			BTreeIndex otherIndex(relationName, otherIndexName, bufMgr, offsetof(tuple,d), INTEGER);
+		}
+		// what a file from before the meta page had a magic word looks like
+		{
+			BlobFile otherFile = BlobFile::open(otherIndexName);
+			Page meta = otherFile.readPage(otherFile.getFirstPageNo());
+			((IndexMetaInfo *)&meta)->magic = 0;
+			otherFile.writePage(otherFile.getFirstPageNo(), meta);
+		}
+		try
+		{
+			BTreeIndex otherIndex(relationName, otherIndexName, bufMgr, offsetof(tuple,d), INTEGER);
+			std::cout << "BadIndexInfoException Test 4 Failed." << std::endl;
+		}
+		catch(BadIndexInfoException e)
+		{
+			std::cout << "BadIndexInfoException Test 4 Passed." << std::endl;
+		}
+		File::remove(otherIndexName);
+	}
+
+	std::cout << "Delete a free page again" << std::endl;
+	{
+		const std::string blobName = relationName + ".blob";
+		try
+		{
+			File::remove(blobName);
+		}
+		catch(FileNotFoundException e)
+		{
+		}
+		BlobFile blob = BlobFile::create(blobName);
+		PageId first, second, third;
+		blob.allocatePage(first);
+		blob.allocatePage(second);
+		blob.allocatePage(third);
+		blob.deletePage(second);
+		try
+		{
+			blob.deletePage(second);
+			std::cout << "InvalidPageException Test 1 Failed." << std::endl;
+		}
+		catch(InvalidPageException e)
+		{
+			std::cout << "InvalidPageException Test 1 Passed." << std::endl;
+		}
+		blob.deletePage(third);
+		try
+		{
+			blob.deletePage(second);
+			std::cout << "InvalidPageException Test 2 Failed." << std::endl;
+		}
+		catch(InvalidPageException e)
+		{
+			std::cout << "InvalidPageException Test 2 Passed." << std::endl;
+		}
+		// each freed page is handed out once
+		PageId reused, again;
+		blob.allocatePage(reused);
+		blob.allocatePage(again);
+		checkPassFail((reused != again && reused != first && again != first), true)
+	}
+	File::remove(relationName + ".blob");
+
+	deleteRelation();
+}
+
+void deleteRelation()
+{
+	if(file1)
+	{
+		bufMgr->flushFile(file1);
+		delete file1;
+		file1 = NULL;
+	}
+	try
+	{
+		File::remove(relationName);
+	}
+	catch(FileNotFoundException e)
+	{
+	}
+}
+
+void intTestsPinned(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	const int total = 30000;
+	RecordId rid;
+	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		// a root leaf is never pinned
+		checkPassFail(index.pinUpperLevels(2), 0)
+		for(int round = 0; round < 2; round++){
+			for(int i = 0; i < total; i++){
+				int key = (int)((i * 7919L) % total);
+				rid.page_number = 1000 + key / 100;
+				rid.slot_number = 1 + key % 100;
+				index.insertEntry(&key, rid);
+			}
+			checkPassFail(index.height(), 2)
+			checkPassFail(entryCount(&index, 0, total, 100), total)
+			int key = 12345;
+			std::vector<RecordId> rids;
+			checkPassFail(index.lookup(&key, rids), 1)
+			checkPassFail(rids[0].page_number, (PageId)(1000 + key / 100))
+			if(round == 1){
+				break;
+			}
+			// the root collapses back into a leaf and its pinned page is freed
+			for(int i = 0; i < total; i++){
+				int key = (int)((i * 7919L) % total);
+				rid.page_number = 1000 + key / 100;
+				rid.slot_number = 1 + key % 100;
+				index.deleteEntry(&key, rid);
+			}
+			checkPassFail(index.height(), 1)
+			checkPassFail(entryCount(&index, 0, total, 100), 0)
+		}
+	}
+
+	// the pinned root was written back when the index was closed
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+	checkPassFail(index.pinUpperLevels(5), 1)
+	checkPassFail(entryCount(&index, 0, total, 100), total)
+	checkPassFail(entryCount(&index, total - 10, total - 1, 0), 10)
+	checkPassFail(index.pinUpperLevels(0), 0)
+	checkPassFail(entryCount(&index, 0, total, 7), total)
+}
+
+void intTestsSwizzle(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	const int total = 60000;
+	RecordId rid;
+	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		for(int i = 0; i < total; i++){
+			int key = (int)((i * 7919L) % total);
+			rid.page_number = 1000 + key / 100;
+			rid.slot_number = 1 + key % 100;
+			index.insertEntry(&key, rid);
+		}
+		// the leaves outnumber the frames, so lookups keep swizzling and evicting them
+		std::vector<RecordId> rids;
+		int found = 0;
+		for(int round = 0; round < 2; round++){
+			for(int i = 0; i < total; i++){
+				int key = (int)((i * 104729L) % total);
+				rids.clear();
+				found += index.lookup(&key, rids) == 1 && rids[0].page_number == (PageId)(1000 + key / 100);
+			}
+		}
+		checkPassFail(found, 2 * total)
+
+		// merges and redistributions move swizzled references between nodes
+		for(int key = 0; key < total; key += 2){
+			rid.page_number = 1000 + key / 100;
+			rid.slot_number = 1 + key % 100;
+			index.deleteEntry(&key, rid);
+		}
+		checkPassFail(entryCount(&index, 0, total, 100), total / 2)
+		index.swizzleChildren(false);
+		checkPassFail(entryCount(&index, 0, total, 7), total / 2)
+		index.swizzleChildren(true);
+		checkPassFail(entryCount(&index, 1000, 2000, 0), 500)
+	}
+
+	// only page numbers were written to the index file
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+	checkPassFail(entryCount(&index, 0, total, 100), total / 2)
+	checkPassFail(entryCount(&index, total - 1000, total, 0), 500)
+}
+
+void intTestsBlocked(){
+	std::cout << "Create a B+ Tree index with blocked non-leaves on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES, BLOCKED_NONLEAVES);
+	checkPassFail(intScan(&index,25,GT,40,LT), 14)
+	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
+	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
+	checkPassFail(intScan(&index,996,GT,1001,LT), 4)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+
+	// enough out of order entries for the root to fill several lines of its directory
+	const int extra = 150000;
+	std::vector<int> keys(extra);
+	for(int i = 0; i < extra; i++){
+		keys[i] = relationSize + i;
+	}
+	std::random_shuffle(keys.begin(), keys.end());
+	RecordId rid;
+	for(int i = 0; i < extra; i++){
+		rid.page_number = 1000 + keys[i] / 100;
+		rid.slot_number = 1 + keys[i] % 100;
+		index.insertEntry(&keys[i], rid);
+	}
+	int found = 0;
+	std::vector<RecordId> rids;
+	for(int key = 0; key < relationSize + extra; key++){
+		rids.clear();
+		found += index.lookup(&key, rids) == 1;
+	}
+	checkPassFail(found, relationSize + extra)
+
+	// appended in batches until the non-leaves split
+	const int batch = 10000;
+	const int appended = 800000;
+	std::vector<RIDKeyPair<int> > entries(batch);
+	for(int first = relationSize + extra; first < relationSize + extra + appended; first += batch){
+		for(int i = 0; i < batch; i++){
+			rid.page_number = 1000 + (first + i) / 100;
+			rid.slot_number = 1 + (first + i) % 100;
+			entries[i].set(rid, first + i);
+		}
+		index.insertBatch(&entries[0], batch);
+	}
+	const int total = relationSize + extra + appended;
+	checkPassFail(entryCount(&index, 0, total, 1000), total)
+	found = 0;
+	for(int key = 0; key < total; key += 7){
+		rids.clear();
+		found += index.lookup(&key, rids) == 1 && (key < relationSize || rids[0].page_number == (PageId)(1000 + key / 100));
+	}
+	checkPassFail(found, (total + 6) / 7)
+
+	// deletes from the front borrow from and merge with siblings, down to the root
+	for(int key = relationSize; key < relationSize + extra + appended - 1000; key++){
+		rid.page_number = 1000 + key / 100;
+		rid.slot_number = 1 + key % 100;
+		index.deleteEntry(&key, rid);
+	}
+	checkPassFail(entryCount(&index, 0, total, 0), relationSize + 1000)
+	checkPassFail(entryCount(&index, total - 1000, total, 100), 1000)
+	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	int key = total - 1;
+	rids.clear();
+	checkPassFail(index.lookup(&key, rids), 1)
+
+	// the non-leaf format is part of what the index file has to match
+	try{
+		std::string otherName;
+		BTreeIndex plain(relationName, otherName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::cout << "BadIndexInfoException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadIndexInfoException e){
+		std::cout << "BadIndexInfoException Test Passed." << std::endl;
+	}
+}
+
+void intTestsLookupBatch(NonLeafFormat nonLeafFormat){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES, nonLeafFormat);
+	// keys past the relation in random order, and runs of duplicates that span leaves or go to posting lists
+	const int extra = 100000;
+	std::vector<int> keys(extra);
+	for(int i = 0; i < extra; i++){
+		keys[i] = relationSize + i;
+	}
+	std::random_shuffle(keys.begin(), keys.end());
+	RecordId rid;
+	for(int i = 0; i < extra; i++){
+		rid.page_number = 1000 + keys[i] / 100;
+		rid.slot_number = 1 + keys[i] % 100;
+		index.insertEntry(&keys[i], rid);
+	}
+	for(int i = 0; i < 3000; i++){
+		int key = i < 1000 ? 17 : 4000;
+		rid.page_number = 5000 + i;
+		rid.slot_number = 1;
+		index.insertEntry(&key, rid);
+	}
+
+	// probes mix hits, duplicates and misses below, between and above the keys
+	std::vector<int> probes;
+	for(int i = 0; i < 2000; i++){
+		probes.push_back((int)((i * 7919L) % (relationSize + extra + 200)) - 100);
+		if(i % 100 == 0){
+			probes.push_back(i % 200 == 0 ? 17 : 4000);
+		}
+	}
+	std::vector<RecordId> expected;
+	std::vector<size_t> expectedEnds;
+	for(size_t i = 0; i < probes.size(); i++){
+		index.lookup(&probes[i], expected);
+		expectedEnds.push_back(expected.size());
+	}
+	size_t sizes[] = {1, 2, 7, 64, 65, 200, probes.size()};
+	int matches = 0;
+	for(int s = 0; s < 7; s++){
+		std::vector<RecordId> rids;
+		std::vector<size_t> ends(probes.size());
+		size_t found = 0;
+		for(size_t first = 0; first < probes.size(); first += sizes[s]){
+			size_t count = std::min(sizes[s], probes.size() - first);
+			found += index.lookupBatch(&probes[first], count, rids, &ends[first]);
+		}
+		bool same = found == expected.size() && rids.size() == expected.size() && ends == expectedEnds;
+		for(size_t i = 0; same && i < rids.size(); i++){
+			same = rids[i].page_number == expected[i].page_number && rids[i].slot_number == expected[i].slot_number;
+		}
+		matches += same;
+	}
+	checkPassFail(matches, 7)
+	size_t entries = 0;
+	for(size_t i = 0; i < probes.size(); i++){
+		entries += (probes[i] >= 0 && probes[i] < relationSize + extra) + (probes[i] == 17) * 1000 + (probes[i] == 4000) * 2000;
+	}
+	checkPassFail(expected.size(), entries)
+
+	// nothing to find, nothing to write
+	std::vector<RecordId> rids;
+	checkPassFail(index.lookupBatch(&probes[0], 0, rids, nullptr), (size_t)0)
+	int missing[] = {-5, relationSize + extra, relationSize + extra + 5};
+	size_t ends[3];
+	checkPassFail(index.lookupBatch(missing, 3, rids, ends), (size_t)0)
+	checkPassFail(ends[2], (size_t)0)
+}
+
+// -----------------------------------------------------------------------------
+// intTestsDescending
+// -----------------------------------------------------------------------------
+void intTestsDescending(LeafFormat leafFormat){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, leafFormat);
+	// keys past the relation in random order, with record ids entryKey can tell the key from,
+	// and runs of duplicates that span leaves or go to posting lists
+	const int extra = 60000;
+	std::vector<int> keys(extra);
+	for(int i = 0; i < extra; i++){
+		keys[i] = relationSize + i;
+	}
+	std::random_shuffle(keys.begin(), keys.end());
+	RecordId rid;
+	for(int i = 0; i < extra; i++){
+		rid.page_number = 1000 + keys[i] / 100;
+		rid.slot_number = 1 + keys[i] % 100;
+		index.insertEntry(&keys[i], rid);
+	}
+	for(int i = 0; i < 3000; i++){
+		int key = i < 1000 ? 17 : relationSize + 500;
+		rid.page_number = 5000 + i;
+		rid.slot_number = i < 1000 ? 1 : 2;
+		index.insertEntry(&key, rid);
+	}
+
+	// every range comes out as the ascending scan does, backwards, one at a time or in batches
+	const int top = relationSize + extra;
+	const int lows[] = {-100, 0, 17, 17, 2500, relationSize + 500, relationSize + 500, top - 1};
+	const int highs[] = {top + 100, top, 17, 4000, 2600, relationSize + 500, top, std::numeric_limits<int>::max()};
+	const size_t batchSizes[] = {0, 1, 7, 1000};
+	int matches = 0;
+	for(int r = 0; r < 8; r++){
+		for(int b = 0; b < 4; b++){
+			matches += descendingScan(&index, lows[r], GTE, highs[r], LTE, batchSizes[b]) >= 0;
+			matches += descendingScan(&index, lows[r], GT, highs[r], LT, batchSizes[b]) >= 0;
+		}
+	}
+	checkPassFail(matches, 64)
+	checkPassFail(descendingScan(&index, 0, GTE, top, LTE, 100), top + 3000)
+	checkPassFail(descendingScan(&index, 17, GTE, 17, LTE, 0), 1001)
+
+	// the largest entries come first
+	int low = 0;
+	int high = top;
+	BTreeCursor scan = index.startScan(&low, GTE, &high, LTE, DESCENDING);
+	int ordered = 0;
+	for(int i = 0; i < 20; i++){
+		scan.scanNext(rid);
+		ordered += entryKey(rid) == top - 1 - i;
+	}
+	scan.endScan();
+	checkPassFail(ordered, 20)
+	low = top + 10;
+	high = top + 20;
+	try{
+		index.startScan(&low, GTE, &high, LTE, DESCENDING);
+		std::cout << "NoSuchKeyFoundException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(NoSuchKeyFoundException e){
+		std::cout << "NoSuchKeyFoundException Test Passed." << std::endl;
+	}
+
+	// merges relink the leaves on both sides
+	for(int i = 0; i < extra; i++){
+		if(keys[i] % 5 != 0){
+			rid.page_number = 1000 + keys[i] / 100;
+			rid.slot_number = 1 + keys[i] % 100;
+			index.deleteEntry(&keys[i], rid);
+		}
+	}
+	checkPassFail(descendingScan(&index, 0, GTE, top, LTE, 0), relationSize + extra / 5 + 3000)
+	checkPassFail(descendingScan(&index, relationSize, GT, top, LT, 64), extra / 5 - 1 + 2000)
+	// and leaves split off into the freed pages do not meet stale links
+	for(int i = 0; i < extra; i++){
+		if(keys[i] % 5 == 1){
+			rid.page_number = 1000 + keys[i] / 100;
+			rid.slot_number = 1 + keys[i] % 100;
+			index.insertEntry(&keys[i], rid);
+		}
+	}
+	checkPassFail(descendingScan(&index, 0, GTE, top, LTE, 0), relationSize + 2 * extra / 5 + 3000)
+}
+
+// -----------------------------------------------------------------------------
+// descendingScan
+// -----------------------------------------------------------------------------
+int descendingScan(BTreeIndex *index, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize)
+{
+	// count the entries of a range scanned from its high end, one at a time for batchSize 0. -1 if they
+	// are not those of the ascending scan or their keys go up
+	std::vector<RecordId> ascending;
+	std::vector<RecordId> descending;
+	RecordId scanRid;
+	BTreeCursor scan = index->openScan(&lowVal, lowOp, &highVal, highOp);
+	try{
+		while(1){
+			scan.scanNext(scanRid);
+			ascending.push_back(scanRid);
+		}
+	}
+	catch(IndexScanCompletedException e){
+	}
+	scan = index->openScan(&lowVal, lowOp, &highVal, highOp, DESCENDING);
+	if(batchSize == 0){
+		try{
+			while(1){
+				scan.scanNext(scanRid);
+				descending.push_back(scanRid);
+			}
+		}
+		catch(IndexScanCompletedException e){
+		}
+	}
+	else{
+		std::vector<RecordId> batch(batchSize);
+		size_t n;
+		while((n = scan.nextBatch(&batch[0], batchSize)) > 0){
+			descending.insert(descending.end(), batch.begin(), batch.begin() + n);
+		}
+	}
+	for(size_t i = 1; i < descending.size(); i++){
+		if(entryKey(descending[i]) > entryKey(descending[i-1])){
+			return -1;
+		}
+	}
+	std::sort(ascending.begin(), ascending.end());
+	std::sort(descending.begin(), descending.end());
+	if(ascending != descending){
+		return -1;
+	}
+	return descending.size();
+}
+
+// -----------------------------------------------------------------------------
+// entryKey
+// -----------------------------------------------------------------------------
+int entryKey(RecordId rid){
+	// record ids of entries past the relation tell their key, intTestsDescending has the layout.
+	// intTestsCounted adds keys below it
+	if(rid.page_number >= 20000){
+		return -(int)((rid.page_number - 20000) * 100 + rid.slot_number - 1);
+	}
+	if(rid.page_number >= 5000){
+		return rid.slot_number == 1 ? 17 : relationSize + 500;
+	}
+	if(rid.page_number >= 1000){
+		return (rid.page_number - 1000) * 100 + rid.slot_number - 1;
+	}
+	return recordKey(rid);
+}
+
+// -----------------------------------------------------------------------------
+// intTestsCounted
+// -----------------------------------------------------------------------------
+void intTestsCounted(LeafFormat leafFormat, NonLeafFormat nonLeafFormat){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, leafFormat, nonLeafFormat);
+	std::vector<int> sorted(relationSize);
+	for(int i = 0; i < relationSize; i++){
+		sorted[i] = i;
+	}
+	checkPassFail(countedMatches(&index, sorted, 50), 200)
+
+	// keys past the relation in random order, with record ids entryKey can tell the key from, and a run
+	// of duplicates that spans leaves, until plain leaves grow a level of non-leaves below the root.
+	// packed leaves would take several times the entries and the time for that
+	const int scale = leafFormat == PACKED_LEAVES ? 5 : 1;
+	const int extra = 300000 / scale;
+	std::vector<int> keys(extra);
+	for(int i = 0; i < extra; i++){
+		keys[i] = relationSize + i;
+	}
+	std::random_shuffle(keys.begin(), keys.end());
+	RecordId rid;
+	for(int i = 0; i < extra; i++){
+		rid.page_number = 1000 + keys[i] / 100;
+		rid.slot_number = 1 + keys[i] % 100;
+		index.insertEntry(&keys[i], rid);
+	}
+	std::vector<RIDKeyPair<int> > entries(2000);
+	for(int i = 0; i < 2000; i++){
+		rid.page_number = 5000 + i;
+		rid.slot_number = 1;
+		entries[i].set(rid, 17);
+	}
+	index.insertBatch(&entries[0], 2000);
+	// keys below the relation going down, which split the leftmost nodes and never come back to
+	// the upper halves, so their counts are only right if they moved along with their children
+	const int negative = 100000 / scale;
+	for(int key = -1; key >= -negative; key--){
+		rid.page_number = 20000 + -key / 100;
+		rid.slot_number = 1 + -key % 100;
+		index.insertEntry(&key, rid);
+		sorted.push_back(key);
+	}
+	sorted.insert(sorted.end(), keys.begin(), keys.end());
+	sorted.insert(sorted.end(), 2000, 17);
+	std::sort(sorted.begin(), sorted.end());
+	if(nonLeafFormat == COUNTED_NONLEAVES && leafFormat == PLAIN_LEAVES){
+		checkPassFail(index.height(), 3)
+	}
+	checkPassFail(countedMatches(&index, sorted, 100), 400)
+	int low = std::numeric_limits<int>::min();
+	int high = std::numeric_limits<int>::max();
+	checkPassFail(index.countRange(&low, GTE, &high, LTE), sorted.size())
+	low = 17;
+	checkPassFail(index.countRange(&low, EQ, &low, EQ), 2001)
+	checkPassFail(index.rank(&low), (size_t)(negative + 17))
+	int key;
+	checkPassFail(index.select(sorted.size(), &key, rid), false)
+
+	// emptying a stretch of keys makes its nodes borrow from their siblings, thinning out the
+	// rest merges them, and both move the counts along with the children
+	for(int i = 0; i < extra; i++){
+		if(keys[i] < relationSize + extra / 3 || keys[i] % 5 != 0){
+			rid.page_number = 1000 + keys[i] / 100;
+			rid.slot_number = 1 + keys[i] % 100;
+			index.deleteEntry(&keys[i], rid);
+		}
+	}
+	for(int i = 0; i < 2000; i += 2){
+		index.deleteEntry(&entries[i].key, entries[i].rid);
+	}
+	sorted.clear();
+	for(int i = -negative; i < relationSize + extra; i++){
+		if(i < relationSize || (i >= relationSize + extra / 3 && i % 5 == 0)){
+			sorted.push_back(i);
+		}
+	}
+	sorted.insert(sorted.begin() + negative + 17, 1000, 17);
+	checkPassFail(countedMatches(&index, sorted, 100), 400)
+	// and splits into the freed pages count from scratch
+	for(int i = 0; i < extra; i++){
+		if(keys[i] % 5 == 1){
+			rid.page_number = 1000 + keys[i] / 100;
+			rid.slot_number = 1 + keys[i] % 100;
+			index.insertEntry(&keys[i], rid);
+			sorted.push_back(keys[i]);
+		}
+	}
+	std::sort(sorted.begin(), sorted.end());
+	checkPassFail(countedMatches(&index, sorted, 100), 400)
+	low = std::numeric_limits<int>::min();
+	checkPassFail(index.countRange(&low, GTE, &high, LTE), sorted.size())
+}
+
+// -----------------------------------------------------------------------------
+// sortedCount
+// -----------------------------------------------------------------------------
+int sortedCount(const std::vector<int> &keys, int lowVal, Operator lowOp, int highVal, Operator highOp)
+{
+	// count the keys of a sorted vector in a range the way a scan of it would
+	std::vector<int>::const_iterator first = lowOp == GT ? std::upper_bound(keys.begin(), keys.end(), lowVal)
+		: std::lower_bound(keys.begin(), keys.end(), lowVal);
+	std::vector<int>::const_iterator last = highOp == LT ? std::lower_bound(keys.begin(), keys.end(), highVal)
+		: std::upper_bound(keys.begin(), keys.end(), highVal);
+	return first < last ? last - first : 0;
+}
+
+// -----------------------------------------------------------------------------
+// countedMatches
+// -----------------------------------------------------------------------------
+int countedMatches(BTreeIndex *index, const std::vector<int> &keys, int probes)
+{
+	// probe random ranges, keys and positions of an index holding the sorted keys, with record ids entryKey
+	// can tell the key from. Returns how many of the probes, four each, found what the vector says
+	int span = keys.back() - keys.front() + 10;
+	int matches = 0;
+	for(int i = 0; i < probes; i++){
+		int lowVal = keys.front() - 5 + rand() % span;
+		int highVal = lowVal + rand() % (i % 2 == 0 ? 100 : span);
+		Operator lowOp = i % 3 == 0 ? GT : GTE;
+		Operator highOp = i % 4 == 0 ? LT : LTE;
+		matches += (int)index->countRange(&lowVal, lowOp, &highVal, highOp) == sortedCount(keys, lowVal, lowOp, highVal, highOp);
+		matches += (int)index->countRange(&lowVal, EQ, &lowVal, EQ) == sortedCount(keys, lowVal, GTE, lowVal, LTE);
+		matches += index->rank(&highVal) == (size_t)(std::lower_bound(keys.begin(), keys.end(), highVal) - keys.begin());
+
+		size_t position = rand() % keys.size();
+		int key;
+		RecordId rid;
+		matches += index->select(position, &key, rid) && key == keys[position] && entryKey(rid) == key;
+	}
+	return matches;
+}
+
+// -----------------------------------------------------------------------------
+// intTestsHeapFetch
+// -----------------------------------------------------------------------------
+void intTestsHeapFetch(){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+
+	{
+		HeapFetch fetch(relationName, bufMgr, &index);
+		RecordId rid;
+		bool thrown = false;
+		try
+		{
+			fetch.scanNext(rid);
+		}
+		catch(ScanNotInitializedException e)
+		{
+			thrown = true;
+		}
+		checkPassFail(thrown, true)
+
+		checkPassFail(heapFetchScan(fetch, 25, GT, 40, LT, HEAPFETCHBATCH, true), 14)
+		checkPassFail(heapFetchScan(fetch, 0, GTE, relationSize, LT, HEAPFETCHBATCH, false), relationSize)
+		checkPassFail(heapFetchScan(fetch, 3000, GT, 3000, LTE, HEAPFETCHBATCH, false), 0)
+		checkPassFail(heapFetchScan(fetch, -100, GTE, 1500, LT, HEAPFETCHBATCH, false), 1500)
+	}
+	// batches smaller than the range, each read in page order on its own
+	{
+		HeapFetch fetch(relationName, bufMgr, &index, 100, 8);
+		checkPassFail(heapFetchScan(fetch, 0, GTE, relationSize, LT, 100, false), relationSize)
+		checkPassFail(heapFetchScan(fetch, 1234, GTE, 4321, LTE, 100, false), 3088)
+		checkPassFail(heapFetchScan(fetch, 10, GTE, 17, LTE, 100, true), 8)
+		checkPassFail(heapFetchScan(fetch, 10, GTE, 18, LTE, 100, false), 9)
+	}
+}
+
+// -----------------------------------------------------------------------------
+// heapFetchScan
+// -----------------------------------------------------------------------------
+int heapFetchScan(HeapFetch &fetch, int lowVal, Operator lowOp, int highVal, Operator highOp, size_t batchSize, bool keyOrder)
+{
+	// fetch the records of a range, checking each key in it comes back once, in key order if keyOrder and
+	// otherwise in page order within each batch. Returns how many came back, -1 if any was wrong
+	fetch.startScan(&lowVal, lowOp, &highVal, highOp);
+	std::vector<bool> seen(relationSize, false);
+	int count = 0;
+	bool ok = true;
+	RecordId rid;
+	RecordId prev;
+	int prevKey = -1;
+	try
+	{
+		while(1)
+		{
+			fetch.scanNext(rid);
+			int key = reinterpret_cast<const RECORD*>(fetch.getRecord().data())->i;
+			bool inRange = (lowOp == GT ? key > lowVal : key >= lowVal) && (highOp == LT ? key < highVal : key <= highVal);
+			if(!inRange || seen[key]){
+				ok = false;
+			}
+			else{
+				seen[key] = true;
+			}
+			if(keyOrder ? key < prevKey : count % batchSize != 0 && rid.page_number < prev.page_number){
+				ok = false;
+			}
+			prev = rid;
+			prevKey = key;
+			count++;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	fetch.endScan();
+	return ok ? count : -1;
+}
+
+// -----------------------------------------------------------------------------
+// intTestsCovering
+// -----------------------------------------------------------------------------
+void intTestsCovering(NonLeafFormat nonLeafFormat){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	std::vector<IncludedAttr> included(2);
+	included[0].offset = offsetof(tuple,d);
+	included[0].length = sizeof(double);
+	included[1].offset = offsetof(tuple,s);
+	included[1].length = 20;
+	std::vector<bool> present(relationSize, true);
+	std::vector<RecordId> rids(relationSize);
+	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES, nonLeafFormat, included);
+		checkPassFail(index.payloadSize(), 28)
+		checkPassFail(index.leafCapacity(), INTARRAYLEAFSIZE * (int)sizeof(RecordId) / ((int)sizeof(RecordId) + 28))
+		checkPassFail((index.height() > 1), true)
+		checkPassFail(coveringScan(&index, 0, relationSize, ASCENDING, 0, present), relationSize)
+		checkPassFail(coveringScan(&index, 100, 4000, DESCENDING, 0, present), 3900)
+		checkPassFail(coveringScan(&index, 0, relationSize, ASCENDING, 1000, present), relationSize)
+		checkPassFail(coveringScan(&index, 1234, 4321, DESCENDING, 97, present), 3087)
+
+		// emptying stretches merges leaves and borrows from their siblings, thinning the rest shifts
+		// entries inside them, and the included attributes have to move along every time
+		int low = 0;
+		int high = relationSize;
+		BTreeCursor scan = index.openScan(&low, GTE, &high, LT);
+		while(scan.nextBatch(&rids[0], relationSize) > 0){
+		}
+		scan.endScan();
+		for(int i = 0; i < relationSize; i++){
+			if((i >= 1000 && i < 2500) || i % 3 == 0){
+				index.deleteEntry(&i, rids[i]);
+				present[i] = false;
+			}
+		}
+		int left = 0;
+		for(int i = 0; i < relationSize; i++){
+			left += present[i];
+		}
+		checkPassFail(coveringScan(&index, 0, relationSize, ASCENDING, 0, present), left)
+		checkPassFail(coveringScan(&index, 0, relationSize, DESCENDING, 500, present), left)
+
+		// reinserted entries read their attributes from the relation, those of a batch as well
+		std::vector<RIDKeyPair<int> > batch;
+		for(int i = 0; i < relationSize; i++){
+			if(!present[i] && i % 2 == 0){
+				index.insertEntry(&i, rids[i]);
+				present[i] = true;
+			}
+			else if(!present[i] && i % 6 == 3){
+				RIDKeyPair<int> entry;
+				entry.set(rids[i], i);
+				batch.push_back(entry);
+				present[i] = true;
+			}
+		}
+		index.insertBatch(&batch[0], batch.size());
+		left = 0;
+		for(int i = 0; i < relationSize; i++){
+			left += present[i];
+		}
+		checkPassFail(coveringScan(&index, 0, relationSize, ASCENDING, 300, present), left)
+		checkPassFail(coveringScan(&index, 0, relationSize, DESCENDING, 0, present), left)
+	}
+
+	// the included attributes are part of what the index file is checked against
+	try{
+		std::string otherName;
+		BTreeIndex other(relationName, otherName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES, nonLeafFormat);
+		std::cout << "BadIndexInfoException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadIndexInfoException e){
+		std::cout << "BadIndexInfoException Test Passed." << std::endl;
+	}
+	try{
+		std::string otherName;
+		BTreeIndex other(relationName, otherName, bufMgr, offsetof(tuple,i), INTEGER, PACKED_LEAVES, nonLeafFormat, included);
+		std::cout << "BadIndexInfoException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadIndexInfoException e){
+		std::cout << "BadIndexInfoException Test Passed." << std::endl;
+	}
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES, nonLeafFormat, included);
+	checkPassFail(coveringScan(&index, 10, 4990, ASCENDING, 64, present), (int)std::count(present.begin() + 10, present.begin() + 4990, true))
+}
+
+// -----------------------------------------------------------------------------
+// coveringScan
+// -----------------------------------------------------------------------------
+int coveringScan(BTreeIndex *index, int lowVal, int highVal, ScanOrder order, size_t batchSize, const std::vector<bool> &present)
+{
+	// scan [lowVal, highVal) of a covering index on the double and string fields, one entry at a time for
+	// batchSize 0, and check the included attributes against the records. Returns how many entries came
+	// back, -1 if any attributes were wrong or a key came back that is not present or twice
+	const int width = index->payloadSize();
+	std::vector<RecordId> rids(std::max(batchSize, (size_t)1));
+	std::vector<char> payloads(rids.size() * width);
+	std::vector<bool> seen(relationSize, false);
+	BTreeCursor scan = index->openScan(&lowVal, GTE, &highVal, LT, order);
+	int count = 0;
+	bool ok = true;
+	while(true){
+		size_t n = 1;
+		if(batchSize == 0){
+			try
+			{
+				scan.scanNext(rids[0], &payloads[0]);
+			}
+			catch(IndexScanCompletedException e)
+			{
+				break;
+			}
+		}
+		else if((n = scan.nextBatch(&rids[0], batchSize, &payloads[0])) == 0){
+			break;
+		}
+		for(size_t i = 0; i < n; i++){
+			int key = recordKey(rids[i]);
+			double d;
+			memcpy(&d, &payloads[i * width], sizeof(double));
+			char s[20];
+			sprintf(s, "%05d string record", key);
+			if(key < lowVal || key >= highVal || !present[key] || seen[key] || d != key
+				|| memcmp(&payloads[i * width + sizeof(double)], s, 19) != 0){
+				ok = false;
+			}
+			else{
+				seen[key] = true;
+			}
+			count++;
+		}
+	}
+	scan.endScan();
+	return ok ? count : -1;
+}
+
+// -----------------------------------------------------------------------------
+// intTestsComposite
+// -----------------------------------------------------------------------------
+void intTestsComposite(NonLeafFormat nonLeafFormat){
+	std::cout << "Create a B+ Tree index on the integer, double and string fields" << std::endl;
+	std::vector<KeyAttr> keys(3);
+	keys[0].offset = offsetof(tuple,i);
+	keys[0].type = INTEGER;
+	keys[1].offset = offsetof(tuple,d);
+	keys[1].type = DOUBLE;
+	keys[2].offset = offsetof(tuple,s);
+	keys[2].type = STRING;
+	keys[2].length = 8;
+
+	std::vector<RECORD> records;
+	std::vector<RecordId> rids;
+	std::vector<bool> present(relationSize, true);
+	{
+		FileScan fscan(relationName, bufMgr);
+		try{
+			RecordId scanRid;
+			while(1){
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				records.push_back(*(RECORD *)recordStr.c_str());
+				rids.push_back(scanRid);
+			}
+		}
+		catch(EndOfFileException e){
+		}
+	}
+
+	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, keys, nonLeafFormat);
+		checkPassFail(index.keySize(), 20)
+		checkPassFail((index.height() > 1), true)
+
+		// the encoding orders values the way they compare, across signs and with -0 equal to 0
+		char a[8];
+		char b[8];
+		int ints[] = {-2147483647 - 1, -300, -1, 0, 1, 255, 256, 2147483647};
+		double doubles[] = {-1e300, -2.5, -1e-300, 0, 1e-300, 0.5, 2, 1e300};
+		bool ordered = true;
+		for(int n = 0; n + 1 < 8; n++){
+			const void *value = &ints[n];
+			const void *next = &ints[n + 1];
+			index.encodePrefix(&value, 1, a);
+			index.encodePrefix(&next, 1, b);
+			ordered = ordered && memcmp(a, b, 4) < 0;
+		}
+		checkPassFail(ordered, true)
+		RECORD low, high;
+		low.i = 0;
+		high.i = 0;
+		for(int n = 0; n + 1 < 8; n++){
+			low.d = doubles[n];
+			high.d = doubles[n + 1];
+			const void *values[] = {&low.i, &low.d};
+			const void *next[] = {&high.i, &high.d};
+			char lowKey[12];
+			char highKey[12];
+			index.encodePrefix(values, 2, lowKey);
+			index.encodePrefix(next, 2, highKey);
+			ordered = ordered && memcmp(lowKey, highKey, 12) < 0;
+		}
+		checkPassFail(ordered, true)
+		low.i = 0;
+		low.d = 0;
+		high.i = 0;
+		high.d = -0.0;
+		const void *zeroKey[] = {&low.i, &low.d};
+		const void *negativeZeroKey[] = {&high.i, &high.d};
+		char zeroBytes[12];
+		char negativeZeroBytes[12];
+		checkPassFail(index.encodePrefix(zeroKey, 2, zeroBytes), 12)
+		index.encodePrefix(negativeZeroKey, 2, negativeZeroBytes);
+		checkPassFail((memcmp(zeroBytes, negativeZeroBytes, 12) == 0), true)
+
+		// a full key, the leading attribute alone and ranges inside and across its values
+		low = records[1234];
+		checkPassFail(compositeScan(&index, 3, low, EQ, 3, low, EQ, records, present), 1)
+		low.i = -7;
+		checkPassFail(compositeScan(&index, 1, low, EQ, 1, low, EQ, records, present), 100)
+		high = low;
+		low.d = -10;
+		high.d = 5;
+		checkPassFail(compositeScan(&index, 2, low, GTE, 2, high, LT, records, present), 30)
+		low.i = -3;
+		high.i = 4;
+		high.d = 0;
+		checkPassFail(compositeScan(&index, 1, low, GT, 2, high, LTE, records, present), 641)
+		low.i = 0;
+		low.d = -0.5;
+		high.i = 0;
+		high.d = 0.5;
+		checkPassFail(compositeScan(&index, 2, low, GT, 2, high, LTE, records, present), 2)
+		low.i = -25;
+		low.d = -20;
+		high.i = -24;
+		checkPassFail(compositeScan(&index, 2, low, GTE, 1, high, LT, records, present), 100)
+		low.i = 24;
+		high.i = 24;
+		checkPassFail(compositeScan(&index, 1, low, GT, 1, high, LTE, records, present), 0)
+
+		// deletes and inserts take the normalized key of the record
+		char key[MAXPAYLOADSIZE];
+		for(size_t n = 0; n < records.size(); n++){
+			if(records[n].i == -7){
+				index.encodeKey((const char *)&records[n], key);
+				index.deleteEntry(key, rids[n]);
+				present[n] = false;
+			}
+		}
+		low.i = -7;
+		checkPassFail(compositeScan(&index, 1, low, EQ, 1, low, EQ, records, present), 0)
+		low.i = -3;
+		high.i = 4;
+		high.d = 0;
+		checkPassFail(compositeScan(&index, 1, low, GT, 2, high, LTE, records, present), 641)
+		for(size_t n = 0; n < records.size(); n++){
+			if(records[n].i == -7 && records[n].d < 5){
+				index.encodeKey((const char *)&records[n], key);
+				index.insertEntry(key, rids[n]);
+				present[n] = true;
+			}
+		}
+		low.i = -7;
+		checkPassFail(compositeScan(&index, 1, low, EQ, 1, low, EQ, records, present), 50)
+		high = low;
+		low.d = -10;
+		high.d = 5;
+		checkPassFail(compositeScan(&index, 2, low, GTE, 2, high, LT, records, present), 30)
+
+		std::cout << "Composite lookups with bad bounds" << std::endl;
+		std::vector<RecordId> out;
+		char lowKey[20];
+		char highKey[20];
+		low.i = 5;
+		high.i = 4;
+		const void *lowValues[] = {&low.i};
+		const void *highValues[] = {&high.i};
+		index.encodePrefix(lowValues, 1, lowKey);
+		index.encodePrefix(highValues, 1, highKey);
+		try{
+			index.lookupKeys(lowKey, 4, GTE, highKey, 4, LTE, out);
+			std::cout << "BadScanrangeException Test Failed." << std::endl;
+			exit(1);
+		}
+		catch(BadScanrangeException e){
+			std::cout << "BadScanrangeException Test Passed." << std::endl;
+		}
+		try{
+			index.lookupKeys(highKey, 4, LTE, lowKey, 4, GTE, out);
+			std::cout << "BadOpcodesException Test Failed." << std::endl;
+			exit(1);
+		}
+		catch(BadOpcodesException e){
+			std::cout << "BadOpcodesException Test Passed." << std::endl;
+		}
+		try{
+			RIDKeyPair<int> entry;
+			entry.set(rids[0], 0);
+			index.insertBatch(&entry, 1);
+			std::cout << "BadIndexInfoException Test Failed." << std::endl;
+			exit(1);
+		}
+		catch(BadIndexInfoException e){
+			std::cout << "BadIndexInfoException Test Passed." << std::endl;
+		}
+	}
+
+	// the attributes of the key are part of what the index file is checked against
+	try{
+		std::string otherName;
+		std::vector<KeyAttr> other = keys;
+		other[2].length = 12;
+		BTreeIndex index(relationName, otherName, bufMgr, other, nonLeafFormat);
+		std::cout << "BadIndexInfoException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadIndexInfoException e){
+		std::cout << "BadIndexInfoException Test Passed." << std::endl;
+	}
+	BTreeIndex index(relationName, intIndexName, bufMgr, keys, nonLeafFormat);
+	RECORD low;
+	low.i = -7;
+	checkPassFail(compositeScan(&index, 1, low, EQ, 1, low, EQ, records, present), 50)
+}
+
+// -----------------------------------------------------------------------------
+// intTestsCompositeGroup
+// -----------------------------------------------------------------------------
+void intTestsCompositeGroup(NonLeafFormat nonLeafFormat){
+	std::cout << "Create a B+ Tree index on the integer, double and string fields, one integer for all" << std::endl;
+	std::vector<KeyAttr> keys(3);
+	keys[0].offset = offsetof(tuple,i);
+	keys[0].type = INTEGER;
+	keys[1].offset = offsetof(tuple,d);
+	keys[1].type = DOUBLE;
+	keys[2].offset = offsetof(tuple,s);
+	keys[2].type = STRING;
+	keys[2].length = 8;
+
+	std::vector<RECORD> records;
+	std::vector<RecordId> rids;
+	{
+		FileScan fscan(relationName, bufMgr);
+		try{
+			RecordId scanRid;
+			while(1){
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				records.push_back(*(RECORD *)recordStr.c_str());
+				rids.push_back(scanRid);
+			}
+		}
+		catch(EndOfFileException e){
+		}
+	}
+	std::vector<bool> present(records.size(), true);
+	int groupSize = (int)records.size();
+
+	// compressed non-leaves take all leaves of the group in the root
+	BTreeIndex index(relationName, intIndexName, bufMgr, keys, nonLeafFormat);
+	checkPassFail((index.height() > (nonLeafFormat == COMPRESSED_NONLEAVES ? 1 : 2)), true)
+
+	// the records were indexed from the last d down, the group comes back in key order all the same
+	RECORD low = records[0];
+	RECORD high;
+	checkPassFail(compositeScan(&index, 1, low, EQ, 1, low, EQ, records, present), groupSize)
+
+	// ranges on the trailing attributes inside the group
+	high = low;
+	low.d = 1000;
+	high.d = 1010;
+	checkPassFail(compositeScan(&index, 2, low, GTE, 2, high, LT, records, present), 20)
+	checkPassFail(compositeScan(&index, 2, low, GT, 2, high, LTE, records, present), 20)
+	low.d = -20;
+	high.d = -15;
+	checkPassFail(compositeScan(&index, 2, low, GTE, 2, high, LTE, records, present), 11)
+	low.d = (groupSize - 1) * 0.5 - 20;
+	high.d = 1e9;
+	checkPassFail(compositeScan(&index, 2, low, GTE, 2, high, LTE, records, present), 1)
+	low = records[777];
+	checkPassFail(compositeScan(&index, 3, low, EQ, 3, low, EQ, records, present), 1)
+
+	// deletes find their entries inside the group, inserts go back between their neighbours
+	char key[MAXPAYLOADSIZE];
+	for(size_t n = 0; n < records.size(); n++){
+		if(records[n].d >= 1000 && records[n].d < 2000){
+			index.encodeKey((const char *)&records[n], key);
+			index.deleteEntry(key, rids[n]);
+			present[n] = false;
+		}
+	}
+	low.d = 990;
+	high = low;
+	high.d = 1010;
+	checkPassFail(compositeScan(&index, 2, low, GTE, 2, high, LT, records, present), 20)
+	for(size_t n = 0; n < records.size(); n++){
+		if(records[n].d >= 1000 && records[n].d < 2000 && (int)(records[n].d * 2) % 4 == 0){
+			index.encodeKey((const char *)&records[n], key);
+			index.insertEntry(key, rids[n]);
+			present[n] = true;
+		}
+	}
+	checkPassFail(compositeScan(&index, 2, low, GTE, 2, high, LT, records, present), 25)
+	checkPassFail(compositeScan(&index, 1, low, EQ, 1, low, EQ, records, present), groupSize - 1500)
+}
+
+// -----------------------------------------------------------------------------
+// intTestsStrings
+// -----------------------------------------------------------------------------
+int intTestsStrings(NonLeafFormat nonLeafFormat){
+	std::cout << "Create a B+ Tree index on the string field" << std::endl;
+	std::vector<KeyAttr> keys(1);
+	keys[0].offset = offsetof(tuple,s);
+	keys[0].type = STRING;
+	keys[0].length = 64;
+
+	BTreeIndex index(relationName, intIndexName, bufMgr, keys, nonLeafFormat);
+	int height = index.height();
+	std::vector<RecordId> out;
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/", GTE, "https://shop.example.com/customers/", LTE, out), relationSize)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00001000", GTE, "https://shop.example.com/customers/00001100", LT, out), 100)
+
+	// orders of a customer share even more, so separators between them stay long and fill compressed nodes
+	const int orders = 40000;
+	std::vector<int> order(orders);
+	for(int k = 0; k < orders; k++){
+		order[k] = k;
+	}
+	std::random_shuffle(order.begin(), order.end());
+	char s[64];
+	char key[MAXPAYLOADSIZE];
+	const void *values[] = {s};
+	for(int n = 0; n < orders; n++){
+		int k = order[n];
+		memset(s, 0, sizeof(s));
+		sprintf(s, "https://shop.example.com/customers/%08d/orders/%010u", 100000 + k / 8, (unsigned)k * 2654435761u);
+		index.encodePrefix(values, 1, key);
+		RecordId rid;
+		rid.page_number = 100000 + k / 100;
+		rid.slot_number = k % 100 + 1;
+		index.insertEntry(key, rid);
+	}
+	checkPassFail((index.height() >= height), true)
+
+	// plain http keys sort before all of them and share less, so the first separators of a node
+	// take its prefix apart and compressed nodes run out of room before their inserts get there
+	for(int k = 0; k < 3000; k++){
+		memset(s, 0, sizeof(s));
+		sprintf(s, "http://shop.example.com/customers/%08d", k * 7 % 3000);
+		index.encodePrefix(values, 1, key);
+		RecordId rid;
+		rid.page_number = 200000 + k;
+		rid.slot_number = 1;
+		index.insertEntry(key, rid);
+	}
+	checkPassFail(stringCount(&index, "http://", GTE, "https://", LT, out), 3000)
+	checkPassFail(stringCount(&index, "http://shop.example.com/customers/00001000", GTE, "http://shop.example.com/customers/00001000", LTE, out), 1)
+	checkPassFail((out[0].page_number == 201000), true)
+	for(int k = 0; k < 3000; k++){
+		memset(s, 0, sizeof(s));
+		sprintf(s, "http://shop.example.com/customers/%08d", k * 7 % 3000);
+		index.encodePrefix(values, 1, key);
+		RecordId rid;
+		rid.page_number = 200000 + k;
+		rid.slot_number = 1;
+		index.deleteEntry(key, rid);
+	}
+	checkPassFail(stringCount(&index, "http://", GTE, "https://", LT, out), 0)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/", GTE, "https://shop.example.com/customers/", LTE, out), relationSize + orders)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00100005/", GTE, "https://shop.example.com/customers/00100005/", LTE, out), 8)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00101000", GTE, "https://shop.example.com/customers/00101100", LT, out), 800)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00001000", GTE, "https://shop.example.com/customers/00001100", LT, out), 100)
+	memset(s, 0, sizeof(s));
+	sprintf(s, "https://shop.example.com/customers/%08d/orders/%010u", 100000 + 12345 / 8, 12345u * 2654435761u);
+	checkPassFail(stringCount(&index, s, GTE, s, LTE, out), 1)
+	checkPassFail((out[0].page_number == 100000 + 12345 / 100 && out[0].slot_number == 12345 % 100 + 1), true)
+
+	// deleting three of every four orders merges leaves and then non-leaves, which have to keep the separators fitting
+	for(int n = 0; n < orders; n++){
+		int k = order[n];
+		if(k % 4 != 0){
+			memset(s, 0, sizeof(s));
+			sprintf(s, "https://shop.example.com/customers/%08d/orders/%010u", 100000 + k / 8, (unsigned)k * 2654435761u);
+			index.encodePrefix(values, 1, key);
+			RecordId rid;
+			rid.page_number = 100000 + k / 100;
+			rid.slot_number = k % 100 + 1;
+			index.deleteEntry(key, rid);
+		}
+	}
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/", GTE, "https://shop.example.com/customers/", LTE, out), relationSize + orders / 4)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00100005/", GTE, "https://shop.example.com/customers/00100005/", LTE, out), 2)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00101000", GTE, "https://shop.example.com/customers/00101100", LT, out), 200)
+	checkPassFail(stringCount(&index, s, GTE, s, LTE, out), 0)
+
+	// and inserting some of them again splits the nodes again
+	for(int n = 0; n < orders; n++){
+		int k = order[n];
+		if(k % 4 == 1){
+			memset(s, 0, sizeof(s));
+			sprintf(s, "https://shop.example.com/customers/%08d/orders/%010u", 100000 + k / 8, (unsigned)k * 2654435761u);
+			index.encodePrefix(values, 1, key);
+			RecordId rid;
+			rid.page_number = 100000 + k / 100;
+			rid.slot_number = k % 100 + 1;
+			index.insertEntry(key, rid);
+		}
+	}
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/", GTE, "https://shop.example.com/customers/", LTE, out), relationSize + orders / 2)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00101000", GTE, "https://shop.example.com/customers/00101100", LT, out), 400)
+	checkPassFail(stringCount(&index, "https://shop.example.com/customers/00000000", GT, "https://shop.example.com/customers/00000010", LT, out), 9)
+	return height;
+}
+
+// -----------------------------------------------------------------------------
+// stringCount
+// -----------------------------------------------------------------------------
+int stringCount(BTreeIndex *index, const char *low, Operator lowOp, const char *high, Operator highOp, std::vector<RecordId> &out)
+{
+	// look up the strings between low and high compared over their lengths in an index on s into out,
+	// and return how many came back
+	out.clear();
+	index->lookupKeys(low, strlen(low), lowOp, high, strlen(high), highOp, out);
+	return (int)out.size();
+}
+
+// -----------------------------------------------------------------------------
+// compositeScan
+// -----------------------------------------------------------------------------
+int compositeScan(BTreeIndex *index, int lowCount, const RECORD &low, Operator lowOp, int highCount, const RECORD &high, Operator highOp, const std::vector<RECORD> &records, const std::vector<bool> &present)
+{
+	// look up the bounds made of the first lowCount and highCount fields of low and high in an index on
+	// (i, d, s) and check the records found against the same bounds compared field by field. Returns how
+	// many rids came back, -1 if any record is out of bounds, came back twice or out of key order, or the
+	// present records in bounds are more than that
+	const void *lowValues[] = {&low.i, &low.d, low.s};
+	const void *highValues[] = {&high.i, &high.d, high.s};
+	char lowKey[MAXPAYLOADSIZE];
+	char highKey[MAXPAYLOADSIZE];
+	int lowLength = index->encodePrefix(lowValues, lowCount, lowKey);
+	int highLength = index->encodePrefix(highValues, highCount, highKey);
+	std::vector<RecordId> out;
+	size_t found = index->lookupKeys(lowKey, lowLength, lowOp, highKey, highLength, highOp, out);
+	bool ok = found == out.size();
+	std::set<std::string> seen;
+	RECORD previous;
+	for(size_t n = 0; n < out.size(); n++){
+		Page *curPage;
+		bufMgr->readPage(file1, out[n].page_number, curPage);
+		RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(out[n]).data()));
+		bufMgr->unPinPage(file1, out[n].page_number, false);
+		int lowCmp = tupleCompare(myRec, low, lowCount);
+		int highCmp = tupleCompare(myRec, high, highCount);
+		if((lowOp == GT ? lowCmp <= 0 : lowCmp < 0) || (highOp == LT ? highCmp >= 0 : highCmp > 0)
+			|| !seen.insert(std::string(myRec.s, 8)).second || (n > 0 && tupleCompare(myRec, previous, 3) < 0)){
+			ok = false;
+		}
+		previous = myRec;
+	}
+	size_t expected = 0;
+	for(size_t n = 0; n < records.size(); n++){
+		int lowCmp = tupleCompare(records[n], low, lowCount);
+		int highCmp = tupleCompare(records[n], high, highCount);
+		if(present[n] && (lowOp == GT ? lowCmp > 0 : lowCmp >= 0) && (highOp == LT ? highCmp < 0 : highCmp <= 0)){
+			expected++;
+		}
+	}
+	return ok && expected == out.size() ? (int)out.size() : -1;
+}
+
+// -----------------------------------------------------------------------------
+// tupleCompare
+// -----------------------------------------------------------------------------
+int tupleCompare(const RECORD &a, const RECORD &b, int count)
+{
+	// compare the first count fields of (i, d, s), s over its first 8 characters
+	if(count > 0 && a.i != b.i){
+		return a.i < b.i ? -1 : 1;
+	}
+	if(count > 1 && a.d != b.d){
+		return a.d < b.d ? -1 : 1;
+	}
+	if(count > 2){
+		return strncmp(a.s, b.s, 8);
+	}
+	return 0;
+}
+
+// -----------------------------------------------------------------------------
+// intTestsTable
+// -----------------------------------------------------------------------------
+void intTestsTable(NonLeafFormat nonLeafFormat){
+	std::cout << "Create an index-organized table on the integer field" << std::endl;
+	std::vector<bool> present(relationSize, true);
+	std::vector<RecordId> rowIds(relationSize);
+	std::vector<int> keys(relationSize);
+	for(int i = 0; i < relationSize; i++){
+		keys[i] = i;
+	}
+	for(int i = relationSize - 1; i > 0; i--){
+		std::swap(keys[i], keys[random() % (i + 1)]);
+	}
+	RECORD record;
+	memset(record.s, ' ', sizeof(record.s));
+	{
+		BTreeIndex table(relationName, intIndexName, bufMgr, offsetof(tuple,i), sizeof(RECORD), nonLeafFormat);
+		for(int i = 0; i < relationSize; i++){
+			sprintf(record.s, "%05d string record", keys[i]);
+			record.i = keys[i];
+			record.d = keys[i];
+			rowIds[keys[i]] = table.insertRecord(std::string(reinterpret_cast<char*>(&record), sizeof(RECORD)));
+		}
+		checkPassFail(table.payloadSize(), (int)sizeof(RECORD))
+		checkPassFail(table.leafCapacity(), INTARRAYLEAFSIZE * (int)sizeof(RecordId) / ((int)sizeof(RecordId) + (int)sizeof(RECORD)))
+		checkPassFail((table.height() > 1), true)
+
+		TableScan scan(&table);
+		checkPassFail(tableScan(scan, true, 0, relationSize, present), relationSize)
+		checkPassFail(tableScan(scan, false, 100, 4000, present), 3900)
+		checkPassFail(tableScan(scan, false, 4321, 4322, present), 1)
+		TableScan small(&table, 7);
+		checkPassFail(tableScan(small, false, 1234, 4321, present), 3087)
+
+		// rows leave and come back with the row ids insertRecord hands out
+		for(int i = 0; i < relationSize; i++){
+			if((i >= 1000 && i < 2500) || i % 3 == 0){
+				table.deleteEntry(&i, rowIds[i]);
+				present[i] = false;
+			}
+		}
+		int left = (int)std::count(present.begin(), present.end(), true);
+		checkPassFail(tableScan(scan, true, 0, relationSize, present), left)
+		checkPassFail(tableScan(small, false, 900, 2600, present), (int)std::count(present.begin() + 900, present.begin() + 2600, true))
+		for(int i = 1000; i < 2500; i += 2){
+			sprintf(record.s, "%05d string record", i);
+			record.i = i;
+			record.d = i;
+			rowIds[i] = table.insertRecord(std::string(reinterpret_cast<char*>(&record), sizeof(RECORD)));
+			present[i] = true;
+		}
+		checkPassFail(tableScan(scan, true, 0, relationSize, present), left + 750)
+
+		std::cout << "Insert into an index-organized table without a record" << std::endl;
+		try{
+			int key = 7;
+			table.insertEntry(&key, rowIds[7]);
+			std::cout << "BadIndexInfoException Test Failed." << std::endl;
+			exit(1);
+		}
+		catch(BadIndexInfoException e){
+			std::cout << "BadIndexInfoException Test Passed." << std::endl;
+		}
+		try{
+			table.insertRecord("short record");
+			std::cout << "BadIndexInfoException Test Failed." << std::endl;
+			exit(1);
+		}
+		catch(BadIndexInfoException e){
+			std::cout << "BadIndexInfoException Test Passed." << std::endl;
+		}
+	}
+
+	// the records stay in the table file, and row ids handed out after reopening it are new ones
+	try{
+		std::string otherName;
+		BTreeIndex other(relationName, otherName, bufMgr, offsetof(tuple,i), sizeof(RECORD) - 8, nonLeafFormat);
+		std::cout << "BadIndexInfoException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadIndexInfoException e){
+		std::cout << "BadIndexInfoException Test Passed." << std::endl;
+	}
+	BTreeIndex table(relationName, intIndexName, bufMgr, offsetof(tuple,i), sizeof(RECORD), nonLeafFormat);
+	TableScan scan(&table);
+	int left = (int)std::count(present.begin(), present.end(), true);
+	checkPassFail(tableScan(scan, true, 0, relationSize, present), left)
+	sprintf(record.s, "%05d string record", 3);
+	record.i = 3;
+	record.d = 3;
+	RecordId rowId = table.insertRecord(std::string(reinterpret_cast<char*>(&record), sizeof(RECORD)));
+	bool fresh = true;
+	for(int i = 0; i < relationSize; i++){
+		fresh = fresh && !(rowIds[i] == rowId);
+	}
+	checkPassFail(fresh, true)
+	present[3] = true;
+	checkPassFail(tableScan(scan, false, 0, 10, present), (int)std::count(present.begin(), present.begin() + 10, true))
+}
+
+// -----------------------------------------------------------------------------
+// tableScan
+// -----------------------------------------------------------------------------
+int tableScan(TableScan &scan, bool whole, int lowVal, int highVal, const std::vector<bool> &present)
+{
+	// scan [lowVal, highVal) of an index-organized table of tuples, or all of it if whole, and check the
+	// records come back in key order and match their keys. Returns how many came back, -1 if any record
+	// was wrong, out of order or not present
+	if(whole){
+		scan.startScan();
+	}
+	else{
+		scan.startScan(&lowVal, GTE, &highVal, LT);
+	}
+	int count = 0;
+	int last = lowVal - 1;
+	bool ok = true;
+	RecordId rowId;
+	try
+	{
+		while(1)
+		{
+			scan.scanNext(rowId);
+			std::string recordStr = scan.getRecord();
+			const RECORD *record = reinterpret_cast<const RECORD*>(recordStr.data());
+			char s[20];
+			sprintf(s, "%05d string record", record->i);
+			if(record->i <= last || record->i >= highVal || !present[record->i] || record->d != record->i
+				|| memcmp(record->s, s, 19) != 0){
+				ok = false;
+			}
+			last = record->i;
+			count++;
+		}
+	}
+	catch(IndexScanCompletedException e)
+	{
+	}
+	scan.endScan();
+	return ok ? count : -1;
 }
 
-// 
 // -----------------------------------------------------------------------------
-// MyIndexTests
+// intTestsHash
 // -----------------------------------------------------------------------------
-void MyIndexTests(int input){
-	if(testNum == 1){
-		if(input == 0){
-			intTestsEmpty();
-		}
-		else if(input == 1){
-			intTestsOne();
-		}
+void intTestsHash(){
+	std::cout << "Create a hash index on the integer field" << std::endl;
+	std::vector<RecordId> ridVec(relationSize);
+	{
+		FileScan fscan(relationName, bufMgr);
 		try{
-			File::remove(intIndexName);
+			RecordId scanRid;
+			while(1){
+				fscan.scanNext(scanRid);
+				std::string recordStr = fscan.getRecord();
+				ridVec[((RECORD *)recordStr.c_str())->i] = scanRid;
+			}
 		}
-		catch(FileNotFoundException e){
+		catch(EndOfFileException e){
 		}
 	}
-}
+	std::vector<bool> present(relationSize, true);
+	const int extra = 20000;
+	{
+		HashIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		checkPassFail((index.bucketCount() > relationSize / HASHBUCKETSIZE), true)
+		checkPassFail(hashMatches(&index, 0, relationSize, ridVec, present), relationSize)
+		checkPassFail(hashMatches(&index, -1000, 0, ridVec, present), 0)
+
+		// keys past the relation split every bucket a few more times, duplicates fill overflow pages
+		int buckets = index.bucketCount();
+		for(int i = relationSize; i < relationSize + extra; i++){
+			RecordId rid;
+			rid.page_number = i;
+			rid.slot_number = 1;
+			index.insertEntry(&i, rid);
+		}
+		checkPassFail((index.bucketCount() > 4 * buckets), true)
+		int duplicate = -7;
+		for(int i = 0; i < 3 * HASHBUCKETSIZE; i++){
+			RecordId rid;
+			rid.page_number = i + 1;
+			rid.slot_number = 2;
+			index.insertEntry(&duplicate, rid);
+		}
+		std::vector<RecordId> rids;
+		checkPassFail((int)index.lookup(&duplicate, rids), 3 * HASHBUCKETSIZE)
+		checkPassFail(hashMatches(&index, 0, relationSize, ridVec, present), relationSize)
+		// room made all over the chain is filled again before it grows
+		for(int i = 0; i < 3 * HASHBUCKETSIZE; i += 3){
+			RecordId rid;
+			rid.page_number = i + 1;
+			rid.slot_number = 2;
+			index.deleteEntry(&duplicate, rid);
+		}
+		for(int i = 0; i < 3 * HASHBUCKETSIZE; i += 3){
+			RecordId rid;
+			rid.page_number = i + 1;
+			rid.slot_number = 2;
+			index.insertEntry(&duplicate, rid);
+		}
+		rids.clear();
+		checkPassFail((int)index.lookup(&duplicate, rids), 3 * HASHBUCKETSIZE)
+		for(int i = 0; i < 3 * HASHBUCKETSIZE; i++){
+			RecordId rid;
+			rid.page_number = i + 1;
+			rid.slot_number = 2;
+			index.deleteEntry(&duplicate, rid);
+		}
+		rids.clear();
+		checkPassFail((int)index.lookup(&duplicate, rids), 0)
 
-// -----------------------------------------------------------------------------
-// intTests
-// -----------------------------------------------------------------------------
+		for(int i = 0; i < relationSize; i += 3){
+			index.deleteEntry(&i, ridVec[i]);
+			present[i] = false;
+		}
+		checkPassFail(hashMatches(&index, 0, relationSize, ridVec, present), relationSize - (relationSize + 2) / 3)
 
-void intTests()
-{
-  std::cout << "Create a B+ Tree index on the integer field" << std::endl;
-  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		std::cout << "Delete an entry that is not in the index" << std::endl;
+		try{
+			int zero = 0;
+			index.deleteEntry(&zero, ridVec[0]);
+			std::cout << "NoSuchKeyFoundException Test Failed." << std::endl;
+			exit(1);
+		}
+		catch(NoSuchKeyFoundException e){
+			std::cout << "NoSuchKeyFoundException Test Passed." << std::endl;
+		}
+	}
 
-	// run some tests
-	checkPassFail(intScan(&index,25,GT,40,LT), 14)
-	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
-	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
-	checkPassFail(intScan(&index,996,GT,1001,LT), 4)
-	checkPassFail(intScan(&index,0,GT,1,LT), 0)
-	checkPassFail(intScan(&index,300,GT,400,LT), 99)
-	checkPassFail(intScan(&index,3000,GTE,4000,LT), 1000)
+	// the buckets are found again through the directory
+	try{
+		std::string otherName;
+		HashIndex other(relationName, otherName, bufMgr, offsetof(tuple,d), DOUBLE);
+		std::cout << "BadIndexInfoException Test Failed." << std::endl;
+		exit(1);
+	}
+	catch(BadIndexInfoException e){
+		std::cout << "BadIndexInfoException Test Passed." << std::endl;
+	}
+	HashIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+	checkPassFail(hashMatches(&index, 0, relationSize, ridVec, present), relationSize - (relationSize + 2) / 3)
+	std::vector<RecordId> rids;
+	int last = relationSize + extra - 1;
+	checkPassFail((int)index.lookup(&last, rids), 1)
+	checkPassFail((int)rids[0].page_number, last)
 }
 
-// 
 // -----------------------------------------------------------------------------
-// intTestsEmpty
+// hashMatches
 // -----------------------------------------------------------------------------
-void intTestsEmpty(){
-	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
-	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
-	
-	// run some tests
-	checkPassFail(intScan(&index,25,GT,40,LT), 0)
-	checkPassFail(intScan(&index,20,GTE,35,LTE), 0)
-	checkPassFail(intScan(&index,-3,GT,3,LT), 0)
+int hashMatches(HashIndex *index, int lowVal, int highVal, const std::vector<RecordId> &rids, const std::vector<bool> &present)
+{
+	// look up every key of [lowVal, highVal) and check each present key finds its record and nothing
+	// else. Returns how many keys were found, -1 if any lookup was wrong
+	int found = 0;
+	bool ok = true;
+	std::vector<RecordId> out;
+	for(int key = lowVal; key < highVal; key++){
+		out.clear();
+		size_t n = index->lookup(&key, out);
+		bool expected = key >= 0 && key < relationSize && present[key];
+		if(n != out.size() || n != (expected ? 1u : 0u) || (expected && !(out[0] == rids[key]))){
+			ok = false;
+		}
+		found += n;
+	}
+	return ok ? found : -1;
 }
 
-// 
 // -----------------------------------------------------------------------------
-// intTestsOne
+// intTestsBuffered
 // -----------------------------------------------------------------------------
-void intTestsOne(){
+void intTestsBuffered(NonLeafFormat nonLeafFormat){
 	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
-	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
-
-	// run some tests
-	checkPassFail(intScan(&index,25,GT,40,LT), 14)
-	checkPassFail(intScan(&index,20,GTE,35,LTE), 16)
-	checkPassFail(intScan(&index,-3,GT,3,LT), 3)
-}
-
-int intScan(BTreeIndex * index, int lowVal, Operator lowOp, int highVal, Operator highOp)
-{
-  RecordId scanRid;
-	Page *curPage;
-
-  std::cout << "Scan for ";
-  if( lowOp == GT ) { std::cout << "("; } else { std::cout << "["; }
-  std::cout << lowVal << "," << highVal;
-  if( highOp == LT ) { std::cout << ")"; } else { std::cout << "]"; }
-  std::cout << std::endl;
-
-  int numResults = 0;
-	
-	try
-	{
-  	index->startScan(&lowVal, lowOp, &highVal, highOp);
+	const int extra = 3 * relationSize;
+	std::vector<int> keys(extra);
+	for(int i = 0; i < extra; i++){
+		keys[i] = relationSize + i;
 	}
-	catch(NoSuchKeyFoundException e)
-	{
-    std::cout << "No Key Found satisfying the scan criteria." << std::endl;
-		return 0;
+	for(int i = extra - 1; i > 0; i--){
+		std::swap(keys[i], keys[random() % (i + 1)]);
 	}
-
-	while(1)
 	{
-		try
-		{
-			index->scanNext(scanRid);
-			bufMgr->readPage(file1, scanRid.page_number, curPage);
-			RECORD myRec = *(reinterpret_cast<const RECORD*>(curPage->getRecord(scanRid).data()));
-			bufMgr->unPinPage(file1, scanRid.page_number, false);
-
-			if( numResults < 5 )
-			{
-				std::cout << "at:" << scanRid.page_number << "," << scanRid.slot_number;
-				std::cout << " -->:" << myRec.i << ":" << myRec.d << ":" << myRec.s << ":" <<std::endl;
-			}
-			else if( numResults == 5 )
-			{
-				std::cout << "..." << std::endl;
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES, nonLeafFormat);
+		index.bufferInserts(1000);
+
+		// a lookup right after an insert finds it, whether the buffer filled up or not
+		bool found = true;
+		std::vector<RecordId> rids;
+		for(int i = 0; i < extra; i++){
+			RecordId rid;
+			rid.page_number = keys[i];
+			rid.slot_number = 1;
+			index.insertEntry(&keys[i], rid);
+			if(i % 777 == 0){
+				rids.clear();
+				found = found && index.lookup(&keys[i], rids) == 1 && rids[0] == rid;
 			}
 		}
-		catch(IndexScanCompletedException e)
-		{
-			break;
+		checkPassFail(found, true)
+		checkPassFail(bufferedScan(&index, relationSize, relationSize + extra), extra)
+		checkPassFail((int)index.countRange(&keys[0], GTE, &keys[0], LTE), 1)
+
+		// deletes and scans wait for what is still buffered
+		for(int i = 0; i < 500; i++){
+			RecordId rid;
+			rid.page_number = keys[i];
+			rid.slot_number = 2;
+			index.insertEntry(&keys[i], rid);
+		}
+		RecordId rid;
+		rid.page_number = keys[0];
+		rid.slot_number = 2;
+		index.deleteEntry(&keys[0], rid);
+		checkPassFail(bufferedScan(&index, relationSize, relationSize + extra), extra + 499)
+		checkPassFail(intScan(&index, 0, GTE, relationSize, LT), relationSize)
+
+		// what is left in the buffer is applied when the index closes
+		for(int i = 500; i < 800; i++){
+			RecordId rid;
+			rid.page_number = keys[i];
+			rid.slot_number = 2;
+			index.insertEntry(&keys[i], rid);
 		}
-
-		numResults++;
 	}
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, PLAIN_LEAVES, nonLeafFormat);
+	checkPassFail(bufferedScan(&index, relationSize, relationSize + extra), extra + 799)
+	index.bufferInserts(100);
+	for(int i = 800; i < 850; i++){
+		RecordId rid;
+		rid.page_number = keys[i];
+		rid.slot_number = 2;
+		index.insertEntry(&keys[i], rid);
+	}
+	index.bufferInserts(0);
+	checkPassFail((int)index.countRange(&keys[849], GTE, &keys[849], LTE), 2)
+	checkPassFail(bufferedScan(&index, relationSize, relationSize + extra), extra + 849)
+}
 
-  if( numResults >= 5 )
-  {
-    std::cout << "Number of results: " << numResults << std::endl;
-  }
-  index->endScan();
-  std::cout << std::endl;
-
+// -----------------------------------------------------------------------------
+// bufferedScan
+// -----------------------------------------------------------------------------
+int bufferedScan(BTreeIndex *index, int lowVal, int highVal){
+	// count the entries of [lowVal,highVal), whose record ids carry their key as page number,
+	// -1 if one is out of order or out of range
+	std::vector<RecordId> batch(256);
+	BTreeCursor scan = index->openScan(&lowVal, GTE, &highVal, LT);
+	int numResults = 0;
+	PageId last = 0;
+	size_t n;
+	while((n = scan.nextBatch(&batch[0], batch.size())) > 0){
+		for(size_t i = 0; i < n; i++){
+			if(batch[i].page_number < last || (int)batch[i].page_number < lowVal || (int)batch[i].page_number >= highVal){
+				return -1;
+			}
+			last = batch[i].page_number;
+		}
+		numResults += n;
+	}
+	scan.endScan();
 	return numResults;
 }
 
-
 // -----------------------------------------------------------------------------
-// errorTests
+// intTestsStatic
 // -----------------------------------------------------------------------------
-
-void errorTests()
-{
-	std::cout << "Error handling tests" << std::endl;
-	std::cout << "--------------------" << std::endl;
-	// Given error test
-
-	try
-	{
-		File::remove(relationName);
-	}
-	catch(FileNotFoundException e)
+void intTestsStatic(LeafFormat leafFormat){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	const std::string staticName = relationName + ".static";
+	const int duplicates = 100;
+	std::vector<RecordId> ridVec(relationSize);
 	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, leafFormat);
+		// a run of duplicates spanning several nodes of the static tree
+		int key = relationSize / 2;
+		for(int i = 0; i < duplicates; i++){
+			RecordId rid;
+			rid.page_number = relationSize + i;
+			rid.slot_number = 3;
+			index.insertEntry(&key, rid);
+		}
+		for(int i = 0; i < relationSize; i++){
+			std::vector<RecordId> rids;
+			index.lookup(&i, rids);
+			ridVec[i] = rids[0];
+		}
+		index.freeze(staticName);
 	}
 
-  file1 = new PageFile(relationName, true);
-	
-  // initialize all of record1.s to keep purify happy
-  memset(record1.s, ' ', sizeof(record1.s));
-	PageId new_page_number;
-  Page new_page = file1->allocatePage(new_page_number);
-
-  // Insert a bunch of tuples into the relation.
-	for(int i = 0; i <10; i++ )
-	{
-    sprintf(record1.s, "%05d string record", i);
-    record1.i = i;
-    record1.d = (double)i;
-    std::string new_data(reinterpret_cast<char*>(&record1), sizeof(record1));
-
-		while(1)
-		{
-			try
-			{
-    		new_page.insertRecord(new_data);
-				break;
-			}
-			catch(InsufficientSpaceException e)
-			{
-				file1->writePage(new_page_number, new_page);
-  			new_page = file1->allocatePage(new_page_number);
-			}
+	// the tree outlives the index it was frozen from
+	StaticTree tree(staticName);
+	checkPassFail((int)tree.size(), relationSize + duplicates)
+	checkPassFail((tree.height() > 1), true)
+	bool sorted = true;
+	for(size_t i = 1; i < tree.size(); i++){
+		sorted = sorted && tree.keys()[i - 1] <= tree.keys()[i];
+	}
+	checkPassFail(sorted, true)
+	int matches = 0;
+	for(int i = 0; i < relationSize; i++){
+		std::vector<RecordId> rids;
+		if(tree.lookup(&i, rids) == 1 && rids[0] == ridVec[i]){
+			matches++;
 		}
-  }
-
-	file1->writePage(new_page_number, new_page);
-
-  BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
-
-	int int2 = 2;
-	int int5 = 5;
-
-	// Scan Tests
-	std::cout << "Call endScan before startScan" << std::endl;
+	}
+	checkPassFail(matches, relationSize - 1)
+	std::vector<RecordId> rids;
+	int key = relationSize / 2;
+	checkPassFail((int)tree.lookup(&key, rids), duplicates + 1)
+	key = -1;
+	checkPassFail((int)tree.lookup(&key, rids), 0)
+	key = relationSize;
+	checkPassFail((int)tree.lookup(&key, rids), 0)
+
+	size_t begin;
+	int low = 25, high = 40;
+	checkPassFail((int)tree.range(&low, GTE, &high, LT, begin), 15)
+	checkPassFail((tree.keys()[begin] == 25 && tree.rids()[begin] == ridVec[25]), true)
+	checkPassFail((int)tree.range(&low, GT, &high, LTE, begin), 15)
+	checkPassFail((tree.keys()[begin] == 26), true)
+	low = relationSize / 2;
+	checkPassFail((int)tree.range(&low, GTE, &low, LTE, begin), duplicates + 1)
+	// equality ranges are taken the way startScan takes them
+	checkPassFail((int)tree.range(&low, EQ, &low, EQ, begin), duplicates + 1)
+	checkPassFail((tree.keys()[begin] == low), true)
+	key = relationSize;
+	checkPassFail((int)tree.range(&key, EQ, &key, EQ, begin), 0)
 	try
 	{
-		index.endScan();
-		std::cout << "ScanNotInitialized Test 1 Failed." << std::endl;
+		tree.range(&low, EQ, &low, LTE, begin);
+		std::cout << "BadOpcodesException Test 2 Failed." << std::endl;
+		exit(1);
 	}
-	catch(ScanNotInitializedException e)
+	catch(BadOpcodesException e)
 	{
-		std::cout << "ScanNotInitialized Test 1 Passed." << std::endl;
+		std::cout << "BadOpcodesException Test 2 Passed." << std::endl;
 	}
-
-	std::cout << "Call scanNext before startScan" << std::endl;
 	try
 	{
-		RecordId foo;
-		index.scanNext(foo);
-		std::cout << "ScanNotInitialized Test 2 Failed." << std::endl;
+		tree.range(&low, EQ, &key, EQ, begin);
+		std::cout << "BadScanrangeException Test Failed." << std::endl;
+		exit(1);
 	}
-	catch(ScanNotInitializedException e)
+	catch(BadScanrangeException e)
 	{
-		std::cout << "ScanNotInitialized Test 2 Passed." << std::endl;
+		std::cout << "BadScanrangeException Test Passed." << std::endl;
 	}
-
-	std::cout << "Scan with bad lowOp" << std::endl;
+	low = std::numeric_limits<int>::min();
+	high = std::numeric_limits<int>::max();
+	checkPassFail((int)tree.range(&low, GTE, &high, LTE, begin), relationSize + duplicates)
+	checkPassFail((int)tree.range(&low, GT, &high, LT, begin), relationSize + duplicates)
+	low = relationSize - 1;
+	checkPassFail((int)tree.range(&low, GT, &high, LTE, begin), 0)
 	try
 	{
-  	index.startScan(&int2, LTE, &int5, LTE);
+		tree.range(&low, LT, &high, LTE, begin);
 		std::cout << "BadOpcodesException Test 1 Failed." << std::endl;
+		exit(1);
 	}
 	catch(BadOpcodesException e)
 	{
 		std::cout << "BadOpcodesException Test 1 Passed." << std::endl;
 	}
 
-	std::cout << "Scan with bad highOp" << std::endl;
-	try
-	{
-  	index.startScan(&int2, GTE, &int5, GTE);
-		std::cout << "BadOpcodesException Test 2 Failed." << std::endl;
-	}
-	catch(BadOpcodesException e)
-	{
-		std::cout << "BadOpcodesException Test 2 Passed." << std::endl;
-	}
+	// a tree of no entries has no nodes to search
+	StaticTree::write(staticName, nullptr, nullptr, 0);
+	StaticTree empty(staticName);
+	checkPassFail((int)empty.size(), 0)
+	checkPassFail((int)empty.lookup(&key, rids), 0)
+	checkPassFail((int)empty.range(&low, GTE, &high, LTE, begin), 0)
+}
 
+// -----------------------------------------------------------------------------
+// intTestsLearned
+// -----------------------------------------------------------------------------
+void intTestsLearned(LeafFormat leafFormat){
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER, leafFormat);
+	std::vector<RecordId> ridVec(relationSize);
+	for(int i = 0; i < relationSize; i++){
+		std::vector<RecordId> rids;
+		index.lookup(&i, rids);
+		ridVec[i] = rids[0];
+	}
 
-	std::cout << "Scan with bad range" << std::endl;
-	try
-	{
-  	index.startScan(&int5, GTE, &int2, LTE);
-		std::cout << "BadScanrangeException Test 1 Failed." << std::endl;
+	// even keys past the relation in stretches of growing gaps, and a run of duplicates over several leaves
+	const int extra = 60000;
+	const int duplicates = 2000;
+	const int duplicateKey = relationSize + 7;
+	std::vector<int> extraKeys(extra);
+	std::vector<RIDKeyPair<int> > batch;
+	for(int i = 0; i < extra; i++){
+		extraKeys[i] = (i == 0 ? relationSize + 10 : extraKeys[i - 1]) + 2 * (1 + (i / 10000) * (i / 10000));
+		RecordId rid;
+		rid.page_number = relationSize + i;
+		rid.slot_number = 1;
+		RIDKeyPair<int> entry;
+		entry.set(rid, extraKeys[i]);
+		batch.push_back(entry);
 	}
-	catch(BadScanrangeException e)
-	{
-		std::cout << "BadScanrangeException Test 1 Passed." << std::endl;
+	for(int i = 0; i < duplicates; i++){
+		RecordId rid;
+		rid.page_number = relationSize + i;
+		rid.slot_number = 2;
+		RIDKeyPair<int> entry;
+		entry.set(rid, duplicateKey);
+		batch.push_back(entry);
+	}
+	index.insertBatch(&batch[0], batch.size());
+
+	for(int error = 0; error < 3; error += 2){
+		size_t segments = index.learnLeaves(error);
+		checkPassFail((segments > 1), true)
+		checkPassFail((index.learnedSize() > 0), true)
+		int matches = 0;
+		for(int i = 0; i < relationSize; i++){
+			std::vector<RecordId> rids;
+			if(index.lookup(&i, rids) == 1 && rids[0] == ridVec[i]){
+				matches++;
+			}
+		}
+		checkPassFail(matches, relationSize)
+		int found = 0;
+		int missing = 0;
+		for(int i = 0; i < extra; i++){
+			std::vector<RecordId> rids;
+			int key = extraKeys[i];
+			found += index.lookup(&key, rids) == 1 && rids[0].page_number == (PageId)(relationSize + i);
+			key++;
+			missing += index.lookup(&key, rids) == 1;
+		}
+		checkPassFail(found, extra)
+		checkPassFail(missing, 0)
+		std::vector<RecordId> rids;
+		int key = duplicateKey;
+		checkPassFail((int)index.lookup(&key, rids), duplicates)
+		key = -1;
+		checkPassFail((int)index.lookup(&key, rids), 0)
+		key = extraKeys[extra - 1] + 1;
+		checkPassFail((int)index.lookup(&key, rids), 0)
 	}
 
-	deleteRelation();
+	// the first insert leaves the model stale and lookups go back to the tree
+	RecordId rid;
+	rid.page_number = 1;
+	rid.slot_number = 9;
+	int key = extraKeys[100] + 1;
+	index.insertEntry(&key, rid);
+	std::vector<RecordId> rids;
+	checkPassFail((int)index.lookup(&key, rids), 1)
+	index.deleteEntry(&key, rid);
+	rids.clear();
+	checkPassFail((int)index.lookup(&key, rids), 0)
+	index.learnLeaves();
+	key = extraKeys[100];
+	checkPassFail((int)index.lookup(&key, rids), 1)
 }
 
-void deleteRelation()
-{
-	if(file1)
+// -----------------------------------------------------------------------------
+// intTestsBloom
+// -----------------------------------------------------------------------------
+void intTestsBloom(){
+	// the filter alone: no false negatives and about the false positives it was sized for
 	{
-		bufMgr->flushFile(file1);
-		delete file1;
-		file1 = NULL;
+		const int keys = 100000;
+		BloomFilter filter(BLOOMBITSPERKEY, keys);
+		for(int i = 0; i < keys; i++){
+			filter.insert(i * 7);
+		}
+		int found = 0;
+		int positives = 0;
+		for(int i = 0; i < keys; i++){
+			found += filter.mayContain(i * 7);
+			positives += filter.mayContain(i * 7 + 3);
+		}
+		checkPassFail(found, keys)
+		checkPassFail((positives < keys / 50), true)
+		checkPassFail((filter.fill() < filter.designFill() + 0.05), true)
+
+		// probes with AVX2, where the processor has it, answer what probes a word at a time do
+		std::vector<char> narrow(keys * 7);
+		filter.vectorProbes(false);
+		for(int i = 0; i < keys * 7; i++){
+			narrow[i] = filter.mayContain(i);
+		}
+		std::cout << "AVX2 probes " << (filter.vectorProbes(true) ? "enabled" : "not available") << std::endl;
+		int agree = 0;
+		for(int i = 0; i < keys * 7; i++){
+			agree += filter.mayContain(i) == (bool)narrow[i];
+		}
+		checkPassFail(agree, keys * 7)
 	}
-	try
+
+	std::cout << "Create a B+ Tree index on the integer field" << std::endl;
+	const int extra = 2000;
 	{
-		File::remove(relationName);
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		index.bloomFilter(BLOOMBITSPERKEY, relationSize + extra);
+		int found = 0;
+		int absent = 0;
+		for(int i = 0; i < relationSize; i++){
+			std::vector<RecordId> rids;
+			found += index.lookup(&i, rids) == 1;
+			int missing = relationSize + i;
+			absent += index.lookup(&missing, rids) == 0;
+		}
+		checkPassFail(found, relationSize)
+		checkPassFail(absent, relationSize)
+
+		// inserts reach the filter before the tree
+		for(int i = 0; i < extra; i++){
+			int key = 2 * relationSize + i;
+			RecordId rid;
+			rid.page_number = relationSize + i;
+			rid.slot_number = 1;
+			index.insertEntry(&key, rid);
+		}
+		found = 0;
+		for(int i = 0; i < extra; i++){
+			std::vector<RecordId> rids;
+			int key = 2 * relationSize + i;
+			found += index.lookup(&key, rids) == 1;
+		}
+		checkPassFail(found, extra)
+		int key = relationSize + 1;
+		try
+		{
+			index.startScan(&key, EQ, &key, EQ);
+			std::cout << "NoSuchKeyFoundException Test Failed." << std::endl;
+			exit(1);
+		}
+		catch(NoSuchKeyFoundException e)
+		{
+			std::cout << "NoSuchKeyFoundException Test Passed." << std::endl;
+		}
+		checkPassFail(intScan(&index, 25, GTE, 25, LTE), 1)
 	}
-	catch(FileNotFoundException e)
+	// the constructor above is what names the index
+	const std::string bloomName = intIndexName + ".bloom";
+	checkPassFail(File::exists(bloomName), true)
+
+	// the filter is read back with the index, and built again from the leaves once its file is gone
+	for(int round = 0; round < 2; round++){
+		if(round == 1){
+			File::remove(bloomName);
+		}
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		int found = 0;
+		int absent = 0;
+		for(int i = 0; i < extra; i++){
+			std::vector<RecordId> rids;
+			int key = 2 * relationSize + i;
+			found += index.lookup(&key, rids) == 1;
+			key = relationSize + i;
+			absent += index.lookup(&key, rids) == 0;
+		}
+		checkPassFail(found, extra)
+		checkPassFail(absent, extra)
+	}
+
+	// dropping the filter removes its file
 	{
+		BTreeIndex index(relationName, intIndexName, bufMgr, offsetof(tuple,i), INTEGER);
+		index.bloomFilter(0);
+		int key = 2 * relationSize;
+		std::vector<RecordId> rids;
+		checkPassFail((int)index.lookup(&key, rids), 1)
 	}
+	checkPassFail(File::exists(bloomName), false)
 }
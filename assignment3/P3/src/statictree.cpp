@@ -0,0 +1,259 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "statictree.h"
+#include "exceptions/bad_index_info_exception.h"
+#include "exceptions/bad_opcodes_exception.h"
+#include "exceptions/bad_scanrange_exception.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/file_open_exception.h"
+
+namespace badgerdb
+{
+
+// -----------------------------------------------------------------------------
+// StaticTree::StaticTree -- Constructor
+// -----------------------------------------------------------------------------
+
+StaticTree::StaticTree(const std::string &fileName)
+{
+	this->fileName = fileName;
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if(fd < 0){
+		throw FileNotFoundException(fileName);
+	}
+	struct stat status;
+	if(fstat(fd, &status) != 0 || (size_t)status.st_size < (size_t)Page::SIZE){
+		close(fd);
+		throw BadIndexInfoException(fileName);
+	}
+	mappingSize = status.st_size;
+	void *start = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+	// the mapping holds its own reference to the file
+	close(fd);
+	if(start == MAP_FAILED){
+		throw FileNotFoundException(fileName);
+	}
+	mapping = (char *)start;
+
+	const StaticMetaInfo *m = (const StaticMetaInfo *)mapping;
+	if(strncmp(m->magic, "BDBSTAT", sizeof(m->magic)) != 0 || m->height < 0 || m->height > STATICMAXLEVELS
+		|| (size_t)m->ridsOffset + m->entryCount * sizeof(RecordId) > mappingSize){
+		munmap(mapping, mappingSize);
+		throw BadIndexInfoException(fileName);
+	}
+	levels = m->height;
+	count = m->entryCount;
+	for(int level = 0; level < levels; level++){
+		levelNodes[level] = (const int *)(mapping + m->levelOffset[level]);
+	}
+	keyArray = (const int *)(mapping + m->keysOffset);
+	ridArray = (const RecordId *)(mapping + m->ridsOffset);
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::~StaticTree -- destructor
+// -----------------------------------------------------------------------------
+
+StaticTree::~StaticTree()
+{
+	munmap(mapping, mappingSize);
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::write
+// -----------------------------------------------------------------------------
+
+const void StaticTree::write(const std::string &fileName, const int *keys, const RecordId *rids, size_t count)
+{
+	const size_t fanout = STATICNODEKEYS + 1;
+	const int padding = std::numeric_limits<int>::max();
+
+	// build the non-leaf levels bottom up from the smallest key below each node of the level under them
+	size_t leafNodes = (count + STATICNODEKEYS - 1) / STATICNODEKEYS;
+	std::vector<int> lowKeys(leafNodes);
+	for(size_t i = 0; i < leafNodes; i++){
+		lowKeys[i] = keys[i * STATICNODEKEYS];
+	}
+	std::vector<std::vector<int> > levels;
+	while(lowKeys.size() > 1){
+		size_t nodes = (lowKeys.size() + fanout - 1) / fanout;
+		std::vector<int> level(nodes * STATICNODEKEYS, padding);
+		std::vector<int> parentLowKeys(nodes);
+		for(size_t node = 0; node < nodes; node++){
+			parentLowKeys[node] = lowKeys[node * fanout];
+			for(size_t i = 1; i < fanout && node * fanout + i < lowKeys.size(); i++){
+				level[node * STATICNODEKEYS + i - 1] = lowKeys[node * fanout + i];
+			}
+		}
+		levels.push_back(level);
+		lowKeys.swap(parentLowKeys);
+	}
+	if(levels.size() > (size_t)STATICMAXLEVELS){
+		throw BadIndexInfoException(fileName);
+	}
+
+	StaticMetaInfo meta;
+	memset(&meta, 0, sizeof(meta));
+	strncpy(meta.magic, "BDBSTAT", sizeof(meta.magic));
+	meta.height = levels.size();
+	meta.entryCount = count;
+	std::int64_t offset = Page::SIZE;
+	for(int level = 0; level < meta.height; level++){
+		meta.levelOffset[level] = offset;
+		offset += levels[meta.height - 1 - level].size() * sizeof(int);
+	}
+	meta.keysOffset = offset;
+	offset += leafNodes * STATICNODEKEYS * sizeof(int);
+	meta.ridsOffset = offset;
+
+	std::ofstream out(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(!out){
+		throw FileOpenException(fileName);
+	}
+	std::vector<char> header(Page::SIZE, 0);
+	memcpy(&header[0], &meta, sizeof(meta));
+	out.write(&header[0], header.size());
+	for(int level = meta.height - 1; level >= 0; level--){
+		out.write((const char *)&levels[level][0], levels[level].size() * sizeof(int));
+	}
+	out.write((const char *)keys, count * sizeof(int));
+	std::vector<int> tail(leafNodes * STATICNODEKEYS - count, padding);
+	if(!tail.empty()){
+		out.write((const char *)&tail[0], tail.size() * sizeof(int));
+	}
+	out.write((const char *)rids, count * sizeof(RecordId));
+	if(!out){
+		throw FileOpenException(fileName);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::lookup
+// -----------------------------------------------------------------------------
+
+const size_t StaticTree::lookup(const void *key, std::vector<RecordId> &outRids)
+{
+	int check = *((int *)key);
+	size_t initialSize = outRids.size();
+	for(size_t pos = lowerBound(check, false); pos < count && keyArray[pos] == check; pos++){
+		outRids.push_back(ridArray[pos]);
+	}
+	return outRids.size() - initialSize;
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::range
+// -----------------------------------------------------------------------------
+
+const size_t StaticTree::range(const void* lowValParm,
+				   const Operator lowOpParm,
+				   const void* highValParm,
+				   const Operator highOpParm,
+				   size_t &outBegin)
+{
+	int lowVal = *((int *)lowValParm);
+	int highVal = *((int *)highValParm);
+	if((lowOpParm == EQ) != (highOpParm == EQ)){
+		throw BadOpcodesException();
+	}
+	if(lowOpParm == EQ && lowVal != highVal){
+		throw BadScanrangeException();
+	}
+	if(lowVal > highVal){
+		throw BadScanrangeException();
+	}
+	if(lowOpParm != EQ && !((lowOpParm == GT or lowOpParm == GTE) and (highOpParm == LT or highOpParm == LTE))){
+		throw BadOpcodesException();
+	}
+	// an equality range is [key, key]
+	outBegin = lowerBound(lowVal, lowOpParm == GT);
+	size_t end = lowerBound(highVal, highOpParm == LTE || highOpParm == EQ);
+	return end > outBegin ? end - outBegin : 0;
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::keys
+// -----------------------------------------------------------------------------
+
+const int* StaticTree::keys()
+{
+	return keyArray;
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::rids
+// -----------------------------------------------------------------------------
+
+const RecordId* StaticTree::rids()
+{
+	return ridArray;
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::size
+// -----------------------------------------------------------------------------
+
+const size_t StaticTree::size()
+{
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::height
+// -----------------------------------------------------------------------------
+
+const int StaticTree::height()
+{
+	return levels;
+}
+
+// -----------------------------------------------------------------------------
+// StaticTree::lowerBound
+// -----------------------------------------------------------------------------
+const size_t StaticTree::lowerBound(int key, bool after){
+	if(count == 0 || (after && key == std::numeric_limits<int>::max())){
+		// the padding would count as at or below it too
+		return count;
+	}
+	// a node's keys below the one looked for, or at it too when after, count the children or keys to skip
+	size_t node = 0;
+	for(int level = 0; level <= levels; level++){
+		const int *keys = level < levels ? levelNodes[level] + node * STATICNODEKEYS : keyArray + node * STATICNODEKEYS;
+		int below = 0;
+#ifdef __SSE2__
+		__m128i bound = _mm_set1_epi32(after ? key : key - 1);
+		if(!after && key == std::numeric_limits<int>::min()){
+			below = 0;
+		}
+		else{
+			for(int i = 0; i < STATICNODEKEYS; i += 4){
+				__m128i greater = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(keys + i)), bound);
+				below += 4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(greater)));
+			}
+		}
+#else
+		for(int i = 0; i < STATICNODEKEYS; i++){
+			below += after ? keys[i] <= key : keys[i] < key;
+		}
+#endif
+		node = level < levels ? node * (STATICNODEKEYS + 1) + below : node * STATICNODEKEYS + below;
+	}
+	return std::min(node, count);
+}
+
+}
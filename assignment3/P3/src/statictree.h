@@ -0,0 +1,197 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "types.h"
+#include "page.h"
+#include "btree.h"
+
+namespace badgerdb
+{
+
+/**
+ * @brief Number of keys in a node of a StaticTree, one cache line of them. A non-leaf node has one more child.
+ */
+const int STATICNODEKEYS = LINEKEYS;
+
+/**
+ * @brief Most non-leaf levels of a StaticTree, enough for any int key set at STATICNODEKEYS + 1 children a node.
+ */
+const int STATICMAXLEVELS = 8;
+
+/**
+ * @brief The header at the start of a static tree file. Every array of the file starts at a multiple of
+ * the cache line size, the first one Page::SIZE bytes into it.
+*/
+struct StaticMetaInfo{
+  /**
+   * "BDBSTAT" and a terminating null, checked when the file is opened.
+   */
+	char magic[8];
+
+  /**
+   * Number of non-leaf levels.
+   */
+	int height;
+
+  /**
+   * Number of entries.
+   */
+	std::int64_t entryCount;
+
+  /**
+   * Offset in the file of the nodes of each non-leaf level, the root level first.
+   */
+	std::int64_t levelOffset[ STATICMAXLEVELS ];
+
+  /**
+   * Offset in the file of the keys, sorted and padded with INT_MAX to a multiple of STATICNODEKEYS.
+   */
+	std::int64_t keysOffset;
+
+  /**
+   * Offset in the file of the record ids, in the order of the keys.
+   */
+	std::int64_t ridsOffset;
+};
+
+/**
+ * @brief Read-only B+ tree written in one go by BTreeIndex::freeze and mapped into memory to be queried
+ * in place. The leaf level is the sorted array of keys itself, cut into nodes of STATICNODEKEYS keys, next
+ * to the array of record ids. Above it every node is full, and node i of a level has nodes
+ * i * (STATICNODEKEYS + 1) to i * (STATICNODEKEYS + 1) + STATICNODEKEYS of the level below as children,
+ * so the tree keeps no child or sibling pointers. A key of a non-leaf node is the smallest key below
+ * the child after it. Entries are addressed by their position in key order and a scan is a walk over
+ * positions. The file never changes once written, so any number of threads may read it at once.
+*/
+class StaticTree {
+
+ private:
+
+  /**
+   * Name of the file.
+   */
+	std::string	fileName;
+
+  /**
+   * Start of the mapping of the whole file.
+   */
+	char		*mapping;
+
+  /**
+   * Length of the mapping in bytes.
+   */
+	size_t	mappingSize;
+
+  /**
+   * Number of non-leaf levels.
+   */
+	int			levels;
+
+  /**
+   * Number of entries.
+   */
+	size_t	count;
+
+  /**
+   * Nodes of each non-leaf level in the mapping, the root level first.
+   */
+	const int	*levelNodes[ STATICMAXLEVELS ];
+
+  /**
+   * Keys in the mapping.
+   */
+	const int	*keyArray;
+
+  /**
+   * Record ids in the mapping.
+   */
+	const RecordId	*ridArray;
+
+	StaticTree(const StaticTree &other);
+	StaticTree & operator=(const StaticTree &other);
+
+ public:
+
+  /**
+   * StaticTree Constructor.
+	 * Open the file and map it into memory read only.
+   *
+   * @param fileName	Name of a file written by StaticTree::write
+   * @throws  FileNotFoundException     If the file does not exist or cannot be mapped.
+   * @throws  BadIndexInfoException     If the file is not a static tree.
+   */
+	StaticTree(const std::string &fileName);
+
+  /**
+   * StaticTree Destructor.
+	 * Unmap the file.
+	**/
+	~StaticTree();
+
+  /**
+	 * Write a static tree holding the given entries to a file, replacing it if it exists.
+   * @param fileName	Name of the file
+   * @param keys			Keys of the entries, in ascending order
+   * @param rids			Record ids of the entries, rids[i] belonging to keys[i]
+   * @param count			Number of entries
+   * @throws  FileOpenException If the file cannot be written.
+	**/
+	static const void write(const std::string &fileName, const int *keys, const RecordId *rids, size_t count);
+
+  /**
+	 * Look up every entry with the key.
+   * @param key			Key to look up, pointer to integer
+   * @param outRids	Receives the record ids of the entries, in key order
+   * @return  Number of record ids added to outRids
+	**/
+	const size_t lookup(const void* key, std::vector<RecordId> &outRids);
+
+  /**
+	 * Find the entries of a range, which take consecutive positions.
+   * @param lowVal	Low value of range, pointer to integer
+   * @param lowOp		Low operator (GT/GTE/EQ)
+   * @param highVal	High value of range, pointer to integer
+   * @param highOp	High operator (LT/LTE/EQ)
+   * @param outBegin	Receives the position of the first entry of the range
+   * @return  Number of entries in the range
+	 * @throws  BadOpcodesException If lowOp and highOp do not contain the right values, or only one of them is EQ.
+	 * @throws  BadScanrangeException If lowVal > highval, or lowVal != highVal for EQ.
+	**/
+	const size_t range(const void* lowVal, const Operator lowOp, const void* highVal, const Operator highOp, size_t &outBegin);
+
+  /**
+	 * Keys of all entries in ascending order, read from the mapping.
+	**/
+	const int* keys();
+
+  /**
+	 * Record ids of all entries in key order, read from the mapping.
+	**/
+	const RecordId* rids();
+
+  /**
+	 * Number of entries.
+	**/
+	const size_t size();
+
+  /**
+	 * Number of non-leaf levels.
+	**/
+	const int height();
+
+ private:
+	// position of the first entry with a key at or above key, or above it if after
+	const size_t lowerBound(int key, bool after);
+};
+
+}
@@ -57,6 +57,18 @@ struct RecordId {
   bool operator!=(const RecordId& rhs) const {
     return (page_number != rhs.page_number) || (slot_number != rhs.slot_number);
   }
+
+  /**
+   * Orders record IDs by page number, then slot number, which is the order
+   * records are stored in the file.
+   *
+   * @param rhs   Record ID to compare against.
+   * @return  Whether this ID comes before the other one.
+   */
+  bool operator<(const RecordId& rhs) const {
+    return page_number < rhs.page_number ||
+        (page_number == rhs.page_number && slot_number < rhs.slot_number);
+  }
 };
 
 }